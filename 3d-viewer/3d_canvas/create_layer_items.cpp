@@ -43,10 +43,9 @@
 #include <class_zone.h>
 #include <convert_basic_shapes_to_polygon.h>
 #include <trigo.h>
+#include <thread_pool.h>
 #include <vector>
-#include <thread>
 #include <algorithm>
-#include <atomic>
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
 #include <profile.h>
@@ -698,40 +697,17 @@ void BOARD_ADAPTER::createLayers( REPORTER* aStatusReporter )
 
         // Add zones objects
         // /////////////////////////////////////////////////////////////////////
-        std::atomic<size_t> nextZone( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
-
-        size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            std::thread t = std::thread( [&]()
-            {
-                for( size_t areaId = nextZone.fetch_add( 1 );
-                            areaId < zones.size();
-                            areaId = nextZone.fetch_add( 1 ) )
+        THREAD_POOL::Get().ParallelFor( zones.size(),
+                [&]( size_t areaId )
                 {
                     const ZONE_CONTAINER* zone = zones[areaId].first;
-
-                    if( zone == nullptr )
-                        break;
-
-                    PCB_LAYER_ID layer = zones[areaId].second;
+                    PCB_LAYER_ID          layer = zones[areaId].second;
 
                     auto layerContainer = m_layers_container2D.find( layer );
 
                     if( layerContainer != m_layers_container2D.end() )
                         AddSolidAreasShapesToContainer( zone, layerContainer->second, layer );
-                }
-
-                threadsFinished++;
-            } );
-
-            t.detach();
-        }
-
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
-
+                } );
     }
 
     if( GetFlag( FL_ZONE ) && GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS )
@@ -790,35 +766,15 @@ void BOARD_ADAPTER::createLayers( REPORTER* aStatusReporter )
 
         if( layer_id_without_F_and_B.size() > 0 )
         {
-            std::atomic<size_t> nextItem( 0 );
-            std::atomic<size_t> threadsFinished( 0 );
-
-            size_t parallelThreadCount = std::min<size_t>(
-                    std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-                    layer_id_without_F_and_B.size() );
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            {
-                std::thread t = std::thread( [&nextItem, &threadsFinished, &layer_id_without_F_and_B, this]()
-                {
-                    for( size_t i = nextItem.fetch_add( 1 );
-                                i < layer_id_without_F_and_B.size();
-                                i = nextItem.fetch_add( 1 ) )
+            THREAD_POOL::Get().ParallelFor( layer_id_without_F_and_B.size(),
+                    [&]( size_t i )
                     {
                         auto layerPoly = m_layers_poly.find( layer_id_without_F_and_B[i] );
 
                         if( layerPoly != m_layers_poly.end() )
                             // This will make a union of all added contours
                             layerPoly->second->Simplify( SHAPE_POLY_SET::PM_FAST );
-                    }
-
-                    threadsFinished++;
-                } );
-
-                t.detach();
-            }
-
-            while( threadsFinished < parallelThreadCount )
-                std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+                    } );
         }
     }
 
@@ -140,6 +140,47 @@ static const wxChar MinPlotPenWidth[] = wxT( "MinPlotPenWidth" );
 
 static const wxChar DebugZoneFiller[] = wxT( "DebugZoneFiller" );
 
+/**
+ * When true, the DRC tests which support it are re-run around each change to the board and
+ * the DRC markers are kept up to date while editing.
+ */
+static const wxChar RealtimeDRC[] = wxT( "RealtimeDRC" );
+
+/**
+ * When true, the zones touched by each change to the board are refilled straight away.
+ */
+static const wxChar RealtimeZoneFill[] = wxT( "RealtimeZoneFill" );
+
+/**
+ * When true, zone fills and their triangulations are kept in a file in the project directory
+ * and reused when the zones and the items around them haven't changed.
+ */
+static const wxChar ZoneFillCache[] = wxT( "ZoneFillCache" );
+
+/**
+ * When true, saving a board also writes a binary snapshot of it next to the board file, and
+ * opening the board loads the snapshot when the board file hasn't changed since.
+ */
+static const wxChar BoardSnapshot[] = wxT( "BoardSnapshot" );
+
+/**
+ * Maximum number of worker threads used for parallel work (DRC, zone fills, connectivity,
+ * 3D rendering, ...).  0 uses one thread per core.
+ */
+static const wxChar MaxWorkerThreads[] = wxT( "MaxWorkerThreads" );
+
+/**
+ * When set, schematic edits only rebuild the parts of the connection graph they can affect
+ * instead of the whole graph.  Turn off to force a full rebuild after each edit.
+ */
+static const wxChar IncrementalConnectivity[] = wxT( "IncrementalConnectivity" );
+
+/**
+ * zlib compression level of the streams of the PDF plots: 0 stores them (fastest plots, large
+ * files), 9 gives the smallest files.
+ */
+static const wxChar PdfCompressionLevel[] = wxT( "PdfCompressionLevel" );
+
 } // namespace KEYS
 
 
@@ -237,6 +278,17 @@ ADVANCED_CFG::ADVANCED_CFG()
 
     m_DebugZoneFiller           = false;
 
+    m_RealTimeDRC               = false;
+    m_RealTimeZoneFill          = false;
+    m_ZoneFillCache             = false;
+    m_BoardSnapshot             = false;
+
+    m_MaxWorkerThreads          = 0;
+
+    m_IncrementalConnectivity   = true;
+
+    m_PdfCompressionLevel       = 9;
+
     loadFromConfigFile();
 }
 
@@ -314,6 +366,27 @@ void ADVANCED_CFG::loadSettings( wxConfigBase& aCfg )
     configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::DebugZoneFiller,
                                                 &m_DebugZoneFiller, false ) );
 
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::RealtimeDRC,
+                                                &m_RealTimeDRC, false ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::RealtimeZoneFill,
+                                                &m_RealTimeZoneFill, false ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::ZoneFillCache,
+                                                &m_ZoneFillCache, false ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::BoardSnapshot,
+                                                &m_BoardSnapshot, false ) );
+
+    configParams.push_back( new PARAM_CFG_INT( true, AC_KEYS::MaxWorkerThreads,
+                                               &m_MaxWorkerThreads, 0, 0, 1024 ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::IncrementalConnectivity,
+                                                &m_IncrementalConnectivity, true ) );
+
+    configParams.push_back( new PARAM_CFG_INT( true, AC_KEYS::PdfCompressionLevel,
+                                               &m_PdfCompressionLevel, 9, 0, 9 ) );
+
     wxConfigLoadSetups( &aCfg, configParams );
 
     for( PARAM_CFG* param : configParams )
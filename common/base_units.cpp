@@ -557,32 +557,75 @@ wxString GetAbbreviatedUnitsLabel( EDA_UNITS aUnit, bool aUseMils, EDA_DATA_TYPE
 }
 
 
-std::string FormatInternalUnits( int aValue )
+/**
+ * The number of decimals of a value in mm, which is a whole number of internal units, or -1
+ * if IU_PER_MM isn't a power of ten.
+ */
+static constexpr int iuDecimals( double aIuPerMm, int aDecimals = 0 )
 {
-    char    buf[50];
-    double  engUnits = aValue;
-    int     len;
+    return aIuPerMm > 1.0 ? iuDecimals( aIuPerMm / 10.0, aDecimals + 1 )
+                          : ( aIuPerMm == 1.0 ? aDecimals : -1 );
+}
+
+
+/**
+ * Writes \a aValue in mm to \a aBuf, without any printf(): the exact decimal of the value is
+ * the shortest one, as long as an int has fewer than 10 significant digits in mm, so this is
+ * what snprintf() gives with "%.10g" (or with "%.10f" less its trailing zeros).
+ *
+ * @return the number of chars written, at most 13.
+ */
+static int formatInternalUnits( char* aBuf, int aValue )
+{
+    constexpr int decimals = iuDecimals( IU_PER_MM );
+
+    static_assert( decimals >= 0 && decimals <= 9, "IU_PER_MM must be a power of ten" );
 
-    engUnits /= IU_PER_MM;
+    char         digits[16];
+    int          count = 0;
+    unsigned int magnitude = aValue < 0 ? 0U - (unsigned int) aValue : (unsigned int) aValue;
 
-    if( engUnits != 0.0 && fabs( engUnits ) <= 0.0001 )
+    do
     {
-        len = snprintf( buf, sizeof(buf), "%.10f", engUnits );
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while( magnitude );
 
-        while( --len > 0 && buf[len] == '0' )
-            buf[len] = '\0';
+    // Leading zeros for the values below 1 mm
+    while( count <= decimals )
+        digits[count++] = '0';
 
-        if( buf[len] == '.' )
-            buf[len] = '\0';
-        else
-            ++len;
-    }
-    else
+    // Trailing zeros of the decimals are dropped, and the point too if nothing is left after it
+    int last = 0;
+
+    while( last < decimals && digits[last] == '0' )
+        ++last;
+
+    char* out = aBuf;
+
+    if( aValue < 0 )
+        *out++ = '-';
+
+    for( int ii = count - 1; ii >= decimals; --ii )
+        *out++ = digits[ii];
+
+    if( last < decimals )
     {
-        len = snprintf( buf, sizeof(buf), "%.10g", engUnits );
+        *out++ = '.';
+
+        for( int ii = decimals - 1; ii >= last; --ii )
+            *out++ = digits[ii];
     }
 
-    return std::string( buf, len );
+    return out - aBuf;
+}
+
+
+std::string FormatInternalUnits( int aValue )
+{
+    char buf[16];
+
+    return std::string( buf, formatInternalUnits( buf, aValue ) );
 }
 
 
@@ -597,20 +640,35 @@ std::string FormatAngle( double aAngle )
 }
 
 
+/**
+ * Formats a pair of values as "x y" in a single string.
+ */
+static std::string formatInternalUnits( int aX, int aY )
+{
+    char buf[32];
+    int  len = formatInternalUnits( buf, aX );
+
+    buf[len++] = ' ';
+    len += formatInternalUnits( buf + len, aY );
+
+    return std::string( buf, len );
+}
+
+
 std::string FormatInternalUnits( const wxPoint& aPoint )
 {
-    return FormatInternalUnits( aPoint.x ) + " " + FormatInternalUnits( aPoint.y );
+    return formatInternalUnits( aPoint.x, aPoint.y );
 }
 
 
 std::string FormatInternalUnits( const VECTOR2I& aPoint )
 {
-    return FormatInternalUnits( aPoint.x ) + " " + FormatInternalUnits( aPoint.y );
+    return formatInternalUnits( aPoint.x, aPoint.y );
 }
 
 
 std::string FormatInternalUnits( const wxSize& aSize )
 {
-    return FormatInternalUnits( aSize.GetWidth() ) + " " + FormatInternalUnits( aSize.GetHeight() );
+    return formatInternalUnits( aSize.GetWidth(), aSize.GetHeight() );
 }
 
@@ -39,10 +39,11 @@
 
 using namespace KIGFX;
 
-KIGFX::GAL_DISPLAY_OPTIONS basic_displayOptions;
+// the basic GAL doesn't get an external display option object.
+// Each thread has its own basic GAL, so that texts can be plotted from several threads at once.
+thread_local KIGFX::GAL_DISPLAY_OPTIONS basic_displayOptions;
 
-// the basic GAL doesn't get an external display option object
-BASIC_GAL basic_gal( basic_displayOptions );
+thread_local BASIC_GAL basic_gal( basic_displayOptions );
 
 const VECTOR2D BASIC_GAL::transform( const VECTOR2D& aPoint ) const
 {
@@ -29,6 +29,7 @@
 #include <common.h>
 #include <reporter.h>
 #include <macros.h>
+#include <cstring>
 #include <mutex>
 #include <wx/process.h>
 #include <wx/config.h>
@@ -42,8 +43,9 @@
 using KIGFX::COLOR4D;
 
 
-// Create only once, as seeding is *very* expensive
-static boost::uuids::random_generator randomGenerator;
+// Create only once per thread, as seeding is *very* expensive.  The generator is not thread
+// safe, and items are created from worker threads when loading files in parallel.
+static thread_local boost::uuids::random_generator randomGenerator;
 
 // These don't have the same performance penalty, but might as well be consistent
 static boost::uuids::string_generator stringGenerator;
@@ -168,12 +170,41 @@ wxString KIID::AsString() const
 }
 
 
+std::string KIID::AsStdString() const
+{
+    return boost::uuids::to_string( m_uuid );
+}
+
+
 wxString KIID::AsLegacyTimestampString() const
 {
     return wxString::Format( "%8.8lX", (unsigned long) AsLegacyTimestamp() );
 }
 
 
+void KIID::GetBytes( uint8_t aBytes[16] ) const
+{
+    memcpy( aBytes, m_uuid.data, 16 );
+}
+
+
+KIID KIID::FromBytes( const uint8_t aBytes[16] )
+{
+    KIID kiid( 0 );
+
+    memcpy( kiid.m_uuid.data, aBytes, 16 );
+
+    if( kiid.IsLegacyTimestamp() )
+    {
+        kiid.m_cached_timestamp = ( (timestamp_t) aBytes[12] << 24 )
+                                  | ( (timestamp_t) aBytes[13] << 16 )
+                                  | ( (timestamp_t) aBytes[14] << 8 ) | aBytes[15];
+    }
+
+    return kiid;
+}
+
+
 void KIID::ConvertTimestampToUuid()
 {
     if( !IsLegacyTimestamp() )
@@ -32,6 +32,8 @@
 #include <wx/string.h>
 #include <gr_text.h>
 
+#include <mutex>
+
 
 using namespace KIGFX;
 
@@ -54,6 +56,10 @@ STROKE_FONT::STROKE_FONT( GAL* aGal ) :
 
 bool STROKE_FONT::LoadNewStrokeFont( const char* const aNewStrokeFont[], int aNewStrokeFontSize )
 {
+    // The glyphs are shared by all the fonts, which can be created from any thread
+    static std::mutex           loadMutex;
+    std::lock_guard<std::mutex> lock( loadMutex );
+
     if( g_newStrokeFontGlyphs )
     {
         m_glyphs = g_newStrokeFontGlyphs;
@@ -29,6 +29,9 @@
 #include <class_text_mod.h>
 #include <class_edge_mod.h>
 #include <class_pad.h>
+#include <class_pcb_text.h>
+#include <class_track.h>
+#include <class_zone.h>
 
 #include <functional>
 
@@ -46,6 +49,46 @@ static inline size_t hash_board_item( const BOARD_ITEM* aItem, int aFlags )
 }
 
 
+// Outline, hole and vertex counts and all the vertices of a polygon set
+static inline size_t hash_poly_set( const SHAPE_POLY_SET& aPoly )
+{
+    size_t ret = hash<int>{}( aPoly.OutlineCount() );
+
+    for( int ii = 0; ii < aPoly.OutlineCount(); ++ii )
+        hash_combine( ret, aPoly.HoleCount( ii ) );
+
+    for( auto it = aPoly.CIterateWithHoles(); it; it++ )
+        hash_combine( ret, it->x, it->y );
+
+    return ret;
+}
+
+
+// Common calculation part for DRAWSEGMENTs and EDGE_MODULEs (when hashed in board coordinates)
+static inline size_t hash_drawsegment( const DRAWSEGMENT* aSegment, int aFlags )
+{
+    size_t ret = hash_board_item( aSegment, aFlags );
+
+    hash_combine( ret, aSegment->GetShape() );
+    hash_combine( ret, aSegment->GetWidth() );
+    hash_combine( ret, aSegment->GetAngle() );
+
+    if( aFlags & HASH_POS )
+    {
+        hash_combine( ret, aSegment->GetStart().x, aSegment->GetStart().y );
+        hash_combine( ret, aSegment->GetEnd().x, aSegment->GetEnd().y );
+
+        for( const wxPoint& pt : aSegment->GetBezierPoints() )
+            hash_combine( ret, pt.x, pt.y );
+
+        if( aSegment->GetShape() == S_POLYGON )
+            hash_combine( ret, hash_poly_set( aSegment->GetPolyShape() ) );
+    }
+
+    return ret;
+}
+
+
 size_t hash_eda( const EDA_ITEM* aItem, int aFlags )
 {
     size_t ret = 0;
@@ -168,8 +211,100 @@ size_t hash_eda( const EDA_ITEM* aItem, int aFlags )
         }
         break;
 
+    case PCB_LINE_T:
+        ret = hash_drawsegment( static_cast<const DRAWSEGMENT*>( aItem ), aFlags );
+        break;
+
+    case PCB_TEXT_T:
+        {
+            const TEXTE_PCB* text = static_cast<const TEXTE_PCB*>( aItem );
+
+            ret = hash_board_item( text, aFlags );
+            hash_combine( ret, text->GetShownText().ToStdString() );
+            hash_combine( ret, text->IsItalic() );
+            hash_combine( ret, text->IsBold() );
+            hash_combine( ret, text->IsMirrored() );
+            hash_combine( ret, text->GetTextWidth() );
+            hash_combine( ret, text->GetTextHeight() );
+            hash_combine( ret, text->GetTextThickness() );
+            hash_combine( ret, text->GetHorizJustify() );
+            hash_combine( ret, text->GetVertJustify() );
+
+            if( aFlags & HASH_POS )
+                hash_combine( ret, text->GetTextPos().x, text->GetTextPos().y );
+
+            if( aFlags & HASH_ROT )
+                hash_combine( ret, text->GetTextAngle() );
+        }
+        break;
+
+    case PCB_TRACE_T:
+    case PCB_ARC_T:
+    case PCB_VIA_T:
+        {
+            const TRACK* track = static_cast<const TRACK*>( aItem );
+
+            ret = hash_board_item( track, aFlags );
+            hash_combine( ret, track->Type() );
+            hash_combine( ret, track->GetWidth() );
+
+            if( aFlags & HASH_POS )
+            {
+                hash_combine( ret, track->GetStart().x, track->GetStart().y );
+                hash_combine( ret, track->GetEnd().x, track->GetEnd().y );
+
+                if( track->Type() == PCB_ARC_T )
+                {
+                    const ARC* arc = static_cast<const ARC*>( track );
+                    hash_combine( ret, arc->GetMid().x, arc->GetMid().y );
+                }
+            }
+
+            if( track->Type() == PCB_VIA_T )
+            {
+                const VIA* via = static_cast<const VIA*>( track );
+
+                hash_combine( ret, via->GetViaType() );
+                hash_combine( ret, via->GetDrillValue() );
+            }
+
+            if( aFlags & HASH_NET )
+                hash_combine( ret, track->GetNetCode() );
+        }
+        break;
+
+    case PCB_ZONE_AREA_T:
+    case PCB_MODULE_ZONE_AREA_T:
+        {
+            const ZONE_CONTAINER* zone = static_cast<const ZONE_CONTAINER*>( aItem );
+
+            ret = hash_board_item( zone, aFlags );
+            hash_combine( ret, zone->GetIsRuleArea(), zone->GetDoNotAllowCopperPour() );
+            hash_combine( ret, zone->GetPriority() );
+            hash_combine( ret, zone->GetLocalClearance() );
+            hash_combine( ret, zone->GetMinThickness() );
+            hash_combine( ret, static_cast<int>( zone->GetPadConnection() ) );
+            hash_combine( ret, zone->GetThermalReliefGap(), zone->GetThermalReliefSpokeWidth() );
+            hash_combine( ret, static_cast<int>( zone->GetFillMode() ) );
+            hash_combine( ret, zone->GetHatchThickness(), zone->GetHatchGap() );
+            hash_combine( ret, zone->GetHatchOrientation() );
+            hash_combine( ret, zone->GetHatchSmoothingLevel(), zone->GetHatchSmoothingValue() );
+            hash_combine( ret, zone->GetHatchHoleMinArea(), zone->GetHatchBorderAlgorithm() );
+            hash_combine( ret, zone->GetCornerSmoothingType(), zone->GetCornerRadius() );
+            hash_combine( ret, static_cast<int>( zone->GetIslandRemovalMode() ) );
+            hash_combine( ret, zone->GetMinIslandArea() );
+            hash_combine( ret, zone->GetFilledPolysUseThickness() );
+
+            if( aFlags & HASH_POS )
+                hash_combine( ret, hash_poly_set( *zone->Outline() ) );
+
+            if( aFlags & HASH_NET )
+                hash_combine( ret, zone->GetNetCode() );
+        }
+        break;
+
     default:
-        wxASSERT_MSG( false, "Unhandled type in function hashModItem() (exporter_gencad.cpp)" );
+        wxASSERT_MSG( false, "Unhandled type in function hash_eda()" );
     }
 
     return ret;
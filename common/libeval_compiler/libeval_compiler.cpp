@@ -18,6 +18,7 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <map>
 #include <memory>
 #include <set>
 #include <vector>
@@ -943,12 +944,55 @@ bool COMPILER::generateUCode( UCODE* aCode, CONTEXT* aPreflightContext )
         stack.pop_back();
     }
 
+    if( !IsErrorPending() )
+        aCode->Optimize();
+
     libeval_dbg(2,"dump: \n%s\n", aCode->Dump().c_str() );
 
     return true;
 }
 
 
+/**
+ * Computes the result of a binary operator.  Shared by the interpreter and the constant
+ * folder so that folding can never change the outcome of an expression.
+ */
+static double evalBinaryOp( int aOp, const VALUE* aArg1, const VALUE* aArg2 )
+{
+    double arg2Value = aArg2 ? aArg2->AsDouble() : 0.0;
+    double arg1Value = aArg1 ? aArg1->AsDouble() : 0.0;
+
+    switch( aOp )
+    {
+    case TR_OP_ADD:           return arg1Value + arg2Value;
+    case TR_OP_SUB:           return arg1Value - arg2Value;
+    case TR_OP_MUL:           return arg1Value * arg2Value;
+    case TR_OP_DIV:           return arg1Value / arg2Value;
+    case TR_OP_LESS_EQUAL:    return arg1Value <= arg2Value ? 1 : 0;
+    case TR_OP_GREATER_EQUAL: return arg1Value >= arg2Value ? 1 : 0;
+    case TR_OP_LESS:          return arg1Value < arg2Value ? 1 : 0;
+    case TR_OP_GREATER:       return arg1Value > arg2Value ? 1 : 0;
+    case TR_OP_EQUAL:         return aArg1 && aArg2 && aArg1->EqualTo( aArg2 ) ? 1 : 0;
+    case TR_OP_NOT_EQUAL:     return aArg1 && aArg2 && aArg1->EqualTo( aArg2 ) ? 0 : 1;
+    case TR_OP_BOOL_AND:      return arg1Value != 0.0 && arg2Value != 0.0 ? 1 : 0;
+    case TR_OP_BOOL_OR:       return arg1Value != 0.0 || arg2Value != 0.0 ? 1 : 0;
+    default:                  return 0.0;
+    }
+}
+
+
+static double evalUnaryOp( int aOp, const VALUE* aArg )
+{
+    double argValue = aArg ? aArg->AsDouble() : 0.0;
+
+    switch( aOp )
+    {
+    case TR_OP_BOOL_NOT:      return argValue != 0.0 ? 0 : 1;
+    default:                  return 0.0;
+    }
+}
+
+
 void UOP::Exec( CONTEXT* ctx )
 {
     switch( m_op )
@@ -977,79 +1021,171 @@ void UOP::Exec( CONTEXT* ctx )
     {
         LIBEVAL::VALUE* arg2 = ctx->Pop();
         LIBEVAL::VALUE* arg1 = ctx->Pop();
-        double          arg2Value = arg2 ? arg2->AsDouble() : 0.0;
-        double          arg1Value = arg1 ? arg1->AsDouble() : 0.0;
-        double          result;
-
-        switch( m_op )
-        {
-        case TR_OP_ADD:
-            result = arg1Value + arg2Value;
-            break;
-        case TR_OP_SUB:
-            result = arg1Value - arg2Value;
-            break;
-        case TR_OP_MUL:
-            result = arg1Value * arg2Value;
-            break;
-        case TR_OP_DIV:
-            result = arg1Value / arg2Value;
-            break;
-        case TR_OP_LESS_EQUAL:
-            result = arg1Value <= arg2Value ? 1 : 0;
-            break;
-        case TR_OP_GREATER_EQUAL:
-            result = arg1Value >= arg2Value ? 1 : 0;
-            break;
-        case TR_OP_LESS:
-            result = arg1Value < arg2Value ? 1 : 0;
-            break;
-        case TR_OP_GREATER:
-            result = arg1Value > arg2Value ? 1 : 0;
-            break;
-        case TR_OP_EQUAL:
-            result = arg1 && arg2 && arg1->EqualTo( arg2 ) ? 1 : 0;
-            break;
-        case TR_OP_NOT_EQUAL:
-            result = arg1 && arg2 && arg1->EqualTo( arg2 ) ? 0 : 1;
-            break;
-        case TR_OP_BOOL_AND:
-            result = arg1Value != 0.0 && arg2Value != 0.0 ? 1 : 0;
-            break;
-        case TR_OP_BOOL_OR:
-            result = arg1Value != 0.0 || arg2Value != 0.0 ? 1 : 0;
-            break;
-        default:
-            result = 0.0;
-            break;
-        }
 
         auto rp = ctx->AllocValue();
-        rp->Set( result );
+        rp->Set( evalBinaryOp( m_op, arg1, arg2 ) );
         ctx->Push( rp );
         return;
     }
     else if( m_op & TR_OP_UNARY_MASK )
     {
         LIBEVAL::VALUE* arg1 = ctx->Pop();
-        double          arg1Value = arg1 ? arg1->AsDouble() : 0.0;
-        double          result;
 
-        switch( m_op )
+        auto rp = ctx->AllocValue();
+        rp->Set( evalUnaryOp( m_op, arg1 ) );
+        ctx->Push( rp );
+        return;
+    }
+}
+
+
+void UCODE::Optimize()
+{
+    // The code is rebuilt as a stack of fragments, each of which is the code computing a
+    // single value on the evaluation stack.
+    struct FRAGMENT
+    {
+        std::vector<UOP*> ops;
+        const VALUE*      constant = nullptr;   // the value, if the fragment is a literal
+        bool              hasCalls = false;     // dropping the fragment would skip a call
+    };
+
+    std::vector<FRAGMENT> stack;
+    std::vector<UOP*>     created;
+
+    auto pop =
+            [&]() -> FRAGMENT
+            {
+                FRAGMENT frag = std::move( stack.back() );
+                stack.pop_back();
+                return frag;
+            };
+
+    auto pushConstant =
+            [&]( double aValue )
+            {
+                UOP* op = new UOP( TR_UOP_PUSH_VALUE, std::make_unique<VALUE>( aValue ) );
+                created.push_back( op );
+
+                FRAGMENT frag;
+                frag.ops.push_back( op );
+                frag.constant = op->m_value.get();
+                stack.push_back( std::move( frag ) );
+            };
+
+    // Is the result of aOp decided by aConst alone (ie: false && x or true || x)?
+    auto isDecidedBy =
+            [&]( int aOp, const FRAGMENT& aConst, const FRAGMENT& aOther ) -> bool
+            {
+                if( !aConst.constant || aOther.hasCalls )
+                    return false;
+
+                bool value = aConst.constant->AsDouble() != 0.0;
+
+                return ( aOp == TR_OP_BOOL_AND && !value ) || ( aOp == TR_OP_BOOL_OR && value );
+            };
+
+    bool wellFormed = true;
+
+    for( UOP* op : m_ucode )
+    {
+        if( op->m_op == TR_UOP_PUSH_VALUE || op->m_op == TR_UOP_PUSH_VAR || op->m_op == TR_NULL )
         {
-        case TR_OP_BOOL_NOT:
-            result = arg1Value != 0.0 ? 0 : 1;
-            break;
-        default:
-            result = 0.0;
+            // TR_NULL is the (no-op) argument placeholder of an argument-less method call
+            FRAGMENT frag;
+            frag.ops.push_back( op );
+
+            // Item references are pushed as PUSH_VALUE ops without a value
+            if( op->m_op == TR_UOP_PUSH_VALUE )
+                frag.constant = op->m_value.get();
+
+            stack.push_back( std::move( frag ) );
+        }
+        else if( op->m_op == TR_OP_METHOD_CALL && !stack.empty() )
+        {
+            FRAGMENT& arg = stack.back();
+            arg.ops.push_back( op );
+            arg.constant = nullptr;
+            arg.hasCalls = true;
+        }
+        else if( ( op->m_op & TR_OP_BINARY_MASK ) && stack.size() >= 2 )
+        {
+            FRAGMENT arg2 = pop();
+            FRAGMENT arg1 = pop();
+
+            if( arg1.constant && arg2.constant )
+            {
+                pushConstant( evalBinaryOp( op->m_op, arg1.constant, arg2.constant ) );
+            }
+            else if( isDecidedBy( op->m_op, arg1, arg2 ) || isDecidedBy( op->m_op, arg2, arg1 ) )
+            {
+                pushConstant( op->m_op == TR_OP_BOOL_OR ? 1.0 : 0.0 );
+            }
+            else
+            {
+                arg1.ops.insert( arg1.ops.end(), arg2.ops.begin(), arg2.ops.end() );
+                arg1.ops.push_back( op );
+                arg1.constant = nullptr;
+                arg1.hasCalls |= arg2.hasCalls;
+                stack.push_back( std::move( arg1 ) );
+            }
+        }
+        else if( ( op->m_op & TR_OP_UNARY_MASK ) && !stack.empty() )
+        {
+            FRAGMENT arg = pop();
+
+            if( arg.constant )
+            {
+                pushConstant( evalUnaryOp( op->m_op, arg.constant ) );
+            }
+            else
+            {
+                arg.ops.push_back( op );
+                stack.push_back( std::move( arg ) );
+            }
+        }
+        else
+        {
+            wellFormed = false;
             break;
         }
+    }
+
+    if( !wellFormed || stack.size() != 1 )
+    {
+        // Leave it to the interpreter to deal with
+        for( UOP* op : created )
+            delete op;
 
-        auto rp = ctx->AllocValue();
-        rp->Set( result );
-        ctx->Push( rp );
         return;
     }
+
+    std::vector<UOP*>& optimized = stack.back().ops;
+    std::set<UOP*>     keep( optimized.begin(), optimized.end() );
+
+    for( UOP* op : m_ucode )
+    {
+        if( !keep.count( op ) )
+            delete op;
+    }
+
+    for( UOP* op : created )
+    {
+        if( !keep.count( op ) )
+            delete op;
+    }
+
+    m_ucode = std::move( optimized );
+
+    // Intern string literals: repeated ones (such as the netclass name in "A.NetClass == 'x'
+    // || B.NetClass == 'x'") share a single value.
+    std::map<wxString, std::shared_ptr<VALUE>> literals;
+
+    for( UOP* op : m_ucode )
+    {
+        if( op->m_op == TR_UOP_PUSH_VALUE && op->m_value && op->m_value->GetType() == VT_STRING )
+            op->m_value = literals.emplace( op->m_value->AsString(), op->m_value ).first->second;
+    }
 }
 
 
@@ -1057,6 +1193,9 @@ VALUE* UCODE::Run( CONTEXT* ctx )
 {
     static VALUE g_false( 0 );
 
+    // Start from an empty stack, even if a previous run left a malformed one behind
+    ctx->Reset();
+
     try
     {
         for( UOP* op : m_ucode )
@@ -31,6 +31,7 @@
 
 #include <fctsys.h>
 #include <base_struct.h>
+#include <kicad_string.h>
 #include <ws_painter.h>
 #include <ws_draw_item.h>
 #include <ws_data_model.h>
@@ -191,7 +192,6 @@ wxString convertLegacyVariableRefs( const wxString& aTextbase )
 void PAGE_LAYOUT_READER_PARSER::Parse( WS_DATA_MODEL* aLayout )
 {
     WS_DATA_ITEM* item;
-    LOCALE_IO     toggle;
 
     for( T token = NextTok(); token != T_RIGHT && token != EOF; token = NextTok() )
     {
@@ -759,7 +759,7 @@ double PAGE_LAYOUT_READER_PARSER::parseDouble()
     if( token != T_NUMBER )
         Expecting( T_NUMBER );
 
-    double val = strtod( CurText(), NULL );
+    double val = StrToDouble( CurText(), NULL );
 
     return val;
 }
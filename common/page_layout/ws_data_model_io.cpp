@@ -104,6 +104,12 @@ public:
     {
         delete m_fileout;
     }
+
+    void Finish()
+    {
+        if( m_fileout )
+            m_fileout->Finish();
+    }
 };
 
 
@@ -143,6 +149,7 @@ void WS_DATA_MODEL::Save( const wxString& aFullFileName )
 {
     WS_DATA_MODEL_FILEIO writer( aFullFileName );
     writer.Format( this );
+    writer.Finish();
 }
 
 
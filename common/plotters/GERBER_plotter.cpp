@@ -41,6 +41,8 @@
 
 #include <build_version.h>
 
+#include <boost/functional/hash.hpp>
+
 #include <gbr_metadata.h>
 
 
@@ -298,30 +300,37 @@ void GERBER_PLOTTER::SetCurrentLineWidth( int aWidth, void* aData )
 }
 
 
+size_t GERBER_PLOTTER::APERTURE_KEY_HASH::operator()( const APERTURE_KEY& aKey ) const
+{
+    size_t seed = std::hash<int>()( aKey.m_Type );
+
+    boost::hash_combine( seed, aKey.m_Size.x );
+    boost::hash_combine( seed, aKey.m_Size.y );
+    boost::hash_combine( seed, aKey.m_ApertureAttribute );
+
+    return seed;
+}
+
+
 int GERBER_PLOTTER::GetOrCreateAperture( const wxSize& aSize,
                         APERTURE::APERTURE_TYPE aType, int aApertureAttribute )
 {
-    int last_D_code = 9;
-
     // Search an existing aperture
-    for( int idx = 0; idx < (int)m_apertures.size(); ++idx )
-    {
-        APERTURE* tool = &m_apertures[idx];
-        last_D_code = tool->m_DCode;
+    APERTURE_KEY key = { aType, aSize, aApertureAttribute };
+    auto         it = m_apertureIndex.find( key );
 
-        if( (tool->m_Type == aType) && (tool->m_Size == aSize) &&
-            (tool->m_ApertureAttribute == aApertureAttribute) )
-            return idx;
-    }
+    if( it != m_apertureIndex.end() )
+        return it->second;
 
-    // Allocate a new aperture
+    // Allocate a new aperture, with the D code following the last one
     APERTURE new_tool;
     new_tool.m_Size  = aSize;
     new_tool.m_Type  = aType;
-    new_tool.m_DCode = last_D_code + 1;
+    new_tool.m_DCode = m_apertures.empty() ? 10 : m_apertures.back().m_DCode + 1;
     new_tool.m_ApertureAttribute = aApertureAttribute;
 
     m_apertures.push_back( new_tool );
+    m_apertureIndex[key] = m_apertures.size() - 1;
 
     return m_apertures.size() - 1;
 }
@@ -37,10 +37,30 @@
 #include <wx/zstream.h>
 #include <wx/mstream.h>
 #include <math/util.h>      // for KiROUND
+#include <thread_pool.h>
 
 #include <algorithm>
 
 
+PDF_PLOTTER::PDF_PLOTTER() :
+        pageTreeHandle( 0 ),
+        fontResDictHandle( 0 ),
+        workFile( nullptr ),
+        m_compressionLevel( wxZ_BEST_COMPRESSION ),
+        m_inBlock( false ),
+        m_blockPagePenWidth( 0 ),
+        m_pageWorkFile( nullptr ),
+        m_blockFile( nullptr ),
+        m_renderTasks( new TASK_GROUP )
+{
+}
+
+
+PDF_PLOTTER::~PDF_PLOTTER()
+{
+}
+
+
 std::string PDF_PLOTTER::encodeStringForPlotter( const wxString& aText )
 {
 // returns a string compatible with PDF string convention from a unicode string.
@@ -153,25 +173,48 @@ void PDF_PLOTTER::SetViewport( const wxPoint& aOffset, double aIusPerDecimil,
  */
 void PDF_PLOTTER::SetCurrentLineWidth( int aWidth, void* aData )
 {
-    wxASSERT( workFile );
+    wxASSERT( workFile || m_page );
 
     if( aWidth == DO_NOT_SET_LINE_WIDTH )
         return;
-    else if( aWidth == USE_DEFAULT_LINE_WIDTH )
-        aWidth = m_renderSettings->GetDefaultPenWidth();
 
-    if( aWidth == 0 )
-        aWidth = 1;
+    aWidth = resolvePenWidth( aWidth );
 
     wxASSERT_MSG( aWidth > 0, "Plotter called to set negative pen width" );
 
     if( aWidth != currentPenWidth )
-        fprintf( workFile, "%g w\n", userToDeviceSize( aWidth ) );
+    {
+        if( m_page )
+        {
+            recordOp( [aWidth]( PDF_PLOTTER& aRenderer )
+                      {
+                          aRenderer.SetCurrentLineWidth( aWidth );
+                      } );
+        }
+        else
+        {
+            fprintf( workFile, "%g w\n", userToDeviceSize( aWidth ) );
+        }
+    }
 
     currentPenWidth = aWidth;
 }
 
 
+int PDF_PLOTTER::resolvePenWidth( int aWidth ) const
+{
+    if( aWidth == DO_NOT_SET_LINE_WIDTH )
+        return currentPenWidth;
+    else if( aWidth == USE_DEFAULT_LINE_WIDTH )
+        aWidth = m_renderSettings->GetDefaultPenWidth();
+
+    if( aWidth == 0 )
+        aWidth = 1;
+
+    return aWidth;
+}
+
+
 /**
  * PDF supports colors fully. It actually has distinct fill and pen colors,
  * but we set both at the same time.
@@ -183,6 +226,12 @@ void PDF_PLOTTER::SetCurrentLineWidth( int aWidth, void* aData )
  */
 void PDF_PLOTTER::emitSetRGBColor( double r, double g, double b )
 {
+    if( m_page )
+    {
+        recordOp( [r, g, b]( PDF_PLOTTER& aRenderer ) { aRenderer.emitSetRGBColor( r, g, b ); } );
+        return;
+    }
+
     wxASSERT( workFile );
     fprintf( workFile, "%g %g %g rg %g %g %g RG\n",
              r, g, b, r, g, b );
@@ -193,6 +242,12 @@ void PDF_PLOTTER::emitSetRGBColor( double r, double g, double b )
  */
 void PDF_PLOTTER::SetDash( PLOT_DASH_TYPE dashed )
 {
+    if( m_page )
+    {
+        recordOp( [dashed]( PDF_PLOTTER& aRenderer ) { aRenderer.SetDash( dashed ); } );
+        return;
+    }
+
     wxASSERT( workFile );
     switch( dashed )
     {
@@ -220,6 +275,16 @@ void PDF_PLOTTER::SetDash( PLOT_DASH_TYPE dashed )
  */
 void PDF_PLOTTER::Rect( const wxPoint& p1, const wxPoint& p2, FILL_T fill, int width )
 {
+    if( m_page )
+    {
+        SetCurrentLineWidth( width );
+        recordOp( [p1, p2, fill]( PDF_PLOTTER& aRenderer )
+                  {
+                      aRenderer.Rect( p1, p2, fill, DO_NOT_SET_LINE_WIDTH );
+                  } );
+        return;
+    }
+
     wxASSERT( workFile );
     DPOINT p1_dev = userToDeviceCoordinates( p1 );
     DPOINT p2_dev = userToDeviceCoordinates( p2 );
@@ -236,6 +301,25 @@ void PDF_PLOTTER::Rect( const wxPoint& p1, const wxPoint& p2, FILL_T fill, int w
  */
 void PDF_PLOTTER::Circle( const wxPoint& pos, int diametre, FILL_T aFill, int width )
 {
+    if( m_page )
+    {
+        SetCurrentLineWidth( width );
+
+        // Same as below: the pen width has to be known here
+        if( aFill == NO_FILL && diametre < width )
+        {
+            aFill = FILLED_SHAPE;
+            SetCurrentLineWidth( 0 );
+            diametre += width;
+        }
+
+        recordOp( [pos, diametre, aFill]( PDF_PLOTTER& aRenderer )
+                  {
+                      aRenderer.Circle( pos, diametre, aFill, DO_NOT_SET_LINE_WIDTH );
+                  } );
+        return;
+    }
+
     wxASSERT( workFile );
     DPOINT pos_dev = userToDeviceCoordinates( pos );
     double radius = userToDeviceSize( diametre / 2.0 );
@@ -294,13 +378,24 @@ void PDF_PLOTTER::Circle( const wxPoint& pos, int diametre, FILL_T aFill, int wi
 void PDF_PLOTTER::Arc( const wxPoint& centre, double StAngle, double EndAngle, int radius,
                       FILL_T fill, int width )
 {
-    wxASSERT( workFile );
+    wxASSERT( workFile || m_page );
     if( radius <= 0 )
     {
         Circle( centre, width, FILLED_SHAPE, 0 );
         return;
     }
 
+    if( m_page )
+    {
+        SetCurrentLineWidth( width );
+        recordOp( [=]( PDF_PLOTTER& aRenderer )
+                  {
+                      aRenderer.Arc( centre, StAngle, EndAngle, radius, fill,
+                                     DO_NOT_SET_LINE_WIDTH );
+                  } );
+        return;
+    }
+
     /* Arcs are not so easily approximated by beziers (in the general case),
        so we approximate them in the old way */
     wxPoint   start, end;
@@ -349,10 +444,20 @@ void PDF_PLOTTER::Arc( const wxPoint& centre, double StAngle, double EndAngle, i
 void PDF_PLOTTER::PlotPoly( const std::vector< wxPoint >& aCornerList,
                            FILL_T aFill, int aWidth, void * aData )
 {
-    wxASSERT( workFile );
+    wxASSERT( workFile || m_page );
     if( aCornerList.size() <= 1 )
         return;
 
+    if( m_page )
+    {
+        SetCurrentLineWidth( aWidth );
+        recordOp( [aCornerList, aFill]( PDF_PLOTTER& aRenderer )
+                  {
+                      aRenderer.PlotPoly( aCornerList, aFill, DO_NOT_SET_LINE_WIDTH );
+                  } );
+        return;
+    }
+
     SetCurrentLineWidth( aWidth );
 
     DPOINT pos = userToDeviceCoordinates( aCornerList[0] );
@@ -371,12 +476,19 @@ void PDF_PLOTTER::PlotPoly( const std::vector< wxPoint >& aCornerList,
 
 void PDF_PLOTTER::PenTo( const wxPoint& pos, char plume )
 {
-    wxASSERT( workFile );
+    wxASSERT( workFile || m_page );
+
+    // The pen state is kept while recording as well, for the base class code reading it
+    if( m_page )
+        recordOp( [pos, plume]( PDF_PLOTTER& aRenderer ) { aRenderer.PenTo( pos, plume ); } );
+
     if( plume == 'Z' )
     {
         if( penState != 'Z' )
         {
-            fputs( "S\n", workFile );
+            if( !m_page )
+                fputs( "S\n", workFile );
+
             penState     = 'Z';
             penLastpos.x = -1;
             penLastpos.y = -1;
@@ -384,7 +496,7 @@ void PDF_PLOTTER::PenTo( const wxPoint& pos, char plume )
         return;
     }
 
-    if( penState != plume || pos != penLastpos )
+    if( !m_page && ( penState != plume || pos != penLastpos ) )
     {
         DPOINT pos_dev = userToDeviceCoordinates( pos );
         fprintf( workFile, "%g %g %c\n",
@@ -401,6 +513,18 @@ void PDF_PLOTTER::PenTo( const wxPoint& pos, char plume )
 void PDF_PLOTTER::PlotImage( const wxImage & aImage, const wxPoint& aPos,
                             double aScaleFactor )
 {
+    if( m_page )
+    {
+        // A deep copy: the image data is reference counted, and not thread safe
+        wxImage image = aImage.Copy();
+
+        recordOp( [image, aPos, aScaleFactor]( PDF_PLOTTER& aRenderer )
+                  {
+                      aRenderer.PlotImage( image, aPos, aScaleFactor );
+                  } );
+        return;
+    }
+
     wxASSERT( workFile );
     wxSize pix_size( aImage.GetWidth(), aImage.GetHeight() );
 
@@ -537,62 +661,71 @@ void PDF_PLOTTER::closePdfObject()
 
 
 /**
- * Starts a PDF stream (for the page). Returns the object handle opened
- * Pass -1 (default) for a fresh object. Especially from PDF 1.5 streams
- * can contain a lot of things, but for the moment we only handle page
- * content.
+ * Starts a PDF stream (page or form content): until closePdfStream *everything*
+ * is written in the temporary workFile
  */
-int PDF_PLOTTER::startPdfStream(int handle)
+void PDF_PLOTTER::startPdfStream()
 {
-    wxASSERT( outputFile );
     wxASSERT( !workFile );
-    handle = startPdfObject( handle );
-
-    // This is guaranteed to be handle+1 but needs to be allocated since
-    // you could allocate more object during stream preparation
-    streamLengthHandle = allocPdfObject();
-    fprintf( outputFile,
-             "<< /Length %d 0 R /Filter /FlateDecode >>\n" // Length is deferred
-             "stream\n", handle + 1 );
 
     // Open a temporary file to accumulate the stream
     workFilename = wxFileName::CreateTempFileName( "" );
     workFile = wxFopen( workFilename, wxT( "w+b" ));
     wxASSERT( workFile );
-    return handle;
 }
 
 
 /**
- * Finish the current PDF stream (writes the deferred length, too)
+ * Read back what was written from the start of a temporary file
  */
-void PDF_PLOTTER::closePdfStream()
+static std::string readWorkFile( FILE* aFile )
 {
-    wxASSERT( workFile );
-
-    long stream_len = ftell( workFile );
+    std::string content;
+    long        stream_len = ftell( aFile );
 
     if( stream_len < 0 )
     {
         wxASSERT( false );
-        return;
+        stream_len = 0;
     }
 
-    // Rewind the file, read in the page stream and DEFLATE it
-    fseek( workFile, 0, SEEK_SET );
-    unsigned char *inbuf = new unsigned char[stream_len];
+    // Rewind the file and read in the stream
+    content.resize( stream_len );
+    fseek( aFile, 0, SEEK_SET );
 
-    int rc = fread( inbuf, 1, stream_len, workFile );
+    int rc = fread( &content[0], 1, stream_len, aFile );
     wxASSERT( rc == stream_len );
     (void) rc;
 
+    return content;
+}
+
+
+/**
+ * Finish the current PDF stream and return its content
+ */
+std::string PDF_PLOTTER::closePdfStream()
+{
+    wxASSERT( workFile );
+
+    std::string content = readWorkFile( workFile );
+
     // We are done with the temporary file, junk it
     fclose( workFile );
     workFile = 0;
     ::wxRemoveFile( workFilename );
 
+    return content;
+}
+
+
+/**
+ * DEFLATE a stream content.  Only uses its arguments, so can run on any thread.
+ */
+static std::string compressPdfStream( const std::string& aData, int aLevel )
+{
     // NULL means memos owns the memory, but provide a hint on optimum size needed.
-    wxMemoryOutputStream    memos( NULL, std::max( 2000l, stream_len ) ) ;
+    wxMemoryOutputStream    memos( NULL, std::max( (size_t) 2000, aData.size() ) );
 
     {
         /* Somewhat standard parameters to compress in DEFLATE. The PDF spec is
@@ -602,96 +735,327 @@ void PDF_PLOTTER::closePdfStream()
          *                    8, Z_DEFAULT_STRATEGY );
          */
 
-        wxZlibOutputStream      zos( memos, wxZ_BEST_COMPRESSION, wxZLIB_ZLIB );
+        wxZlibOutputStream      zos( memos, aLevel, wxZLIB_ZLIB );
 
-        zos.Write( inbuf, stream_len );
-
-        delete[] inbuf;
+        zos.Write( aData.data(), aData.size() );
 
     }   // flush the zip stream using zos destructor
 
     wxStreamBuffer* sb = memos.GetOutputStreamBuffer();
 
-    unsigned out_count = sb->Tell();
+    return std::string( (const char*) sb->GetBufferStart(), sb->Tell() );
+}
 
-    fwrite( sb->GetBufferStart(), 1, out_count, outputFile );
 
+void PDF_PLOTTER::writePdfStream( int aHandle, const std::string& aData,
+                                  const std::string& aDict )
+{
+    // The length is known now, so no need to defer it in an indirect object
+    startPdfObject( aHandle );
+    fprintf( outputFile,
+             "<<%s /Length %u /Filter /FlateDecode >>\n"
+             "stream\n", aDict.c_str(), (unsigned) aData.size() );
+    fwrite( aData.data(), 1, aData.size(), outputFile );
     fputs( "endstream\n", outputFile );
     closePdfObject();
+}
 
-    // Writing the deferred length as an indirect object
-    startPdfObject( streamLengthHandle );
-    fprintf( outputFile, "%u\n", out_count );
-    closePdfObject();
+
+std::unique_ptr<PDF_PLOTTER> PDF_PLOTTER::newPageRenderer() const
+{
+    std::unique_ptr<PDF_PLOTTER> renderer( new PDF_PLOTTER );
+
+    renderer->plotScale = plotScale;
+    renderer->m_IUsPerDecimil = m_IUsPerDecimil;
+    renderer->iuPerDeviceUnit = iuPerDeviceUnit;
+    renderer->plotOffset = plotOffset;
+    renderer->m_plotMirror = m_plotMirror;
+    renderer->m_mirrorIsHorizontal = m_mirrorIsHorizontal;
+    renderer->m_yaxisReversed = m_yaxisReversed;
+    renderer->colorMode = colorMode;
+    renderer->negativeMode = negativeMode;
+    renderer->currentPenWidth = currentPenWidth;
+    renderer->penState = penState;
+    renderer->penLastpos = penLastpos;
+    renderer->pageInfo = pageInfo;
+    renderer->paperSize = paperSize;
+    renderer->m_renderSettings = m_renderSettings;
+    renderer->plotScaleAdjX = plotScaleAdjX;
+    renderer->plotScaleAdjY = plotScaleAdjY;
+    renderer->m_textMode = m_textMode;
+
+    return renderer;
+}
+
+
+/**
+ * Replays the drawing operations of the page in a stream, and compresses it with the forms
+ * the page paints.  The render settings are only read, so several pages can be rendered at
+ * the same time.
+ */
+void PDF_PLOTTER::renderPage( PDF_PAGE& aPage, int aCompressionLevel )
+{
+    startPdfStream();
+
+    // Default graphic settings (coordinate system, default color and line style)
+    fprintf( workFile,
+             "%g 0 0 %g 0 0 cm 1 J 1 j 0 0 0 rg 0 0 0 RG %g w\n",
+             0.0072 * plotScaleAdjX, 0.0072 * plotScaleAdjY,
+             userToDeviceSize( m_renderSettings->GetDefaultPenWidth() ) );
+
+    for( const PAGE_OP& op : aPage.ops )
+        op( *this );
+
+    // Free the operations (and the images they hold) on this thread
+    aPage.ops.clear();
+    aPage.ops.shrink_to_fit();
+
+    aPage.content = compressPdfStream( closePdfStream(), aCompressionLevel );
+
+    for( const std::string& form : m_pageForms )
+        aPage.forms.push_back( compressPdfStream( form, aCompressionLevel ) );
+
+    if( m_blockFile )
+    {
+        fclose( m_blockFile );
+        m_blockFile = nullptr;
+        ::wxRemoveFile( m_blockFilename );
+    }
+}
+
+
+void PDF_PLOTTER::writeRenderedPages( bool aWait )
+{
+    if( aWait )
+        m_renderTasks->Wait();
+
+    for( ; !m_pages.empty() && m_pages.front()->done; m_pages.pop_front() )
+    {
+        const PDF_PAGE& page = *m_pages.front();
+
+        writePdfStream( page.streamHandle, page.content );
+
+        // The forms of the page which aren't already in the file.  Identical contents give
+        // identical compressed data, so the latter is the key
+        std::vector<int> forms;
+
+        for( const std::string& data : page.forms )
+        {
+            auto it = m_formHandles.find( data );
+
+            if( it != m_formHandles.end() )
+            {
+                forms.push_back( it->second );
+                continue;
+            }
+
+            forms.push_back( allocPdfObject() );
+            m_formHandles[data] = forms.back();
+
+            // The form has the coordinate system of the page it is painted on, whose CTM
+            // makes 1 unit a decimil, moved to its anchor: it may extend on any side of it
+            int  width = page.sizeMils.x * 10;
+            int  height = page.sizeMils.y * 10;
+            char dict[250];
+
+            snprintf( dict, sizeof( dict ),
+                      " /Type /XObject /Subtype /Form /BBox [%d %d %d %d]"
+                      " /Resources << /ProcSet [/PDF /Text /ImageC /ImageB] /Font %d 0 R >>",
+                      -width, -height, 2 * width, 2 * height, fontResDictHandle );
+
+            writePdfStream( forms.back(), data, dict );
+        }
+
+        /* Page size is in 1/72 of inch (default user space units)
+           Works like the bbox in postscript but there is no need for
+           swapping the sizes, since PDF doesn't require a portrait page.
+           We use the MediaBox but PDF has lots of other less used boxes
+           to use */
+
+        const double BIGPTsPERMIL = 0.072;
+
+        startPdfObject( page.handle );
+        fprintf( outputFile,
+                 "<<\n"
+                 "/Type /Page\n"
+                 "/Parent %d 0 R\n"
+                 "/Resources <<\n"
+                 "    /ProcSet [/PDF /Text /ImageC /ImageB]\n"
+                 "    /Font %d 0 R",
+                 pageTreeHandle,
+                 fontResDictHandle );
+
+        // The forms painted on the page
+        if( !forms.empty() )
+        {
+            fputs( "\n    /XObject <<", outputFile );
+
+            for( size_t ii = 0; ii < forms.size(); ii++ )
+                fprintf( outputFile, " /Fm%d %d 0 R", (int) ii, forms[ii] );
+
+            fputs( " >>", outputFile );
+        }
+
+        fprintf( outputFile,
+                 " >>\n"
+                 "/MediaBox [0 0 %d %d]\n"
+                 "/Contents %d 0 R\n"
+                 ">>\n",
+                 int( ceil( page.sizeMils.x * BIGPTsPERMIL ) ),
+                 int( ceil( page.sizeMils.y * BIGPTsPERMIL ) ),
+                 page.streamHandle );
+        closePdfObject();
+    }
 }
 
+
 /**
- * Starts a new page in the PDF document
+ * Starts a new page in the PDF document.  The page is recorded, and rendered on the
+ * thread pool once closed
  */
 void PDF_PLOTTER::StartPage()
 {
     wxASSERT( outputFile );
-    wxASSERT( !workFile );
+    wxASSERT( !m_page );
 
     // Compute the paper size in IUs
     paperSize = pageInfo.GetSizeMils();
     paperSize.x *= 10.0 / iuPerDeviceUnit;
     paperSize.y *= 10.0 / iuPerDeviceUnit;
 
-    // Open the content stream; the page object will go later
-    pageStreamHandle = startPdfStream();
-
-    /* Now, until ClosePage *everything* must be wrote in workFile, to be
-       compressed later in closePdfStream */
+    // The page stream sets the default pen width, but the plotter doesn't track it
+    currentPenWidth = -1;
 
-    // Default graphic settings (coordinate system, default color and line style)
-    fprintf( workFile,
-             "%g 0 0 %g 0 0 cm 1 J 1 j 0 0 0 rg 0 0 0 RG %g w\n",
-             0.0072 * plotScaleAdjX, 0.0072 * plotScaleAdjY,
-             userToDeviceSize( m_renderSettings->GetDefaultPenWidth() ) );
+    m_page.reset( new PDF_PAGE );
+    m_page->handle = 0;
+    m_page->streamHandle = 0;
+    m_page->sizeMils = pageInfo.GetSizeMils();
+    m_page->renderer = newPageRenderer();
+    m_page->done = false;
 }
 
 /**
- * Close the current page in the PDF document (and emit its compressed stream)
+ * Close the current page in the PDF document, and render it while the next pages are plotted
  */
 void PDF_PLOTTER::ClosePage()
 {
+    wxASSERT( m_page && !m_inBlock );
+
+    // The objects can be anywhere in the file (the xref table tells where they are), so the
+    // handles are allocated now, in the order of the pages, and the objects written later
+    m_page->handle = allocPdfObject();
+    m_page->streamHandle = allocPdfObject();
+    pageHandles.push_back( m_page->handle );
+
+    PDF_PAGE* page = m_page.get();
+    int       level = m_compressionLevel;
+
+    m_pages.push_back( std::move( m_page ) );
+
+    m_renderTasks->Run(
+            [page, level]()
+            {
+                page->renderer->renderPage( *page, level );
+                page->renderer.reset();
+                page->done = true;
+            } );
+
+    // Write the pages rendered in the meantime
+    writeRenderedPages( false );
+}
+
+
+/**
+ * A reusable block is rendered in its own stream, in the coordinates of its anchor, and
+ * painted translated to the anchor.  The forms are painted with the graphic state of the
+ * page, but they are saved and restored around them: so the form sets its own pen width,
+ * and the page gets back its own after it
+ */
+void PDF_PLOTTER::StartReusableBlock( const wxPoint& aAnchor )
+{
+    wxASSERT( !m_inBlock );
+    wxASSERT( penState == 'Z' );
+
+    DPOINT pageAnchor = userToDeviceCoordinates( aAnchor );
+
+    m_blockPageOffset = plotOffset;
+    m_blockPagePenWidth = currentPenWidth;
+    plotOffset += aAnchor;
+    m_blockTranslation = pageAnchor - userToDeviceCoordinates( aAnchor );
+    currentPenWidth = -1;
+    m_inBlock = true;
+
+    if( m_page )
+    {
+        recordOp( [aAnchor]( PDF_PLOTTER& aRenderer )
+                  {
+                      aRenderer.StartReusableBlock( aAnchor );
+                  } );
+        return;
+    }
+
     wxASSERT( workFile );
 
-    // Close the page stream (and compress it)
-    closePdfStream();
+    // All the blocks of the page go through the same temporary file
+    if( !m_blockFile )
+    {
+        m_blockFilename = wxFileName::CreateTempFileName( "" );
+        m_blockFile = wxFopen( m_blockFilename, wxT( "w+b" ) );
+        wxASSERT( m_blockFile );
+    }
 
-    // Emit the page object and put it in the page list for later
-    pageHandles.push_back( startPdfObject() );
+    fseek( m_blockFile, 0, SEEK_SET );
+    m_pageWorkFile = workFile;
+    workFile = m_blockFile;
+}
 
-    /* Page size is in 1/72 of inch (default user space units)
-       Works like the bbox in postscript but there is no need for
-       swapping the sizes, since PDF doesn't require a portrait page.
-       We use the MediaBox but PDF has lots of other less used boxes
-       to use */
 
-    const double BIGPTsPERMIL = 0.072;
-    wxSize psPaperSize = pageInfo.GetSizeMils();
+void PDF_PLOTTER::EndReusableBlock()
+{
+    wxASSERT( m_inBlock );
 
-    fprintf( outputFile,
-             "<<\n"
-             "/Type /Page\n"
-             "/Parent %d 0 R\n"
-             "/Resources <<\n"
-             "    /ProcSet [/PDF /Text /ImageC /ImageB]\n"
-             "    /Font %d 0 R >>\n"
-             "/MediaBox [0 0 %d %d]\n"
-             "/Contents %d 0 R\n"
-             ">>\n",
-             pageTreeHandle,
-             fontResDictHandle,
-             int( ceil( psPaperSize.x * BIGPTsPERMIL ) ),
-             int( ceil( psPaperSize.y * BIGPTsPERMIL ) ),
-             pageStreamHandle );
-    closePdfObject();
+    plotOffset = m_blockPageOffset;
+    currentPenWidth = m_blockPagePenWidth;
+    m_inBlock = false;
+
+    if( m_page )
+    {
+        recordOp( []( PDF_PLOTTER& aRenderer ) { aRenderer.EndReusableBlock(); } );
+        return;
+    }
+
+    std::string content = readWorkFile( workFile );
+
+    workFile = m_pageWorkFile;
+    m_pageWorkFile = nullptr;
+
+    if( content.empty() )
+        return;
+
+    // The forms are numbered per page; the page resources tell which object each one is
+    auto it = m_pageFormIndices.find( content );
+    int  form;
+
+    if( it != m_pageFormIndices.end() )
+    {
+        form = it->second;
+    }
+    else
+    {
+        form = m_pageForms.size();
+        m_pageFormIndices[content] = form;
+        m_pageForms.push_back( std::move( content ) );
+    }
 
-    // Mark the page stream as idle
-    pageStreamHandle = 0;
+    if( m_blockTranslation.x == 0.0 && m_blockTranslation.y == 0.0 )
+    {
+        fprintf( workFile, "/Fm%d Do\n", form );
+    }
+    else
+    {
+        fprintf( workFile, "q 1 0 0 1 %g %g cm /Fm%d Do Q\n", m_blockTranslation.x,
+                 m_blockTranslation.y, form );
+    }
 }
 
 /**
@@ -706,6 +1070,7 @@ bool PDF_PLOTTER::StartPlot()
     // First things first: the customary null object
     xrefTable.clear();
     xrefTable.push_back( 0 );
+    m_formHandles.clear();
 
     /* The header (that's easy!). The second line is binary junk required
        to make the file binary from the beginning (the important thing is
@@ -735,6 +1100,9 @@ bool PDF_PLOTTER::EndPlot()
     // Close the current page (often the only one)
     ClosePage();
 
+    // And write all the pages still being rendered
+    writeRenderedPages( true );
+
     /* We need to declare the resources we're using (fonts in particular)
        The useful standard one is the Helvetica family. Adding external fonts
        is *very* involved! */
@@ -882,6 +1250,19 @@ void PDF_PLOTTER::Text( const wxPoint&              aPos,
     if( aSize.x == 0 || aSize.y == 0 )
         return;
 
+    if( m_page )
+    {
+        // Stroking the text is the most expensive part of plotting: leave it to the renderer
+        recordOp( [=]( PDF_PLOTTER& aRenderer )
+                  {
+                      aRenderer.Text( aPos, aColor, aText, aOrient, aSize, aH_justify,
+                                      aV_justify, aWidth, aItalic, aBold, aMultilineAllowed );
+                  } );
+
+        currentPenWidth = resolvePenWidth( aWidth );
+        return;
+    }
+
     // Render phantom text (which will be searchable) behind the stroke font.  This won't
     // be pixel-accurate, but it doesn't matter for searching.
     int render_mode = 3;    // invisible
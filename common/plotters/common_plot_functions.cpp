@@ -33,6 +33,8 @@
 #include "ws_data_item.h"
 #include <wx/filename.h>
 
+#include <mutex>
+
 
 wxString GetDefaultPlotExtension( PLOT_FORMAT aFormat )
 {
@@ -57,6 +59,92 @@ wxString GetDefaultPlotExtension( PLOT_FORMAT aFormat )
 }
 
 
+/**
+ * @return true if the text of \a aItem depends on the page (sheet number, title block...)
+ */
+static bool isPageDependentText( WS_DRAW_ITEM_BASE* aItem )
+{
+    if( aItem->Type() != WSG_TEXT_T || !aItem->GetPeer() )
+        return false;
+
+    return static_cast<WS_DATA_ITEM_TEXT*>( aItem->GetPeer() )->m_TextBase.Contains( "${" );
+}
+
+
+static void plotWorkSheetItem( PLOTTER* plotter, WS_DRAW_ITEM_BASE* item, COLOR4D plotColor,
+                               int defaultPenWidth )
+{
+    plotter->SetCurrentLineWidth( PLOTTER::USE_DEFAULT_LINE_WIDTH );
+
+    switch( item->Type() )
+    {
+    case WSG_LINE_T:
+        {
+            WS_DRAW_ITEM_LINE* line = (WS_DRAW_ITEM_LINE*) item;
+            plotter->SetCurrentLineWidth( std::max( line->GetPenWidth(), defaultPenWidth ) );
+            plotter->MoveTo( line->GetStart() );
+            plotter->FinishTo( line->GetEnd() );
+        }
+        break;
+
+    case WSG_RECT_T:
+        {
+            WS_DRAW_ITEM_RECT* rect = (WS_DRAW_ITEM_RECT*) item;
+            int penWidth = std::max( rect->GetPenWidth(), defaultPenWidth );
+            plotter->Rect( rect->GetStart(), rect->GetEnd(), NO_FILL, penWidth );
+        }
+        break;
+
+    case WSG_TEXT_T:
+        {
+            WS_DRAW_ITEM_TEXT* text = (WS_DRAW_ITEM_TEXT*) item;
+            int penWidth = std::max( text->GetEffectiveTextPenWidth(), defaultPenWidth );
+            plotter->Text( text->GetTextPos(), plotColor, text->GetShownText(),
+                           text->GetTextAngle(), text->GetTextSize(), text->GetHorizJustify(),
+                           text->GetVertJustify(), penWidth, text->IsItalic(), text->IsBold(),
+                           text->IsMultilineAllowed() );
+        }
+        break;
+
+    case WSG_POLY_T:
+        {
+            WS_DRAW_ITEM_POLYPOLYGONS* poly = (WS_DRAW_ITEM_POLYPOLYGONS*) item;
+            int penWidth = std::max( poly->GetPenWidth(), defaultPenWidth );
+            std::vector<wxPoint> points;
+
+            for( int idx = 0; idx < poly->GetPolygons().OutlineCount(); ++idx )
+            {
+                points.clear();
+                SHAPE_LINE_CHAIN& outline = poly->GetPolygons().Outline( idx );
+
+                for( int ii = 0; ii < outline.PointCount(); ii++ )
+                    points.emplace_back( outline.CPoint( ii ).x, outline.CPoint( ii ).y );
+
+                plotter->PlotPoly( points, FILLED_SHAPE, penWidth );
+            }
+        }
+        break;
+
+    case WSG_BITMAP_T:
+        {
+            WS_DRAW_ITEM_BITMAP* drawItem = (WS_DRAW_ITEM_BITMAP*) item;
+            auto*                bitmap = (WS_DATA_ITEM_BITMAP*) drawItem->GetPeer();
+
+            if( bitmap->m_ImageBitmap == NULL )
+                break;
+
+            bitmap->m_ImageBitmap->PlotImage( plotter, drawItem->GetPosition(), plotColor,
+                                              PLOTTER::USE_DEFAULT_LINE_WIDTH );
+        }
+        break;
+
+    default:
+        wxFAIL_MSG( "PlotWorkSheet(): Unknown worksheet item." );
+        break;
+    }
+}
+
+
 void PlotWorkSheet( PLOTTER* plotter, const PROJECT* aProject, const TITLE_BLOCK& aTitleBlock,
                     const PAGE_INFO& aPageInfo, int aSheetNumber, int aNumberOfSheets,
                     const wxString &aSheetDesc, const wxString &aFilename, COLOR4D aColor )
@@ -71,6 +159,12 @@ void PlotWorkSheet( PLOTTER* plotter, const PROJECT* aProject, const TITLE_BLOCK
         plotColor = COLOR4D( RED );
 
     plotter->SetColor( plotColor );
+
+    // The draw items are built from the items of the page layout model, which keep a list of
+    // them: only one thread at a time can go through the model
+    static std::mutex           modelMutex;
+    std::lock_guard<std::mutex> lock( modelMutex );
+
     WS_DRAW_ITEM_LIST drawList;
 
     // Print only a short filename, if aFilename is the full filename
@@ -87,76 +181,25 @@ void PlotWorkSheet( PLOTTER* plotter, const PROJECT* aProject, const TITLE_BLOCK
 
     drawList.BuildWorkSheetGraphicList( aPageInfo, aTitleBlock );
 
-    // Draw item list
+    // Plot the runs of items which are the same on every page as reusable blocks, so that the
+    // plotters able to do it emit them once for the whole file
+    bool inBlock = false;
+
     for( WS_DRAW_ITEM_BASE* item = drawList.GetFirst(); item; item = drawList.GetNext() )
     {
-        plotter->SetCurrentLineWidth( PLOTTER::USE_DEFAULT_LINE_WIDTH );
-
-        switch( item->Type() )
-        {
-        case WSG_LINE_T:
-            {
-                WS_DRAW_ITEM_LINE* line = (WS_DRAW_ITEM_LINE*) item;
-                plotter->SetCurrentLineWidth( std::max( line->GetPenWidth(), defaultPenWidth ) );
-                plotter->MoveTo( line->GetStart() );
-                plotter->FinishTo( line->GetEnd() );
-            }
-            break;
+        bool reusable = !isPageDependentText( item );
 
-        case WSG_RECT_T:
-            {
-                WS_DRAW_ITEM_RECT* rect = (WS_DRAW_ITEM_RECT*) item;
-                int penWidth = std::max( rect->GetPenWidth(), defaultPenWidth );
-                plotter->Rect( rect->GetStart(), rect->GetEnd(), NO_FILL, penWidth );
-            }
-            break;
+        if( reusable && !inBlock )
+            plotter->StartReusableBlock( wxPoint( 0, 0 ) );
+        else if( !reusable && inBlock )
+            plotter->EndReusableBlock();
 
-        case WSG_TEXT_T:
-            {
-                WS_DRAW_ITEM_TEXT* text = (WS_DRAW_ITEM_TEXT*) item;
-                int penWidth = std::max( text->GetEffectiveTextPenWidth(), defaultPenWidth );
-                plotter->Text( text->GetTextPos(), plotColor, text->GetShownText(),
-                               text->GetTextAngle(), text->GetTextSize(), text->GetHorizJustify(),
-                               text->GetVertJustify(), penWidth, text->IsItalic(), text->IsBold(),
-                               text->IsMultilineAllowed() );
-            }
-            break;
-
-        case WSG_POLY_T:
-            {
-                WS_DRAW_ITEM_POLYPOLYGONS* poly = (WS_DRAW_ITEM_POLYPOLYGONS*) item;
-                int penWidth = std::max( poly->GetPenWidth(), defaultPenWidth );
-                std::vector<wxPoint> points;
-
-                for( int idx = 0; idx < poly->GetPolygons().OutlineCount(); ++idx )
-                {
-                    points.clear();
-                    SHAPE_LINE_CHAIN& outline = poly->GetPolygons().Outline( idx );
-
-                    for( int ii = 0; ii < outline.PointCount(); ii++ )
-                        points.emplace_back( outline.CPoint( ii ).x, outline.CPoint( ii ).y );
-
-                    plotter->PlotPoly( points, FILLED_SHAPE, penWidth );
-                }
-            }
-            break;
-
-        case WSG_BITMAP_T:
-            {
-                WS_DRAW_ITEM_BITMAP* drawItem = (WS_DRAW_ITEM_BITMAP*) item;
-                auto*                bitmap = (WS_DATA_ITEM_BITMAP*) drawItem->GetPeer();
-
-                if( bitmap->m_ImageBitmap == NULL )
-                    break;
+        inBlock = reusable;
+        plotWorkSheetItem( plotter, item, plotColor, defaultPenWidth );
+    }
 
-                bitmap->m_ImageBitmap->PlotImage( plotter, drawItem->GetPosition(), plotColor,
-                                                  PLOTTER::USE_DEFAULT_LINE_WIDTH );
-            }
-            break;
+    if( inBlock )
+        plotter->EndReusableBlock();
 
-        default:
-            wxFAIL_MSG( "PlotWorkSheet(): Unknown worksheet item." );
-            break;
-        }
-    }
+    plotter->SetColor( plotColor );
 }
@@ -23,11 +23,21 @@
  */
 
 
+#include <algorithm>
 #include <cstdarg>
+#include <cstdio>
+#include <cstring>
 #include <config.h> // HAVE_FGETC_NOLOCK
 
 #include <richio.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 // Fall back to getc() when getc_unlocked() is not available on the target platform.
 #if !defined( HAVE_FGETC_NOLOCK )
@@ -225,6 +235,153 @@ char* FILE_LINE_READER::ReadLine()
 }
 
 
+MAPPED_FILE_LINE_READER::MAPPED_FILE_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber, unsigned aMaxLineLength ) :
+    LINE_READER( aMaxLineLength ),
+    m_data( nullptr ),
+    m_size( 0 ),
+    m_ndx( 0 ),
+    m_mapped( false ),
+    m_savedChar( 0 ),
+    m_saved( false )
+{
+    m_ownLine = m_line;
+    m_source  = aFileName;
+    m_lineNum = aStartingLineNumber;
+
+#ifndef _WIN32
+    int fd = open( aFileName.fn_str(), O_RDONLY );
+
+    if( fd >= 0 )
+    {
+        struct stat st;
+
+        if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+        {
+            // Private and writable, so that lines can be nul terminated in place
+            void* addr = mmap( nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+
+            if( addr != MAP_FAILED )
+            {
+                madvise( addr, st.st_size, MADV_SEQUENTIAL );
+
+                m_data   = static_cast<char*>( addr );
+                m_size   = st.st_size;
+                m_mapped = true;
+            }
+        }
+
+        close( fd );
+    }
+#endif
+
+    if( !m_mapped )
+    {
+        // Plain stdio: wxFFile would also show its errors in a log dialog, while they are
+        // reported by the caller of the IO_ERROR
+        FILE* fp = wxFopen( aFileName, wxT( "rb" ) );
+
+        if( !fp )
+        {
+            wxString msg = wxString::Format(
+                _( "Unable to open filename \"%s\" for reading" ), aFileName.GetData() );
+            THROW_IO_ERROR( msg );
+        }
+
+        long length = -1;
+
+        if( fseek( fp, 0, SEEK_END ) == 0 )
+            length = ftell( fp );
+
+        size_t count = 0;
+
+        if( length > 0 && fseek( fp, 0, SEEK_SET ) == 0 )
+        {
+            m_readData.resize( length );
+            count = fread( m_readData.data(), 1, m_readData.size(), fp );
+        }
+
+        fclose( fp );
+
+        if( length < 0 || count != (size_t) length )
+        {
+            wxString msg = wxString::Format(
+                _( "Unable to read file \"%s\"" ), aFileName.GetData() );
+            THROW_IO_ERROR( msg );
+        }
+
+        m_data = m_readData.data();
+        m_size = m_readData.size();
+    }
+}
+
+
+MAPPED_FILE_LINE_READER::~MAPPED_FILE_LINE_READER()
+{
+#ifndef _WIN32
+    if( m_mapped )
+        munmap( m_data, m_size );
+#endif
+
+    // Hand the line buffer back to LINE_READER for deletion
+    m_line = m_ownLine;
+}
+
+
+char* MAPPED_FILE_LINE_READER::ReadLine()
+{
+    restore();
+
+    // m_lineNum is incremented even if there was no line read, because this
+    // leads to better error reporting when we hit an end of file.
+    ++m_lineNum;
+
+    if( m_ndx >= m_size )
+    {
+        m_line = m_ownLine;
+        m_length = 0;
+        m_line[0] = 0;
+        return NULL;
+    }
+
+    char*       begin = m_data + m_ndx;
+    const char* newline = static_cast<const char*>( memchr( begin, '\n', m_size - m_ndx ) );
+    size_t      length = newline ? newline - begin + 1 : m_size - m_ndx;
+
+    if( length >= m_maxLineLength )
+        THROW_IO_ERROR( _( "Maximum line length exceeded" ) );
+
+    m_ndx += length;
+
+    if( m_ndx < m_size )
+    {
+        m_savedChar = m_data[m_ndx];
+        m_saved = true;
+        m_data[m_ndx] = 0;
+
+        m_line = begin;
+        m_length = length;
+    }
+    else
+    {
+        // There is no room for the nul after the last line of the file, so copy it
+        m_line = m_ownLine;
+        m_length = 0;
+
+        if( length + 1 > m_capacity )
+            expandCapacity( length + 1 );
+
+        m_ownLine = m_line;
+
+        memcpy( m_line, begin, length );
+        m_length = length;
+        m_line[m_length] = 0;
+    }
+
+    return m_line;
+}
+
+
 STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource ):
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
     m_lines( aString ), m_ndx( 0 )
@@ -363,8 +520,117 @@ const char* OUTPUTFORMATTER::GetQuoteChar( const char* wrapee )
     return GetQuoteChar( wrapee, quoteChar );
 }
 
+/**
+ * @return true if the only conversions of \a fmt are plain "%s", "%d", "%c" and "%%", which
+ *         are the ones of nearly all the s-expression output and are formatted here without
+ *         vsnprintf().
+ */
+static bool isPlainFormat( const char* fmt )
+{
+    for( const char* cp = strchr( fmt, '%' ); cp; cp = strchr( cp + 2, '%' ) )
+    {
+        switch( cp[1] )
+        {
+        case 's':
+        case 'd':
+        case 'c':
+        case '%':
+            break;
+
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+int OUTPUTFORMATTER::plainPrint( const char* fmt, va_list ap )
+{
+    size_t len = 0;
+
+    auto reserve =
+            [&]( size_t aCount )
+            {
+                if( len + aCount > m_buffer.size() )
+                    m_buffer.resize( len + aCount + 1000 );
+            };
+
+    for( const char* cp = fmt; *cp; ++cp )
+    {
+        if( *cp != '%' )
+        {
+            reserve( 1 );
+            m_buffer[len++] = *cp;
+            continue;
+        }
+
+        switch( *++cp )
+        {
+        case 's':
+        {
+            const char* str = va_arg( ap, const char* );
+
+            if( !str )
+                str = "(null)";
+
+            size_t count = strlen( str );
+
+            reserve( count );
+            memcpy( &m_buffer[len], str, count );
+            len += count;
+            break;
+        }
+
+        case 'd':
+        {
+            int          value = va_arg( ap, int );
+            unsigned int magnitude = value < 0 ? 0U - (unsigned int) value : (unsigned int) value;
+            char         digits[12];
+            int          count = 0;
+
+            do
+            {
+                digits[count++] = '0' + magnitude % 10;
+                magnitude /= 10;
+            } while( magnitude );
+
+            reserve( count + 1 );
+
+            if( value < 0 )
+                m_buffer[len++] = '-';
+
+            while( count )
+                m_buffer[len++] = digits[--count];
+
+            break;
+        }
+
+        case 'c':
+            reserve( 1 );
+            m_buffer[len++] = (char) va_arg( ap, int );
+            break;
+
+        default:    // "%%"
+            reserve( 1 );
+            m_buffer[len++] = '%';
+            break;
+        }
+    }
+
+    if( len > 0 )
+        write( &m_buffer[0], len );
+
+    return len;
+}
+
+
 int OUTPUTFORMATTER::vprint( const char* fmt,  va_list ap )
 {
+    if( isPlainFormat( fmt ) )
+        return plainPrint( fmt, ap );
+
     // This function can call vsnprintf twice.
     // But internally, vsnprintf retrieves arguments from the va_list identified by arg as if
     // va_arg was used on it, and thus the state of the va_list is likely to be altered by the call.
@@ -409,13 +675,16 @@ int OUTPUTFORMATTER::Print( int nestLevel, const char* fmt, ... )
 
     va_start( args, fmt );
 
+    static const char spaces[] = "                                ";
+
     int result = 0;
     int total  = 0;
 
-    for( int i=0; i<nestLevel;  ++i )
+    // no error checking needed, an exception indicates an error.
+    for( int count = nestLevel * NESTWIDTH; count > 0; count -= sizeof( spaces ) - 1 )
     {
-        // no error checking needed, an exception indicates an error.
-        result = sprint( "%*c", NESTWIDTH, ' ' );
+        result = std::min( count, (int) sizeof( spaces ) - 1 );
+        write( spaces, result );
 
         total += result;
     }
@@ -513,20 +782,68 @@ FILE_OUTPUTFORMATTER::FILE_OUTPUTFORMATTER( const wxString& aFileName, const wxC
 
     if( !m_fp )
         THROW_IO_ERROR( strerror( errno ) );
+
+    m_pending.reserve( FILE_OUTPUTFMTBUFZ );
 }
 
 
 FILE_OUTPUTFORMATTER::~FILE_OUTPUTFORMATTER()
 {
     if( m_fp )
+    {
+        // Errors can't be reported from here, Finish() is there for those who care about them
+        if( !m_pending.empty() )
+            fwrite( m_pending.data(), m_pending.size(), 1, m_fp );
+
         fclose( m_fp );
+    }
 }
 
 
-void FILE_OUTPUTFORMATTER::write( const char* aOutBuf, int aCount )
+void FILE_OUTPUTFORMATTER::Finish()
+{
+    if( !m_fp )
+        return;
+
+    flush();
+
+    FILE* fp = m_fp;
+
+    m_fp = nullptr;
+
+    if( fclose( fp ) != 0 )
+        THROW_IO_ERROR( strerror( errno ) );
+}
+
+
+void FILE_OUTPUTFORMATTER::flush()
 {
-    if( fwrite( aOutBuf, (unsigned) aCount, 1, m_fp ) != 1 )
+    if( m_pending.empty() )
+        return;
+
+    if( fwrite( m_pending.data(), m_pending.size(), 1, m_fp ) != 1 )
         THROW_IO_ERROR( strerror( errno ) );
+
+    m_pending.clear();
+}
+
+
+void FILE_OUTPUTFORMATTER::write( const char* aOutBuf, int aCount )
+{
+    wxASSERT_MSG( m_fp, "FILE_OUTPUTFORMATTER written to after Finish()" );
+
+    if( m_pending.size() + aCount > FILE_OUTPUTFMTBUFZ )
+        flush();
+
+    if( aCount >= FILE_OUTPUTFMTBUFZ )
+    {
+        if( fwrite( aOutBuf, (unsigned) aCount, 1, m_fp ) != 1 )
+            THROW_IO_ERROR( strerror( errno ) );
+    }
+    else
+    {
+        m_pending.append( aOutBuf, aCount );
+    }
 }
 
 
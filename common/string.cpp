@@ -31,6 +31,13 @@
 #include <richio.h>                        // StrPrintf
 #include <kicad_string.h>
 
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <locale>
+#include <sstream>
+
 
 /**
  * Illegal file name characters used to insure file names will be valid on all supported
@@ -381,6 +388,141 @@ char* StrPurge( char* text )
 }
 
 
+double StrToDouble( const char* aText, char** aEnd )
+{
+    // Powers of ten that are exactly representable by a double
+    static const double exactPowersOfTen[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* cp = aText;
+
+    if( aEnd )
+        *aEnd = const_cast<char*>( aText );
+
+    while( *cp == ' ' || ( *cp >= '\t' && *cp <= '\r' ) )
+        ++cp;
+
+    const char* number = cp;
+    bool        negative = false;
+
+    if( *cp == '-' || *cp == '+' )
+        negative = *cp++ == '-';
+
+    uint64_t mantissa = 0;
+    int      significantDigits = 0;
+    int      exponent = 0;
+    bool     sawDigit = false;
+
+    for( ; *cp >= '0' && *cp <= '9'; ++cp )
+    {
+        sawDigit = true;
+
+        if( mantissa || *cp != '0' )
+        {
+            if( significantDigits < 19 )
+                mantissa = mantissa * 10 + ( *cp - '0' );
+            else
+                exponent++;
+
+            significantDigits++;
+        }
+    }
+
+    if( *cp == '.' )
+    {
+        for( ++cp; *cp >= '0' && *cp <= '9'; ++cp )
+        {
+            sawDigit = true;
+
+            if( mantissa || *cp != '0' )
+            {
+                if( significantDigits < 19 )
+                {
+                    mantissa = mantissa * 10 + ( *cp - '0' );
+                    exponent--;
+                }
+
+                significantDigits++;
+            }
+            else
+            {
+                exponent--;
+            }
+        }
+    }
+
+    if( !sawDigit )
+        return 0.0;
+
+    if( *cp == 'e' || *cp == 'E' )
+    {
+        const char* exp = cp + 1;
+        bool        negativeExp = false;
+
+        if( *exp == '-' || *exp == '+' )
+            negativeExp = *exp++ == '-';
+
+        if( *exp >= '0' && *exp <= '9' )
+        {
+            int value = 0;
+
+            for( ; *exp >= '0' && *exp <= '9'; ++exp )
+            {
+                if( value < 100000 )
+                    value = value * 10 + ( *exp - '0' );
+            }
+
+            exponent += negativeExp ? -value : value;
+            cp = exp;
+        }
+    }
+
+    if( aEnd )
+        *aEnd = const_cast<char*>( cp );
+
+    double value;
+
+    if( mantissa == 0 )
+    {
+        value = 0.0;
+    }
+    else if( significantDigits <= 19 && mantissa <= ( uint64_t( 1 ) << 53 )
+             && exponent >= -22 && exponent <= 22 )
+    {
+        // Both operands are exact, so the result is correctly rounded
+        value = (double) mantissa;
+
+        if( exponent < 0 )
+            value /= exactPowersOfTen[-exponent];
+        else
+            value *= exactPowersOfTen[exponent];
+    }
+    else
+    {
+        // Rare: leave the rounding to the standard library, in the "C" locale
+        std::istringstream stream( std::string( number, cp ) );
+        stream.imbue( std::locale::classic() );
+        stream >> value;
+
+        if( stream.fail() )
+        {
+            errno = ERANGE;
+
+            // Overflows give the largest double, underflows give zero
+            if( std::abs( value ) == std::numeric_limits<double>::max() )
+                value = negative ? -HUGE_VAL : HUGE_VAL;
+        }
+
+        return value;
+    }
+
+    return negative ? -value : value;
+}
+
+
 char* GetLine( FILE* File, char* Line, int* LineNum, int SizeLine )
 {
     do {
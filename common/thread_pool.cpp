@@ -0,0 +1,366 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <advanced_config.h>
+#include <geometry/shape_poly_set.h>
+#include <thread_pool.h>
+
+
+// The pool (if any) whose worker is the current thread, and the worker's index
+static thread_local THREAD_POOL* tl_pool = nullptr;
+static thread_local size_t       tl_workerIndex = 0;
+
+static const size_t NOT_A_WORKER = std::numeric_limits<size_t>::max();
+
+
+/**
+ * The tiled polygon operations of kimath, which can't depend on common, run on the shared pool
+ */
+static struct THREAD_POOL_KIMATH_REGISTRATION
+{
+    THREAD_POOL_KIMATH_REGISTRATION()
+    {
+        SHAPE_POLY_SET::SetParallelFor(
+                []( size_t aCount, const std::function<void( size_t )>& aFunc )
+                {
+                    THREAD_POOL::Get().ParallelFor( aCount, aFunc );
+                },
+                []() -> size_t
+                {
+                    return THREAD_POOL::Get().GetWorkerCount();
+                } );
+    }
+} _THREAD_POOL_KIMATH_REGISTRATION;
+
+
+THREAD_POOL& THREAD_POOL::Get()
+{
+    // Never destroyed: joining the workers while a kiface is being unloaded can deadlock on
+    // some platforms, and they hold no resources worth releasing at exit.
+    static THREAD_POOL* pool = new THREAD_POOL( ADVANCED_CFG::GetCfg().m_MaxWorkerThreads );
+
+    return *pool;
+}
+
+
+THREAD_POOL::THREAD_POOL( size_t aWorkers ) :
+        m_pending( 0 ),
+        m_stopping( false )
+{
+    if( aWorkers == 0 )
+        aWorkers = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+
+    for( size_t ii = 0; ii < aWorkers; ++ii )
+        m_queues.push_back( std::make_unique<WORKER_QUEUE>() );
+
+    for( size_t ii = 0; ii < aWorkers; ++ii )
+        m_workers.emplace_back( &THREAD_POOL::workerLoop, this, ii );
+}
+
+
+THREAD_POOL::~THREAD_POOL()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_wakeMutex );
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+
+    for( std::thread& worker : m_workers )
+        worker.join();
+}
+
+
+void THREAD_POOL::Submit( std::function<void()> aTask )
+{
+    WORKER_QUEUE& queue = ( tl_pool == this ) ? *m_queues[tl_workerIndex] : m_sharedQueue;
+
+    // Counted before it is queued so that the count can't go below zero
+    m_pending++;
+
+    {
+        std::lock_guard<std::mutex> lock( queue.m_mutex );
+        queue.m_tasks.push_back( std::move( aTask ) );
+    }
+
+    // Taking the lock orders the wake-up after a worker's check of m_pending
+    {
+        std::lock_guard<std::mutex> lock( m_wakeMutex );
+    }
+
+    m_wake.notify_one();
+}
+
+
+bool THREAD_POOL::popTask( size_t aIndex, std::function<void()>& aTask )
+{
+    auto take =
+            [&]( WORKER_QUEUE& aQueue, bool aNewest ) -> bool
+            {
+                std::lock_guard<std::mutex> lock( aQueue.m_mutex );
+
+                if( aQueue.m_tasks.empty() )
+                    return false;
+
+                if( aNewest )
+                {
+                    aTask = std::move( aQueue.m_tasks.back() );
+                    aQueue.m_tasks.pop_back();
+                }
+                else
+                {
+                    aTask = std::move( aQueue.m_tasks.front() );
+                    aQueue.m_tasks.pop_front();
+                }
+
+                m_pending--;
+                return true;
+            };
+
+    if( m_pending == 0 )
+        return false;
+
+    // Our own tasks first, newest first as they are the most likely to be in the cache
+    if( aIndex != NOT_A_WORKER && take( *m_queues[aIndex], true ) )
+        return true;
+
+    if( take( m_sharedQueue, false ) )
+        return true;
+
+    // Then steal the oldest task of another worker; it is likely to be the biggest
+    size_t count = m_queues.size();
+    size_t first = ( aIndex != NOT_A_WORKER ) ? aIndex + 1 : 0;
+
+    for( size_t ii = 0; ii < count; ++ii )
+    {
+        size_t victim = ( first + ii ) % count;
+
+        if( victim != aIndex && take( *m_queues[victim], false ) )
+            return true;
+    }
+
+    return false;
+}
+
+
+void THREAD_POOL::workerLoop( size_t aIndex )
+{
+    tl_pool = this;
+    tl_workerIndex = aIndex;
+
+    std::function<void()> task;
+
+    while( true )
+    {
+        if( popTask( aIndex, task ) )
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( m_wakeMutex );
+
+        m_wake.wait( lock, [&]() { return m_stopping || m_pending > 0; } );
+
+        if( m_stopping && m_pending == 0 )
+            return;
+    }
+}
+
+
+bool THREAD_POOL::RunPendingTask()
+{
+    std::function<void()> task;
+
+    if( !popTask( tl_pool == this ? tl_workerIndex : NOT_A_WORKER, task ) )
+        return false;
+
+    task();
+    return true;
+}
+
+
+void THREAD_POOL::ParallelFor( size_t aCount, const std::function<void( size_t )>& aFunc,
+                               TASK_GROUP* aGroup )
+{
+    std::atomic<size_t> next( 0 );
+
+    auto loop =
+            [&]()
+            {
+                try
+                {
+                    for( size_t ii = next++; ii < aCount; ii = next++ )
+                    {
+                        if( aGroup && aGroup->IsCancelled() )
+                            break;
+
+                        aFunc( ii );
+                    }
+                }
+                catch( ... )
+                {
+                    // Stop the other threads from taking new indices
+                    next = aCount;
+                    throw;
+                }
+            };
+
+    size_t helpers = std::min( aCount, GetConcurrency() );
+
+    if( helpers <= 1 )
+    {
+        loop();
+        return;
+    }
+
+    // The calling thread takes its share of the indices too
+    TASK_GROUP         group( *this );
+    std::exception_ptr exception;
+
+    for( size_t ii = 0; ii < helpers - 1; ++ii )
+        group.Run( loop );
+
+    try
+    {
+        loop();
+    }
+    catch( ... )
+    {
+        exception = std::current_exception();
+    }
+
+    group.Wait();
+
+    if( exception )
+        std::rethrow_exception( exception );
+}
+
+
+TASK_GROUP::TASK_GROUP( THREAD_POOL& aPool ) :
+        m_pool( aPool ),
+        m_cancelled( false ),
+        m_running( 0 )
+{
+}
+
+
+TASK_GROUP::~TASK_GROUP()
+{
+    try
+    {
+        Wait();
+    }
+    catch( ... )
+    {
+        // Nobody left to hand the exception to
+    }
+}
+
+
+void TASK_GROUP::Run( std::function<void()> aTask )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_running++;
+    }
+
+    m_pool.Submit(
+            [this, aTask]()
+            {
+                std::exception_ptr exception;
+
+                if( !m_cancelled )
+                {
+                    try
+                    {
+                        aTask();
+                    }
+                    catch( ... )
+                    {
+                        exception = std::current_exception();
+                        m_cancelled = true;
+                    }
+                }
+
+                taskDone( exception );
+            } );
+}
+
+
+void TASK_GROUP::taskDone( std::exception_ptr aException )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( aException && !m_exception )
+        m_exception = aException;
+
+    // Notify under the lock: the group may be destroyed as soon as it is released
+    if( --m_running == 0 )
+        m_done.notify_all();
+}
+
+
+void TASK_GROUP::Wait()
+{
+    while( true )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            if( m_running == 0 )
+                break;
+        }
+
+        // Help out rather than block a thread the pool may need to finish our tasks
+        if( !m_pool.RunPendingTask() )
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_done.wait_for( lock, std::chrono::milliseconds( 1 ),
+                             [&]() { return m_running == 0; } );
+        }
+    }
+
+    std::exception_ptr exception;
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        std::swap( exception, m_exception );
+    }
+
+    if( exception )
+        std::rethrow_exception( exception );
+}
+
+
+bool TASK_GROUP::WaitFor( std::chrono::milliseconds aTimeout )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    return m_done.wait_for( lock, aTimeout, [&]() { return m_running == 0; } );
+}
@@ -19,11 +19,11 @@
  */
 
 #include <list>
-#include <thread>
+#include <set>
 #include <algorithm>
-#include <future>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <profile.h>
 #include <common.h>
 #include <erc.h>
@@ -37,6 +37,8 @@
 #include <sch_sheet_path.h>
 #include <sch_text.h>
 #include <schematic.h>
+#include <thread_pool.h>
+#include <trigo.h>
 #include <connection_graph.h>
 #include <widgets/ui_common.h>
 
@@ -50,6 +52,143 @@
 static const wxChar ConnProfileMask[] = wxT( "CONN_PROFILE" );
 
 
+/**
+ * @return the items a connectable schematic item adds to the graph on the given sheet: its pins
+ *         for components and sheets, the item itself for everything else.
+ */
+static std::vector<SCH_ITEM*> graphItems( SCH_ITEM* aItem, const SCH_SHEET_PATH& aSheet )
+{
+    std::vector<SCH_ITEM*> items;
+
+    if( aItem->Type() == SCH_COMPONENT_T )
+    {
+        for( SCH_PIN* pin : static_cast<SCH_COMPONENT*>( aItem )->GetPins( &aSheet ) )
+            items.push_back( pin );
+    }
+    else if( aItem->Type() == SCH_SHEET_T )
+    {
+        for( SCH_SHEET_PIN* pin : static_cast<SCH_SHEET*>( aItem )->GetPins() )
+            items.push_back( pin );
+    }
+    else
+    {
+        items.push_back( aItem );
+    }
+
+    return items;
+}
+
+
+/**
+ * @return the items of the graph added by \a aItem which have a connection point at \a aPoint.
+ */
+static std::vector<SCH_ITEM*> graphItemsAt( SCH_ITEM* aItem, const SCH_SHEET_PATH& aSheet,
+                                            const wxPoint& aPoint )
+{
+    std::vector<SCH_ITEM*> items;
+
+    if( aItem->Type() == SCH_COMPONENT_T )
+    {
+        for( SCH_PIN* pin : static_cast<SCH_COMPONENT*>( aItem )->GetPins( &aSheet ) )
+        {
+            if( pin->GetPosition() == aPoint )
+                items.push_back( pin );
+        }
+    }
+    else if( aItem->Type() == SCH_SHEET_T )
+    {
+        for( SCH_SHEET_PIN* pin : static_cast<SCH_SHEET*>( aItem )->GetPins() )
+        {
+            if( pin->GetTextPos() == aPoint )
+                items.push_back( pin );
+        }
+    }
+    else
+    {
+        for( const wxPoint& point : aItem->GetConnectionPoints() )
+        {
+            if( point == aPoint )
+            {
+                items.push_back( aItem );
+                break;
+            }
+        }
+    }
+
+    return items;
+}
+
+
+static bool isLabel( const SCH_ITEM* aItem )
+{
+    switch( aItem->Type() )
+    {
+    case SCH_LABEL_T:
+    case SCH_GLOBAL_LABEL_T:
+    case SCH_HIER_LABEL_T:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+/**
+ * Adds the name of a connection, and those of all its bus members, to \a aNames.
+ */
+static void addConnectionNames( const SCH_CONNECTION* aConnection, std::vector<wxString>& aNames )
+{
+    aNames.push_back( aConnection->Name( true ) );
+
+    for( const std::shared_ptr<SCH_CONNECTION>& member : aConnection->Members() )
+        addConnectionNames( member.get(), aNames );
+}
+
+
+/**
+ * @return the name linking a hierarchical label to the sheet pin with the same name.
+ */
+static wxString hierLinkName( const SCH_SHEET_PATH& aChildSheet, const wxString& aName )
+{
+    return aChildSheet.PathAsString() + aName;
+}
+
+
+/**
+ * Groups the sheets of a list by screen.  Sheets sharing a screen share their items, so their
+ * connectivity can't be updated at the same time, unlike that of sheets from different groups.
+ *
+ * @return the indices of the sheets of each group, in the order of the list.
+ */
+static std::vector<std::vector<size_t>> groupSheetsByScreen( const SCH_SHEET_PATHS& aSheets )
+{
+    std::vector<std::vector<size_t>>        groups;
+    std::unordered_map<SCH_SCREEN*, size_t> group_index;
+
+    for( size_t ii = 0; ii < aSheets.size(); ++ii )
+    {
+        auto result = group_index.emplace( aSheets[ii].LastScreen(), groups.size() );
+
+        if( result.second )
+            groups.emplace_back();
+
+        groups[result.first->second].push_back( ii );
+    }
+
+    return groups;
+}
+
+
+static void setConnectionGraph( SCH_CONNECTION* aConnection, CONNECTION_GRAPH* aGraph )
+{
+    aConnection->SetGraph( aGraph );
+
+    for( const std::shared_ptr<SCH_CONNECTION>& member : aConnection->Members() )
+        setConnectionGraph( member.get(), aGraph );
+}
+
+
 bool CONNECTION_SUBGRAPH::ResolveDrivers( bool aCreateMarkers )
 {
     PRIORITY               highest_priority = PRIORITY::INVALID;
@@ -378,6 +517,10 @@ void CONNECTION_GRAPH::Reset()
     m_item_to_subgraph_map.clear();
     m_local_label_cache.clear();
     m_global_label_cache.clear();
+    m_sheet_items.clear();
+    m_sheet_item_subgraphs.clear();
+    m_link_name_to_subgraphs.clear();
+    m_subgraph_link_names.clear();
     m_last_net_code = 1;
     m_last_bus_code = 1;
     m_last_subgraph_code = 1;
@@ -388,40 +531,70 @@ void CONNECTION_GRAPH::Recalculate( const SCH_SHEET_LIST& aSheetList, bool aUnco
 {
     PROF_COUNTER recalc_time( "CONNECTION_GRAPH::Recalculate" );
 
-    if( aUnconditional )
+    bool incremental = !aUnconditional && ADVANCED_CFG::GetCfg().m_IncrementalConnectivity
+                            && updateIncrementally( aSheetList );
+
+    m_last_recalc_incremental = incremental;
+
+    if( !incremental )
+    {
         Reset();
 
-    PROF_COUNTER update_items( "updateItemConnectivity" );
+        PROF_COUNTER update_items( "updateItemConnectivity" );
 
-    m_sheetList = aSheetList;
+        m_sheetList = aSheetList;
 
-    for( const SCH_SHEET_PATH& sheet : aSheetList )
-    {
-        std::vector<SCH_ITEM*> items;
+        // Added here since the tasks below can't add to the map
+        for( const SCH_SHEET_PATH& sheet : aSheetList )
+            m_sheet_items[sheet];
 
-        for( SCH_ITEM* item : sheet.LastScreen()->Items() )
-        {
-            if( item->IsConnectable() && ( aUnconditional || item->IsConnectivityDirty() ) )
-                items.push_back( item );
-        }
+        // The sheets of a group share their items, so are handled in order by the same task.
+        // The results are then merged in the order of the list.
+        std::vector<std::vector<size_t>> groups = groupSheetsByScreen( aSheetList );
+        std::vector<SHEET_GRAPH_ITEMS>   results( aSheetList.size() );
 
-        m_items.reserve( m_items.size() + items.size() );
+        THREAD_POOL::Get().ParallelFor( groups.size(),
+                [&]( size_t aGroup )
+                {
+                    for( size_t ii : groups[aGroup] )
+                    {
+                        const SCH_SHEET_PATH&  sheet = aSheetList[ii];
+                        std::vector<SCH_ITEM*> items;
 
-        updateItemConnectivity( sheet, items );
+                        for( SCH_ITEM* item : sheet.LastScreen()->Items() )
+                        {
+                            if( item->IsConnectable() )
+                                items.push_back( item );
+                        }
 
-        // UpdateDanglingState() also adds connected items for SCH_TEXT
-        sheet.LastScreen()->TestDanglingEnds( &sheet );
-    }
+                        updateItemConnectivity( sheet, items, results[ii] );
 
-    if( wxLog::IsAllowedTraceMask( ConnProfileMask ) )
-        update_items.Show();
+                        // UpdateDanglingState() also adds connected items for SCH_TEXT
+                        sheet.LastScreen()->TestDanglingEnds( &sheet );
+                    }
+                } );
 
-    PROF_COUNTER build_graph( "buildConnectionGraph" );
+        for( SHEET_GRAPH_ITEMS& result : results )
+        {
+            m_items.insert( m_items.end(), result.m_items.begin(), result.m_items.end() );
+            m_invisible_power_pins.insert( m_invisible_power_pins.end(),
+                                           result.m_invisible_power_pins.begin(),
+                                           result.m_invisible_power_pins.end() );
+        }
 
-    buildConnectionGraph();
+        if( wxLog::IsAllowedTraceMask( ConnProfileMask ) )
+            update_items.Show();
 
-    if( wxLog::IsAllowedTraceMask( ConnProfileMask ) )
-        build_graph.Show();
+        PROF_COUNTER build_graph( "buildConnectionGraph" );
+
+        buildConnectionGraph();
+
+        for( CONNECTION_SUBGRAPH* subgraph : m_subgraphs )
+            indexSubgraph( subgraph );
+
+        if( wxLog::IsAllowedTraceMask( ConnProfileMask ) )
+            build_graph.Show();
+    }
 
     recalc_time.Stop();
 
@@ -432,7 +605,9 @@ void CONNECTION_GRAPH::Recalculate( const SCH_SHEET_LIST& aSheetList, bool aUnco
     // Pressure relief valve for release builds
     const double max_recalc_time_msecs = 250.;
 
-    if( m_allowRealTime && ADVANCED_CFG::GetCfg().m_realTimeConnectivity &&
+    // Requested full rebuilds (ERC, netlisting, global cleanup) are expected to be slow, but
+    // any recalculation triggered by an edit counts, including a fallback to a full rebuild.
+    if( m_allowRealTime && ADVANCED_CFG::GetCfg().m_realTimeConnectivity && !aUnconditional &&
         recalc_time.msecs() > max_recalc_time_msecs )
     {
         m_allowRealTime = false;
@@ -441,13 +616,653 @@ void CONNECTION_GRAPH::Recalculate( const SCH_SHEET_LIST& aSheetList, bool aUnco
 }
 
 
+bool CONNECTION_GRAPH::updateIncrementally( const SCH_SHEET_LIST& aSheetList )
+{
+    if( m_subgraphs.empty() || aSheetList.size() != m_sheetList.size() )
+        return false;
+
+    // Sheet names are part of the net names, so a change to the hierarchy can rename any net
+    for( size_t ii = 0; ii < aSheetList.size(); ++ii )
+    {
+        if( aSheetList[ii] != m_sheetList[ii] )
+            return false;
+    }
+
+    // Likewise for bus aliases and buses.  Edited aliases are replaced, not modified.
+    size_t alias_count = 0;
+
+    for( const SCH_SHEET_PATH& sheet : aSheetList )
+    {
+        for( const std::shared_ptr<BUS_ALIAS>& alias : sheet.LastScreen()->GetBusAliases() )
+        {
+            auto it = m_bus_alias_cache.find( alias->GetName() );
+
+            if( it == m_bus_alias_cache.end() || it->second != alias )
+                return false;
+
+            alias_count++;
+        }
+    }
+
+    if( alias_count < m_bus_alias_cache.size() )
+        return false;
+
+    PROF_COUNTER find_stale( "find affected subgraphs" );
+
+    // Find the subgraphs holding or touching a changed item, then the ones they may be linked
+    // to by name, and so on.
+
+    std::unordered_set<CONNECTION_SUBGRAPH*> stale;
+    std::vector<CONNECTION_SUBGRAPH*>        to_visit;
+    std::unordered_set<wxString>             visited_names;
+
+    auto addStale =
+            [&]( CONNECTION_SUBGRAPH* aSubgraph )
+            {
+                if( stale.insert( aSubgraph ).second )
+                    to_visit.push_back( aSubgraph );
+            };
+
+    auto addName =
+            [&]( const wxString& aName )
+            {
+                if( aName.IsEmpty() || !visited_names.insert( aName ).second )
+                    return;
+
+                auto it = m_link_name_to_subgraphs.find( aName );
+
+                if( it != m_link_name_to_subgraphs.end() )
+                {
+                    for( CONNECTION_SUBGRAPH* subgraph : it->second )
+                        addStale( subgraph );
+                }
+            };
+
+    auto addStaleItem =
+            [&]( const SCH_SHEET_PATH& aSheet, SCH_ITEM* aGraphItem )
+            {
+                const auto& item_subgraphs = m_sheet_item_subgraphs[aSheet];
+                auto        it = item_subgraphs.find( aGraphItem );
+
+                if( it != item_subgraphs.end() )
+                    addStale( it->second );
+            };
+
+    // New and changed items, with the items they now add to the graph, and removed items
+    std::unordered_map<SCH_SHEET_PATH,
+                       std::vector<std::pair<SCH_ITEM*, std::vector<SCH_ITEM*>>>> changed;
+    std::unordered_map<SCH_SHEET_PATH, std::vector<SCH_ITEM*>> removed;
+    std::vector<wxString> names;
+
+    // Items which may have been deleted: these must only be used as keys
+    std::unordered_set<SCH_ITEM*> gone;
+
+    for( const SCH_SHEET_PATH& sheet : aSheetList )
+    {
+        SCH_SCREEN*                   screen = sheet.LastScreen();
+        auto&                         known = m_sheet_items[sheet];
+        std::unordered_set<SCH_ITEM*> present;
+
+        for( SCH_ITEM* item : screen->Items() )
+        {
+            if( !item->IsConnectable() )
+                continue;
+
+            present.insert( item );
+
+            auto known_it = known.find( item );
+
+            if( known_it != known.end() && !item->IsConnectivityDirty() )
+                continue;
+
+            // A sheet can be renamed, which renames all the nets inside
+            if( item->Type() == SCH_SHEET_T )
+                return false;
+
+            std::vector<SCH_ITEM*> graph_items = graphItems( item, sheet );
+
+            if( known_it != known.end() )
+            {
+                for( SCH_ITEM* graph_item : known_it->second )
+                {
+                    addStaleItem( sheet, graph_item );
+
+                    // Pins are recreated when the symbol changes
+                    if( std::find( graph_items.begin(), graph_items.end(), graph_item )
+                            == graph_items.end() )
+                    {
+                        gone.insert( graph_item );
+                    }
+                }
+            }
+
+            for( SCH_ITEM* graph_item : graph_items )
+                addStaleItem( sheet, graph_item );
+
+            // Items connected to this one where it is now
+            for( const wxPoint& point : item->GetConnectionPoints() )
+            {
+                for( SCH_ITEM* other : screen->Items().Overlapping( point ) )
+                {
+                    if( other == item || !other->IsConnectable() )
+                        continue;
+
+                    for( SCH_ITEM* graph_item : graphItemsAt( other, sheet, point ) )
+                        addStaleItem( sheet, graph_item );
+
+                    // Labels also connect to the middle of wires (see TestDanglingEnds())
+                    if( isLabel( item ) && other->Type() == SCH_LINE_T )
+                    {
+                        SCH_LINE* line = static_cast<SCH_LINE*>( other );
+
+                        if( TestSegmentHit( point, line->GetStartPoint(), line->GetEndPoint(), 1 ) )
+                            addStaleItem( sheet, line );
+                    }
+                }
+
+                if( item->Type() == SCH_BUS_WIRE_ENTRY_T || item->Type() == SCH_BUS_BUS_ENTRY_T )
+                {
+                    if( SCH_LINE* bus = screen->GetBus( point ) )
+                        addStaleItem( sheet, bus );
+                }
+            }
+
+            if( item->Type() == SCH_LINE_T )
+            {
+                SCH_LINE* line = static_cast<SCH_LINE*>( item );
+
+                for( SCH_ITEM* other : screen->Items().Overlapping( line->GetBoundingBox() ) )
+                {
+                    if( isLabel( other )
+                            && TestSegmentHit( static_cast<SCH_TEXT*>( other )->GetTextPos(),
+                                               line->GetStartPoint(), line->GetEndPoint(), 1 ) )
+                    {
+                        addStaleItem( sheet, other );
+                    }
+                }
+            }
+
+            // Subgraphs the item's drivers may link to
+            names.clear();
+            itemLinkNames( item, sheet, names );
+
+            for( const wxString& name : names )
+                addName( name );
+
+            changed[sheet].emplace_back( item, std::move( graph_items ) );
+        }
+
+        for( const auto& entry : known )
+        {
+            if( !present.count( entry.first ) )
+            {
+                for( SCH_ITEM* graph_item : entry.second )
+                {
+                    addStaleItem( sheet, graph_item );
+                    gone.insert( graph_item );
+                }
+
+                removed[sheet].push_back( entry.first );
+            }
+        }
+    }
+
+    if( changed.empty() && removed.empty() )
+        return true;
+
+    for( size_t ii = 0; ii < to_visit.size(); ++ii )
+    {
+        CONNECTION_SUBGRAPH*  subgraph = to_visit[ii];
+        const SCH_SHEET_PATH& sheet = subgraph->m_sheet;
+
+        auto it = m_subgraph_link_names.find( subgraph );
+
+        if( it != m_subgraph_link_names.end() )
+        {
+            for( const wxString& name : it->second )
+                addName( name );
+        }
+
+        // Bus entries are linked to their bus by position rather than by name
+        for( SCH_ITEM* item : subgraph->m_items )
+        {
+            if( gone.count( item ) )
+                continue;
+
+            if( item->Type() == SCH_BUS_WIRE_ENTRY_T )
+            {
+                auto entry = static_cast<SCH_BUS_WIRE_ENTRY*>( item );
+                addStaleItem( sheet, entry->m_connected_bus_item );
+            }
+            else if( item->Type() == SCH_BUS_BUS_ENTRY_T )
+            {
+                auto entry = static_cast<SCH_BUS_BUS_ENTRY*>( item );
+
+                for( SCH_ITEM* bus : entry->m_connected_bus_items )
+                    addStaleItem( sheet, bus );
+            }
+            else if( item->Type() == SCH_LINE_T && item->GetLayer() == LAYER_BUS )
+            {
+                for( SCH_ITEM* entry : sheet.LastScreen()->Items().Overlapping(
+                                               SCH_BUS_WIRE_ENTRY_T, item->GetBoundingBox() ) )
+                {
+                    if( static_cast<SCH_BUS_WIRE_ENTRY*>( entry )->m_connected_bus_item == item )
+                        addStaleItem( sheet, entry );
+                }
+
+                for( SCH_ITEM* entry : sheet.LastScreen()->Items().Overlapping(
+                                               SCH_BUS_BUS_ENTRY_T, item->GetBoundingBox() ) )
+                    addStaleItem( sheet, entry );
+            }
+        }
+    }
+
+    if( wxLog::IsAllowedTraceMask( ConnProfileMask ) )
+        find_stale.Show();
+
+    wxLogTrace( ConnProfileMask, "%lu of %lu subgraphs affected", stale.size(),
+                m_subgraphs.size() );
+
+    // Not worth the bookkeeping
+    if( stale.size() > m_subgraphs.size() / 2 )
+        return false;
+
+    PROF_COUNTER rebuild( "rebuild affected subgraphs" );
+
+    // From here on, the graph is updated
+
+    for( const auto& it : changed )
+    {
+        auto& known = m_sheet_items[it.first];
+
+        for( const auto& entry : it.second )
+            known[entry.first] = entry.second;
+    }
+
+    for( const auto& it : removed )
+    {
+        auto& known = m_sheet_items[it.first];
+
+        for( SCH_ITEM* item : it.second )
+            known.erase( item );
+    }
+
+    // All the items covered by the stale subgraphs, and those of the changed items
+    std::unordered_map<SCH_SHEET_PATH, std::unordered_set<SCH_ITEM*>> island_items;
+
+    for( CONNECTION_SUBGRAPH* subgraph : stale )
+    {
+        island_items[subgraph->m_sheet].insert( subgraph->m_items.begin(),
+                                                subgraph->m_items.end() );
+    }
+
+    for( const auto& it : changed )
+    {
+        for( const auto& entry : it.second )
+            island_items[it.first].insert( entry.second.begin(), entry.second.end() );
+    }
+
+    // Subgraphs of invisible power pins gather pins from several sheets
+    std::unordered_set<long> stale_codes;
+
+    for( CONNECTION_SUBGRAPH* subgraph : stale )
+        stale_codes.insert( subgraph->m_code );
+
+    for( const auto& it : m_invisible_power_pins )
+    {
+        if( gone.count( it.second ) )
+            continue;
+
+        SCH_CONNECTION* connection = it.second->Connection( it.first );
+
+        if( connection && stale_codes.count( connection->SubgraphCode() ) )
+            island_items[it.first].insert( it.second );
+    }
+
+    // Rebuild them in a graph of their own, which has all it needs since any subgraph these
+    // items may connect to is part of it
+
+    CONNECTION_GRAPH island( m_schematic );
+
+    island.m_sheetList          = aSheetList;
+    island.m_last_net_code      = m_last_net_code;
+    island.m_last_bus_code      = m_last_bus_code;
+    island.m_last_subgraph_code = m_last_subgraph_code;
+
+    // Keep the codes of existing nets
+    island.m_net_name_to_code_map.swap( m_net_name_to_code_map );
+    island.m_bus_name_to_code_map.swap( m_bus_name_to_code_map );
+
+    std::vector<SCH_SHEET_PATH> island_sheets;
+
+    for( const SCH_SHEET_PATH& sheet : aSheetList )
+    {
+        auto island_it = island_items.find( sheet );
+
+        if( island_it == island_items.end() )
+            continue;
+
+        const std::unordered_set<SCH_ITEM*>& graph_items = island_it->second;
+        const auto&                          known = m_sheet_items[sheet];
+        std::vector<SCH_ITEM*>               items;
+
+        // Keep the order of the screen, so that the result matches a full rebuild
+        for( SCH_ITEM* item : sheet.LastScreen()->Items() )
+        {
+            auto known_it = known.find( item );
+
+            if( known_it == known.end() )
+                continue;
+
+            for( SCH_ITEM* graph_item : known_it->second )
+            {
+                if( graph_items.count( graph_item ) )
+                {
+                    items.push_back( item );
+                    break;
+                }
+            }
+        }
+
+        SHEET_GRAPH_ITEMS result;
+
+        island.updateItemConnectivity( sheet, items, result, &graph_items );
+        island_sheets.push_back( sheet );
+
+        island.m_items.insert( island.m_items.end(), result.m_items.begin(),
+                               result.m_items.end() );
+        island.m_invisible_power_pins.insert( island.m_invisible_power_pins.end(),
+                                              result.m_invisible_power_pins.begin(),
+                                              result.m_invisible_power_pins.end() );
+    }
+
+    // Rebuilding the connectivity of an item clears the links made by TestDanglingEnds()
+    for( const SCH_SHEET_PATH& sheet : island_sheets )
+        sheet.LastScreen()->TestDanglingEnds( &sheet );
+
+    island.buildConnectionGraph();
+
+    merge( island, stale );
+
+    if( wxLog::IsAllowedTraceMask( ConnProfileMask ) )
+        rebuild.Show();
+
+    return true;
+}
+
+
+void CONNECTION_GRAPH::merge( CONNECTION_GRAPH& aGraph,
+                              const std::unordered_set<CONNECTION_SUBGRAPH*>& aStale )
+{
+    auto isStale =
+            [&]( const CONNECTION_SUBGRAPH* aSubgraph )
+            {
+                return aStale.count( const_cast<CONNECTION_SUBGRAPH*>( aSubgraph ) ) > 0;
+            };
+
+    auto removeStale =
+            [&]( auto& aVector )
+            {
+                aVector.erase( std::remove_if( aVector.begin(), aVector.end(), isStale ),
+                               aVector.end() );
+            };
+
+    auto removeStaleFromMap =
+            [&]( auto& aMap )
+            {
+                for( auto it = aMap.begin(); it != aMap.end(); )
+                {
+                    removeStale( it->second );
+
+                    if( it->second.empty() )
+                        it = aMap.erase( it );
+                    else
+                        ++it;
+                }
+            };
+
+    std::unordered_set<SCH_ITEM*> stale_items;
+
+    for( CONNECTION_SUBGRAPH* subgraph : aStale )
+    {
+        unindexSubgraph( subgraph );
+
+        for( SCH_ITEM* item : subgraph->m_items )
+        {
+            stale_items.insert( item );
+
+            auto it = m_item_to_subgraph_map.find( item );
+
+            if( it != m_item_to_subgraph_map.end() && it->second == subgraph )
+                m_item_to_subgraph_map.erase( it );
+        }
+    }
+
+    removeStale( m_subgraphs );
+    removeStale( m_driver_subgraphs );
+    removeStaleFromMap( m_sheet_to_subgraphs_map );
+    removeStaleFromMap( m_net_code_to_subgraphs_map );
+    removeStaleFromMap( m_net_name_to_subgraphs_map );
+    removeStaleFromMap( m_global_label_cache );
+    removeStaleFromMap( m_local_label_cache );
+
+    m_items.erase( std::remove_if( m_items.begin(), m_items.end(),
+                                   [&]( SCH_ITEM* aItem )
+                                   {
+                                       return stale_items.count( aItem ) > 0;
+                                   } ),
+                   m_items.end() );
+
+    // The same pin can be on other sheets which were not rebuilt
+    std::set<std::pair<SCH_SHEET_PATH, SCH_PIN*>> rebuilt_pins(
+            aGraph.m_invisible_power_pins.begin(), aGraph.m_invisible_power_pins.end() );
+
+    m_invisible_power_pins.erase( std::remove_if( m_invisible_power_pins.begin(),
+                                                  m_invisible_power_pins.end(),
+                                                  [&]( const auto& aEntry )
+                                                  {
+                                                      return rebuilt_pins.count( aEntry ) > 0;
+                                                  } ),
+                                  m_invisible_power_pins.end() );
+
+    for( CONNECTION_SUBGRAPH* subgraph : aStale )
+        delete subgraph;
+
+    // Take over the new subgraphs; their connections must now refer to this graph
+    for( CONNECTION_SUBGRAPH* subgraph : aGraph.m_subgraphs )
+    {
+        subgraph->m_graph = this;
+
+        for( SCH_ITEM* item : subgraph->m_items )
+        {
+            if( SCH_CONNECTION* connection = item->Connection( subgraph->m_sheet ) )
+                setConnectionGraph( connection, this );
+
+            m_item_to_subgraph_map[item] = subgraph;
+        }
+
+        for( const auto& it : subgraph->m_bus_neighbors )
+            setConnectionGraph( it.first.get(), this );
+
+        for( const auto& it : subgraph->m_bus_parents )
+            setConnectionGraph( it.first.get(), this );
+
+        m_subgraphs.push_back( subgraph );
+        indexSubgraph( subgraph );
+    }
+
+    m_driver_subgraphs.insert( m_driver_subgraphs.end(), aGraph.m_driver_subgraphs.begin(),
+                               aGraph.m_driver_subgraphs.end() );
+
+    auto mergeMap =
+            [&]( auto& aMap, const auto& aOther )
+            {
+                for( const auto& it : aOther )
+                {
+                    auto& vec = aMap[it.first];
+                    vec.insert( vec.end(), it.second.begin(), it.second.end() );
+                }
+            };
+
+    mergeMap( m_sheet_to_subgraphs_map, aGraph.m_sheet_to_subgraphs_map );
+    mergeMap( m_net_code_to_subgraphs_map, aGraph.m_net_code_to_subgraphs_map );
+    mergeMap( m_net_name_to_subgraphs_map, aGraph.m_net_name_to_subgraphs_map );
+    mergeMap( m_global_label_cache, aGraph.m_global_label_cache );
+    mergeMap( m_local_label_cache, aGraph.m_local_label_cache );
+
+    m_items.insert( m_items.end(), aGraph.m_items.begin(), aGraph.m_items.end() );
+    m_invisible_power_pins.insert( m_invisible_power_pins.end(),
+                                   aGraph.m_invisible_power_pins.begin(),
+                                   aGraph.m_invisible_power_pins.end() );
+
+    m_net_name_to_code_map.swap( aGraph.m_net_name_to_code_map );
+    m_bus_name_to_code_map.swap( aGraph.m_bus_name_to_code_map );
+    m_last_net_code      = aGraph.m_last_net_code;
+    m_last_bus_code      = aGraph.m_last_bus_code;
+    m_last_subgraph_code = aGraph.m_last_subgraph_code;
+
+    // The subgraphs are ours now
+    aGraph.m_subgraphs.clear();
+    aGraph.Reset();
+}
+
+
+void CONNECTION_GRAPH::indexSubgraph( CONNECTION_SUBGRAPH* aSubgraph )
+{
+    auto& item_subgraphs = m_sheet_item_subgraphs[aSubgraph->m_sheet];
+
+    for( SCH_ITEM* item : aSubgraph->m_items )
+        item_subgraphs[item] = aSubgraph;
+
+    std::vector<wxString> names;
+
+    for( SCH_ITEM* driver : aSubgraph->m_drivers )
+    {
+        names.push_back( aSubgraph->GetNameForDriver( driver ) );
+
+        // Secondary drivers may be buses with members of their own
+        if( std::shared_ptr<SCH_CONNECTION> c = getDefaultConnection( driver, aSubgraph ) )
+            addConnectionNames( c.get(), names );
+    }
+
+    if( aSubgraph->m_driver_connection )
+        addConnectionNames( aSubgraph->m_driver_connection, names );
+
+    for( SCH_SHEET_PIN* pin : aSubgraph->m_hier_pins )
+    {
+        SCH_SHEET_PATH path = aSubgraph->m_sheet;
+        path.push_back( pin->GetParent() );
+
+        names.push_back( hierLinkName( path, aSubgraph->GetNameForDriver( pin ) ) );
+    }
+
+    for( SCH_HIERLABEL* label : aSubgraph->m_hier_ports )
+        names.push_back( hierLinkName( aSubgraph->m_sheet, aSubgraph->GetNameForDriver( label ) ) );
+
+    std::sort( names.begin(), names.end() );
+    names.erase( std::unique( names.begin(), names.end() ), names.end() );
+
+    for( const wxString& name : names )
+        m_link_name_to_subgraphs[name].insert( aSubgraph );
+
+    m_subgraph_link_names[aSubgraph] = std::move( names );
+}
+
+
+void CONNECTION_GRAPH::unindexSubgraph( CONNECTION_SUBGRAPH* aSubgraph )
+{
+    auto& item_subgraphs = m_sheet_item_subgraphs[aSubgraph->m_sheet];
+
+    for( SCH_ITEM* item : aSubgraph->m_items )
+    {
+        auto it = item_subgraphs.find( item );
+
+        if( it != item_subgraphs.end() && it->second == aSubgraph )
+            item_subgraphs.erase( it );
+    }
+
+    auto names_it = m_subgraph_link_names.find( aSubgraph );
+
+    if( names_it == m_subgraph_link_names.end() )
+        return;
+
+    for( const wxString& name : names_it->second )
+    {
+        auto it = m_link_name_to_subgraphs.find( name );
+
+        if( it == m_link_name_to_subgraphs.end() )
+            continue;
+
+        it->second.erase( aSubgraph );
+
+        if( it->second.empty() )
+            m_link_name_to_subgraphs.erase( it );
+    }
+
+    m_subgraph_link_names.erase( names_it );
+}
+
+
+void CONNECTION_GRAPH::itemLinkNames( SCH_ITEM* aItem, const SCH_SHEET_PATH& aSheet,
+                                      std::vector<wxString>& aNames )
+{
+    if( isLabel( aItem ) )
+    {
+        wxString name = EscapeString( static_cast<SCH_TEXT*>( aItem )->GetShownText(),
+                                      CTX_NETNAME );
+        SCH_CONNECTION connection( aItem, aSheet );
+
+        connection.SetGraph( this );
+        connection.ConfigureFromLabel( name );
+
+        aNames.push_back( name );
+        addConnectionNames( &connection, aNames );
+
+        if( aItem->Type() == SCH_HIER_LABEL_T )
+            aNames.push_back( hierLinkName( aSheet, name ) );
+    }
+    else if( aItem->Type() == SCH_COMPONENT_T )
+    {
+        // The weak names of the pins may also conflict with other nets
+        for( SCH_PIN* pin : static_cast<SCH_COMPONENT*>( aItem )->GetPins( &aSheet ) )
+        {
+            aNames.push_back( pin->GetDefaultNetName( aSheet ) );
+
+            if( pin->IsPowerConnection() )
+                aNames.push_back( pin->GetName() );
+        }
+    }
+}
+
+
 void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
-                                               const std::vector<SCH_ITEM*>& aItemList )
+                                               const std::vector<SCH_ITEM*>& aItemList,
+                                               SHEET_GRAPH_ITEMS& aResult,
+                                               const std::unordered_set<SCH_ITEM*>* aGraphItems )
 {
     std::map< wxPoint, std::vector<SCH_ITEM*> > connection_map;
 
+    // N.B. this can run for several sheets at once, so the map must not be added to here
+    auto* known = aGraphItems ? nullptr : &m_sheet_items.at( aSheet );
+
+    auto skip =
+            [&]( SCH_ITEM* aGraphItem )
+            {
+                return aGraphItems && !aGraphItems->count( aGraphItem );
+            };
+
     for( SCH_ITEM* item : aItemList )
     {
+        if( aGraphItems )
+        {
+            if( item->Type() != SCH_SHEET_T && item->Type() != SCH_COMPONENT_T && skip( item ) )
+                continue;
+        }
+        else
+        {
+            ( *known )[item] = graphItems( item, aSheet );
+        }
+
         std::vector< wxPoint > points = item->GetConnectionPoints();
         item->ConnectedItems( aSheet ).clear();
 
@@ -455,6 +1270,9 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
         {
             for( SCH_SHEET_PIN* pin : static_cast<SCH_SHEET*>( item )->GetPins() )
             {
+                if( skip( pin ) )
+                    continue;
+
                 if( !pin->Connection( aSheet ) )
                     pin->InitializeConnection( aSheet, this );
 
@@ -462,7 +1280,7 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
                 pin->Connection( aSheet )->Reset();
 
                 connection_map[ pin->GetTextPos() ].push_back( pin );
-                m_items.emplace_back( pin );
+                aResult.m_items.emplace_back( pin );
             }
         }
         else if( item->Type() == SCH_COMPONENT_T )
@@ -478,6 +1296,9 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
 
             for( SCH_PIN* pin : component->GetPins( &aSheet ) )
             {
+                if( skip( pin ) )
+                    continue;
+
                 pin->InitializeConnection( aSheet, this );
 
                 wxPoint pos = pin->GetPosition();
@@ -489,15 +1310,15 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
                 // Invisible power pins need to be post-processed later
 
                 if( pin->IsPowerConnection() && !pin->IsVisible() )
-                    m_invisible_power_pins.emplace_back( std::make_pair( aSheet, pin ) );
+                    aResult.m_invisible_power_pins.emplace_back( std::make_pair( aSheet, pin ) );
 
                 connection_map[ pos ].push_back( pin );
-                m_items.emplace_back( pin );
+                aResult.m_items.emplace_back( pin );
             }
         }
         else
         {
-            m_items.emplace_back( item );
+            aResult.m_items.emplace_back( item );
             auto conn = item->InitializeConnection( aSheet, this );
 
             // Set bus/net property here so that the propagation code uses it
@@ -670,68 +1491,125 @@ void CONNECTION_GRAPH::buildConnectionGraph()
             m_bus_alias_cache[ alias->GetName() ] = alias;
     }
 
-    // Build subgraphs from items (on a per-sheet basis)
+    // Build subgraphs from items (on a per-sheet basis).  Like the item connectivity, this is
+    // done for the groups of sheets sharing a screen in parallel, and the subgraphs are then
+    // numbered in the order of the sheets.
+
+    std::vector<SCH_SHEET_PATH>                sheets;
+    std::unordered_map<SCH_SHEET_PATH, size_t> sheet_index;
+    std::vector<std::vector<SCH_ITEM*>>        sheet_items;
+
+    auto addSheet =
+            [&]( const SCH_SHEET_PATH& aSheet ) -> size_t
+            {
+                auto result = sheet_index.emplace( aSheet, sheets.size() );
+
+                if( result.second )
+                {
+                    sheets.push_back( aSheet );
+                    sheet_items.emplace_back();
+                }
+
+                return result.first->second;
+            };
+
+    for( const SCH_SHEET_PATH& sheet : m_sheetList )
+        addSheet( sheet );
 
     for( SCH_ITEM* item : m_items )
     {
         for( const auto& it : item->m_connection_map )
         {
-            const auto sheet = it.first;
-            auto connection = it.second;
+            if( it.second->SubgraphCode() == 0 )
+                sheet_items[addSheet( it.first )].push_back( item );
+        }
+    }
+
+    std::vector<std::vector<CONNECTION_SUBGRAPH*>> sheet_subgraphs( sheets.size() );
 
-            if( connection->SubgraphCode() == 0 )
+    auto buildSubgraphs =
+            [&]( size_t aSheet )
             {
-                auto subgraph = new CONNECTION_SUBGRAPH( this );
+                const SCH_SHEET_PATH& sheet = sheets[aSheet];
 
-                subgraph->m_code = m_last_subgraph_code++;
-                subgraph->m_sheet = sheet;
+                for( SCH_ITEM* item : sheet_items[aSheet] )
+                {
+                    SCH_CONNECTION* connection = item->Connection( sheet );
 
-                subgraph->AddItem( item );
+                    if( connection->SubgraphCode() != 0 )
+                        continue;
 
-                connection->SetSubgraphCode( subgraph->m_code );
-                m_item_to_subgraph_map[item] = subgraph;
+                    auto subgraph = new CONNECTION_SUBGRAPH( this );
 
-                std::list<SCH_ITEM*> members;
+                    // Only used to mark the items visited until the subgraphs are numbered
+                    subgraph->m_code = sheet_subgraphs[aSheet].size() + 1;
+                    subgraph->m_sheet = sheet;
 
-                auto get_items =
-                        [&]( SCH_ITEM* aItem ) -> bool
-                        {
-                            auto* conn = aItem->Connection( sheet );
+                    subgraph->AddItem( item );
 
-                            if( !conn )
-                                conn = aItem->InitializeConnection( sheet, this );
+                    connection->SetSubgraphCode( subgraph->m_code );
 
-                            return ( conn->SubgraphCode() == 0 );
-                        };
+                    std::list<SCH_ITEM*> members;
 
-                std::copy_if( item->ConnectedItems( sheet ).begin(),
-                              item->ConnectedItems( sheet ).end(),
-                              std::back_inserter( members ), get_items );
+                    auto get_items =
+                            [&]( SCH_ITEM* aItem ) -> bool
+                            {
+                                auto* conn = aItem->Connection( sheet );
 
-                for( auto connected_item : members )
-                {
-                    if( connected_item->Type() == SCH_NO_CONNECT_T )
-                        subgraph->m_no_connect = connected_item;
+                                if( !conn )
+                                    conn = aItem->InitializeConnection( sheet, this );
 
-                    auto connected_conn = connected_item->Connection( sheet );
+                                return ( conn->SubgraphCode() == 0 );
+                            };
 
-                    wxASSERT( connected_conn );
+                    std::copy_if( item->ConnectedItems( sheet ).begin(),
+                                  item->ConnectedItems( sheet ).end(),
+                                  std::back_inserter( members ), get_items );
 
-                    if( connected_conn->SubgraphCode() == 0 )
+                    for( auto connected_item : members )
                     {
-                        connected_conn->SetSubgraphCode( subgraph->m_code );
-                        m_item_to_subgraph_map[connected_item] = subgraph;
-                        subgraph->AddItem( connected_item );
+                        if( connected_item->Type() == SCH_NO_CONNECT_T )
+                            subgraph->m_no_connect = connected_item;
 
-                        std::copy_if( connected_item->ConnectedItems( sheet ).begin(),
-                                      connected_item->ConnectedItems( sheet ).end(),
-                                      std::back_inserter( members ), get_items );
+                        auto connected_conn = connected_item->Connection( sheet );
+
+                        wxASSERT( connected_conn );
+
+                        if( connected_conn->SubgraphCode() == 0 )
+                        {
+                            connected_conn->SetSubgraphCode( subgraph->m_code );
+                            subgraph->AddItem( connected_item );
+
+                            std::copy_if( connected_item->ConnectedItems( sheet ).begin(),
+                                          connected_item->ConnectedItems( sheet ).end(),
+                                          std::back_inserter( members ), get_items );
+                        }
                     }
+
+                    subgraph->m_dirty = true;
+                    sheet_subgraphs[aSheet].push_back( subgraph );
                 }
+            };
 
-                subgraph->m_dirty = true;
-                m_subgraphs.push_back( subgraph );
-            }
+    std::vector<std::vector<size_t>> groups = groupSheetsByScreen( sheets );
+
+    THREAD_POOL::Get().ParallelFor( groups.size(),
+            [&]( size_t aGroup )
+            {
+                for( size_t ii : groups[aGroup] )
+                    buildSubgraphs( ii );
+            } );
+
+    for( const std::vector<CONNECTION_SUBGRAPH*>& subgraphs : sheet_subgraphs )
+    {
+        for( CONNECTION_SUBGRAPH* subgraph : subgraphs )
+        {
+            subgraph->m_code = m_last_subgraph_code++;
+
+            for( SCH_ITEM* item : subgraph->m_items )
+                item->Connection( subgraph->m_sheet )->SetSubgraphCode( subgraph->m_code );
+
+            m_subgraphs.push_back( subgraph );
         }
     }
 
@@ -757,12 +1635,6 @@ void CONNECTION_GRAPH::buildConnectionGraph()
 
     // Resolve drivers for subgraphs and propagate connectivity info
 
-    // We don't want to spin up a new thread for fewer than 8 nets (overhead costs)
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            ( m_subgraphs.size() + 3 ) / 4 );
-
-    std::atomic<size_t> nextSubgraph( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
     std::vector<CONNECTION_SUBGRAPH*> dirty_graphs;
 
     std::copy_if( m_subgraphs.begin(), m_subgraphs.end(), std::back_inserter( dirty_graphs ),
@@ -771,76 +1643,61 @@ void CONNECTION_GRAPH::buildConnectionGraph()
                       return candidate->m_dirty;
                   } );
 
-    auto update_lambda = [&nextSubgraph, &dirty_graphs]() -> size_t
+    auto update_lambda = [&dirty_graphs]( size_t subgraphId )
     {
-        for( size_t subgraphId = nextSubgraph++; subgraphId < dirty_graphs.size(); subgraphId = nextSubgraph++ )
-        {
-            auto subgraph = dirty_graphs[subgraphId];
+        auto subgraph = dirty_graphs[subgraphId];
 
-            if( !subgraph->m_dirty )
-                continue;
+        if( !subgraph->m_dirty )
+            return;
 
-            // Special processing for some items
-            for( auto item : subgraph->m_items )
+        // Special processing for some items
+        for( auto item : subgraph->m_items )
+        {
+            switch( item->Type() )
             {
-                switch( item->Type() )
-                {
-                case SCH_NO_CONNECT_T:
-                    subgraph->m_no_connect = item;
-                    break;
-
-                case SCH_BUS_WIRE_ENTRY_T:
-                    subgraph->m_bus_entry = item;
-                    break;
+            case SCH_NO_CONNECT_T:
+                subgraph->m_no_connect = item;
+                break;
 
-                case SCH_PIN_T:
-                {
-                    auto pin = static_cast<SCH_PIN*>( item );
+            case SCH_BUS_WIRE_ENTRY_T:
+                subgraph->m_bus_entry = item;
+                break;
 
-                    if( pin->GetType() == ELECTRICAL_PINTYPE::PT_NC )
-                        subgraph->m_no_connect = item;
+            case SCH_PIN_T:
+            {
+                auto pin = static_cast<SCH_PIN*>( item );
 
-                    break;
-                }
+                if( pin->GetType() == ELECTRICAL_PINTYPE::PT_NC )
+                    subgraph->m_no_connect = item;
 
-                default:
-                    break;
-                }
+                break;
             }
 
-            if( !subgraph->ResolveDrivers() )
-            {
-                subgraph->m_dirty = false;
+            default:
+                break;
             }
-            else
-            {
-                // Now the subgraph has only one driver
-                SCH_ITEM* driver = subgraph->m_driver;
-                SCH_SHEET_PATH sheet = subgraph->m_sheet;
-                SCH_CONNECTION* connection = driver->Connection( sheet );
-
-                connection->ConfigureFromLabel( subgraph->GetNameForDriver( driver ) );
-                connection->SetDriver( driver );
-                connection->ClearDirty();
+        }
 
-                subgraph->m_dirty = false;
-            }
+        if( !subgraph->ResolveDrivers() )
+        {
+            subgraph->m_dirty = false;
         }
+        else
+        {
+            // Now the subgraph has only one driver
+            SCH_ITEM* driver = subgraph->m_driver;
+            SCH_SHEET_PATH sheet = subgraph->m_sheet;
+            SCH_CONNECTION* connection = driver->Connection( sheet );
 
-        return 1;
-    };
+            connection->ConfigureFromLabel( subgraph->GetNameForDriver( driver ) );
+            connection->SetDriver( driver );
+            connection->ClearDirty();
 
-    if( parallelThreadCount == 1 )
-        update_lambda();
-    else
-    {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
+            subgraph->m_dirty = false;
+        }
+    };
 
-        // Finalize the threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
-    }
+    THREAD_POOL::Get().ParallelFor( dirty_graphs.size(), update_lambda );
 
     // Now discard any non-driven subgraphs from further consideration
 
@@ -1498,6 +2355,15 @@ void CONNECTION_GRAPH::buildConnectionGraph()
                 }
             } ),
             m_subgraphs.end() );
+
+    // The absorbed subgraphs are gone, so point their items to the survivors
+    m_item_to_subgraph_map.clear();
+
+    for( CONNECTION_SUBGRAPH* subgraph : m_subgraphs )
+    {
+        for( SCH_ITEM* item : subgraph->m_items )
+            m_item_to_subgraph_map[item] = subgraph;
+    }
 }
 
 
@@ -22,6 +22,8 @@
 #define _CONNECTION_GRAPH_H
 
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <common.h>
@@ -227,7 +229,8 @@ public:
               m_last_net_code( 1 ),
               m_last_bus_code( 1 ),
               m_last_subgraph_code( 1 ),
-              m_schematic( aSchematic )
+              m_schematic( aSchematic ),
+              m_last_recalc_incremental( false )
     {}
 
     ~CONNECTION_GRAPH()
@@ -245,11 +248,23 @@ public:
     /**
      * Updates the connection graph for the given list of sheets.
      *
+     * Unless \a aUnconditional is set (or the IncrementalConnectivity advanced config option is
+     * off), only the subgraphs which may be affected by the items changed since the last update
+     * are rebuilt: the ones holding or touching a changed or removed item, and the ones they
+     * can be linked to by name (labels, power pins, sheet pins and bus members).  Changes which
+     * can't be handled that way, such as a change to the hierarchy, fall back to a full rebuild.
+     *
      * @param aSheetList is the list of possibly modified sheets
      * @param aUnconditional is true if an unconditional full recalculation should be done
      */
     void Recalculate( const SCH_SHEET_LIST& aSheetList, bool aUnconditional = false );
 
+    /**
+     * @return true if the last call to Recalculate() updated the graph incrementally, false
+     * if it rebuilt the whole graph.
+     */
+    bool LastRecalcWasIncremental() const { return m_last_recalc_incremental; }
+
     /**
      * Returns a bus alias pointer for the given name if it exists (from cache)
      *
@@ -345,6 +360,60 @@ private:
 
     SCHEMATIC* m_schematic;     ///< The schematic this graph represents
 
+    bool m_last_recalc_incremental;     ///< Set by Recalculate(), see LastRecalcWasIncremental()
+
+    /// The items of a sheet to add to the graph, as found by updateItemConnectivity()
+    struct SHEET_GRAPH_ITEMS
+    {
+        std::vector<SCH_ITEM*>                           m_items;
+        std::vector<std::pair<SCH_SHEET_PATH, SCH_PIN*>> m_invisible_power_pins;
+    };
+
+    // For each sheet, the connectable items of its screen as of the last update, with the
+    // items each of them added to the graph (itself, or its pins)
+    std::unordered_map<SCH_SHEET_PATH,
+                       std::unordered_map<SCH_ITEM*, std::vector<SCH_ITEM*>>> m_sheet_items;
+
+    // For each sheet, the subgraph of each item of the graph
+    std::unordered_map<SCH_SHEET_PATH,
+                       std::unordered_map<SCH_ITEM*, CONNECTION_SUBGRAPH*>> m_sheet_item_subgraphs;
+
+    // Subgraphs by the names they may be linked to other subgraphs through, and the reverse
+    std::unordered_map<wxString,
+                       std::unordered_set<CONNECTION_SUBGRAPH*>> m_link_name_to_subgraphs;
+
+    std::unordered_map<CONNECTION_SUBGRAPH*, std::vector<wxString>> m_subgraph_link_names;
+
+    /**
+     * Rebuilds the part of the graph affected by the items changed since the last update.
+     *
+     * The affected subgraphs are rebuilt from scratch in a separate graph (so that they go
+     * through exactly the same steps as in a full rebuild), which is then merged into this one.
+     *
+     * @return false if the changes can't be handled incrementally, in which case the graph has
+     *         not been modified and needs a full rebuild.
+     */
+    bool updateIncrementally( const SCH_SHEET_LIST& aSheetList );
+
+    /**
+     * Replaces \a aStale with the subgraphs of \a aGraph, which takes over the same items.
+     * \a aGraph is left empty.
+     */
+    void merge( CONNECTION_GRAPH& aGraph, const std::unordered_set<CONNECTION_SUBGRAPH*>& aStale );
+
+    /// Adds a subgraph to the lookup tables used by updateIncrementally()
+    void indexSubgraph( CONNECTION_SUBGRAPH* aSubgraph );
+
+    /// Removes a subgraph from the lookup tables used by updateIncrementally()
+    void unindexSubgraph( CONNECTION_SUBGRAPH* aSubgraph );
+
+    /**
+     * Collects the names the drivers of a new or changed item could link its subgraph to
+     * others through.
+     */
+    void itemLinkNames( SCH_ITEM* aItem, const SCH_SHEET_PATH& aSheet,
+                        std::vector<wxString>& aNames );
+
     /**
      * Updates the graphical connectivity between items (i.e. where they touch)
      * The items passed in must be on the same sheet.
@@ -367,13 +436,19 @@ private:
      * checks to ensure that the items should actually connect, the items are
      * linked together using ConnectedItems().
      *
-     * As a side effect, items are loaded into m_items for BuildConnectionGraph()
+     * The items to add to m_items for BuildConnectionGraph() are returned in \a aResult.
+     * Sheets which don't share a screen can be updated at the same time.
      *
      * @param aSheet is the path to the sheet of all items in the list
      * @param aItemList is a list of items to consider
+     * @param aResult receives the items to add to the graph
+     * @param aGraphItems if given, only the items of the graph (i.e. the items themselves, or
+     *                    their pins) found in this set are considered
      */
     void updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
-                                 const std::vector<SCH_ITEM*>& aItemList );
+                                 const std::vector<SCH_ITEM*>& aItemList,
+                                 SHEET_GRAPH_ITEMS& aResult,
+                                 const std::unordered_set<SCH_ITEM*>* aGraphItems = nullptr );
 
     /**
      * Generates the connection graph (after all item connectivity has been updated)
@@ -466,7 +466,7 @@ void SCH_EDIT_FRAME::KiwayMailIn( KIWAY_EXPRESS& mail )
         // TODO remove once real-time connectivity is a given
         if( !ADVANCED_CFG::GetCfg().m_realTimeConnectivity || !CONNECTION_GRAPH::m_allowRealTime )
             // Ensure the netlist data is up to date:
-            RecalculateConnections( NO_CLEANUP );
+            RecalculateConnections( NO_CLEANUP, true );
 
         exporter.Format( &formatter, GNL_ALL | GNL_OPT_KICAD );
 
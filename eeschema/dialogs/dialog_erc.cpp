@@ -266,7 +266,7 @@ void DIALOG_ERC::testErc( REPORTER& aReporter )
 
     // The connection graph has a whole set of ERC checks it can run
     aReporter.ReportTail( _( "Checking conflicts...\n" ) );
-    m_parent->RecalculateConnections( NO_CLEANUP );
+    m_parent->RecalculateConnections( NO_CLEANUP, true );
     sch->ConnectionGraph()->RunERC();
 
     // Test is all units of each multiunit component have the same footprint assigned.
@@ -227,6 +227,7 @@ void DIALOG_SYMBOL_REMAP::createProjectSymbolLibTable( REPORTER& aReporter )
             {
                 FILE_OUTPUTFORMATTER formatter( fn.GetFullPath() );
                 prjLibTable.Format( &formatter, 0 );
+                formatter.Finish();
             }
             catch( const IO_ERROR& ioe )
             {
@@ -50,7 +50,7 @@ bool SCH_EDIT_FRAME::WriteNetListFile( int aFormat, const wxString& aFullFileNam
     Schematic().GetSheets().AnnotatePowerSymbols();
 
     // Ensure the netlist data is up to date:
-    RecalculateConnections( NO_CLEANUP );
+    RecalculateConnections( NO_CLEANUP, true );
 
     if( !ReadyToNetlist( false ) )
         return false;
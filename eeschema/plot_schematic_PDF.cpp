@@ -26,6 +26,7 @@
  */
 
 #include <fctsys.h>
+#include <advanced_config.h>
 #include <plotter.h>
 #include <sch_edit_frame.h>
 #include <base_units.h>
@@ -67,6 +68,7 @@ void DIALOG_PLOT_SCHEMATIC::createPDFFile( bool aPlotAll, bool aPlotFrameRef,
     plotter->SetColorMode( getModeColor() );
     plotter->SetCreator( wxT( "Eeschema-PDF" ) );
     plotter->SetTitle( m_parent->GetTitleBlock().GetTitle() );
+    plotter->SetCompressionLevel( ADVANCED_CFG::GetCfg().m_PdfCompressionLevel );
 
     wxString msg;
     wxFileName plotFileName;
@@ -1811,7 +1811,10 @@ void SCH_COMPONENT::Plot( PLOTTER* aPlotter )
         TRANSFORM temp = GetTransform();
         aPlotter->StartBlock( nullptr );
 
+        // The body of the symbol is the same for all its instances with the same orientation
+        aPlotter->StartReusableBlock( m_Pos );
         m_part->Plot( aPlotter, GetUnit(), GetConvert(), m_Pos, temp );
+        aPlotter->EndReusableBlock();
 
         for( SCH_FIELD field : m_Fields )
             field.Plot( aPlotter );
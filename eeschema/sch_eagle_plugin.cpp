@@ -456,6 +456,7 @@ SCH_SHEET* SCH_EAGLE_PLUGIN::Load( const wxString& aFileName, SCHEMATIC* aSchema
         {
             FILE_OUTPUTFORMATTER formatter( fn.GetFullPath() );
             libTable->Format( &formatter, 0 );
+            formatter.Finish();
         }
 
         // Relaod the symbol library table.
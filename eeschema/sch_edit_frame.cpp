@@ -1127,7 +1127,7 @@ void SCH_EDIT_FRAME::UpdateTitle()
 }
 
 
-void SCH_EDIT_FRAME::RecalculateConnections( SCH_CLEANUP_FLAGS aCleanupFlags )
+void SCH_EDIT_FRAME::RecalculateConnections( SCH_CLEANUP_FLAGS aCleanupFlags, bool aFullRebuild )
 {
     SCH_SHEET_LIST list = Schematic().GetSheets();
     PROF_COUNTER   timer;
@@ -1146,7 +1146,9 @@ void SCH_EDIT_FRAME::RecalculateConnections( SCH_CLEANUP_FLAGS aCleanupFlags )
     timer.Stop();
     wxLogTrace( "CONN_PROFILE", "SchematicCleanUp() %0.4f ms", timer.msecs() );
 
-    Schematic().ConnectionGraph()->Recalculate( list, true );
+    // Edits are tracked by the items themselves, but a global cleanup can change anything
+    Schematic().ConnectionGraph()->Recalculate( list,
+                                                aFullRebuild || aCleanupFlags == GLOBAL_CLEANUP );
 }
 
 
@@ -901,8 +901,13 @@ public:
 
     /**
      * Generates the connection data for the entire schematic hierarchy.
+     *
+     * @param aCleanupFlags is the kind of schematic cleanup to perform first.
+     * @param aFullRebuild forces the connection graph to be rebuilt from scratch instead of
+     *                     updating only the edited items.  Consumers that sign off on the
+     *                     connectivity (ERC, netlisting) must set it.
      */
-    void RecalculateConnections( SCH_CLEANUP_FLAGS aCleanupFlags );
+    void RecalculateConnections( SCH_CLEANUP_FLAGS aCleanupFlags, bool aFullRebuild = false );
 
     /**
      * Allows Eeschema to install its preferences panels into the preferences dialog.
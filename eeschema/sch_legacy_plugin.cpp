@@ -1839,6 +1839,8 @@ void SCH_LEGACY_PLUGIN::Save( const wxString& aFileName, SCH_SHEET* aSheet, SCHE
     m_out = &formatter;     // no ownership
 
     Format( aSheet );
+
+    formatter.Finish();
 }
 
 
@@ -3743,6 +3745,7 @@ void SCH_LEGACY_PLUGIN_CACHE::Save( bool aSaveDocFile )
     }
 
     formatter->Print( 0, "#\n#End Library\n" );
+    formatter->Finish();
     formatter.reset();
 
     m_fileModTime = fn.GetModificationTime();
@@ -4251,6 +4254,7 @@ void SCH_LEGACY_PLUGIN_CACHE::saveDocFile()
     }
 
     formatter.Print( 0, "#\n#End Doc Library\n" );
+    formatter.Finish();
 }
 
 
@@ -195,6 +195,7 @@ SCH_SHEET* SCH_ALTIUM_PLUGIN::Load( const wxString& aFileName, SCHEMATIC* aSchem
         {
             FILE_OUTPUTFORMATTER formatter( fn.GetFullPath() );
             libTable->Format( &formatter, 0 );
+            formatter.Finish();
         }
 
         // Relaod the symbol library table.
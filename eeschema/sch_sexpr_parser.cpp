@@ -32,6 +32,7 @@
 #include <wx/tokenzr.h>
 
 #include <common.h>
+#include <kicad_string.h>
 #include <lib_id.h>
 
 #include <class_libentry.h>
@@ -399,7 +400,7 @@ double SCH_SEXPR_PARSER::parseDouble()
 
     errno = 0;
 
-    double fval = strtod( CurText(), &tmp );
+    double fval = StrToDouble( CurText(), &tmp );
 
     if( errno )
     {
@@ -387,7 +387,7 @@ void BACK_ANNOTATE::applyChangelist()
 
     if( !m_dryRun )
     {
-        m_frame->RecalculateConnections( NO_CLEANUP );
+        m_frame->RecalculateConnections( NO_CLEANUP, true );
         m_frame->UpdateNetHighlightStatus();
     }
 
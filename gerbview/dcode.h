@@ -109,6 +109,23 @@ public:
                                              * (shapes with hole )
                                              */
 
+    /**
+     * The bounding box of the aperture macro shape, relative to the flash position, for an
+     * item transform (the translations excepted).  Building the shape of each flash just for
+     * its bounding box is slow: see GERBER_DRAW_ITEM::GetBoundingBox().
+     */
+    struct MACRO_BBOX
+    {
+        bool        m_swapAxis;
+        bool        m_mirrorA;
+        bool        m_mirrorB;
+        wxRealPoint m_drawScale;
+        double      m_rotation;
+        BOX2I       m_bbox;
+    };
+
+    std::vector<MACRO_BBOX> m_MacroBBoxes;  ///< one per item transform the macro is flashed with
+
 public:
     D_CODE( int num_dcode );
     ~D_CODE();
@@ -122,6 +139,7 @@ public:
     void AppendParam( double aValue )
     {
         m_am_params.push_back( aValue );
+        m_MacroBBoxes.clear();
     }
 
     /**
@@ -151,6 +169,7 @@ public:
     void SetMacro( APERTURE_MACRO* aMacro )
     {
         m_Macro = aMacro;
+        m_MacroBBoxes.clear();
     }
 
 
@@ -266,30 +266,7 @@ bool GERBVIEW_FRAME::Read_EXCELLON_File( const wxString& aFullFileName )
         return false;
     }
 
-    layerId = images->AddGbrImage( drill_layer, layerId );
-
-    if( layerId < 0 )
-    {
-        delete drill_layer;
-        ShowInfoBarError( _( "No empty layers to load file into." ) );
-        return false;
-    }
-
-    // Display errors list
-    if( drill_layer->GetMessages().size() > 0 )
-    {
-        HTML_MESSAGE_BOX dlg( this, _( "Error reading EXCELLON drill file" ) );
-        dlg.ListSet( drill_layer->GetMessages() );
-        dlg.ShowModal();
-    }
-
-    if( GetCanvas() )
-    {
-        for( GERBER_DRAW_ITEM* item : drill_layer->GetItems() )
-            GetCanvas()->GetView()->Add( (KIGFX::VIEW_ITEM*) item );
-    }
-
-    return success;
+    return addImageToActiveLayer( drill_layer );
 }
 
 /*
@@ -388,6 +365,8 @@ bool EXCELLON_IMAGE::LoadFile( const wxString & aFullFileName )
     delete m_FileFunction;
     m_FileFunction = new X2_ATTRIBUTE_FILEFUNCTION( dummy );
 
+    BuildItemIndex();
+
     m_InUse = true;
 
     return true;
@@ -266,8 +266,9 @@ bool GERBVIEW_FRAME::loadListOfGerberAndDrillFiles( const wxString& aPath,
     wxString msg;
     WX_STRING_REPORTER reporter( &msg );
 
-    // Create progress dialog (only used if more than 1 file to load
-    std::unique_ptr<WX_PROGRESS_REPORTER> progress = nullptr;
+    // The files to read, and whether each one is a NC drill file
+    std::vector<wxString> fileNames;
+    std::vector<bool>     isDrill;
 
     for( unsigned ii = 0; ii < aFilenameList.GetCount(); ii++ )
     {
@@ -288,72 +289,90 @@ bool GERBVIEW_FRAME::loadListOfGerberAndDrillFiles( const wxString& aPath,
             continue;
         }
 
-        m_lastFileName = filename.GetFullPath();
+        bool drill = aFileType && (*aFileType)[ii] == 1;
 
-        if( !progress && ( aFilenameList.GetCount() > 1 ) )
+        if( !drill && filename.GetExt() == GerberJobFileExtension.c_str() )
         {
-            progress = std::make_unique<WX_PROGRESS_REPORTER>( this,
-                            _( "Loading Gerber files..." ), 1, false );
-            progress->SetMaxProgress( aFilenameList.GetCount() - 1 );
-            progress->Report( wxString::Format( _("Loading %u/%zu %s" ), ii+1,
-                                            aFilenameList.GetCount(), m_lastFileName ) );
+            //We cannot read a gerber job file as a gerber plot file: skip it
+            wxString txt;
+            txt.Printf(
+                _( "<b>A gerber job file cannot be loaded as a plot file</b> <i>%s</i>" ),
+                filename.GetFullName() );
+            success = false;
+            reporter.Report( txt, RPT_SEVERITY_ERROR );
+            continue;
         }
-        else if( progress )
+
+        fileNames.push_back( filename.GetFullPath() );
+        isDrill.push_back( drill );
+    }
+
+    // The files are all read at once, each one into its own image.  The images are then
+    // put on the layers in the order of the list.
+    std::unique_ptr<WX_PROGRESS_REPORTER> progress = nullptr;
+
+    if( fileNames.size() > 1 )
+    {
+        progress = std::make_unique<WX_PROGRESS_REPORTER>( this,
+                        _( "Loading Gerber files..." ), 1, false );
+        progress->SetMaxProgress( fileNames.size() );
+        progress->Report( wxString::Format( _( "Loading %zu files" ), fileNames.size() ) );
+    }
+
+    std::vector<std::unique_ptr<GERBER_FILE_IMAGE>> images =
+            GERBER_FILE_IMAGE_LIST::LoadImages( fileNames, isDrill, progress.get() );
+
+    progress.reset();
+
+    for( size_t ii = 0; ii < images.size(); ii++ )
+    {
+        m_lastFileName = fileNames[ii];
+
+        if( !images[ii] )
         {
-            progress->Report( wxString::Format( _("Loading %u/%zu %s" ), ii+1,
-                                            aFilenameList.GetCount(), m_lastFileName ) );
-            progress->KeepRefreshing();
+            wxString warning;
+            warning << "<b>" << _( "File not found:" ) << "</b><br>"
+                    << m_lastFileName << "<br>";
+            reporter.Report( warning, RPT_SEVERITY_WARNING );
+            success = false;
+            continue;
         }
 
         SetActiveLayer( layer, false );
 
         visibility[ layer ] = true;
 
-        if( aFileType && (*aFileType)[ii] == 1 )
-        {
-            LoadExcellonFiles( filename.GetFullPath() );
-            layer = GetActiveLayer();   // Loading NC drill file changes the active layer
-        }
+        // If the layer contains old gerber or nc drill data, remove it
+        if( GetGbrImage( layer ) )
+            Erase_Current_DrawLayer( false );
+
+        if( !addImageToActiveLayer( images[ii].release() ) )
+            continue;
+
+        if( isDrill[ii] )
+            UpdateFileHistory( m_lastFileName, &m_drillFileHistory );
         else
+            UpdateFileHistory( m_lastFileName );
+
+        layer = getNextAvailableLayer( layer );
+
+        if( layer == NO_AVAILABLE_LAYERS && ii < images.size() - 1 )
         {
-            if( filename.GetExt() == GerberJobFileExtension.c_str() )
+            success = false;
+            reporter.Report( MSG_NO_MORE_LAYER, RPT_SEVERITY_ERROR );
+
+            // Report the name of not loaded files:
+            for( ii += 1; ii < images.size(); ii++ )
             {
-                //We cannot read a gerber job file as a gerber plot file: skip it
-                wxString txt;
-                txt.Printf(
-                    _( "<b>A gerber job file cannot be loaded as a plot file</b> <i>%s</i>" ),
-                    filename.GetFullName() );
-                success = false;
+                filename = fileNames[ii];
+                wxString txt = wxString::Format( MSG_NOT_LOADED, filename.GetFullName() );
                 reporter.Report( txt, RPT_SEVERITY_ERROR );
             }
-            else if( Read_GERBER_File( filename.GetFullPath() ) )
-            {
-                UpdateFileHistory( m_lastFileName );
 
-                layer = getNextAvailableLayer( layer );
-
-                if( layer == NO_AVAILABLE_LAYERS && ii < aFilenameList.GetCount()-1 )
-                {
-                    success = false;
-                    reporter.Report( MSG_NO_MORE_LAYER, RPT_SEVERITY_ERROR );
-
-                    // Report the name of not loaded files:
-                    ii += 1;
-                    while( ii < aFilenameList.GetCount() )
-                    {
-                        filename = aFilenameList[ii++];
-                        wxString txt = wxString::Format( MSG_NOT_LOADED, filename.GetFullName() );
-                        reporter.Report( txt, RPT_SEVERITY_ERROR );
-                    }
-                    break;
-                }
-
-                SetActiveLayer( layer, false );
-            }
+            break;
         }
 
-        if( progress )
-            progress->AdvanceProgress();
+        SetActiveLayer( layer, false );
     }
 
     if( !success )
@@ -19,6 +19,11 @@
 
 #include "gerber_collectors.h"
 
+#include <convert_to_biu.h>
+#include <gbr_layout.h>
+#include <gerber_file_image.h>
+#include <gerber_file_image_list.h>
+
 const KICAD_T GERBER_COLLECTOR::AllItems[] = {
     GERBER_LAYOUT_T,
     GERBER_IMAGE_T,
@@ -60,7 +65,33 @@ void GERBER_COLLECTOR::Collect( EDA_ITEM* aItem, const KICAD_T aScanList[],
     // the Inspect() function.
     SetRefPos( aRefPos );
 
-    aItem->Visit( m_inspector, NULL, m_ScanTypes );
+    bool drawItems = false;
+
+    for( const KICAD_T* p = m_ScanTypes; *p != EOT; ++p )
+        drawItems |= *p == GERBER_DRAW_ITEM_T;
+
+    if( aItem->Type() == GERBER_LAYOUT_T && drawItems )
+    {
+        // Only the items near aRefPos can be hit: take them from the spatial index of each
+        // image rather than visiting all of them.  The margin is the smallest hit test radius
+        // of GERBER_DRAW_ITEM::HitTest().
+        GERBER_FILE_IMAGE_LIST* images = static_cast<GBR_LAYOUT*>( aItem )->GetImagesList();
+
+        for( unsigned layer = 0; layer < images->ImagesMaxCount(); ++layer )
+        {
+            GERBER_FILE_IMAGE* image = images->GetGbrImage( layer );
+
+            if( image == NULL )    // Graphic layer not yet used
+                continue;
+
+            for( GERBER_DRAW_ITEM* item : image->GetItemsAt( aRefPos, Millimeter2iu( 0.01 ) ) )
+                Inspect( item, NULL );
+        }
+    }
+    else
+    {
+        aItem->Visit( m_inspector, NULL, m_ScanTypes );
+    }
 
     // record the length of the primary list before concatenating on to it.
     m_PrimaryLength = m_List.size();
@@ -267,6 +267,48 @@ wxString GERBER_DRAW_ITEM::ShowGBRShape() const
 }
 
 
+EDA_RECT GERBER_DRAW_ITEM::getMacroBoundingBox( D_CODE* aCode ) const
+{
+    double       rotation = m_lyrRotation + m_GerberImageFile->m_ImageRotation;
+    wxPoint      abStart = GetABPosition( m_Start );
+    const BOX2I* relBBox = nullptr;
+
+    // The translations of GetABPosition() don't change the shape, the other parameters do
+    for( const D_CODE::MACRO_BBOX& cached : aCode->m_MacroBBoxes )
+    {
+        if( cached.m_swapAxis == m_swapAxis && cached.m_mirrorA == m_mirrorA
+                && cached.m_mirrorB == m_mirrorB && cached.m_drawScale == m_drawScale
+                && cached.m_rotation == rotation )
+        {
+            relBBox = &cached.m_bbox;
+            break;
+        }
+    }
+
+    if( !relBBox )
+    {
+        // The shape is in absolute (AB) coordinates
+        SHAPE_POLY_SET*    shape = aCode->GetMacro()->GetApertureMacroShape( this, m_Start );
+        D_CODE::MACRO_BBOX cached = { m_swapAxis, m_mirrorA, m_mirrorB, m_drawScale, rotation,
+                                      shape->BBox() };
+
+        cached.m_bbox.Move( -VECTOR2I( abStart ) );
+        aCode->m_MacroBBoxes.push_back( cached );
+        relBBox = &aCode->m_MacroBBoxes.back().m_bbox;
+    }
+
+    BOX2I bb = *relBBox;
+    bb.Move( VECTOR2I( abStart ) );
+
+    // As in APERTURE_MACRO::GetApertureMacroShape(), plus the rounding of GetABPosition()
+    EDA_RECT bbox( wxPoint( 0, 0 ), wxSize( 1, 1 ) );
+    bbox.Move( GetABPosition( wxPoint( bb.Centre().x, bb.Centre().y ) ) );
+    bbox.Inflate( bb.GetWidth() / 2 + 1, bb.GetHeight() / 2 + 1 );
+
+    return bbox;
+}
+
+
 D_CODE* GERBER_DRAW_ITEM::GetDcodeDescr() const
 {
     if( (m_DCode < FIRST_DCODE) || (m_DCode > LAST_DCODE) )
@@ -367,12 +409,8 @@ const EDA_RECT GERBER_DRAW_ITEM::GetBoundingBox() const
     case GBR_SPOT_MACRO:
     {
         if( code )
-        {
-            // Update the shape drawings and the bounding box coordiantes:
-            code->GetMacro()->GetApertureMacroShape( this, m_Start );
-            // now the bounding box is valid:
-            bbox = code->GetMacro()->GetBoundingBox();
-        }
+            bbox = getMacroBoundingBox( code );
+
         break;
     }
 
@@ -386,6 +424,18 @@ const EDA_RECT GERBER_DRAW_ITEM::GetBoundingBox() const
                 bbox.Inflate( bb.GetWidth() / 2, bb.GetHeight() / 2 );
                 bbox.SetOrigin( bb.GetOrigin().x, bb.GetOrigin().y );
             }
+            else
+            {
+                // The polygon is only built when the segment is drawn: until then, use the
+                // ends of the segment and the size of the rectangular pen
+                int xmin = std::min( m_Start.x, m_End.x ) - m_Size.x / 2;
+                int ymin = std::min( m_Start.y, m_End.y ) - m_Size.y / 2;
+                int xmax = std::max( m_Start.x, m_End.x ) - m_Size.x / 2 + m_Size.x;
+                int ymax = std::max( m_Start.y, m_End.y ) - m_Size.y / 2 + m_Size.y;
+
+                bbox = EDA_RECT( wxPoint( xmin, ymin ),
+                                 wxSize( xmax - xmin + 1, ymax - ymin + 1 ) );
+            }
         }
         else
         {
@@ -964,8 +1014,16 @@ double GERBER_DRAW_ITEM::ViewGetLOD( int aLayer, KIGFX::VIEW* aView ) const
         switch( m_Shape )
         {
         case GBR_SPOT_MACRO:
-            size = GetDcodeDescr()->GetMacro()->GetBoundingBox().GetWidth();
+        {
+            D_CODE* code = GetDcodeDescr();
+
+            // The macro shape is no longer built at load time, so its own bounding box
+            // may not be set: use the cached one of the flash
+            if( code )
+                size = getMacroBoundingBox( code ).GetWidth();
+
             break;
+        }
 
         case GBR_ARC:
             size = GetLineLength( m_Start, m_ArcCentre );
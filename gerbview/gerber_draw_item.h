@@ -231,6 +231,15 @@ public:
 
     const EDA_RECT GetBoundingBox() const override;
 
+private:
+    /**
+     * @return the bounding box of a flashed aperture macro.  The macro shape is built only
+     * once per D-code and item transform, and moved to the flash position.
+     */
+    EDA_RECT getMacroBoundingBox( D_CODE* aCode ) const;
+
+public:
+
     void Print( wxDC* aDC, const wxPoint& aOffset, GBR_DISPLAY_OPTIONS* aOptions );
 
     /**
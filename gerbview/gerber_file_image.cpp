@@ -388,6 +388,53 @@ void GERBER_FILE_IMAGE::RemoveAttribute( X2_ATTRIBUTE& aAttribute )
 }
 
 
+void GERBER_FILE_IMAGE::BuildItemIndex()
+{
+    m_itemIndex.RemoveAll();
+
+    for( int ii = 0; ii < (int) m_drawings.size(); ++ii )
+    {
+        GERBER_DRAW_ITEM* item = m_drawings[ii];
+        EDA_RECT          bbox = item->GetBoundingBox();
+
+        // GERBER_DRAW_ITEM::HitTest() accepts points up to a whole pen width from an arc
+        if( item->m_Shape == GBR_ARC )
+            bbox.Inflate( item->m_Size.x / 2 + 1 );
+
+        const int mmin[2] = { bbox.GetX(), bbox.GetY() };
+        const int mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
+
+        m_itemIndex.Insert( mmin, mmax, ii );
+    }
+}
+
+
+std::vector<GERBER_DRAW_ITEM*> GERBER_FILE_IMAGE::GetItemsAt( const wxPoint& aPos,
+                                                              int aMargin ) const
+{
+    const int        mmin[2] = { aPos.x - aMargin, aPos.y - aMargin };
+    const int        mmax[2] = { aPos.x + aMargin, aPos.y + aMargin };
+    std::vector<int> found;
+
+    m_itemIndex.Search( mmin, mmax,
+                        [&found]( const int& aIndex )
+                        {
+                            found.push_back( aIndex );
+                            return true;
+                        } );
+
+    std::sort( found.begin(), found.end() );
+
+    std::vector<GERBER_DRAW_ITEM*> items;
+    items.reserve( found.size() );
+
+    for( int ii : found )
+        items.push_back( m_drawings[ii] );
+
+    return items;
+}
+
+
 SEARCH_RESULT GERBER_FILE_IMAGE::Visit( INSPECTOR inspector, void* testData, const KICAD_T scanTypes[] )
 {
     KICAD_T        stype;
@@ -32,6 +32,7 @@
 #include <gerber_draw_item.h>
 #include <am_primitive.h>
 #include <gbr_netlist_metadata.h>
+#include <geometry/rtree.h>
 
 // An useful macro used when reading gerber files;
 #define IsNumber( x ) ( ( ( (x) >= '0' ) && ( (x) <='9' ) )   \
@@ -115,6 +116,9 @@ class GERBER_FILE_IMAGE : public EDA_ITEM
     GERBER_LAYER       m_GBRLayerParams;                    // hold params for the current gerber layer
     GERBER_DRAW_ITEMS  m_drawings;                              // linked list of Gerber Items to draw
 
+    /// The position in m_drawings of the items, by bounding box; built by BuildItemIndex()
+    RTree<int, int, 2, double> m_itemIndex;
+
 public:
     bool               m_InUse;                                 // true if this image is currently in use
                                                                 // (a file is loaded in it)
@@ -292,6 +296,18 @@ public:
         m_drawings.push_back( aItem );
     }
 
+    /**
+     * Builds the spatial index of the items, used by GetItemsAt().  Called once the file is
+     * read, as the items don't move afterwards.
+     */
+    void BuildItemIndex();
+
+    /**
+     * @return the items which bounding box, inflated by \a aMargin, contains \a aPos, in the
+     * order of the items list.
+     */
+    std::vector<GERBER_DRAW_ITEM*> GetItemsAt( const wxPoint& aPos, int aMargin = 0 ) const;
+
     /**
      * @return the last GERBER_DRAW_ITEM* item of the items list
      */
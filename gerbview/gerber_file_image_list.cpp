@@ -33,8 +33,12 @@
 #include <gerbview_frame.h>
 #include <gerber_file_image.h>
 #include <gerber_file_image_list.h>
+#include <excellon_image.h>
 #include <X2_gerber_attributes.h>
+#include <thread_pool.h>
+#include <widgets/progress_reporter.h>
 
+#include <chrono>
 #include <map>
 
 
@@ -94,11 +98,69 @@ int GERBER_FILE_IMAGE_LIST::AddGbrImage( GERBER_FILE_IMAGE* aGbrImage, int aIdx
         return -1;  // No room
 
     m_GERBER_List[idx] = aGbrImage;
+    aGbrImage->m_GraphicLayer = idx;
 
     return idx;
 }
 
 
+std::vector<std::unique_ptr<GERBER_FILE_IMAGE>> GERBER_FILE_IMAGE_LIST::LoadImages(
+        const std::vector<wxString>& aFileNames, const std::vector<bool>& aIsDrill,
+        PROGRESS_REPORTER* aProgressReporter )
+{
+    std::vector<std::unique_ptr<GERBER_FILE_IMAGE>> images( aFileNames.size() );
+
+    // Held by the calling thread for the whole read, so that the readers don't switch
+    // the locale under each other
+    LOCALE_IO  toggle;
+    TASK_GROUP tasks;
+
+    for( size_t ii = 0; ii < aFileNames.size(); ++ii )
+    {
+        tasks.Run( [&, ii]()
+                   {
+                       std::unique_ptr<GERBER_FILE_IMAGE> image;
+                       bool                               success;
+
+                       // The graphic layer is given when the image is added to a list
+                       if( aIsDrill[ii] )
+                       {
+                           EXCELLON_IMAGE* drill = new EXCELLON_IMAGE( 0 );
+
+                           image.reset( drill );
+                           success = drill->LoadFile( aFileNames[ii] );
+                       }
+                       else
+                       {
+                           image = std::make_unique<GERBER_FILE_IMAGE>( 0 );
+                           success = image->LoadGerberFile( aFileNames[ii] );
+                       }
+
+                       if( success )
+                           images[ii] = std::move( image );
+
+                       if( aProgressReporter )
+                           aProgressReporter->AdvanceProgress();
+                   } );
+    }
+
+    if( aProgressReporter )
+    {
+        while( !tasks.WaitFor( std::chrono::milliseconds( 100 ) ) )
+        {
+            aProgressReporter->KeepRefreshing();
+
+            if( aProgressReporter->IsCancelled() )
+                tasks.Cancel();
+        }
+    }
+
+    tasks.Wait();
+
+    return images;
+}
+
+
 void GERBER_FILE_IMAGE_LIST::DeleteAllImages()
 {
     for( unsigned idx = 0; idx < m_GERBER_List.size(); ++idx )
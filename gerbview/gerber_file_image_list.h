@@ -25,6 +25,7 @@
 #ifndef GERBER_FILE_IMAGE_LIST_H
 #define GERBER_FILE_IMAGE_LIST_H
 
+#include <memory>
 #include <vector>
 #include <set>
 #include <unordered_map>
@@ -54,6 +55,7 @@
  */
 
 class GERBER_FILE_IMAGE;
+class PROGRESS_REPORTER;
 
 /**
  * @brief GERBER_FILE_IMAGE_LIST is a helper class to handle a list of GERBER_FILE_IMAGE files
@@ -77,13 +79,26 @@ public:
 
     /**
      * Add a GERBER_FILE_IMAGE* at index aIdx
-     * or at the first free location if aIdx < 0
+     * or at the first free location if aIdx < 0, which becomes its graphic layer
      * @param aGbrImage = the image to add
      * @param aIdx = the location to use ( 0 ... GERBER_DRAWLAYERS_COUNT-1 )
      * @return true if the index used, or -1 if no room to add image
      */
     int AddGbrImage( GERBER_FILE_IMAGE* aGbrImage, int aIdx );
 
+    /**
+     * Reads a set of Gerber and NC drill files at once, each into its own image, on the
+     * THREAD_POOL.  The images are not added to a list: this is left to the caller, which
+     * gives them their graphic layer.
+     * @param aFileNames = the full names of the files to read
+     * @param aIsDrill = true for each file which is a NC drill file, false for a Gerber file
+     * @param aProgressReporter = if not null, advanced once per file read and kept refreshed
+     * while waiting for the files
+     * @return the images, in the order of the files (nullptr for a file which can't be read)
+     */
+    static std::vector<std::unique_ptr<GERBER_FILE_IMAGE>> LoadImages(
+            const std::vector<wxString>& aFileNames, const std::vector<bool>& aIsDrill,
+            PROGRESS_REPORTER* aProgressReporter = nullptr );
 
     /**
      * remove all loaded data in list, and delete all images. Memory is freed
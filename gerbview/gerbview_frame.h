@@ -208,6 +208,13 @@ private:
                                         const wxArrayString& aFilenameList,
                                         const std::vector<int>* aFileType = nullptr );
 
+    /**
+     * Puts \a aImage, read from a Gerber or NC drill file, on the active layer, which must
+     * be empty, adds its items to the view and shows the messages of the reader if any.
+     * @return false if the image can't be added (it is then deleted).
+     */
+    bool addImageToActiveLayer( GERBER_FILE_IMAGE* aImage );
+
 public:
     GERBVIEW_FRAME( KIWAY* aKiway, wxWindow* aParent );
     ~GERBVIEW_FRAME();
@@ -30,6 +30,7 @@
 #include <gerbview_frame.h>
 #include <gerber_file_image.h>
 #include <gerber_file_image_list.h>
+#include <excellon_image.h>
 #include <view/view.h>
 
 #include <html_messagebox.h>
@@ -42,7 +43,6 @@ bool GERBVIEW_FRAME::Read_GERBER_File( const wxString& GERBER_FullFileName )
     wxString msg;
 
     int layer = GetActiveLayer();
-    GERBER_FILE_IMAGE_LIST* images = GetImagesList();
     GERBER_FILE_IMAGE* gerber = GetGbrImage( layer );
 
     if( gerber != NULL )
@@ -64,13 +64,28 @@ bool GERBVIEW_FRAME::Read_GERBER_File( const wxString& GERBER_FullFileName )
         return false;
     }
 
-    images->AddGbrImage( gerber, layer );
+    return addImageToActiveLayer( gerber );
+}
+
+
+bool GERBVIEW_FRAME::addImageToActiveLayer( GERBER_FILE_IMAGE* aImage )
+{
+    wxString msg;
+    bool     isDrill = dynamic_cast<EXCELLON_IMAGE*>( aImage ) != nullptr;
+
+    if( GetImagesList()->AddGbrImage( aImage, GetActiveLayer() ) < 0 )
+    {
+        delete aImage;
+        ShowInfoBarError( _( "No empty layers to load file into." ) );
+        return false;
+    }
 
     // Display errors list
-    if( gerber->GetMessages().size() > 0 )
+    if( aImage->GetMessages().size() > 0 )
     {
-        HTML_MESSAGE_BOX dlg( this, _("Errors") );
-        dlg.ListSet(gerber->GetMessages());
+        HTML_MESSAGE_BOX dlg( this, isDrill ? _( "Error reading EXCELLON drill file" )
+                                            : _( "Errors" ) );
+        dlg.ListSet( aImage->GetMessages() );
         dlg.ShowModal();
     }
 
@@ -79,9 +94,9 @@ bool GERBVIEW_FRAME::Read_GERBER_File( const wxString& GERBER_FullFileName )
      * or has missing definitions,
      * warn the user:
      */
-    if( gerber->GetItemsCount() && gerber->m_Has_MissingDCode )
+    if( !isDrill && aImage->GetItemsCount() && aImage->m_Has_MissingDCode )
     {
-        if( !gerber->m_Has_DCode )
+        if( !aImage->m_Has_DCode )
             msg = _("Warning: this file has no D-Code definition\n"
                     "Therefore the size of some items is undefined");
         else
@@ -93,13 +108,13 @@ bool GERBVIEW_FRAME::Read_GERBER_File( const wxString& GERBER_FullFileName )
 
     if( GetCanvas() )
     {
-        if( gerber->m_ImageNegative )
+        if( aImage->m_ImageNegative )
         {
             // TODO: find a way to handle negative images
             // (maybe convert geometry into positives?)
         }
 
-        for( auto item : gerber->GetItems() )
+        for( auto item : aImage->GetItems() )
             GetCanvas()->GetView()->Add( (KIGFX::VIEW_ITEM*) item );
     }
 
@@ -111,8 +126,6 @@ bool GERBVIEW_FRAME::Read_GERBER_File( const wxString& GERBER_FullFileName )
 // size of a single line of text from a gerber file.
 // warning: some files can have *very long* lines, so the buffer must be large.
 #define GERBER_BUFZ 1000000
-// A large buffer to store one line
-static char lineBuffer[GERBER_BUFZ+1];
 
 bool GERBER_FILE_IMAGE::LoadGerberFile( const wxString& aFullFileName )
 {
@@ -135,6 +148,11 @@ bool GERBER_FILE_IMAGE::LoadGerberFile( const wxString& aFullFileName )
 
     wxString msg;
 
+    // The line buffer belongs to this read, so that several files can be read at once.
+    // It is only kept while reading.
+    std::vector<char> buffer( GERBER_BUFZ + 1 );
+    char*             lineBuffer = buffer.data();
+
     while( true )
     {
         if( fgets( lineBuffer, GERBER_BUFZ, m_Current_File ) == NULL )
@@ -219,6 +237,8 @@ bool GERBER_FILE_IMAGE::LoadGerberFile( const wxString& aFullFileName )
 
     fclose( m_Current_File );
 
+    BuildItemIndex();
+
     m_InUse = true;
 
     return true;
@@ -142,6 +142,41 @@ public:
      */
     bool m_DebugZoneFiller;
 
+    /**
+     * Re-run the incremental DRC tests around each edit
+     */
+    bool m_RealTimeDRC;
+
+    /**
+     * Refill the zones (and zone layers) affected by each edit
+     */
+    bool m_RealTimeZoneFill;
+
+    /**
+     * Keep zone fills in an on-disk cache and reuse them when they are still valid
+     */
+    bool m_ZoneFillCache;
+
+    /**
+     * Keep a binary snapshot next to saved boards and load it instead when the board is unchanged
+     */
+    bool m_BoardSnapshot;
+
+    /**
+     * Cap on the number of threads of the shared thread pool (0 for one per core)
+     */
+    int m_MaxWorkerThreads;
+
+    /**
+     * Rebuild only the affected part of the schematic connection graph after an edit
+     */
+    bool m_IncrementalConnectivity;
+
+    /**
+     * zlib compression level of the PDF plots, from 0 (fastest) to 9 (smallest files)
+     */
+    int m_PdfCompressionLevel;
+
 private:
     ADVANCED_CFG();
 
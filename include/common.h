@@ -83,6 +83,21 @@ public:
     wxString AsString() const;
     wxString AsLegacyTimestampString() const;
 
+    /**
+     * @return the same as AsString(), without going through a wxString, for file output.
+     */
+    std::string AsStdString() const;
+
+    /**
+     * Copies the 16 bytes of the UUID to \a aBytes, for binary files.
+     */
+    void GetBytes( uint8_t aBytes[16] ) const;
+
+    /**
+     * @return the KIID of the 16 bytes written by GetBytes().
+     */
+    static KIID FromBytes( const uint8_t aBytes[16] );
+
     /**
      * Change an existing time stamp based UUID into a true UUID.
      *
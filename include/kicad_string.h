@@ -108,6 +108,19 @@ std::string EscapedUTF8( wxString aString );
  */
 wxString EscapedHTML( const wxString& aString );
 
+/**
+ * Convert the decimal number at the start of \a aText to a double, as strtod() does in the
+ * "C" locale, whatever the current locale is.  Thread safe, and does not allocate for numbers
+ * of up to 19 significant digits with a decimal exponent of at most 22.
+ *
+ * Leading white space is skipped.  Hexadecimal numbers, infinities and NaNs are not accepted.
+ *
+ * @param aEnd if not NULL, receives a pointer past the last character used, or \a aText if
+ *             there is no number.
+ * @return the number, and sets errno to ERANGE if it is out of the range of a double.
+ */
+double StrToDouble( const char* aText, char** aEnd );
+
 /**
  * Read one line line from \a aFile.
  *
@@ -24,8 +24,9 @@
 #include <cstddef>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
-#include <stack>
+#include <vector>
 
 #include <base_units.h>
 
@@ -241,6 +242,17 @@ public:
         return operator==( *v2 );
     }
 
+    /**
+     * Returns the value to its undefined state.  Unlike assigning a fresh VALUE this keeps
+     * the string's buffer, so recycled values don't need to reallocate it.
+     */
+    void Clear()
+    {
+        m_type = VT_UNDEFINED;
+        m_valueDbl = 0;
+        m_valueStr.clear();
+    }
+
 private:
     VAR_TYPE_T  m_type;
     double      m_valueDbl;
@@ -258,9 +270,22 @@ public:
 };
 
 
+/**
+ * The evaluation state of an expression: the value stack and the scratch values pushed on it.
+ *
+ * Both live in fixed-size buffers inside the context so that running an expression doesn't
+ * touch the heap.  Scratch values are recycled on each UCODE::Run(); should an expression
+ * need more of them than the pool holds, the overflow is heap-allocated.
+ */
 class CONTEXT
 {
 public:
+    CONTEXT() :
+        m_stackPtr( 0 ),
+        m_valuesUsed( 0 )
+    {
+    }
+
     virtual ~CONTEXT()
     {
         for( VALUE* value : m_ownedValues )
@@ -269,6 +294,13 @@ public:
 
     VALUE* AllocValue()
     {
+        if( m_valuesUsed < VALUE_POOL_SIZE )
+        {
+            VALUE* value = &m_valuePool[ m_valuesUsed++ ];
+            value->Clear();
+            return value;
+        }
+
         VALUE* value = new VALUE();
         m_ownedValues.push_back( value );
         return value;
@@ -276,27 +308,46 @@ public:
 
     void Push( VALUE* v )
     {
-        m_stack.push( v );
+        if( m_stackPtr >= STACK_SIZE )
+        {
+            ReportError( _( "Expression too complex" ) );
+            return;
+        }
+
+        m_stack[ m_stackPtr++ ] = v;
     }
 
     VALUE* Pop()
     {
-        if( m_stack.size() == 0 )
+        if( m_stackPtr == 0 )
         {
             ReportError( _( "Malformed expression" ) );
             return AllocValue();
         }
 
-        VALUE* value = m_stack.top();
-        m_stack.pop();
-        return value;
+        return m_stack[ --m_stackPtr ];
     }
 
     int SP() const
     {
-        return m_stack.size();
+        return m_stackPtr;
     };
 
+    /**
+     * Empties the stack and recycles all scratch values.  Values previously returned by
+     * AllocValue() (and hence the result of the previous UCODE::Run()) become invalid.
+     */
+    void Reset()
+    {
+        m_stackPtr = 0;
+        m_valuesUsed = 0;
+
+        for( VALUE* value : m_ownedValues )
+            delete value;
+
+        m_ownedValues.clear();
+    }
+
     void SetErrorCallback( std::function<void( const wxString& aMessage, int aOffset )> aCallback )
     {
         m_errorCallback = std::move( aCallback );
@@ -307,8 +358,14 @@ public:
     const ERROR_STATUS& GetError() const { return m_errorStatus; }
 
 private:
+    static const int STACK_SIZE = 64;
+    static const int VALUE_POOL_SIZE = 16;
+
+    VALUE*              m_stack[STACK_SIZE];
+    int                 m_stackPtr;
+    VALUE               m_valuePool[VALUE_POOL_SIZE];
+    int                 m_valuesUsed;
     std::vector<VALUE*> m_ownedValues;
-    std::stack<VALUE*>  m_stack;
     ERROR_STATUS        m_errorStatus;
 
     std::function<void( const wxString& aMessage, int aOffset )> m_errorCallback;
@@ -325,9 +382,21 @@ public:
         m_ucode.push_back(uop);
     }
 
+    /**
+     * Evaluates the code.
+     *
+     * @return the result, which is owned by \a ctx and only valid until its next use.
+     */
     VALUE* Run( CONTEXT* ctx );
     wxString Dump() const;
 
+    /**
+     * Optimisation pass run once the code has been generated: folds constant subexpressions,
+     * drops the operands of && and || which can't change the result, and interns string
+     * literals.  Leaves the code untouched if it isn't a well-formed expression.
+     */
+    void Optimize();
+
     virtual std::unique_ptr<VAR_REF> CreateVarRef( const wxString& var, const wxString& field )
     {
         return nullptr;
@@ -375,11 +444,13 @@ public:
     wxString Format() const;
 
 private:
+    friend class UCODE;
+
     int                      m_op;
 
     FUNC_CALL_REF            m_func;
     std::unique_ptr<VAR_REF> m_ref;
-    std::unique_ptr<VALUE>   m_value;
+    std::shared_ptr<VALUE>   m_value;     // shared between interned literals
 };
 
 class TOKENIZER
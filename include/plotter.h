@@ -32,6 +32,11 @@
 #ifndef PLOT_COMMON_H_
 #define PLOT_COMMON_H_
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <math/box2.h>
 #include <gr_text.h>
@@ -42,6 +47,7 @@ class COLOR_SETTINGS;
 class SHAPE_POLY_SET;
 class SHAPE_LINE_CHAIN;
 class GBR_NETLIST_METADATA;
+class TASK_GROUP;
 
 /**
  * Enum PlotFormat
@@ -485,6 +491,24 @@ public:
      */
     virtual void EndBlock( void* aData ) {}
 
+    /**
+     * Starts a group of drawing items which is likely to be plotted again, unchanged, in other
+     * places of the file (the fixed part of the worksheet of each page, the symbols or the
+     * footprints used several times...).  Plotters able to define some content once and to
+     * reference it (PDF) emit the identical groups only once.  The group is ended by
+     * EndReusableBlock(); groups can't be nested.
+     * for most of plotters: do nothing
+     * @param aAnchor is the position the items of the group are relative to: the groups whose
+     * items are the same relative to their anchor are identical
+     */
+    virtual void StartReusableBlock( const wxPoint& aAnchor ) {}
+
+    /**
+     * Ends a group of drawing items started by StartReusableBlock().
+     * for most of plotters: do nothing
+     */
+    virtual void EndReusableBlock() {}
+
 
 protected:
     // These are marker subcomponents
@@ -849,14 +873,8 @@ protected:
 class PDF_PLOTTER : public PSLIKE_PLOTTER
 {
 public:
-    PDF_PLOTTER() :
-            pageTreeHandle( 0 ),
-            fontResDictHandle( 0 ),
-            pageStreamHandle( 0 ),
-            streamLengthHandle( 0 ),
-            workFile( nullptr )
-    {
-    }
+    PDF_PLOTTER();
+    ~PDF_PLOTTER();
 
     virtual PLOT_FORMAT GetPlotterType() const override
     {
@@ -918,8 +936,41 @@ public:
     virtual void PlotImage( const wxImage& aImage, const wxPoint& aPos,
                             double aScaleFactor ) override;
 
+    /**
+     * A reusable block is recorded as a form XObject in the coordinates of its anchor, and
+     * painted translated to the anchor.  The blocks with the same content share the same form,
+     * emitted once in the file.
+     */
+    virtual void StartReusableBlock( const wxPoint& aAnchor ) override;
+    virtual void EndReusableBlock() override;
+
+    /**
+     * Sets the zlib compression level of the streams, from 0 (stored, fastest) to 9 (smallest
+     * file, the default).
+     */
+    void SetCompressionLevel( int aLevel ) { m_compressionLevel = aLevel; }
+    int GetCompressionLevel() const { return m_compressionLevel; }
+
 
 protected:
+    /// A drawing operation of a page, recorded while the page is plotted and replayed by the
+    /// renderer of the page
+    typedef std::function<void( PDF_PLOTTER& )> PAGE_OP;
+
+    /// A page, rendered and compressed on the thread pool while the next pages are plotted,
+    /// then written in the file in the order the pages were closed
+    struct PDF_PAGE
+    {
+        int                          handle;        ///< The page object
+        int                          streamHandle;  ///< The content stream of the page
+        wxSize                       sizeMils;
+        std::unique_ptr<PDF_PLOTTER> renderer;      ///< With the settings of the page
+        std::vector<PAGE_OP>         ops;
+        std::string                  content;       ///< Compressed, once done is set
+        std::vector<std::string>     forms;         ///< Compressed forms painted as /Fm<index>
+        std::atomic<bool>            done;
+    };
+
     /// convert a wxString unicode string to a char string compatible with the accepted
     /// string PDF format (convert special chars and non ascii7 chars)
     std::string encodeStringForPlotter( const wxString& aUnicode ) override;
@@ -928,16 +979,60 @@ protected:
     int allocPdfObject();
     int startPdfObject(int handle = -1);
     void closePdfObject();
-    int startPdfStream(int handle = -1);
-    void closePdfStream();
+
+    /// Opens the temporary file where the content of a stream is accumulated
+    void startPdfStream();
+
+    /// Closes the current stream
+    /// @return its (uncompressed) content
+    std::string closePdfStream();
+
+    /// Writes the stream object \a aHandle, of the already compressed \a aData
+    void writePdfStream( int aHandle, const std::string& aData, const std::string& aDict = "" );
+
+    /// @return the pen width SetCurrentLineWidth() would set for \a aWidth
+    int resolvePenWidth( int aWidth ) const;
+
+    /// Records an operation of the page being plotted
+    void recordOp( PAGE_OP aOp ) { m_page->ops.push_back( std::move( aOp ) ); }
+
+    /// @return a plotter with the settings of this one, to render the page being started
+    std::unique_ptr<PDF_PLOTTER> newPageRenderer() const;
+
+    /// Renders the operations of \a aPage; runs on the thread pool, in the renderer of the page
+    void renderPage( PDF_PAGE& aPage, int aCompressionLevel );
+
+    /// Writes the rendered pages in order, waiting for them to be rendered if \a aWait
+    /// is set, otherwise stopping at the first one which isn't
+    void writeRenderedPages( bool aWait );
+
     int pageTreeHandle;		 /// Handle to the root of the page tree object
     int fontResDictHandle;	 /// Font resource dictionary
     std::vector<int> pageHandles;/// Handles to the page objects
-    int pageStreamHandle;	 /// Handle of the page content object
-    int streamLengthHandle;      /// Handle to the deferred stream length
     wxString workFilename;
     FILE* workFile;  	         /// Temporary file to costruct the stream before zipping
     std::vector<long> xrefTable; /// The PDF xref offset table
+
+    int      m_compressionLevel;
+
+    bool     m_inBlock;
+    wxPoint  m_blockPageOffset;         ///< The plot offset of the page, before the block
+    int      m_blockPagePenWidth;       ///< The pen width of the page, before the block
+    DPOINT   m_blockTranslation;        ///< From the coordinates of the block to the page ones
+
+    // Rendering a page
+    FILE*    m_pageWorkFile;            ///< The page stream while a reusable block is rendered
+    wxString m_blockFilename;           ///< Temporary file of the blocks, reused for each one
+    FILE*    m_blockFile;
+    std::vector<std::string>             m_pageForms;   ///< The forms painted on the page
+    std::unordered_map<std::string, int> m_pageFormIndices;
+
+    std::unique_ptr<PDF_PAGE>              m_page;        ///< The page being plotted
+    std::deque<std::unique_ptr<PDF_PAGE>>  m_pages;       ///< Not yet written pages
+    std::unordered_map<std::string, int>   m_formHandles; ///< Form XObjects, by content
+
+    // Last, so that the rendering tasks are finished before the pages are destroyed
+    std::unique_ptr<TASK_GROUP> m_renderTasks;
 };
 
 class SVG_PLOTTER : public PSLIKE_PLOTTER
@@ -1427,6 +1522,29 @@ protected:
     std::vector<APERTURE> m_apertures; // The list of available apertures
     int     m_currentApertureIdx;      // The index of the current aperture in m_apertures
 
+    /// What tells an aperture from another: its type, size and attribute
+    struct APERTURE_KEY
+    {
+        APERTURE::APERTURE_TYPE m_Type;
+        wxSize                  m_Size;
+        int                     m_ApertureAttribute;
+
+        bool operator==( const APERTURE_KEY& aOther ) const
+        {
+            return m_Type == aOther.m_Type && m_Size == aOther.m_Size
+                   && m_ApertureAttribute == aOther.m_ApertureAttribute;
+        }
+    };
+
+    struct APERTURE_KEY_HASH
+    {
+        size_t operator()( const APERTURE_KEY& aKey ) const;
+    };
+
+    // The index in m_apertures of each aperture, so that a board with thousands of apertures
+    // doesn't search the list for each item
+    std::unordered_map<APERTURE_KEY, int, APERTURE_KEY_HASH> m_apertureIndex;
+
     bool    m_gerberUnitInch;          // true if the gerber units are inches, false for mm
     int     m_gerberUnitFmt;           // number of digits in mantissa.
                                        // usually 6 in Inches and 5 or 6  in mm
@@ -247,6 +247,71 @@ public:
 };
 
 
+/**
+ * MAPPED_FILE_LINE_READER
+ * is a LINE_READER that maps a whole file into memory and returns lines in place, without
+ * copying them into a line buffer.
+ *
+ * The mapping is private and writable: the nul terminating the current line temporarily
+ * replaces the first byte of the next line, and is put back by the next ReadLine().  The
+ * returned line is therefore only valid until the next call.  Where the file cannot be
+ * mapped, it is read into memory instead.
+ */
+class MAPPED_FILE_LINE_READER : public LINE_READER
+{
+protected:
+    char*   m_data;         ///< the file contents
+    size_t  m_size;         ///< no. bytes in m_data
+    size_t  m_ndx;          ///< offset of the next line in m_data
+    bool    m_mapped;       ///< m_data is a memory mapping, else it is m_readData
+    char    m_savedChar;    ///< byte of m_data at m_ndx replaced by the nul of the last line
+    bool    m_saved;        ///< m_savedChar must be put back
+    char*   m_ownLine;      ///< the line buffer of the LINE_READER, for the last line
+
+    std::vector<char> m_readData;
+
+    void restore()
+    {
+        if( m_saved )
+        {
+            m_data[m_ndx] = m_savedChar;
+            m_saved = false;
+        }
+    }
+
+public:
+
+    /**
+     * Constructor MAPPED_FILE_LINE_READER
+     * opens @a aFileName and maps it into memory.
+     *
+     * @param aFileName is the name of the file to open and to use for error reporting purposes.
+     * @param aStartingLineNumber is the initial line number to report on error.
+     * @param aMaxLineLength is the maximum supported line length.
+     *
+     * @throw IO_ERROR if @a aFileName cannot be opened.
+     */
+    MAPPED_FILE_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber = 0,
+            unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX );
+
+    ~MAPPED_FILE_LINE_READER();
+
+    char* ReadLine() override;
+
+    /**
+     * Function Rewind
+     * goes back to the start of the file and resets the line number back to zero.
+     */
+    void Rewind()
+    {
+        restore();
+        m_ndx = 0;
+        m_lineNum = 0;
+    }
+};
+
+
 /**
  * STRING_LINE_READER
  * is a LINE_READER that reads from a multiline 8 bit wide std::string
@@ -307,6 +372,7 @@ public:
 
 
 #define OUTPUTFMTBUFZ    500        ///< default buffer size for any OUTPUT_FORMATTER
+#define FILE_OUTPUTFMTBUFZ  65536   ///< bytes a FILE_OUTPUTFORMATTER holds before writing them
 
 /**
  * OUTPUTFORMATTER
@@ -332,6 +398,9 @@ class OUTPUTFORMATTER
     int sprint( const char* fmt, ... );
     int vprint( const char* fmt,  va_list ap );
 
+    /// vprint() for the formats with only plain %s, %d, %c and %% conversions, without printf
+    int plainPrint( const char* fmt, va_list ap );
+
 
 protected:
     OUTPUTFORMATTER( int aReserve = OUTPUTFMTBUFZ, char aQuoteChar = '"' ) :
@@ -472,7 +541,7 @@ public:
      */
     void StripUseless();
 
-    const std::string& GetString()
+    const std::string& GetString() const
     {
         return m_mystring;
     }
@@ -508,13 +577,25 @@ public:
 
     ~FILE_OUTPUTFORMATTER();
 
+    /**
+     * Function Finish
+     * writes what is still buffered and closes the file.  Nothing can be written after this.
+     * Without it, the file is closed by the destructor, which can't report errors.
+     * @throw IO_ERROR if the file cannot be written.
+     */
+    void Finish();
+
 protected:
     //-----<OUTPUTFORMATTER>------------------------------------------------
     void write( const char* aOutBuf, int aCount ) override;
     //-----</OUTPUTFORMATTER>-----------------------------------------------
 
+    /// Writes the buffered output to the file.
+    void flush();
+
     FILE*       m_fp;               ///< takes ownership
     wxString    m_filename;
+    std::string m_pending;          ///< output not written yet, up to FILE_OUTPUTFMTBUFZ bytes
 };
 
 
@@ -0,0 +1,182 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TASK_GROUP;
+
+
+/**
+ * THREAD_POOL
+ * is the set of worker threads shared by everything which runs work in parallel, so that
+ * concurrent jobs don't oversubscribe the cores and don't each pay for starting threads.
+ *
+ * Each worker has its own task queue.  A task queued from a worker goes to that worker's
+ * queue and is run last-in first-out; tasks queued from other threads go to a shared queue.
+ * An idle worker takes from the shared queue, then steals the oldest task of another worker.
+ *
+ * The number of workers is set by the MaxWorkerThreads advanced config option (0, the
+ * default, uses one per core).
+ *
+ * Work is normally submitted through a TASK_GROUP or ParallelFor() rather than directly.
+ */
+class THREAD_POOL
+{
+public:
+    /**
+     * @return the shared pool, started on first use.
+     */
+    static THREAD_POOL& Get();
+
+    /**
+     * Creates a pool with \a aWorkers threads (one per core when 0).
+     */
+    explicit THREAD_POOL( size_t aWorkers = 0 );
+    ~THREAD_POOL();
+
+    THREAD_POOL( const THREAD_POOL& ) = delete;
+    THREAD_POOL& operator=( const THREAD_POOL& ) = delete;
+
+    /**
+     * @return the number of worker threads.
+     */
+    size_t GetWorkerCount() const { return m_workers.size(); }
+
+    /**
+     * @return the number of tasks worth splitting a job into: the workers plus the calling
+     *         thread, which helps while it waits.
+     */
+    size_t GetConcurrency() const { return m_workers.size() + 1; }
+
+    /**
+     * Calls \a aFunc( ii ) for each \a ii in [0, \a aCount), on the workers and the calling
+     * thread, and returns once all the calls are done.  Indices are handed out one by one,
+     * so the calls may vary in length.
+     *
+     * @param aGroup if given, no new indices are handed out once it is cancelled.
+     */
+    void ParallelFor( size_t aCount, const std::function<void( size_t )>& aFunc,
+                      TASK_GROUP* aGroup = nullptr );
+
+    /**
+     * Queues \a aTask.  Prefer TASK_GROUP::Run(), which allows waiting on the task.
+     */
+    void Submit( std::function<void()> aTask );
+
+    /**
+     * Runs one queued task on the calling thread, if there is one.  Used by threads waiting
+     * for tasks to finish, so that a wait from a worker can't starve the pool.
+     * @return true if a task was run.
+     */
+    bool RunPendingTask();
+
+private:
+    struct WORKER_QUEUE
+    {
+        std::mutex                        m_mutex;
+        std::deque<std::function<void()>> m_tasks;
+    };
+
+    void workerLoop( size_t aIndex );
+
+    bool popTask( size_t aIndex, std::function<void()>& aTask );
+
+    std::vector<std::thread>                   m_workers;
+    std::vector<std::unique_ptr<WORKER_QUEUE>> m_queues;        // one per worker
+    WORKER_QUEUE                               m_sharedQueue;
+
+    std::mutex                                 m_wakeMutex;
+    std::condition_variable                    m_wake;
+    std::atomic<size_t>                        m_pending;       // queued, not yet started
+    bool                                       m_stopping;
+};
+
+
+/**
+ * TASK_GROUP
+ * runs tasks on a THREAD_POOL and waits for them as a whole.
+ *
+ * Cancel() stops tasks which haven't started yet from running; the running ones can poll
+ * IsCancelled() to stop early.  If a task throws, the group is cancelled and the exception
+ * is rethrown by Wait().
+ *
+ * The destructor waits for the tasks still running.
+ */
+class TASK_GROUP
+{
+public:
+    explicit TASK_GROUP( THREAD_POOL& aPool = THREAD_POOL::Get() );
+    ~TASK_GROUP();
+
+    TASK_GROUP( const TASK_GROUP& ) = delete;
+    TASK_GROUP& operator=( const TASK_GROUP& ) = delete;
+
+    THREAD_POOL& GetPool() const { return m_pool; }
+
+    void Run( std::function<void()> aTask );
+
+    /**
+     * Waits for all the tasks of the group, running queued tasks on the calling thread
+     * meanwhile.
+     */
+    void Wait();
+
+    /**
+     * Waits up to \a aTimeout for the tasks of the group, without running any of them on the
+     * calling thread.  Meant for the UI thread, which has to keep the progress reporting
+     * alive while it waits.
+     * @return true if all the tasks are done (call Wait() to get their exception, if any).
+     */
+    bool WaitFor( std::chrono::milliseconds aTimeout );
+
+    void Cancel() { m_cancelled = true; }
+
+    bool IsCancelled() const { return m_cancelled; }
+
+private:
+    friend class THREAD_POOL;
+
+    void taskDone( std::exception_ptr aException );
+
+    THREAD_POOL&            m_pool;
+    std::atomic<bool>       m_cancelled;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_done;
+    size_t                  m_running;      // submitted and not finished
+    std::exception_ptr      m_exception;
+};
+
+#endif // THREAD_POOL_H
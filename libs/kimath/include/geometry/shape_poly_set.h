@@ -28,6 +28,7 @@
 
 #include <cstdio>
 #include <deque>                        // for deque
+#include <functional>
 #include <iosfwd>                       // for string, stringstream
 #include <memory>
 #include <set>                          // for set
@@ -170,6 +171,19 @@ class SHAPE_POLY_SET : public SHAPE
                 return m_vertices.size();
             }
 
+            const VECTOR2I& GetVertex( int index ) const
+            {
+                return m_vertices[ index ];
+            }
+
+            void GetTriangleIndices( int index, int& a, int& b, int& c ) const
+            {
+                const TRI& tri = m_triangles[ index ];
+                a = tri.a;
+                b = tri.b;
+                c = tri.c;
+            }
+
             void Move( const VECTOR2I& aVec )
             {
                 for( auto& vertex : m_vertices )
@@ -684,6 +698,12 @@ class SHAPE_POLY_SET : public SHAPE
             return m_triangulatedPolys[aIndex].get();
         }
 
+        /**
+         * Adopts a triangulation built elsewhere (ie: read back from a cache) as the cached
+         * triangulation of the set.  The caller is responsible for it matching the polygons.
+         */
+        void SetTriangulation( std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>& aPolys );
+
         const SHAPE_LINE_CHAIN& COutline( int aIndex ) const
         {
             return m_polys[aIndex][0];
@@ -967,6 +987,55 @@ class SHAPE_POLY_SET : public SHAPE
             Inflate( -aAmount, aCircleSegmentsCount, aCornerStrategy );
         }
 
+        /**
+         * Tiled, multi-threaded versions of BooleanSubtract(), BooleanIntersection() and
+         * Inflate() for very large polygon sets (a board-sized ground pour, for instance).
+         *
+         * The set is cut into a grid of tiles.  Each tile, plus an overlap margin wide enough
+         * for the operation to be exact inside the tile, is processed on its own (see
+         * SetParallelFor()) and the results are then merged back together.  Neighbouring tiles are cut along the
+         * same axis-aligned lines, so their seams coincide exactly and vanish in the merge.
+         *
+         * Sets with fewer than \a aMinVertices vertices (counting both operands) just use the
+         * plain operation.
+         */
+        void TiledBooleanSubtract( const SHAPE_POLY_SET& b, POLYGON_MODE aFastMode,
+                                   int aMinVertices = TILED_MIN_VERTICES );
+
+        void TiledBooleanIntersection( const SHAPE_POLY_SET& b, POLYGON_MODE aFastMode,
+                                       int aMinVertices = TILED_MIN_VERTICES );
+
+        void TiledInflate( int aAmount, int aCircleSegmentsCount,
+                           CORNER_STRATEGY aCornerStrategy = ROUND_ALL_CORNERS,
+                           int aMinVertices = TILED_MIN_VERTICES );
+
+        void TiledDeflate( int aAmount, int aCircleSegmentsCount,
+                           CORNER_STRATEGY aCornerStrategy = ROUND_ALL_CORNERS,
+                           int aMinVertices = TILED_MIN_VERTICES )
+        {
+            TiledInflate( -aAmount, aCircleSegmentsCount, aCornerStrategy, aMinVertices );
+        }
+
+        ///> Below this many vertices a tiled operation isn't worth the cutting and merging
+        static const int TILED_MIN_VERTICES = 20000;
+
+        ///> Runs aFunc( 0 ) ... aFunc( aCount - 1 ), on as many threads as it sees fit
+        typedef void (*PARALLEL_FOR)( size_t aCount, const std::function<void( size_t )>& aFunc );
+
+        ///> Returns the number of threads a PARALLEL_FOR runs its loop on
+        typedef size_t (*WORKER_COUNT)();
+
+        /**
+         * Sets the function the tiled operations run their tiles with.  kimath has no thread
+         * pool of its own (the shared one is in common, which depends on kimath), so the
+         * application installs it; until then the tiles are processed on the calling thread.
+         *
+         * @param aParallelFor is the parallel loop, or nullptr to process the tiles serially.
+         * @param aWorkerCount gives the number of threads of \a aParallelFor, which sets the
+         *                     number of tiles.  If nullptr, a single thread is assumed.
+         */
+        static void SetParallelFor( PARALLEL_FOR aParallelFor, WORKER_COUNT aWorkerCount );
+
         /**
          * Performs outline inflation/deflation, using round corners.  Polygons can have holes,
          * and/or linked holes with main outlines.  The resulting polygons are laso polygons with
@@ -1308,6 +1377,16 @@ class SHAPE_POLY_SET : public SHAPE
         void booleanOp( ClipperLib::ClipType aType, const SHAPE_POLY_SET& aShape,
                         const SHAPE_POLY_SET& aOtherShape, POLYGON_MODE aFastMode );
 
+        /**
+         * Runs \a aOp on each tile of the set (see TiledInflate()) and merges the results.
+         * @param aMargin is the overlap each tile needs for \a aOp to be exact inside it
+         * @param aOp is called with the part of the set within the (overlapping) tile and the
+         *            bounds of that tile; it must only use the part of any other operand
+         *            within those bounds
+         */
+        void tiledOp( int aMargin, POLYGON_MODE aFastMode,
+                      const std::function<void( SHAPE_POLY_SET&, const BOX2I& )>& aOp );
+
         /**
          * containsSingle function
          * Checks whether the point aP is inside the aSubpolyIndex-th polygon of the polyset. If
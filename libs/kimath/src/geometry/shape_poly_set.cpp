@@ -530,6 +530,206 @@ void SHAPE_POLY_SET::BooleanIntersection( const SHAPE_POLY_SET& a,
 }
 
 
+// Constant initialized, so that it can be set from the static initializers of other modules
+static SHAPE_POLY_SET::PARALLEL_FOR s_parallelFor = nullptr;
+static SHAPE_POLY_SET::WORKER_COUNT s_workerCount = nullptr;
+
+
+void SHAPE_POLY_SET::SetParallelFor( PARALLEL_FOR aParallelFor, WORKER_COUNT aWorkerCount )
+{
+    s_parallelFor = aParallelFor;
+    s_workerCount = aWorkerCount;
+}
+
+
+/**
+ * Runs aFunc( 0 ) ... aFunc( aCount - 1 ) with the installed parallel loop, if any.
+ */
+static void parallelFor( size_t aCount, const std::function<void( size_t )>& aFunc )
+{
+    if( s_parallelFor )
+    {
+        s_parallelFor( aCount, aFunc );
+        return;
+    }
+
+    for( size_t ii = 0; ii < aCount; ++ii )
+        aFunc( ii );
+}
+
+
+/**
+ * Returns the part of aSet inside aRect.  Outlines and holes which can't reach the rectangle
+ * are dropped before clipping, so that cutting a huge set into many tiles doesn't cost a full
+ * pass over the set per tile.
+ */
+static SHAPE_POLY_SET clipToRect( const SHAPE_POLY_SET& aSet, const BOX2I& aRect,
+                                  SHAPE_POLY_SET::POLYGON_MODE aFastMode )
+{
+    SHAPE_POLY_SET candidates;
+    SHAPE_POLY_SET rect;
+    SHAPE_POLY_SET result;
+
+    for( int ii = 0; ii < aSet.OutlineCount(); ++ii )
+    {
+        const SHAPE_LINE_CHAIN& outline = aSet.COutline( ii );
+
+        if( !outline.BBox().Intersects( aRect ) )
+            continue;
+
+        int idx = candidates.AddOutline( outline );
+
+        for( int jj = 0; jj < aSet.HoleCount( ii ); ++jj )
+        {
+            const SHAPE_LINE_CHAIN& hole = aSet.CHole( ii, jj );
+
+            if( hole.BBox().Intersects( aRect ) )
+                candidates.AddHole( hole, idx );
+        }
+    }
+
+    if( candidates.IsEmpty() )
+        return result;
+
+    rect.NewOutline();
+    rect.Append( aRect.GetX(), aRect.GetY() );
+    rect.Append( aRect.GetRight(), aRect.GetY() );
+    rect.Append( aRect.GetRight(), aRect.GetBottom() );
+    rect.Append( aRect.GetX(), aRect.GetBottom() );
+
+    result.BooleanIntersection( candidates, rect, aFastMode );
+    return result;
+}
+
+
+void SHAPE_POLY_SET::tiledOp( int aMargin, POLYGON_MODE aFastMode,
+                              const std::function<void( SHAPE_POLY_SET&, const BOX2I& )>& aOp )
+{
+    if( IsEmpty() )
+        return;
+
+    // Enough tiles to keep all the workers busy even when some tiles turn out to be empty
+    int   threads = std::max<int>( 1, s_workerCount ? s_workerCount() : 1 );
+    int   grid = std::max( 2, KiROUND( std::ceil( std::sqrt( 2.0 * threads ) ) ) );
+    BOX2I area = BBox( aMargin );
+
+    // Tile boundaries.  Each one is shared by both of its neighbours so that they cut the
+    // set along exactly the same line.
+    auto split =
+            [&]( int aStart, int aSize, int aIndex ) -> int
+            {
+                return aStart + (int) ( (int64_t) aSize * aIndex / grid );
+            };
+
+    std::vector<SHAPE_POLY_SET> tiles( grid * grid );
+
+    parallelFor( tiles.size(),
+            [&]( size_t aTile )
+            {
+                int   col = (int) aTile % grid;
+                int   row = (int) aTile / grid;
+                BOX2I tile;
+
+                tile.SetOrigin( split( area.GetX(), area.GetWidth(), col ),
+                                split( area.GetY(), area.GetHeight(), row ) );
+                tile.SetEnd( split( area.GetX(), area.GetWidth(), col + 1 ),
+                             split( area.GetY(), area.GetHeight(), row + 1 ) );
+
+                BOX2I overlap = tile;
+                overlap.Inflate( aMargin );
+
+                SHAPE_POLY_SET piece = clipToRect( *this, overlap, PM_FAST );
+
+                if( piece.IsEmpty() )
+                    return;
+
+                aOp( piece, overlap );
+
+                tiles[aTile] = clipToRect( piece, tile, PM_FAST );
+            } );
+
+    // Stitch neighbouring tiles together, pairwise, until only one is left
+    for( size_t step = 1; step < tiles.size(); step *= 2 )
+    {
+        std::vector<size_t> pairs;
+
+        for( size_t ii = 0; ii + step < tiles.size(); ii += 2 * step )
+            pairs.push_back( ii );
+
+        parallelFor( pairs.size(),
+                [&]( size_t aPair )
+                {
+                    SHAPE_POLY_SET& lhs = tiles[ pairs[aPair] ];
+                    SHAPE_POLY_SET& rhs = tiles[ pairs[aPair] + step ];
+
+                    if( lhs.IsEmpty() )
+                        std::swap( lhs, rhs );
+                    else if( !rhs.IsEmpty() )
+                        lhs.BooleanAdd( rhs, step * 2 >= tiles.size() ? aFastMode : PM_FAST );
+
+                    rhs.RemoveAllContours();
+                } );
+    }
+
+    *this = tiles[0];
+}
+
+
+void SHAPE_POLY_SET::TiledBooleanSubtract( const SHAPE_POLY_SET& b, POLYGON_MODE aFastMode,
+                                           int aMinVertices )
+{
+    if( TotalVertices() + b.TotalVertices() < aMinVertices )
+    {
+        BooleanSubtract( b, aFastMode );
+        return;
+    }
+
+    tiledOp( 0, aFastMode,
+             [&]( SHAPE_POLY_SET& aTile, const BOX2I& aBounds )
+             {
+                 aTile.BooleanSubtract( clipToRect( b, aBounds, PM_FAST ), PM_FAST );
+             } );
+}
+
+
+void SHAPE_POLY_SET::TiledBooleanIntersection( const SHAPE_POLY_SET& b, POLYGON_MODE aFastMode,
+                                               int aMinVertices )
+{
+    if( TotalVertices() + b.TotalVertices() < aMinVertices )
+    {
+        BooleanIntersection( b, aFastMode );
+        return;
+    }
+
+    tiledOp( 0, aFastMode,
+             [&]( SHAPE_POLY_SET& aTile, const BOX2I& aBounds )
+             {
+                 aTile.BooleanIntersection( clipToRect( b, aBounds, PM_FAST ), PM_FAST );
+             } );
+}
+
+
+void SHAPE_POLY_SET::TiledInflate( int aAmount, int aCircleSegmentsCount,
+                                   CORNER_STRATEGY aCornerStrategy, int aMinVertices )
+{
+    if( TotalVertices() < aMinVertices )
+    {
+        Inflate( aAmount, aCircleSegmentsCount, aCornerStrategy );
+        return;
+    }
+
+    // A corner can reach out by up to the miter limit (see Inflate()) times the amount, and
+    // everything within that distance of a tile must be in the tile's piece.
+    int reach = aCornerStrategy == ALLOW_ACUTE_CORNERS ? 10 : 2;
+
+    tiledOp( std::abs( aAmount ) * reach + 1, PM_FAST,
+             [&]( SHAPE_POLY_SET& aTile, const BOX2I& aBounds )
+             {
+                 aTile.Inflate( aAmount, aCircleSegmentsCount, aCornerStrategy );
+             } );
+}
+
+
 void SHAPE_POLY_SET::InflateWithLinkedHoles( int aFactor, int aCircleSegmentsCount,
                                              POLYGON_MODE aFastMode )
 {
@@ -2027,6 +2227,15 @@ void SHAPE_POLY_SET::CacheTriangulation( bool aPartition )
 }
 
 
+void SHAPE_POLY_SET::SetTriangulation(
+        std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>& aPolys )
+{
+    m_triangulatedPolys = std::move( aPolys );
+    m_triangulationValid = true;
+    m_hash = checksum();
+}
+
+
 MD5_HASH SHAPE_POLY_SET::checksum() const
 {
     MD5_HASH hash;
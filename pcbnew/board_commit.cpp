@@ -32,6 +32,10 @@
 #include <tools/pcb_tool_base.h>
 #include <tools/pcb_actions.h>
 #include <connectivity/connectivity_data.h>
+#include <drc/drc_engine.h>
+#include <tools/drc_tool.h>
+#include <advanced_config.h>
+#include <zone_filler.h>
 
 #include <functional>
 using namespace std::placeholders;
@@ -92,10 +96,51 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
     std::set<EDA_ITEM*> savedModules;
     SELECTION_TOOL*     selTool = m_toolMgr->GetTool<SELECTION_TOOL>();
     bool                itemsDeselected = false;
+    bool                realtimeDRC = !m_editModules && ADVANCED_CFG::GetCfg().m_RealTimeDRC;
+    bool                realtimeFill = !m_editModules && ADVANCED_CFG::GetCfg().m_RealTimeZoneFill;
+    std::vector<EDA_RECT> dirtyAreas;
+    std::vector<std::pair<EDA_RECT, LSET>> dirtyFillAreas;
 
     if( Empty() )
         return;
 
+    auto addDirtyArea =
+            [&]( BOARD_ITEM* aItem )
+            {
+                if( realtimeDRC )
+                    dirtyAreas.push_back( aItem->GetBoundingBox() );
+
+                if( realtimeFill )
+                {
+                    LSET layers = aItem->GetLayerSet();
+
+                    // Footprints carry pads on any copper layer, and the board outline clips
+                    // the fills on all of them
+                    if( aItem->Type() == PCB_MODULE_T || aItem->IsOnLayer( Edge_Cuts ) )
+                        layers = LSET::AllCuMask();
+
+                    dirtyFillAreas.emplace_back( aItem->GetBoundingBox(), layers );
+                }
+            };
+
+    // Collect the areas the online DRC has to re-check (and the zone filler to refill) now, as
+    // the copies and the removed items may be gone by the time they run
+    if( realtimeDRC || realtimeFill )
+    {
+        for( COMMIT_LINE& ent : m_changes )
+        {
+            BOARD_ITEM* boardItem = static_cast<BOARD_ITEM*>( ent.m_item );
+
+            if( boardItem->Type() == PCB_MARKER_T || boardItem->Type() == PCB_NETINFO_T )
+                continue;
+
+            addDirtyArea( boardItem );
+
+            if( ent.m_copy )
+                addDirtyArea( static_cast<BOARD_ITEM*>( ent.m_copy ) );
+        }
+    }
+
     for( COMMIT_LINE& ent : m_changes )
     {
         int changeType = ent.m_type & CHT_TYPE;
@@ -290,6 +335,26 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
         }
     }
 
+    // Refill the zone layers touched by the change before the ratsnest is rebuilt, so that it
+    // takes the new fills into account
+    if( realtimeFill && !dirtyFillAreas.empty() )
+    {
+        ZONE_FILLER                  filler( board, nullptr );
+        std::vector<ZONE_CONTAINER*> refilledZones;
+
+        if( PCB_EDIT_FRAME* editFrame = dynamic_cast<PCB_EDIT_FRAME*>( frame ) )
+            filler.SetFillCache( editFrame->GetZoneFillCache() );
+
+        if( filler.FillIncremental( dirtyFillAreas, refilledZones ) )
+        {
+            for( ZONE_CONTAINER* zone : refilledZones )
+            {
+                connectivity->Update( zone );
+                view->Update( zone );
+            }
+        }
+    }
+
     if ( !m_editModules )
     {
         size_t num_changes = m_changes.size();
@@ -309,6 +374,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
 
                 auto boardItem = static_cast<BOARD_ITEM*>( ent.m_item );
 
+                if( realtimeDRC )
+                    dirtyAreas.push_back( boardItem->GetBoundingBox() );
+
                 if( aCreateUndoEntry )
                 {
                     ITEM_PICKER itemWrapper( nullptr, boardItem, UNDO_REDO::CHANGED );
@@ -326,6 +394,16 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
         }
     }
 
+    // Netclass assignments may have changed, so memoized rule resolutions can't be trusted
+    if( board->GetDesignSettings().m_DRCEngine )
+        board->GetDesignSettings().m_DRCEngine->ClearConstraintCache();
+
+    if( realtimeDRC && !dirtyAreas.empty() )
+    {
+        if( DRC_TOOL* drcTool = m_toolMgr->GetTool<DRC_TOOL>() )
+            drcTool->RunIncrementalTests( dirtyAreas );
+    }
+
     if( !m_editModules && aCreateUndoEntry )
         frame->SaveCopyInUndoList( undoList, UNDO_REDO::UNSPECIFIED );
 
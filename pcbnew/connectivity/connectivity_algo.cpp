@@ -29,10 +29,10 @@
 #include <geometry/geometry_utils.h>
 #include <board_commit.h>
 
-#include <thread>
+#include <thread_pool.h>
+#include <atomic>
 #include <mutex>
 #include <algorithm>
-#include <future>
 
 #ifdef PROFILE
 #include <profile.h>
@@ -203,13 +203,9 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
 #ifdef PROFILE
     PROF_COUNTER garbage_collection( "garbage-collection" );
 #endif
-    std::vector<CN_ITEM*> garbage;
-    garbage.reserve( 1024 );
-
-    m_itemList.RemoveInvalidItems( garbage );
-
-    for( auto item : garbage )
-        delete item;
+    // The ratsnest must take the anchors of all the nets again once they have moved
+    if( m_itemList.RemoveInvalidItems() )
+        std::fill( m_dirtyNets.begin(), m_dirtyNets.end(), true );
 
 #ifdef PROFILE
     garbage_collection.Show();
@@ -226,20 +222,27 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
         m_progressReporter->KeepRefreshing();
     }
 
+    // The connections found by each thread
+    std::vector<std::vector<CN_LIST::CONNECTION>> connections;
+
     if( m_itemList.IsDirty() )
     {
-        size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+        THREAD_POOL& pool = THREAD_POOL::Get();
+        size_t       parallelThreadCount = std::min<size_t>( pool.GetWorkerCount(),
                 ( dirtyItems.size() + 7 ) / 8 );
 
         std::atomic<size_t> nextItem( 0 );
-        std::vector<std::future<size_t>> returns( parallelThreadCount );
+        TASK_GROUP          tasks( pool );
+
+        connections.resize( std::max<size_t>( parallelThreadCount, 1 ) );
 
         auto conn_lambda = [&nextItem, &dirtyItems]
-                            ( CN_LIST* aItemList, PROGRESS_REPORTER* aReporter) -> size_t
+                            ( CN_LIST* aItemList, PROGRESS_REPORTER* aReporter,
+                              std::vector<CN_LIST::CONNECTION>* aConnections ) -> size_t
         {
             for( size_t i = nextItem++; i < dirtyItems.size(); i = nextItem++ )
             {
-                CN_VISITOR visitor( dirtyItems[i] );
+                CN_VISITOR visitor( dirtyItems[i], *aConnections );
                 aItemList->FindNearby( dirtyItems[i], visitor );
 
                 if( aReporter )
@@ -250,33 +253,42 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
         };
 
         if( parallelThreadCount <= 1 )
-            conn_lambda( &m_itemList, m_progressReporter );
+            conn_lambda( &m_itemList, m_progressReporter, &connections[0] );
         else
         {
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-                returns[ii] = std::async( std::launch::async, conn_lambda,
-                        &m_itemList, m_progressReporter );
-
             for( size_t ii = 0; ii < parallelThreadCount; ++ii )
             {
-                // Here we balance returns with a 100ms timeout to allow UI updating
-                std::future_status status;
-                do
-                {
-                    if( m_progressReporter )
-                        m_progressReporter->KeepRefreshing();
+                std::vector<CN_LIST::CONNECTION>* found = &connections[ii];
 
-                    status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-                } while( status != std::future_status::ready );
+                tasks.Run(
+                        [&, found]()
+                        {
+                            conn_lambda( &m_itemList, m_progressReporter, found );
+                        } );
             }
+
+            // Here we wait with a 100ms timeout to allow UI updating
+            while( !tasks.WaitFor( std::chrono::milliseconds( 100 ) ) )
+            {
+                if( m_progressReporter )
+                    m_progressReporter->KeepRefreshing();
+            }
+
+            tasks.Wait();
         }
 
         if( m_progressReporter )
             m_progressReporter->KeepRefreshing();
     }
 
+    m_itemList.UpdateConnections( connections );
+
 #ifdef PROFILE
-        search_basic.Show();
+    search_basic.Show();
+    std::cerr << "search-basic: " << m_itemList.Size() << " items, "
+              << m_itemList.AnchorArena().Size() << " anchors, "
+              << m_itemList.Connections().size() / 2 << " connections, "
+              << m_itemList.MemoryUsage() / 1024 << " kB" << std::endl;
 #endif
 
     m_itemList.ClearDirtyFlags();
@@ -302,87 +314,161 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
 {
     bool withinAnyNet = ( aMode != CSM_PROPAGATE );
 
-    std::deque<CN_ITEM*> Q;
-    std::set<CN_ITEM*> item_set;
-
     CLUSTERS clusters;
 
     if( m_itemList.IsDirty() )
         searchConnections();
 
-    auto addToSearchList = [&item_set, withinAnyNet, aSingleNet, aTypes] ( CN_ITEM *aItem )
-    {
-        if( withinAnyNet && aItem->Net() <= 0 )
-            return;
+#ifdef PROFILE
+    PROF_COUNTER search_clusters( "search-clusters" );
+#endif
 
-        if( !aItem->Valid() )
-            return;
+    // The items that pass the filters, and their nets, by item index
+    const int         count = m_itemList.IndexCount();
+    std::vector<char> member( count, 0 );
+    std::vector<int>  nets( count, -1 );
 
-        if( aSingleNet >=0 && aItem->Net() != aSingleNet )
-            return;
+    for( CN_ITEM* item : m_itemList )
+    {
+        if( withinAnyNet && item->Net() <= 0 )
+            continue;
 
-        bool found = false;
+        if( !item->Valid() )
+            continue;
 
-        for( int i = 0; aTypes[i] != EOT; i++ )
+        if( aSingleNet >= 0 && item->Net() != aSingleNet )
+            continue;
+
+        for( int j = 0; aTypes[j] != EOT; j++ )
         {
-            if( aItem->Parent()->Type() == aTypes[i] )
+            if( item->Parent()->Type() == aTypes[j] )
             {
-                found = true;
+                member[item->Index()] = 1;
+                nets[item->Index()] = item->Net();
                 break;
             }
         }
+    }
 
-        if( !found )
-            return;
+    // Connected components by a lock-free union-find over the item indices.  Roots are always
+    // linked to the smaller root, so concurrent unions can't make a cycle.
+    std::unique_ptr<std::atomic<int>[]> parent( new std::atomic<int>[count] );
 
-        aItem->SetVisited( false );
+    for( int i = 0; i < count; i++ )
+        parent[i].store( i, std::memory_order_relaxed );
 
-        item_set.insert( aItem );
-    };
+    auto find =
+            [&parent]( int aItem ) -> int
+            {
+                while( true )
+                {
+                    int up = parent[aItem].load( std::memory_order_relaxed );
 
-    std::for_each( m_itemList.begin(), m_itemList.end(), addToSearchList );
+                    if( up == aItem )
+                        return aItem;
 
-    while( !item_set.empty() )
-    {
-        CN_CLUSTER_PTR cluster ( new CN_CLUSTER() );
-        CN_ITEM*       root;
-        auto           it = item_set.begin();
+                    int upUp = parent[up].load( std::memory_order_relaxed );
 
-        while( it != item_set.end() && (*it)->Visited() )
-            it = item_set.erase( item_set.begin() );
+                    // Path halving; losing the race to another thread is harmless
+                    if( upUp != up )
+                        parent[aItem].compare_exchange_weak( up, upUp, std::memory_order_relaxed );
 
-        if( it == item_set.end() )
-            break;
+                    aItem = upUp;
+                }
+            };
 
-        root = *it;
-        root->SetVisited ( true );
+    auto unite =
+            [&parent, &find]( int aFirst, int aSecond )
+            {
+                while( true )
+                {
+                    aFirst = find( aFirst );
+                    aSecond = find( aSecond );
 
-        Q.clear();
-        Q.push_back( root );
+                    if( aFirst == aSecond )
+                        return;
 
-        while( Q.size() )
-        {
-            CN_ITEM* current = Q.front();
+                    if( aFirst < aSecond )
+                        std::swap( aFirst, aSecond );
 
-            Q.pop_front();
-            cluster->Add( current );
+                    int expected = aFirst;
 
-            for( auto n : current->ConnectedItems() )
-            {
-                if( withinAnyNet && n->Net() != root->Net() )
-                    continue;
+                    if( parent[aFirst].compare_exchange_strong( expected, aSecond,
+                                                                std::memory_order_relaxed ) )
+                    {
+                        return;
+                    }
+                }
+            };
+
+    const std::vector<int>& connections = m_itemList.Connections();
 
-                if( !n->Visited() && n->Valid() )
+    auto uniteRange =
+            [&]( int aBegin, int aEnd )
+            {
+                for( int i = aBegin; i < aEnd; i++ )
                 {
-                    n->SetVisited( true );
-                    Q.push_back( n );
+                    if( !member[i] )
+                        continue;
+
+                    int offset = m_itemList.ConnectionOffset( i );
+                    int end = offset + m_itemList.ConnectionCount( i );
+
+                    for( int k = offset; k < end; k++ )
+                    {
+                        int connected = connections[k];
+
+                        // Each connection is stored at both ends, so do it from one of them
+                        if( connected < i || !member[connected] )
+                            continue;
+
+                        if( withinAnyNet && nets[connected] != nets[i] )
+                            continue;
+
+                        unite( i, connected );
+                    }
                 }
-            }
+            };
+
+    const int chunkSize = 4096;
+    const int chunks = ( count + chunkSize - 1 ) / chunkSize;
+
+    if( chunks <= 1 )
+    {
+        uniteRange( 0, count );
+    }
+    else
+    {
+        THREAD_POOL::Get().ParallelFor( chunks,
+                [&]( size_t aChunk )
+                {
+                    uniteRange( aChunk * chunkSize,
+                                std::min<int>( count, ( aChunk + 1 ) * chunkSize ) );
+                } );
+    }
+
+    // Gather the clusters in list order
+    std::vector<CN_CLUSTER*> rootCluster( count, nullptr );
+
+    for( CN_ITEM* item : m_itemList )
+    {
+        if( !member[item->Index()] )
+            continue;
+
+        int root = find( item->Index() );
+
+        if( !rootCluster[root] )
+        {
+            clusters.emplace_back( new CN_CLUSTER() );
+            rootCluster[root] = clusters.back().get();
         }
 
-        clusters.push_back( cluster );
+        rootCluster[root]->Add( item );
     }
 
+#ifdef PROFILE
+    search_clusters.Show();
+#endif
 
     std::sort( clusters.begin(), clusters.end(), []( CN_CLUSTER_PTR a, CN_CLUSTER_PTR b ) {
         return a->OriginNet() < b->OriginNet();
@@ -404,15 +490,26 @@ void reportProgress( PROGRESS_REPORTER* aReporter, int aCount, int aSize, int aD
 
 void CN_CONNECTIVITY_ALGO::Build( BOARD* aBoard, PROGRESS_REPORTER* aReporter )
 {
+#ifdef PROFILE
+    PROF_COUNTER build( "connectivity-build" );
+#endif
+
     const int delta = 100;  // Number of additions between 2 calls to the progress bar
     int ii = 0;
     int size = 0;
+    int pads = 0;
 
     size += aBoard->Zones().size();
     size += aBoard->Tracks().size();
 
     for( MODULE* mod : aBoard->Modules() )
-        size += mod->Pads().size();
+        pads += mod->Pads().size();
+
+    size += pads;
+
+    // At least one item per zone; tracks have two anchors, pads and vias one
+    m_itemList.Reserve( m_itemList.Size() + size,
+                        m_itemList.AnchorArena().Size() + 2 * aBoard->Tracks().size() + pads );
 
     size *= 2;      // Our caller us gets the other half of the progress bar
 
@@ -436,6 +533,13 @@ void CN_CONNECTIVITY_ALGO::Build( BOARD* aBoard, PROGRESS_REPORTER* aReporter )
             reportProgress( aReporter, ii++, size, delta );
         }
     }
+
+#ifdef PROFILE
+    build.Show();
+    std::cerr << "connectivity-build: " << m_itemList.Size() << " items, "
+              << m_itemList.AnchorArena().Size() << " anchors, "
+              << m_itemList.MemoryUsage() / 1024 << " kB" << std::endl;
+#endif
 }
 
 
@@ -645,8 +749,7 @@ void CN_VISITOR::checkZoneItemConnection( CN_ZONE_LAYER* aZoneLayer, CN_ITEM* aI
     {
         if( aZoneLayer->ContainsPoint( aItem->GetAnchor( i ), accuracy ) )
         {
-            aZoneLayer->Connect( aItem );
-            aItem->Connect( aZoneLayer );
+            connect( aZoneLayer, aItem );
             return;
         }
     }
@@ -687,8 +790,7 @@ void CN_VISITOR::checkZoneZoneConnection( CN_ZONE_LAYER* aZoneLayerA, CN_ZONE_LA
 
         if( aZoneLayerB->ContainsPoint( outline.CPoint( i ), radiusA ) )
         {
-            aZoneLayerA->Connect( aZoneLayerB );
-            aZoneLayerB->Connect( aZoneLayerA );
+            connect( aZoneLayerA, aZoneLayerB );
             return;
         }
     }
@@ -703,8 +805,7 @@ void CN_VISITOR::checkZoneZoneConnection( CN_ZONE_LAYER* aZoneLayerA, CN_ZONE_LA
 
         if( aZoneLayerA->ContainsPoint( outline2.CPoint( i ), radiusB ) )
         {
-            aZoneLayerA->Connect( aZoneLayerB );
-            aZoneLayerB->Connect( aZoneLayerA );
+            connect( aZoneLayerA, aZoneLayerB );
             return;
         }
     }
@@ -728,7 +829,7 @@ bool CN_VISITOR::operator()( CN_ITEM* aCandidate )
     // If both m_item and aCandidate are marked dirty, they will both be searched
     // Since we are reciprocal in our connection, we arbitrarily pick one of the connections
     // to conduct the expensive search
-    if( aCandidate->Dirty() && aCandidate < m_item )
+    if( aCandidate->Dirty() && aCandidate->Index() < m_item->Index() )
         return true;
 
     // We should handle zone-zone connection separately
@@ -770,8 +871,7 @@ bool CN_VISITOR::operator()( CN_ITEM* aCandidate )
     {
         if( parentB->HitTest( wxPoint( aCandidate->GetAnchor( i ) ), accuracyA ) )
         {
-            m_item->Connect( aCandidate );
-            aCandidate->Connect( m_item );
+            connect( m_item, aCandidate );
             return true;
         }
     }
@@ -780,8 +880,7 @@ bool CN_VISITOR::operator()( CN_ITEM* aCandidate )
     {
         if( parentA->HitTest( wxPoint( m_item->GetAnchor( i ) ), accuracyB ) )
         {
-            m_item->Connect( aCandidate );
-            aCandidate->Connect( m_item );
+            connect( m_item, aCandidate );
             return true;
         }
     }
@@ -288,8 +288,9 @@ class CN_VISITOR {
 
 public:
 
-    CN_VISITOR( CN_ITEM* aItem ) :
-        m_item( aItem )
+    CN_VISITOR( CN_ITEM* aItem, std::vector<CN_LIST::CONNECTION>& aConnections ) :
+        m_item( aItem ),
+        m_connections( aConnections )
     {}
 
     bool operator()( CN_ITEM* aCandidate );
@@ -300,8 +301,16 @@ protected:
 
     void checkZoneZoneConnection( CN_ZONE_LAYER* aZoneLayerA, CN_ZONE_LAYER* aZoneLayerB );
 
+    void connect( CN_ITEM* aItemA, CN_ITEM* aItemB )
+    {
+        m_connections.emplace_back( aItemA->Index(), aItemB->Index() );
+    }
+
     ///> the item we are looking for connections to
     CN_ITEM* m_item;
+
+    ///> receives the connections found, for CN_LIST::UpdateConnections()
+    std::vector<CN_LIST::CONNECTION>& m_connections;
 };
 
 #endif
@@ -27,9 +27,8 @@
 #include <profile.h>
 #endif
 
-#include <thread>
+#include <thread_pool.h>
 #include <algorithm>
-#include <future>
 
 #include <connectivity/connectivity_data.h>
 #include <connectivity/connectivity_algo.h>
@@ -120,31 +119,19 @@ void CONNECTIVITY_DATA::updateRatsnest()
     std::copy_if( m_nets.begin() + 1, m_nets.end(), std::back_inserter( dirty_nets ),
             [] ( RN_NET* aNet ) { return aNet->IsDirty() && aNet->GetNodeCount() > 0; } );
 
-    // We don't want to spin up a new thread for fewer than 8 nets (overhead costs)
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            ( dirty_nets.size() + 7 ) / 8 );
-
-    std::atomic<size_t> nextNet( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
-
-    auto update_lambda = [&nextNet, &dirty_nets]() -> size_t
+    // We don't want to hand out fewer than 8 nets to the thread pool (overhead costs)
+    if( dirty_nets.size() < 8 )
     {
-        for( size_t i = nextNet++; i < dirty_nets.size(); i = nextNet++ )
-            dirty_nets[i]->Update();
-
-        return 1;
-    };
-
-    if( parallelThreadCount == 1 )
-        update_lambda();
+        for( RN_NET* net : dirty_nets )
+            net->Update();
+    }
     else
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
-
-        // Finalize the ratsnest threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
+        THREAD_POOL::Get().ParallelFor( dirty_nets.size(),
+                                        [&]( size_t ii )
+                                        {
+                                            dirty_nets[ii]->Update();
+                                        } );
     }
 
     #ifdef PROFILE
@@ -585,7 +572,7 @@ bool CONNECTIVITY_DATA::TestTrackEndpointDangling( TRACK* aTrack, wxPoint* aPos
     if( !citem->Valid() )
         return false;
 
-    for( const std::shared_ptr<CN_ANCHOR>& anchor : citem->Anchors() )
+    for( CN_ANCHOR* anchor : citem->Anchors() )
     {
         if( anchor->IsDangling() )
         {
@@ -152,7 +152,7 @@ void CN_ITEM::Dump()
 {
     wxLogDebug("    valid: %d, connected: \n", !!Valid());
 
-    for( auto i : m_connected )
+    for( auto i : ConnectedItems() )
     {
         TRACK* t = static_cast<TRACK*>( i->Parent() );
         wxLogDebug( "    - %p %d\n", t, t->Type() );
@@ -184,15 +184,15 @@ const VECTOR2I CN_ZONE_LAYER::GetAnchor( int n ) const
 }
 
 
-void CN_ITEM::RemoveInvalidRefs()
+void CN_LIST::addAnchor( CN_ITEM* aItem, const VECTOR2I& aPos )
 {
-    for( auto it = m_connected.begin(); it != m_connected.end(); )
-    {
-        if( !(*it)->Valid() )
-            it = m_connected.erase( it );
-        else
-            ++it;
-    }
+    int index = m_anchors.Add( CN_ANCHOR( aPos, aItem ) );
+
+    if( aItem->m_anchorCount == 0 )
+        aItem->m_firstAnchor = index;
+
+    wxASSERT( aItem->m_firstAnchor + aItem->m_anchorCount == index );
+    aItem->m_anchorCount++;
 }
 
 
@@ -201,8 +201,8 @@ CN_ITEM* CN_LIST::Add( D_PAD* pad )
     if( !pad->IsOnCopperLayer() )
          return nullptr;
 
-     auto item = new CN_ITEM( pad, false, 1 );
-     item->AddAnchor( pad->ShapePos() );
+     auto item = create( m_itemPool, pad, false );
+     addAnchor( item, pad->ShapePos() );
      item->SetLayers( LAYER_RANGE( F_Cu, B_Cu ) );
 
      switch( pad->GetAttribute() )
@@ -228,17 +228,15 @@ CN_ITEM* CN_LIST::Add( D_PAD* pad )
      }
 
      addItemtoTree( item );
-     m_items.push_back( item );
      SetDirty();
      return item;
 }
 
 CN_ITEM* CN_LIST::Add( TRACK* track )
 {
-    auto item = new CN_ITEM( track, true );
-    m_items.push_back( item );
-    item->AddAnchor( track->GetStart() );
-    item->AddAnchor( track->GetEnd() );
+    auto item = create( m_itemPool, track, true );
+    addAnchor( item, track->GetStart() );
+    addAnchor( item, track->GetEnd() );
     item->SetLayer( track->GetLayer() );
     addItemtoTree( item );
     SetDirty();
@@ -247,10 +245,9 @@ CN_ITEM* CN_LIST::Add( TRACK* track )
 
 CN_ITEM* CN_LIST::Add( ARC* aArc )
 {
-    auto item = new CN_ITEM( aArc, true );
-    m_items.push_back( item );
-    item->AddAnchor( aArc->GetStart() );
-    item->AddAnchor( aArc->GetEnd() );
+    auto item = create( m_itemPool, aArc, true );
+    addAnchor( item, aArc->GetStart() );
+    addAnchor( item, aArc->GetEnd() );
     item->SetLayer( aArc->GetLayer() );
     addItemtoTree( item );
     SetDirty();
@@ -259,10 +256,9 @@ CN_ITEM* CN_LIST::Add( ARC* aArc )
 
  CN_ITEM* CN_LIST::Add( VIA* via )
  {
-     auto item = new CN_ITEM( via, true, 1 );
+     auto item = create( m_itemPool, via, true );
 
-     m_items.push_back( item );
-     item->AddAnchor( via->GetStart() );
+     addAnchor( item, via->GetStart() );
 
      item->SetLayers( LAYER_RANGE( via->TopLayer(), via->BottomLayer() ) );
      addItemtoTree( item );
@@ -278,13 +274,12 @@ CN_ITEM* CN_LIST::Add( ARC* aArc )
 
      for( int j = 0; j < polys.OutlineCount(); j++ )
      {
-         CN_ZONE_LAYER* zitem = new CN_ZONE_LAYER( zone, aLayer, false, j );
+         CN_ZONE_LAYER* zitem = create( m_zoneLayerPool, zone, aLayer, false, j );
          const auto& outline = zone->GetFilledPolysList( aLayer ).COutline( j );
 
          for( int k = 0; k < outline.PointCount(); k++ )
-             zitem->AddAnchor( outline.CPoint( k ) );
+             addAnchor( zitem, outline.CPoint( k ) );
 
-         m_items.push_back( zitem );
          zitem->SetLayer( aLayer );
          addItemtoTree( zitem );
          rv.push_back( zitem );
@@ -295,16 +290,52 @@ CN_ITEM* CN_LIST::Add( ARC* aArc )
  }
 
 
-void CN_LIST::RemoveInvalidItems( std::vector<CN_ITEM*>& aGarbage )
+void CN_LIST::destroy( CN_ITEM* aItem )
+{
+    m_itemsByIndex[aItem->m_index] = nullptr;
+    m_freeIndices.push_back( aItem->m_index );
+    m_deadAnchors += aItem->m_anchorCount;
+
+    // The parent may be gone already, so it can't tell the type of the item
+    if( CN_ZONE_LAYER* zoneLayer = dynamic_cast<CN_ZONE_LAYER*>( aItem ) )
+        m_zoneLayerPool.Destroy( zoneLayer );
+    else
+        m_itemPool.Destroy( aItem );
+}
+
+
+void CN_LIST::Clear()
+{
+    for( CN_ITEM* item : m_items )
+        destroy( item );
+
+    m_items.clear();
+    m_index.RemoveAll();
+    m_itemPool.Clear();
+    m_zoneLayerPool.Clear();
+    m_itemsByIndex.clear();
+    m_freeIndices.clear();
+    m_anchors.Clear();
+    m_deadAnchors = 0;
+    m_connectionOffsets.clear();
+    m_connectionCounts.clear();
+    m_connections.clear();
+    m_staleConnections = false;
+}
+
+
+bool CN_LIST::RemoveInvalidItems()
 {
     if( !m_hasInvalid )
-        return;
+        return false;
+
+    std::vector<CN_ITEM*> garbage;
 
-    auto lastItem = std::remove_if(m_items.begin(), m_items.end(), [&aGarbage] ( CN_ITEM* item )
+    auto lastItem = std::remove_if(m_items.begin(), m_items.end(), [&garbage] ( CN_ITEM* item )
     {
         if( !item->Valid() )
         {
-            aGarbage.push_back ( item );
+            garbage.push_back ( item );
             return true;
         }
 
@@ -313,13 +344,134 @@ void CN_LIST::RemoveInvalidItems( std::vector<CN_ITEM*>& aGarbage )
 
     m_items.resize( lastItem - m_items.begin() );
 
-    for( auto item : m_items )
-        item->RemoveInvalidRefs();
-
-    for( auto item : aGarbage )
+    for( auto item : garbage )
+    {
         m_index.Remove( item );
+        destroy( item );
+    }
+
+    if( !garbage.empty() )
+        m_staleConnections = true;
 
     m_hasInvalid = false;
+
+    if( m_deadAnchors > CN_ANCHOR_ARENA::BLOCK_SIZE && m_deadAnchors > m_anchors.Size() / 2 )
+    {
+        compactAnchors();
+        return true;
+    }
+
+    return false;
+}
+
+
+void CN_LIST::compactAnchors()
+{
+    CN_ANCHOR_ARENA compacted;
+
+    compacted.Reserve( m_anchors.Size() - m_deadAnchors );
+
+    for( CN_ITEM* item : m_items )
+    {
+        int first = compacted.Size();
+
+        for( int i = 0; i < item->m_anchorCount; i++ )
+            compacted.Add( *m_anchors.Get( item->m_firstAnchor + i ) );
+
+        item->m_firstAnchor = first;
+    }
+
+    // The old blocks live on as long as the ratsnest holds some of their anchors
+    m_anchors = std::move( compacted );
+    m_deadAnchors = 0;
+}
+
+
+void CN_LIST::UpdateConnections( const std::vector<std::vector<CONNECTION>>& aFound )
+{
+    bool found = false;
+
+    for( const std::vector<CONNECTION>& connections : aFound )
+        found |= !connections.empty();
+
+    if( !found && !m_staleConnections )
+        return;
+
+    const int count = m_itemsByIndex.size();
+
+    // Both ends of the connections to keep and of the new ones, as ( from, to ) pairs
+    std::vector<CONNECTION> pairs;
+
+    for( int i = 0; i < (int) m_connectionCounts.size() && i < count; i++ )
+    {
+        if( !m_itemsByIndex[i] )
+            continue;
+
+        const int* connected = m_connections.data() + m_connectionOffsets[i];
+
+        for( int k = 0; k < m_connectionCounts[i]; k++ )
+        {
+            // Removed items have left their index free
+            if( m_itemsByIndex[connected[k]] )
+                pairs.emplace_back( i, connected[k] );
+        }
+    }
+
+    for( const std::vector<CONNECTION>& connections : aFound )
+    {
+        for( const CONNECTION& connection : connections )
+        {
+            pairs.emplace_back( connection.first, connection.second );
+            pairs.emplace_back( connection.second, connection.first );
+        }
+    }
+
+    // Bucket the pairs by their first item, then drop the duplicates of each item
+    m_connectionOffsets.assign( count + 1, 0 );
+    m_connectionCounts.assign( count, 0 );
+
+    for( const CONNECTION& pair : pairs )
+        m_connectionOffsets[pair.first + 1]++;
+
+    for( int i = 0; i < count; i++ )
+        m_connectionOffsets[i + 1] += m_connectionOffsets[i];
+
+    m_connections.resize( pairs.size() );
+
+    for( const CONNECTION& pair : pairs )
+        m_connections[m_connectionOffsets[pair.first] + m_connectionCounts[pair.first]++] =
+                pair.second;
+
+    for( int i = 0; i < count; i++ )
+    {
+        int* begin = m_connections.data() + m_connectionOffsets[i];
+        int* end = begin + m_connectionCounts[i];
+
+        std::sort( begin, end );
+        m_connectionCounts[i] = std::unique( begin, end ) - begin;
+    }
+
+    m_staleConnections = false;
+}
+
+
+void CN_LIST::Reserve( int aItems, int aAnchors )
+{
+    m_items.reserve( aItems );
+    m_itemsByIndex.reserve( aItems );
+    m_anchors.Reserve( aAnchors );
+}
+
+
+size_t CN_LIST::MemoryUsage() const
+{
+    return m_itemPool.MemoryUsage() + m_zoneLayerPool.MemoryUsage()
+           + m_items.capacity() * sizeof( CN_ITEM* )
+           + m_itemsByIndex.capacity() * sizeof( CN_ITEM* )
+           + m_freeIndices.capacity() * sizeof( int )
+           + m_anchors.MemoryUsage()
+           + ( m_connectionOffsets.capacity() + m_connectionCounts.capacity()
+               + m_connections.capacity() ) * sizeof( int );
 }
 
 
@@ -40,7 +40,10 @@
 
 #include <memory>
 #include <algorithm>
+#include <array>
 #include <functional>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <deque>
 #include <intrusive_list.h>
@@ -50,6 +53,7 @@
 
 class CN_ITEM;
 class CN_CLUSTER;
+class CN_LIST;
 
 class CN_ANCHOR
 {
@@ -163,22 +167,181 @@ private:
 
 
 typedef std::shared_ptr<CN_ANCHOR>  CN_ANCHOR_PTR;
-typedef std::vector<CN_ANCHOR_PTR>  CN_ANCHORS;
 
 
-// basic connectivity item
-class CN_ITEM
+/**
+ * The anchors of a CN_LIST, addressed by index.
+ *
+ * Anchors are stored in blocks which never move, and are only ever appended: the anchors of
+ * removed items stay in place until the list compacts its arena.  A CN_ANCHOR_PTR shares the
+ * ownership of the block of its anchor, so the ratsnest can keep anchors past a compaction.
+ */
+class CN_ANCHOR_ARENA
 {
 public:
-    using CONNECTED_ITEMS = std::vector<CN_ITEM*>;
+    static const int BLOCK_SIZE = 256;
+
+    CN_ANCHOR_ARENA() :
+            m_size( 0 )
+    {}
+
+    /// @return the index of the new anchor
+    int Add( const CN_ANCHOR& aAnchor )
+    {
+        if( m_size == (int) m_blocks.size() * BLOCK_SIZE )
+            m_blocks.push_back( std::make_shared<BLOCK>() );
+
+        ( *m_blocks.back() )[m_size % BLOCK_SIZE] = aAnchor;
+        return m_size++;
+    }
+
+    CN_ANCHOR* Get( int aIndex ) const
+    {
+        return &( *m_blocks[aIndex / BLOCK_SIZE] )[aIndex % BLOCK_SIZE];
+    }
+
+    CN_ANCHOR_PTR GetPtr( int aIndex ) const
+    {
+        return CN_ANCHOR_PTR( m_blocks[aIndex / BLOCK_SIZE], Get( aIndex ) );
+    }
+
+    int Size() const
+    {
+        return m_size;
+    }
+
+    void Reserve( int aCount )
+    {
+        m_blocks.reserve( ( aCount + BLOCK_SIZE - 1 ) / BLOCK_SIZE );
+    }
+
+    void Clear()
+    {
+        m_blocks.clear();
+        m_size = 0;
+    }
+
+    size_t MemoryUsage() const
+    {
+        return m_blocks.size() * sizeof( BLOCK )
+               + m_blocks.capacity() * sizeof( std::shared_ptr<BLOCK> );
+    }
+
+private:
+    using BLOCK = std::array<CN_ANCHOR, BLOCK_SIZE>;
+
+    std::vector<std::shared_ptr<BLOCK>> m_blocks;
+    int                                 m_size;
+};
+
+
+/**
+ * The anchors of an item: a range of the anchor arena of its list.
+ */
+class CN_ANCHORS
+{
+public:
+    class ITER
+    {
+    public:
+        ITER( const CN_ANCHOR_ARENA* aArena, int aIndex ) :
+                m_arena( aArena ),
+                m_index( aIndex )
+        {}
+
+        CN_ANCHOR* operator*() const { return m_arena->Get( m_index ); }
+        ITER& operator++() { ++m_index; return *this; }
+        bool operator!=( const ITER& aOther ) const { return m_index != aOther.m_index; }
+
+    private:
+        const CN_ANCHOR_ARENA* m_arena;
+        int                    m_index;
+    };
+
+    CN_ANCHORS( const CN_ANCHOR_ARENA* aArena, int aFirst, int aCount ) :
+            m_arena( aArena ),
+            m_first( aFirst ),
+            m_count( aCount )
+    {}
+
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+
+    CN_ANCHOR* operator[]( size_t aIndex ) const { return m_arena->Get( m_first + aIndex ); }
+
+    ///> @return a pointer sharing the ownership of the anchor, for keeping it
+    CN_ANCHOR_PTR Ptr( size_t aIndex ) const { return m_arena->GetPtr( m_first + aIndex ); }
+
+    ITER begin() const { return ITER( m_arena, m_first ); }
+    ITER end() const { return ITER( m_arena, m_first + m_count ); }
 
 private:
+    const CN_ANCHOR_ARENA* m_arena;
+    int                    m_first;
+    int                    m_count;
+};
+
+
+/**
+ * The items connected to an item: a range of the adjacency array of its list, which holds
+ * item indices.
+ */
+class CN_CONNECTED_ITEMS
+{
+public:
+    class ITER
+    {
+    public:
+        ITER( CN_ITEM* const* aItems, const int* aIndex ) :
+                m_items( aItems ),
+                m_index( aIndex )
+        {}
+
+        CN_ITEM* operator*() const { return m_items[*m_index]; }
+        ITER& operator++() { ++m_index; return *this; }
+        bool operator!=( const ITER& aOther ) const { return m_index != aOther.m_index; }
+
+    private:
+        CN_ITEM* const* m_items;
+        const int*      m_index;
+    };
+
+    CN_CONNECTED_ITEMS( CN_ITEM* const* aItems, const int* aBegin, const int* aEnd ) :
+            m_items( aItems ),
+            m_begin( aBegin ),
+            m_end( aEnd )
+    {}
+
+    size_t size() const { return m_end - m_begin; }
+    bool empty() const { return m_begin == m_end; }
+
+    ITER begin() const { return ITER( m_items, m_begin ); }
+    ITER end() const { return ITER( m_items, m_end ); }
+
+private:
+    CN_ITEM* const* m_items;
+    const int*      m_begin;
+    const int*      m_end;
+};
+
+
+// basic connectivity item
+class CN_ITEM
+{
+private:
+    friend class CN_LIST;
+
     BOARD_CONNECTED_ITEM* m_parent;
 
-    ///> list of items physically connected (touching)
-    CONNECTED_ITEMS m_connected;
+    ///> list holding the item, its anchors and its connections
+    CN_LIST* m_list;
+
+    ///> index of the item in its list, unchanged for the lifetime of the item
+    int m_index;
 
-    CN_ANCHORS m_anchors;
+    ///> range of the item's anchors in the anchor arena of its list
+    int m_firstAnchor;
+    int m_anchorCount;
 
     ///> visited flag for the BFS scan
     bool m_visited;
@@ -189,9 +352,6 @@ private:
     ///> valid flag, used to identify garbage items (we use lazy removal)
     bool m_valid;
 
-    ///> mutex protecting this item's connected_items set to allow parallel connection threads
-    std::mutex m_listLock;
-
 protected:
     ///> dirty flag, used to identify recently added item not yet scanned into the connectivity search
     bool m_dirty;
@@ -205,28 +365,34 @@ protected:
 public:
     void Dump();
 
-    CN_ITEM( BOARD_CONNECTED_ITEM* aParent, bool aCanChangeNet, int aAnchorCount = 2 )
+    /**
+     * Items are created by CN_LIST::Add(), which sets up their storage.
+     */
+    CN_ITEM( BOARD_CONNECTED_ITEM* aParent, bool aCanChangeNet )
     {
         m_parent = aParent;
+        m_list = nullptr;
+        m_index = -1;
+        m_firstAnchor = 0;
+        m_anchorCount = 0;
         m_canChangeNet = aCanChangeNet;
         m_visited = false;
         m_valid = true;
         m_dirty = true;
-        m_anchors.reserve( std::max( 6, aAnchorCount ) );
         m_layers = LAYER_RANGE( 0, PCB_LAYER_ID_COUNT );
-        m_connected.reserve( 8 );
     }
 
     virtual ~CN_ITEM() {};
 
-    void AddAnchor( const VECTOR2I& aPos )
-    {
-        m_anchors.emplace_back( std::make_shared<CN_ANCHOR>( aPos, this ) );
-    }
+    inline CN_ANCHORS Anchors() const;
 
-    CN_ANCHORS& Anchors()
+    /**
+     * @return the index of the item in its list, unchanged for the lifetime of the item.
+     * The indices of removed items are reused.
+     */
+    int Index() const
     {
-        return m_anchors;
+        return m_index;
     }
 
     void SetValid( bool aValid )
@@ -304,15 +470,10 @@ public:
         return m_parent;
     }
 
-    const CONNECTED_ITEMS& ConnectedItems()  const
-    {
-        return m_connected;
-    }
-
-    void ClearConnections()
-    {
-        m_connected.clear();
-    }
+    /**
+     * @return the items touching this one, as of the last connection search of its list.
+     */
+    inline CN_CONNECTED_ITEMS ConnectedItems() const;
 
     void SetVisited( bool aVisited )
     {
@@ -329,20 +490,6 @@ public:
         return m_canChangeNet;
     }
 
-    void Connect( CN_ITEM* b )
-    {
-        std::lock_guard<std::mutex> lock( m_listLock );
-
-        auto i = std::lower_bound( m_connected.begin(), m_connected.end(), b );
-
-        if( i != m_connected.end() && *i == b )
-          return;
-
-        m_connected.insert( i, b );
-    }
-
-    void RemoveInvalidRefs();
-
     virtual int             AnchorCount() const;
     virtual const VECTOR2I  GetAnchor( int n ) const;
 
@@ -376,7 +523,7 @@ public:
         return m_subpolyIndex;
     }
 
-    bool ContainsAnchor( const CN_ANCHOR_PTR anchor ) const
+    bool ContainsAnchor( const CN_ANCHOR* anchor ) const
     {
         return ContainsPoint( anchor->Pos(), 0 );
     }
@@ -410,14 +557,114 @@ private:
     PCB_LAYER_ID m_layer;
 };
 
+/**
+ * Block storage for connectivity items.  Items never move, and the slots of destroyed items
+ * are reused.
+ */
+template <class T>
+class CN_ITEM_POOL
+{
+public:
+    static const int BLOCK_SIZE = 256;
+
+    CN_ITEM_POOL() :
+            m_used( BLOCK_SIZE )
+    {}
+
+    template <typename... Args>
+    T* Create( Args&&... aArgs )
+    {
+        void* slot;
+
+        if( !m_free.empty() )
+        {
+            slot = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            if( m_used == BLOCK_SIZE )
+            {
+                m_blocks.emplace_back( new STORAGE[BLOCK_SIZE] );
+                m_used = 0;
+            }
+
+            slot = &m_blocks.back()[m_used++];
+        }
+
+        return new( slot ) T( std::forward<Args>( aArgs )... );
+    }
+
+    void Destroy( T* aItem )
+    {
+        aItem->~T();
+        m_free.push_back( aItem );
+    }
+
+    /// Releases the storage; all the items must have been destroyed
+    void Clear()
+    {
+        m_blocks.clear();
+        m_free.clear();
+        m_used = BLOCK_SIZE;
+    }
+
+    size_t MemoryUsage() const
+    {
+        return m_blocks.size() * BLOCK_SIZE * sizeof( STORAGE )
+               + m_blocks.capacity() * sizeof( std::unique_ptr<STORAGE[]> )
+               + m_free.capacity() * sizeof( void* );
+    }
+
+private:
+    using STORAGE = typename std::aligned_storage<sizeof( T ), alignof( T )>::type;
+
+    std::vector<std::unique_ptr<STORAGE[]>> m_blocks;
+    std::vector<void*>                      m_free;
+    int                                     m_used;     ///< Slots used in the last block
+};
+
+
+/**
+ * The connectivity items, with their anchors and connections in flat storage.
+ *
+ * Items are allocated in blocks and addressed by a stable index (CN_ITEM::Index()).  Their
+ * anchors are ranges of an anchor arena, and the connections of all the items are ranges of
+ * a single array of item indices, rebuilt by UpdateConnections() after each connection
+ * search.
+ */
 class CN_LIST
 {
+public:
+    ///> A pair of touching items, by index
+    using CONNECTION = std::pair<int, int>;
+
 private:
     bool m_dirty;
     bool m_hasInvalid;
 
+    ///> set when items were removed since the last update of the connections
+    bool m_staleConnections;
+
     CN_RTREE<CN_ITEM*> m_index;
 
+    CN_ITEM_POOL<CN_ITEM>       m_itemPool;
+    CN_ITEM_POOL<CN_ZONE_LAYER> m_zoneLayerPool;
+
+    ///> the items by index, nullptr for free indices
+    std::vector<CN_ITEM*> m_itemsByIndex;
+    std::vector<int>      m_freeIndices;
+
+    CN_ANCHOR_ARENA m_anchors;
+
+    ///> anchors of removed items, still in the arena
+    int m_deadAnchors;
+
+    ///> connections of the item of each index: a range of m_connections
+    std::vector<int> m_connectionOffsets;
+    std::vector<int> m_connectionCounts;
+    std::vector<int> m_connections;
+
 protected:
     std::vector<CN_ITEM*> m_items;
 
@@ -426,22 +673,59 @@ protected:
         m_index.Insert( item );
     }
 
+    /**
+     * Creates an item in \a aPool and gives it an index.
+     */
+    template <class T, typename... Args>
+    T* create( CN_ITEM_POOL<T>& aPool, Args&&... aArgs )
+    {
+        T* item = aPool.Create( std::forward<Args>( aArgs )... );
+
+        item->m_list = this;
+
+        if( m_freeIndices.empty() )
+        {
+            item->m_index = m_itemsByIndex.size();
+            m_itemsByIndex.push_back( item );
+        }
+        else
+        {
+            item->m_index = m_freeIndices.back();
+            m_freeIndices.pop_back();
+            m_itemsByIndex[item->m_index] = item;
+        }
+
+        m_items.push_back( item );
+        return item;
+    }
+
+    /**
+     * Adds an anchor to \a aItem.  The anchors of an item must all be added before those of
+     * the next item.
+     */
+    void addAnchor( CN_ITEM* aItem, const VECTOR2I& aPos );
+
+    void destroy( CN_ITEM* aItem );
+
+    /// Moves the anchors of the current items to a new arena, leaving out the dead ones
+    void compactAnchors();
+
 public:
     CN_LIST()
     {
         m_dirty = false;
         m_hasInvalid = false;
+        m_staleConnections = false;
+        m_deadAnchors = 0;
     }
 
-    void Clear()
+    ~CN_LIST()
     {
-        for( auto item : m_items )
-            delete item;
-
-        m_items.clear();
-        m_index.RemoveAll();
+        Clear();
     }
 
+    void Clear();
+
     using ITER       = decltype( m_items )::iterator;
     using CONST_ITER = decltype( m_items )::const_iterator;
 
@@ -460,6 +744,56 @@ public:
 
     CN_ITEM* operator[] ( int aIndex ) { return m_items[aIndex]; }
 
+    /**
+     * @return the item of index \a aIndex (see CN_ITEM::Index()), or nullptr if the index is
+     * free.
+     */
+    CN_ITEM* ItemByIndex( int aIndex ) const
+    {
+        return m_itemsByIndex[aIndex];
+    }
+
+    /// @return the number of item indices, used and free
+    int IndexCount() const
+    {
+        return m_itemsByIndex.size();
+    }
+
+    CN_ITEM* const* ItemsByIndex() const
+    {
+        return m_itemsByIndex.data();
+    }
+
+    const CN_ANCHOR_ARENA& AnchorArena() const
+    {
+        return m_anchors;
+    }
+
+    /**
+     * The connections of the item of index \a aIndex are the item indices
+     * Connections()[ ConnectionOffset( aIndex ) ] onwards, ConnectionCount( aIndex ) of them.
+     */
+    int ConnectionOffset( int aIndex ) const
+    {
+        return aIndex < (int) m_connectionOffsets.size() ? m_connectionOffsets[aIndex] : 0;
+    }
+
+    int ConnectionCount( int aIndex ) const
+    {
+        return aIndex < (int) m_connectionCounts.size() ? m_connectionCounts[aIndex] : 0;
+    }
+
+    const std::vector<int>& Connections() const
+    {
+        return m_connections;
+    }
+
+    /**
+     * Stores the connections found by a connection search, with those already stored between
+     * items which are still there.  Each connection need only be given once, from either end.
+     */
+    void UpdateConnections( const std::vector<std::vector<CONNECTION>>& aFound );
+
     template <class T>
     void FindNearby( CN_ITEM *aItem, T aFunc )
     {
@@ -481,7 +815,13 @@ public:
         return m_dirty;
     }
 
-    void RemoveInvalidItems( std::vector<CN_ITEM*>& aGarbage );
+    /**
+     * Destroys the items marked as invalid.
+     *
+     * @return true if the anchors of the remaining items were moved to a compacted arena, in
+     * which case the anchors held by the ratsnest are no longer those of the items.
+     */
+    bool RemoveInvalidItems();
 
     void ClearDirtyFlags()
     {
@@ -504,6 +844,12 @@ public:
         return m_items.size();
     }
 
+    /// Makes room for \a aItems items with \a aAnchors anchors in all
+    void Reserve( int aItems, int aAnchors );
+
+    /// @return the memory used by the items, their anchors and their connections
+    size_t MemoryUsage() const;
+
     CN_ITEM* Add( D_PAD* pad );
 
     CN_ITEM* Add( TRACK* track );
@@ -515,6 +861,21 @@ public:
     const std::vector<CN_ITEM*> Add( ZONE_CONTAINER* zone, PCB_LAYER_ID aLayer );
 };
 
+
+CN_ANCHORS CN_ITEM::Anchors() const
+{
+    return CN_ANCHORS( &m_list->AnchorArena(), m_firstAnchor, m_anchorCount );
+}
+
+
+CN_CONNECTED_ITEMS CN_ITEM::ConnectedItems() const
+{
+    const int* begin = m_list->Connections().data() + m_list->ConnectionOffset( m_index );
+
+    return CN_CONNECTED_ITEMS( m_list->ItemsByIndex(), begin,
+                               begin + m_list->ConnectionCount( m_index ) );
+}
+
 class CN_CLUSTER
 {
 private:
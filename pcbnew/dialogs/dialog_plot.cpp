@@ -36,6 +36,7 @@
 #include <class_board.h>
 #include <dialog_plot.h>
 #include <dialog_gendrill.h>
+#include <fab_output_job.h>
 #include <wx_html_report_panel.h>
 #include <tool/tool_manager.h>
 #include <tools/zone_filler_tool.h>
@@ -852,7 +853,8 @@ void DIALOG_PLOT::Plot( wxCommandEvent& event )
     // Save the current plot options in the board
     m_parent->SetPlotSettings( m_plotOpts );
 
-    wxBusyCursor dummy;
+    wxBusyCursor   dummy;
+    FAB_OUTPUT_JOB job( board );
 
     for( LSEQ seq = m_plotOpts.GetLayerSelection().UIOrder();  seq;  ++seq )
     {
@@ -879,32 +881,16 @@ void DIALOG_PLOT::Plot( wxCommandEvent& event )
         wxString fullname = fn.GetFullName();
         jobfile_writer.AddGbrFile( layer, fullname );
 
-        LOCALE_IO toggle;
-
-        PLOTTER*    plotter = StartPlotBoard( board, &m_plotOpts, layer, fn.GetFullPath(), wxEmptyString );
-
-        // Print diags in messages box:
-        wxString msg;
-
-        if( plotter )
-        {
-            PlotOneBoardLayer( board, plotter, layer, m_plotOpts );
-            plotter->EndPlot();
-            delete plotter->RenderSettings();
-            delete plotter;
-
-            msg.Printf( _( "Plot file \"%s\" created." ), fn.GetFullPath() );
-            reporter.Report( msg, RPT_SEVERITY_ACTION );
-        }
-        else
-        {
-            msg.Printf( _( "Unable to create file \"%s\"." ), fn.GetFullPath() );
-            reporter.Report( msg, RPT_SEVERITY_ERROR );
-        }
-
-        wxSafeYield();      // displays report message.
+        job.AddLayer( layer, fn.GetFullPath(), m_plotOpts );
     }
 
+    // Display the report messages as the layers are plotted
+    job.Run( &reporter,
+             []()
+             {
+                 wxSafeYield();
+             } );
+
     if( m_plotOpts.GetFormat() == PLOT_FORMAT::GERBER && m_plotOpts.GetCreateGerberJobFile() )
     {
         // Pick the basename from the board file
@@ -31,6 +31,39 @@
 #include <drc/drc_rule.h>
 #include <drc/drc_rule_condition.h>
 #include <drc/drc_test_provider.h>
+#include <drc/drc_item.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <hash_eda.h>
+#include <thread_pool.h>
+
+
+// Reports made on a thread which has a buffer installed are collected in that buffer instead
+// of being passed on.  See RunTests() and ParallelFor().
+static thread_local DRC_ENGINE::DEFERRED_REPORTS* s_deferredReports = nullptr;
+
+
+/**
+ * Installs a report buffer on the current thread for the lifetime of the scope.  The previous
+ * one is restored on exit, as a worker waiting on nested tasks may run some of them itself.
+ */
+struct DEFERRED_REPORTS_SCOPE
+{
+    DEFERRED_REPORTS_SCOPE( DRC_ENGINE::DEFERRED_REPORTS* aReports ) :
+            m_previous( s_deferredReports )
+    {
+        s_deferredReports = aReports;
+    }
+
+    ~DEFERRED_REPORTS_SCOPE()
+    {
+        s_deferredReports = m_previous;
+    }
+
+    DRC_ENGINE::DEFERRED_REPORTS* m_previous;
+};
+
 
 void drcPrintDebugMessage( int level, const wxString& msg, const char *function, int line )
 {
@@ -57,8 +90,10 @@ DRC_ENGINE::DRC_ENGINE( BOARD* aBoard, BOARD_DESIGN_SETTINGS *aSettings ) :
     m_testTracksAgainstZones( false ),
     m_reportAllTrackErrors( false ),
     m_testFootprints( false ),
+    m_incremental( false ),
     m_reporter( nullptr ),
-    m_progressReporter( nullptr )
+    m_progressReporter( nullptr ),
+    m_mainThreadId( std::this_thread::get_id() )
 {
     m_errorLimits.resize( DRCE_LAST + 1 );
 
@@ -287,6 +322,8 @@ void DRC_ENGINE::loadRules( const wxFileName& aPath )
 
 bool DRC_ENGINE::CompileRules()
 {
+    ClearConstraintCache();
+
     ReportAux( wxString::Format( "Compiling Rules (%d rules, %d conditions): ",
                                  (int) m_rules.size(),
                                  (int) m_ruleConditions.size() ) );
@@ -389,6 +426,124 @@ void DRC_ENGINE::InitEngine( const wxFileName& aRulePath )
 
 void DRC_ENGINE::RunTests( EDA_UNITS aUnits, bool aTestTracksAgainstZones,
                            bool aReportAllTrackErrors, bool aTestFootprints )
+{
+    m_incremental = false;
+    m_dirtyAreas.clear();
+    m_incrementalItemMap.clear();
+
+    runTests( aUnits, aTestTracksAgainstZones, aReportAllTrackErrors, aTestFootprints );
+}
+
+
+void DRC_ENGINE::RunTestsIncremental( const std::vector<EDA_RECT>& aDirtyAreas, EDA_UNITS aUnits,
+                                      bool aTestTracksAgainstZones, bool aReportAllTrackErrors )
+{
+    // Anything further from a changed item than the worst clearance can't have been affected
+    // by the change.
+    DRC_CONSTRAINT constraint;
+    int            worstClearance = 0;
+
+    for( DRC_CONSTRAINT_TYPE_T type : { DRC_CONSTRAINT_TYPE_CLEARANCE,
+                                        DRC_CONSTRAINT_TYPE_HOLE_CLEARANCE,
+                                        DRC_CONSTRAINT_TYPE_EDGE_CLEARANCE,
+                                        DRC_CONSTRAINT_TYPE_COURTYARD_CLEARANCE } )
+    {
+        if( QueryWorstConstraint( type, constraint, DRCCQ_LARGEST_MINIMUM ) )
+            worstClearance = std::max( worstClearance, constraint.GetValue().Min() );
+    }
+
+    // Local pad clearances can exceed the rule clearances
+    for( MODULE* module : m_board->Modules() )
+    {
+        for( D_PAD* pad : module->Pads() )
+        {
+            worstClearance = std::max( worstClearance,
+                                       pad->GetLocalClearanceOverrides( nullptr ) );
+        }
+    }
+
+    m_incremental = true;
+    m_dirtyAreas.clear();
+    m_incrementalItemMap.clear();
+
+    for( EDA_RECT area : aDirtyAreas )
+    {
+        area.Normalize();
+        area.Inflate( worstClearance );
+        m_dirtyAreas.push_back( area );
+    }
+
+    // Testing every item against a long list of areas would cost more than it saves
+    if( m_dirtyAreas.size() > 16 )
+    {
+        for( size_t ii = 1; ii < m_dirtyAreas.size(); ++ii )
+            m_dirtyAreas.front().Merge( m_dirtyAreas[ii] );
+
+        m_dirtyAreas.resize( 1 );
+    }
+
+    runTests( aUnits, aTestTracksAgainstZones, aReportAllTrackErrors, false );
+}
+
+
+bool DRC_ENGINE::InDirtyRegion( const BOARD_ITEM* aItem ) const
+{
+    if( !m_incremental )
+        return true;
+
+    EDA_RECT bbox = aItem->GetBoundingBox();
+    bbox.Normalize();
+
+    for( const EDA_RECT& area : m_dirtyAreas )
+    {
+        if( area.Intersects( bbox ) )
+            return true;
+    }
+
+    return false;
+}
+
+
+bool DRC_ENGINE::IsSupersededByIncrementalRun( const DRC_ITEM* aItem )
+{
+    DRC_TEST_PROVIDER* test = aItem->GetViolatingTest();
+
+    // Violations loaded from disk (or reported by tests which weren't re-run) stand
+    if( !m_incremental || !test || !test->SupportsIncremental() )
+        return false;
+
+    // BOARD::GetItem() walks the whole board: look the items up in a map instead, as this is
+    // called for every marker
+    if( m_incrementalItemMap.empty() )
+        m_board->FillItemMap( m_incrementalItemMap );
+
+    std::vector<EDA_ITEM*> items;
+
+    for( const KIID& id : { aItem->GetMainItemID(), aItem->GetAuxItemID(),
+                            aItem->GetAuxItem2ID(), aItem->GetAuxItem3ID() } )
+    {
+        if( id == niluuid )
+            continue;
+
+        auto it = m_incrementalItemMap.find( id );
+
+        // Not found: the item has been deleted
+        if( it == m_incrementalItemMap.end() )
+            continue;
+
+        if( !InDirtyRegion( static_cast<BOARD_ITEM*>( it->second ) ) )
+            return false;
+
+        items.push_back( it->second );
+    }
+
+    // The violations of the tests skipped by the run (e.g. tracks against zones) stand
+    return test->RetestedIncrementally( aItem, items );
+}
+
+
+void DRC_ENGINE::runTests( EDA_UNITS aUnits, bool aTestTracksAgainstZones,
+                           bool aReportAllTrackErrors, bool aTestFootprints )
 {
     m_userUnits = aUnits;
 
@@ -402,7 +557,10 @@ void DRC_ENGINE::RunTests( EDA_UNITS aUnits, bool aTestTracksAgainstZones,
         int phases = 0;
 
         for( DRC_TEST_PROVIDER* provider : m_testProviders )
-            phases += provider->GetNumPhases();
+        {
+            if( !m_incremental || provider->SupportsIncremental() )
+                phases += provider->GetNumPhases();
+        }
 
         m_progressReporter->AddPhases( phases );
     }
@@ -415,18 +573,210 @@ void DRC_ENGINE::RunTests( EDA_UNITS aUnits, bool aTestTracksAgainstZones,
             m_errorLimits[ ii ] = INT_MAX;
     }
 
-    for( DRC_TEST_PROVIDER* provider : m_testProviders )
+    // Update the shape caches in the pads to prevent multi-threaded rebuilds.
+    for( MODULE* module : m_board->Modules() )
+    {
+        for( D_PAD* pad : module->Pads() )
+        {
+            if( pad->IsDirty() )
+                pad->BuildEffectiveShapes( UNDEFINED_LAYER );
+        }
+    }
+
+    m_mainThreadId = std::this_thread::get_id();
+
+    // Netclasses may have been edited since the last run
+    ClearConstraintCache();
+
+    size_t                        count = m_testProviders.size();
+    size_t                        stop = count;     // index of the first provider to fail
+    std::vector<DEFERRED_REPORTS> reports( count );
+    std::vector<char>             results( count, true );
+    std::vector<char>             skipped( count, false );
+
+    // An incremental run only re-runs the providers which can restrict themselves to the
+    // dirty region
+    for( size_t ii = 0; ii < count; ++ii )
+        skipped[ii] = m_incremental && !m_testProviders[ii]->SupportsIncremental();
+
+    auto runProvider =
+            [&]( size_t ii )
+            {
+                DRC_TEST_PROVIDER* provider = m_testProviders[ii];
+
+                DEFERRED_REPORTS_SCOPE scope( &reports[ii] );
+
+                drc_dbg( 0, "Running test provider: '%s'\n", provider->GetName() );
+
+                ReportAux( wxString::Format( "Run DRC provider: '%s'", provider->GetName() ) );
+
+                results[ii] = provider->Run();
+            };
+
+    // Providers which modify the board (or caches the other providers read) are run first,
+    // one after the other on this thread.
+    for( size_t ii = 0; ii < count; ++ii )
+    {
+        if( skipped[ii] || m_testProviders[ii]->IsThreadSafe() )
+            continue;
+
+        runProvider( ii );
+
+        if( !results[ii] )
+        {
+            stop = ii;
+            break;
+        }
+    }
+
+    // The remaining providers only read the board and run concurrently.  A serial run stops
+    // at the first provider which fails, so there's no point in starting any after that.
+    TASK_GROUP tasks;
+
+    for( size_t ii = 0; ii < stop; ++ii )
     {
-        drc_dbg( 0, "Running test provider: '%s'\n", provider->GetName() );
+        if( skipped[ii] || !m_testProviders[ii]->IsThreadSafe() )
+            continue;
+
+        if( GetThreadCount() <= 1 )
+            runProvider( ii );
+        else
+            tasks.Run( [&runProvider, ii]() { runProvider( ii ); } );
+    }
+
+    waitForWorkers( tasks );
 
-        ReportAux( wxString::Format( "Run DRC provider: '%s'", provider->GetName() ) );
+    // Finally hand the results over in provider order, again stopping where a serial run
+    // would have.
+    for( size_t ii = 0; ii < count; ++ii )
+    {
+        replayReports( reports[ii] );
 
-        if( !provider->Run() )
+        if( !results[ii] )
             break;
     }
 }
 
 
+size_t DRC_ENGINE::GetThreadCount() const
+{
+    return THREAD_POOL::Get().GetWorkerCount();
+}
+
+
+void DRC_ENGINE::ParallelFor( size_t aCount, size_t aChunks,
+                              const std::function<void( size_t, size_t, size_t )>& aFunc )
+{
+    aChunks = std::max<size_t>( std::min( aChunks, aCount ), 1 );
+
+    if( aChunks == 1 )
+    {
+        aFunc( 0, 0, aCount );
+        return;
+    }
+
+    size_t                        chunkSize = ( aCount + aChunks - 1 ) / aChunks;
+    std::vector<DEFERRED_REPORTS> reports( aChunks );
+    TASK_GROUP                    tasks;
+
+    for( size_t ii = 0; ii < aChunks; ++ii )
+    {
+        size_t begin = std::min( ii * chunkSize, aCount );
+        size_t end = std::min( begin + chunkSize, aCount );
+
+        tasks.Run( [&reports, &aFunc, ii, begin, end]()
+                   {
+                       DEFERRED_REPORTS_SCOPE scope( &reports[ii] );
+                       aFunc( ii, begin, end );
+                   } );
+    }
+
+    waitForWorkers( tasks );
+
+    // Replaying on the calling thread sends the reports on to wherever its own reports go
+    // (which is usually its provider's buffer).
+    for( const DEFERRED_REPORTS& chunkReports : reports )
+        replayReports( chunkReports );
+}
+
+
+void DRC_ENGINE::waitForWorkers( TASK_GROUP& aTasks )
+{
+    if( std::this_thread::get_id() == m_mainThreadId )
+    {
+        // Here we wait with a 100ms timeout to allow UI updating
+        while( !aTasks.WaitFor( std::chrono::milliseconds( 100 ) ) )
+        {
+            if( m_progressReporter )
+                m_progressReporter->KeepRefreshing();
+        }
+    }
+
+    // Elsewhere (ie: from a provider running on a worker) help with the tasks.  Either way
+    // this rethrows anything a task threw.
+    aTasks.Wait();
+}
+
+
+void DRC_ENGINE::replayReports( const DEFERRED_REPORTS& aReports )
+{
+    for( const DEFERRED_REPORT& report : aReports )
+    {
+        if( report.m_item )
+            ReportViolation( report.m_item, report.m_pos );
+        else
+            ReportAux( report.m_message );
+    }
+}
+
+
+DRC_ENGINE::ITEM_SIGNATURE::ITEM_SIGNATURE( const BOARD_ITEM* aItem ) :
+    m_type( TYPE_NOT_INIT ),
+    m_layer( UNDEFINED_LAYER ),
+    m_netclass( nullptr ),
+    m_subType( 0 )
+{
+    if( !aItem )
+        return;
+
+    m_type = aItem->Type();
+    m_layer = aItem->GetLayer();
+    m_layers = aItem->GetLayerSet();
+
+    if( aItem->IsConnected() )
+    {
+        // The NetClass property is the name of the net's netclass
+        NETINFO_ITEM* net = static_cast<const BOARD_CONNECTED_ITEM*>( aItem )->GetNet();
+        m_netclass = net ? net->GetNetClass() : nullptr;
+    }
+
+    if( m_type == PCB_VIA_T )
+        m_subType = (int) static_cast<const VIA*>( aItem )->GetViaType();
+    else if( m_type == PCB_PAD_T )
+        m_subType = (int) static_cast<const D_PAD*>( aItem )->GetAttribute();
+}
+
+
+size_t DRC_ENGINE::CONSTRAINT_CACHE_KEY_HASH::operator()( const CONSTRAINT_CACHE_KEY& aKey ) const
+{
+    const ITEM_SIGNATURE& a = aKey.m_a;
+    const ITEM_SIGNATURE& b = aKey.m_b;
+
+    return hash_val( (int) aKey.m_constraintType, (int) aKey.m_layer,
+                     (int) a.m_type, (int) a.m_layer, static_cast<const BASE_SET&>( a.m_layers ),
+                     a.m_netclass, a.m_subType,
+                     (int) b.m_type, (int) b.m_layer, static_cast<const BASE_SET&>( b.m_layers ),
+                     b.m_netclass, b.m_subType );
+}
+
+
+void DRC_ENGINE::ClearConstraintCache()
+{
+    std::unique_lock<std::shared_timed_mutex> lock( m_constraintCacheLock );
+    m_constraintCache.clear();
+}
+
+
 DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintId,
                                               const BOARD_ITEM* a, const BOARD_ITEM* b,
                                               PCB_LAYER_ID aLayer, REPORTER* aReporter )
@@ -442,6 +792,7 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
     const BOARD_CONNECTED_ITEM* connectedB = dynamic_cast<const BOARD_CONNECTED_ITEM*>( b );
     const DRC_CONSTRAINT*       constraintRef = nullptr;
     bool                        implicit = false;
+    wxString                    source;     // Not m_msg: this may be called from several threads
 
     // Local overrides take precedence
     if( aConstraintId == DRC_CONSTRAINT_TYPE_CLEARANCE )
@@ -451,7 +802,7 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
 
         if( connectedA && connectedA->GetLocalClearanceOverrides( nullptr ) > 0 )
         {
-            overrideA = connectedA->GetLocalClearanceOverrides( &m_msg );
+            overrideA = connectedA->GetLocalClearanceOverrides( &source );
 
             REPORT( "" )
             REPORT( wxString::Format( _( "Local override on %s; clearance: %s." ),
@@ -461,7 +812,7 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
 
         if( connectedB && connectedB->GetLocalClearanceOverrides( nullptr ) > 0 )
         {
-            overrideB = connectedB->GetLocalClearanceOverrides( &m_msg );
+            overrideB = connectedB->GetLocalClearanceOverrides( &source );
 
             REPORT( "" )
             REPORT( wxString::Format( _( "Local override on %s; clearance: %s." ),
@@ -471,15 +822,37 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
 
         if( overrideA || overrideB )
         {
-            DRC_CONSTRAINT constraint( DRC_CONSTRAINT_TYPE_CLEARANCE, m_msg );
+            DRC_CONSTRAINT constraint( DRC_CONSTRAINT_TYPE_CLEARANCE, source );
             constraint.m_Value.SetMin( std::max( overrideA, overrideB ) );
             return constraint;
         }
     }
 
-    if( m_constraintMap.count( aConstraintId ) )
+    // As long as only cacheable conditions are evaluated the result depends solely on the
+    // signatures of the two items, and can be reused for any other pair with the same ones.
+    // The cache is bypassed when reporting so that the full resolution gets reported.
+    CONSTRAINT_CACHE_KEY key = { aConstraintId, aLayer, ITEM_SIGNATURE( a ), ITEM_SIGNATURE( b ) };
+    bool                 cached = false;
+    bool                 cacheable = true;
+
+    if( !aReporter )
+    {
+        std::shared_lock<std::shared_timed_mutex> lock( m_constraintCacheLock );
+        auto                                      cacheIt = m_constraintCache.find( key );
+
+        if( cacheIt != m_constraintCache.end() )
+        {
+            constraintRef = cacheIt->second.m_constraint;
+            implicit = cacheIt->second.m_implicit;
+            cached = true;
+        }
+    }
+
+    auto ruleIt = m_constraintMap.find( aConstraintId );
+
+    if( !cached && ruleIt != m_constraintMap.end() )
     {
-        std::vector<CONSTRAINT_WITH_CONDITIONS*>* ruleset = m_constraintMap[ aConstraintId ];
+        std::vector<CONSTRAINT_WITH_CONDITIONS*>* ruleset = ruleIt->second;
 
         // Last matching rule wins, so process in reverse order
         for( int ii = (int) ruleset->size() - 1; ii >= 0; --ii )
@@ -533,6 +906,9 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
                                               rcons->condition->GetExpression() ) )
                 }
 
+                if( !rcons->condition->IsCacheable() )
+                    cacheable = false;
+
                 if( rcons->condition->EvaluateFor( a, b, aLayer, aReporter ) )
                 {
                     REPORT( implicit ? _( "Constraint applicable." )
@@ -550,6 +926,12 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
         }
     }
 
+    if( !cached && cacheable && !aReporter )
+    {
+        std::unique_lock<std::shared_timed_mutex> lock( m_constraintCacheLock );
+        m_constraintCache[ key ] = { constraintRef, implicit };
+    }
+
     // Unfortunately implicit rules don't work for local clearances (such as zones) because
     // they have to be max'ed with netclass values (which are already implicit rules), and our
     // rule selection paradigm is "winner takes all".
@@ -568,7 +950,7 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
                                       MessageTextFromValue( UNITS, localA, true ) ) )
 
             if( localA > clearance )
-                clearance = connectedA->GetLocalClearance( &m_msg );
+                clearance = connectedA->GetLocalClearance( &source );
         }
 
         if( localB > 0 )
@@ -579,12 +961,12 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
                                       MessageTextFromValue( UNITS, localB, true ) ) )
 
             if( localB > clearance )
-                clearance = connectedB->GetLocalClearance( &m_msg );
+                clearance = connectedB->GetLocalClearance( &source );
         }
 
         if( localA > global || localB > global )
         {
-            DRC_CONSTRAINT constraint( DRC_CONSTRAINT_TYPE_CLEARANCE, m_msg );
+            DRC_CONSTRAINT constraint( DRC_CONSTRAINT_TYPE_CLEARANCE, source );
             constraint.m_Value.SetMin( clearance );
             return constraint;
         }
@@ -592,8 +974,7 @@ DRC_CONSTRAINT DRC_ENGINE::EvalRulesForItems( DRC_CONSTRAINT_TYPE_T aConstraintI
 
     // fixme: return optional<drc_constraint>, let the particular test decide what to do if no matching constraint
     // is found
-    static DRC_CONSTRAINT nullConstraint;
-    nullConstraint.m_DisallowFlags = 0;
+    static const DRC_CONSTRAINT nullConstraint;
 
     return constraintRef ? *constraintRef : nullConstraint;
 
@@ -611,6 +992,12 @@ bool DRC_ENGINE::IsErrorLimitExceeded( int error_code )
 
 void DRC_ENGINE::ReportViolation( const std::shared_ptr<DRC_ITEM>& aItem, wxPoint aPos )
 {
+    if( s_deferredReports )
+    {
+        s_deferredReports->push_back( { aItem, aPos, wxEmptyString } );
+        return;
+    }
+
     m_errorLimits[ aItem->GetErrorCode() ] -= 1;
 
     if( m_violationHandler )
@@ -643,6 +1030,12 @@ void DRC_ENGINE::ReportAux ( const wxString& aStr )
     if( !m_reporter )
         return;
 
+    if( s_deferredReports )
+    {
+        s_deferredReports->push_back( { nullptr, wxPoint(), aStr } );
+        return;
+    }
+
     m_reporter->Report( aStr, RPT_SEVERITY_INFO );
 }
 
@@ -653,6 +1046,11 @@ bool DRC_ENGINE::ReportProgress( double aProgress )
         return true;
 
     m_progressReporter->SetCurrentProgress( aProgress );
+
+    // Only the main thread may touch the UI; workers just check for cancellation
+    if( std::this_thread::get_id() != m_mainThreadId )
+        return !m_progressReporter->IsCancelled();
+
     return m_progressReporter->KeepRefreshing( false );
 }
 
@@ -663,6 +1061,10 @@ bool DRC_ENGINE::ReportPhase( const wxString& aMessage )
         return true;
 
     m_progressReporter->AdvancePhase( aMessage );
+
+    if( std::this_thread::get_id() != m_mainThreadId )
+        return !m_progressReporter->IsCancelled();
+
     return m_progressReporter->KeepRefreshing( false );
 }
 
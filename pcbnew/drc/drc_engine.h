@@ -24,10 +24,16 @@
 #ifndef DRC_ENGINE_H
 #define DRC_ENGINE_H
 
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 
+#include <eda_rect.h>
 #include <drc/drc_rule.h>
 
 
@@ -41,6 +47,7 @@ class MARKER_PCB;
 class NETCLASS;
 class NETLIST;
 class PROGRESS_REPORTER;
+class TASK_GROUP;
 class REPORTER;
 
 namespace KIGFX
@@ -127,6 +134,12 @@ public:
 
     /**
      * Runs the DRC tests.
+     *
+     * Providers which only read the board (see DRC_TEST_PROVIDER::IsThreadSafe()) are run
+     * concurrently.  All violations are buffered per provider and handed to the violation
+     * handler in provider order once the tests are complete, so the report is identical to
+     * that of a serial run.
+     *
      * @param aUnits
      * @param aTestTracksAgainstZones
      * @param aReportAllTrackErrors
@@ -135,6 +148,54 @@ public:
     void RunTests( EDA_UNITS aUnits = EDA_UNITS::MILLIMETRES, bool aTestTracksAgainstZones = true,
                    bool aReportAllTrackErrors = true, bool aTestFootprints = true );
 
+    /**
+     * Re-runs the tests which support it (see DRC_TEST_PROVIDER::SupportsIncremental()) on
+     * only the part of the board which an edit may have affected.
+     *
+     * The dirty region is made up of \a aDirtyAreas inflated by the worst clearance.  Tests
+     * on single items are run for the items touching it, and tests on pairs of items for the
+     * pairs which both touch it.  The region stays in effect until the next run so that the
+     * caller can find the stale violations with IsSupersededByIncrementalRun().
+     *
+     * @param aDirtyAreas the bounding boxes of the changed items, both before and after the
+     *                    change (and of any deleted items)
+     */
+    void RunTestsIncremental( const std::vector<EDA_RECT>& aDirtyAreas,
+                              EDA_UNITS aUnits = EDA_UNITS::MILLIMETRES,
+                              bool aTestTracksAgainstZones = false,
+                              bool aReportAllTrackErrors = true );
+
+    /**
+     * @return true unless the current run is an incremental one and \a aItem lies entirely
+     *         outside its dirty region.
+     */
+    bool InDirtyRegion( const BOARD_ITEM* aItem ) const;
+
+    /**
+     * @return true if \a aItem was reported by one of the providers re-run by the last
+     *         incremental run, and all the items it refers to either touch the dirty region or
+     *         have been deleted.  Such a violation would have been reported again had it still
+     *         applied.
+     */
+    bool IsSupersededByIncrementalRun( const DRC_ITEM* aItem );
+
+    /**
+     * Runs \a aFunc over the range [0, aCount) split into \a aChunks contiguous chunks, each a
+     * task of the shared THREAD_POOL.  Violations and log messages reported from within the
+     * chunks are buffered and replayed in chunk order once all of them have finished, so the
+     * result is identical to that of a serial walk over the range.
+     *
+     * @param aFunc is called as aFunc( chunkIndex, begin, end ); the chunk index allows callers
+     *              to keep per-worker scratch state.
+     */
+    void ParallelFor( size_t aCount, size_t aChunks,
+                      const std::function<void( size_t, size_t, size_t )>& aFunc );
+
+    /**
+     * @return the number of worker threads a provider should split its work over.
+     */
+    size_t GetThreadCount() const;
+
     BOARD_DESIGN_SETTINGS* GetDesignSettings() const { return m_designSettings; }
 
     BOARD* GetBoard() const { return m_board; }
@@ -146,6 +207,12 @@ public:
                                       PCB_LAYER_ID aLayer = UNDEFINED_LAYER,
                                       REPORTER* aReporter = nullptr );
 
+    /**
+     * Discards the constraints memoized by EvalRulesForItems().  Must be called whenever the
+     * rules or the board's netclasses may have changed.
+     */
+    void ClearConstraintCache();
+
     std::vector<DRC_CONSTRAINT> QueryConstraintsById( DRC_CONSTRAINT_TYPE_T ruleID );
 
     bool HasRulesForConstraintType( DRC_CONSTRAINT_TYPE_T constraintID );
@@ -188,6 +255,80 @@ private:
         DRC_CONSTRAINT       constraint;
     };
 
+public:
+    /**
+     * A violation (or, when m_item is null, a log message) reported from a worker thread and
+     * held back until it can be passed on in a deterministic order.
+     */
+    struct DEFERRED_REPORT
+    {
+        std::shared_ptr<DRC_ITEM> m_item;
+        wxPoint                   m_pos;
+        wxString                  m_message;
+    };
+
+    typedef std::vector<DEFERRED_REPORT> DEFERRED_REPORTS;
+
+private:
+    void replayReports( const DEFERRED_REPORTS& aReports );
+
+    /**
+     * Waits for a group of tasks, keeping the progress reporter alive if called from the
+     * thread which started the tests.
+     */
+    void waitForWorkers( TASK_GROUP& aTasks );
+
+    void runTests( EDA_UNITS aUnits, bool aTestTracksAgainstZones, bool aReportAllTrackErrors,
+                   bool aTestFootprints );
+
+    /**
+     * The properties of an item which a cacheable rule condition can depend on.  Two items
+     * with equal signatures always resolve to the same rules.
+     * See PCB_EXPR_UCODE::IsCacheable().
+     */
+    struct ITEM_SIGNATURE
+    {
+        KICAD_T         m_type;
+        PCB_LAYER_ID    m_layer;
+        LSET            m_layers;
+        const NETCLASS* m_netclass;
+        int             m_subType;     // VIATYPE for vias, PAD_ATTR_T for pads
+
+        ITEM_SIGNATURE( const BOARD_ITEM* aItem );
+
+        bool operator==( const ITEM_SIGNATURE& aOther ) const
+        {
+            return m_type == aOther.m_type && m_layer == aOther.m_layer
+                    && m_netclass == aOther.m_netclass && m_subType == aOther.m_subType
+                    && m_layers == aOther.m_layers;
+        }
+    };
+
+    struct CONSTRAINT_CACHE_KEY
+    {
+        DRC_CONSTRAINT_TYPE_T m_constraintType;
+        PCB_LAYER_ID          m_layer;
+        ITEM_SIGNATURE        m_a;
+        ITEM_SIGNATURE        m_b;
+
+        bool operator==( const CONSTRAINT_CACHE_KEY& aOther ) const
+        {
+            return m_constraintType == aOther.m_constraintType && m_layer == aOther.m_layer
+                    && m_a == aOther.m_a && m_b == aOther.m_b;
+        }
+    };
+
+    struct CONSTRAINT_CACHE_KEY_HASH
+    {
+        size_t operator()( const CONSTRAINT_CACHE_KEY& aKey ) const;
+    };
+
+    struct CACHED_CONSTRAINT
+    {
+        const DRC_CONSTRAINT* m_constraint;    // nullptr if no rule applies
+        bool                  m_implicit;
+    };
+
     void loadImplicitRules();
     void loadTestProviders();
     DRC_RULE* createImplicitRule( const wxString& name );
@@ -208,14 +349,30 @@ protected:
     bool                             m_reportAllTrackErrors;
     bool                             m_testFootprints;
 
+    // The dirty region of the last run, if it was an incremental one
+    bool                             m_incremental;
+    std::vector<EDA_RECT>            m_dirtyAreas;
+
+    // The board items by id, built by the first IsSupersededByIncrementalRun() after a run
+    std::map<KIID, EDA_ITEM*>        m_incrementalItemMap;
+
     // constraint -> rule -> provider
     std::unordered_map< DRC_CONSTRAINT_TYPE_T,
                         std::vector<CONSTRAINT_WITH_CONDITIONS*>* > m_constraintMap;
 
+    // Rule resolution results for item signatures, filled in by EvalRulesForItems().  Lookups
+    // from the provider threads share the lock; only storing a new result takes it exclusively.
+    std::unordered_map<CONSTRAINT_CACHE_KEY, CACHED_CONSTRAINT,
+                       CONSTRAINT_CACHE_KEY_HASH>   m_constraintCache;
+    std::shared_timed_mutex          m_constraintCacheLock;
+
     DRC_VIOLATION_HANDLER            m_violationHandler;
     REPORTER*                        m_reporter;
     PROGRESS_REPORTER*               m_progressReporter;
 
+    // The thread RunTests() was called from; the only one allowed to refresh the UI
+    std::thread::id                  m_mainThreadId;
+
     wxString m_msg;  // Allocating strings gets expensive enough to want to avoid it
 };
 
@@ -0,0 +1,178 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef DRC_RTREE_H_
+#define DRC_RTREE_H_
+
+#include <algorithm>
+#include <vector>
+
+#include <eda_rect.h>
+#include <class_board_item.h>
+#include <layers_id_colors_and_visibility.h>
+
+#include <geometry/rtree.h>
+
+
+/**
+ * DRC_RTREE -
+ * Implements a per-layer R-tree for fast spatial indexing of board items during DRC.
+ * Non-owning.
+ *
+ * Each item is stored with its bounding box inflated by a caller-supplied clearance (usually
+ * the worst clearance of the test being run), so a query with an item's own bounding box
+ * returns every item which could possibly violate that clearance.
+ *
+ * Query results are always returned in insertion order so that providers iterating over the
+ * candidates report violations in exactly the same order as a plain list walk would.
+ */
+class DRC_RTREE
+{
+private:
+    using drc_rtree = RTree<int, int, 2, double>;
+
+public:
+    DRC_RTREE()
+    {
+        for( int layer = 0; layer < PCB_LAYER_ID_COUNT; ++layer )
+            m_tree[layer] = new drc_rtree();
+    }
+
+    ~DRC_RTREE()
+    {
+        for( drc_rtree* tree : m_tree )
+            delete tree;
+    }
+
+    /**
+     * Function Insert()
+     * Inserts an item into the tree on each of the layers in \a aLayers which it occupies.
+     * @param aItem the item to index
+     * @param aLayers the layers on which the item is to be indexed
+     * @param aWorstClearance the amount by which to inflate the item's bounding box
+     */
+    void Insert( BOARD_ITEM* aItem, LSET aLayers, int aWorstClearance = 0 )
+    {
+        EDA_RECT bbox = aItem->GetBoundingBox();
+
+        bbox.Normalize();
+        bbox.Inflate( aWorstClearance );
+
+        Insert( aItem, bbox, aLayers & aItem->GetLayerSet() );
+    }
+
+    /**
+     * Function Insert()
+     * Inserts an item into the tree with an explicitly given bounding box.
+     */
+    void Insert( BOARD_ITEM* aItem, const EDA_RECT& aBBox, LSET aLayers )
+    {
+        const int index   = (int) m_items.size();
+        const int mmin[2] = { aBBox.GetX(), aBBox.GetY() };
+        const int mmax[2] = { aBBox.GetRight(), aBBox.GetBottom() };
+
+        m_items.push_back( aItem );
+
+        for( PCB_LAYER_ID layer : aLayers.Seq() )
+            m_tree[layer]->Insert( mmin, mmax, index );
+    }
+
+    /**
+     * Function clear()
+     * Removes all items from the RTree
+     */
+    void clear()
+    {
+        for( drc_rtree* tree : m_tree )
+            tree->RemoveAll();
+
+        m_items.clear();
+    }
+
+    /**
+     * @return the number of distinct items indexed
+     */
+    size_t size() const
+    {
+        return m_items.size();
+    }
+
+    bool empty() const
+    {
+        return m_items.empty();
+    }
+
+    /**
+     * Function QueryColliding()
+     * Collects the items on any of \a aLayers whose (inflated) bounding box intersects
+     * \a aRect.  Each item is reported once, in insertion order.
+     *
+     * @param aResult receives the candidate items (it is cleared first)
+     * @param aMinIndex only items inserted at or after this index are returned; used by
+     *                  tests which only need to look at each pair of items once
+     */
+    void QueryColliding( const EDA_RECT& aRect, LSET aLayers, std::vector<BOARD_ITEM*>& aResult,
+                         int aMinIndex = 0 ) const
+    {
+        EDA_RECT rect = aRect;
+        rect.Normalize();
+
+        const int        mmin[2] = { rect.GetX(), rect.GetY() };
+        const int        mmax[2] = { rect.GetRight(), rect.GetBottom() };
+        std::vector<int> indices;
+
+        auto visitor =
+                [&]( const int& aIndex ) -> bool
+                {
+                    if( aIndex >= aMinIndex )
+                        indices.push_back( aIndex );
+
+                    return true;
+                };
+
+        for( PCB_LAYER_ID layer : aLayers.Seq() )
+            m_tree[layer]->Search( mmin, mmax, visitor );
+
+        std::sort( indices.begin(), indices.end() );
+        indices.erase( std::unique( indices.begin(), indices.end() ), indices.end() );
+
+        aResult.clear();
+        aResult.reserve( indices.size() );
+
+        for( int index : indices )
+            aResult.push_back( m_items[index] );
+    }
+
+    void QueryColliding( const EDA_RECT& aRect, PCB_LAYER_ID aLayer,
+                         std::vector<BOARD_ITEM*>& aResult, int aMinIndex = 0 ) const
+    {
+        QueryColliding( aRect, LSET( aLayer ), aResult, aMinIndex );
+    }
+
+private:
+    drc_rtree*               m_tree[PCB_LAYER_ID_COUNT];
+    std::vector<BOARD_ITEM*> m_items;
+};
+
+
+#endif /* DRC_RTREE_H_ */
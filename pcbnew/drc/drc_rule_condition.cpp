@@ -84,6 +84,13 @@ bool DRC_RULE_CONDITION::EvaluateFor( const BOARD_ITEM* aItemA, const BOARD_ITEM
 }
 
 
+bool DRC_RULE_CONDITION::IsCacheable() const
+{
+    // An uncompiled (or failed) condition always evaluates to false
+    return !m_ucode || m_ucode->IsCacheable();
+}
+
+
 bool DRC_RULE_CONDITION::Compile( REPORTER* aReporter, int aSourceLine, int aSourceOffset )
 {
     PCB_EXPR_COMPILER compiler;
@@ -44,6 +44,13 @@ public:
 
     bool Compile( REPORTER* aReporter, int aSourceLine = 0, int aSourceOffset = 0 );
 
+    /**
+     * @return false if the condition reads properties which are specific to individual items
+     * (geometry, position, etc.), meaning that its results can't be shared between items of the
+     * same type, netclass and layers.  Derived from the compiled expression.
+     */
+    bool IsCacheable() const;
+
     void SetExpression( const wxString& aExpression ) { m_expression = aExpression; }
     wxString GetExpression() const { return m_expression; }
 
@@ -125,6 +125,13 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
     std::bitset<MAX_STRUCT_TYPE_ID> typeMask;
     int n = 0;
 
+    // In an incremental run only the items touching the dirty region need to be (re)tested
+    auto visit =
+            [&]( BOARD_ITEM* aItem ) -> bool
+            {
+                return !m_drcEngine->InDirtyRegion( aItem ) || aFunc( aItem );
+            };
+
     if( aTypes.size() == 0 )
     {
         for( int i = 0; i < MAX_STRUCT_TYPE_ID; i++ )
@@ -142,17 +149,17 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
         {
             if( typeMask[ PCB_TRACE_T ] && item->Type() == PCB_TRACE_T )
             {
-                aFunc( item );
+                visit( item );
                 n++;
             }
             else if( typeMask[ PCB_VIA_T ] && item->Type() == PCB_VIA_T )
             {
-                aFunc( item );
+                visit( item );
                 n++;
             }
             else if( typeMask[ PCB_ARC_T ] && item->Type() == PCB_ARC_T )
             {
-                aFunc( item );
+                visit( item );
                 n++;
             }
         }
@@ -164,28 +171,28 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
         {
             if( typeMask[PCB_DIMENSION_T] && BaseType( item->Type() ) == PCB_DIMENSION_T )
             {
-                if( !aFunc( item ) )
+                if( !visit( item ) )
                     return n;
 
                 n++;
             }
             else if( typeMask[ PCB_LINE_T ] && item->Type() == PCB_LINE_T )
             {
-                if( !aFunc( item ) )
+                if( !visit( item ) )
                     return n;
 
                 n++;
             }
             else if( typeMask[ PCB_TEXT_T ] && item->Type() == PCB_TEXT_T )
             {
-                if( !aFunc( item ) )
+                if( !visit( item ) )
                     return n;
 
                 n++;
             }
             else if( typeMask[ PCB_TARGET_T ] && item->Type() == PCB_TARGET_T )
             {
-                if( !aFunc( item ) )
+                if( !visit( item ) )
                     return n;
 
                 n++;
@@ -199,7 +206,7 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
         {
             if( typeMask[ PCB_ZONE_AREA_T ] && item->Type() == PCB_ZONE_AREA_T )
             {
-                if( !aFunc( item ) )
+                if( !visit( item ) )
                     return n;
 
                 n++;
@@ -213,7 +220,7 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
         {
             if( (mod->Reference().GetLayerSet() & aLayers).any() )
             {
-                if( !aFunc( &mod->Reference() ) )
+                if( !visit( &mod->Reference() ) )
                     return n;
 
                 n++;
@@ -221,7 +228,7 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
 
             if( (mod->Value().GetLayerSet() & aLayers).any() )
             {
-                if( !aFunc( &mod->Value() ) )
+                if( !visit( &mod->Value() ) )
                     return n;
 
                 n++;
@@ -234,7 +241,7 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
             {
                 if( typeMask[ PCB_PAD_T ] && pad->Type() == PCB_PAD_T )
                 {
-                    if( !aFunc( pad ) )
+                    if( !visit( pad ) )
                         return n;
 
                     n++;
@@ -248,14 +255,14 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
             {
                 if( typeMask[ PCB_MODULE_TEXT_T ] && dwg->Type() == PCB_MODULE_TEXT_T )
                 {
-                    if( !aFunc( dwg ) )
+                    if( !visit( dwg ) )
                         return n;
 
                     n++;
                 }
                 else if( typeMask[ PCB_MODULE_EDGE_T ] && dwg->Type() == PCB_MODULE_EDGE_T )
                 {
-                    if( !aFunc( dwg ) )
+                    if( !visit( dwg ) )
                         return n;
 
                     n++;
@@ -269,7 +276,7 @@ int DRC_TEST_PROVIDER::forEachGeometryItem( const std::vector<KICAD_T>& aTypes,
             {
                 if( typeMask[ PCB_MODULE_ZONE_AREA_T ] && zone->Type() == PCB_MODULE_ZONE_AREA_T )
                 {
-                    if( ! aFunc( zone ) )
+                    if( !visit( zone ) )
                         return n;
 
                     n++;
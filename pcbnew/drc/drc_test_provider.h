@@ -97,6 +97,36 @@ public:
         return m_isRuleDriven;
     }
 
+    /**
+     * Providers which only read the board (and don't touch any caches which other providers
+     * might read) may be run concurrently with each other.
+     */
+    virtual bool IsThreadSafe() const
+    {
+        return false;
+    }
+
+    /**
+     * Providers whose violations are all local to the items involved can be re-run on just
+     * the dirty region of the board (see DRC_ENGINE::RunTestsIncremental()).  Such providers
+     * must skip any item for which DRC_ENGINE::InDirtyRegion() returns false.
+     */
+    virtual bool SupportsIncremental() const
+    {
+        return false;
+    }
+
+    /**
+     * @return true if the last incremental run re-tested the kind of violation of \a aItem,
+     *         whose items still on the board are \a aItems.  Providers which skip some of their
+     *         tests in incremental runs must return false for the violations of those tests.
+     */
+    virtual bool RetestedIncrementally( const DRC_ITEM* aItem,
+                                        const std::vector<EDA_ITEM*>& aItems ) const
+    {
+        return SupportsIncremental();
+    }
+
 protected:
     int forEachGeometryItem( const std::vector<KICAD_T>& aTypes, LSET aLayers,
                              const std::function<bool(BOARD_ITEM*)>& aFunc );
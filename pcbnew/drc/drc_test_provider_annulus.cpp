@@ -63,6 +63,16 @@ public:
     virtual std::set<DRC_CONSTRAINT_TYPE_T> GetConstraintTypes() const override;
 
     int GetNumPhases() const override;
+
+    bool IsThreadSafe() const override
+    {
+        return true;
+    }
+
+    bool SupportsIncremental() const override
+    {
+        return true;
+    }
 };
 
 
@@ -147,6 +157,9 @@ bool DRC_TEST_PROVIDER_ANNULUS::Run()
         if( !reportProgress( ii++, board->Tracks().size(), delta ) )
             break;
 
+        if( !m_drcEngine->InDirtyRegion( item ) )
+            continue;
+
         if( !checkAnnulus( item ) )
             break;
     }
@@ -21,6 +21,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <algorithm>
+
 #include <common.h>
 #include <class_board.h>
 #include <class_drawsegment.h>
@@ -36,6 +38,7 @@
 #include <drc/drc_engine.h>
 #include <drc/drc_item.h>
 #include <drc/drc_rule.h>
+#include <drc/drc_rtree.h>
 #include <drc/drc_test_provider_clearance_base.h>
 #include <class_dimension.h>
 
@@ -78,7 +81,32 @@ public:
 
     int GetNumPhases() const override;
 
+    bool IsThreadSafe() const override
+    {
+        return true;
+    }
+
+    bool SupportsIncremental() const override
+    {
+        return true;
+    }
+
+    bool RetestedIncrementally( const DRC_ITEM* aItem,
+                                const std::vector<EDA_ITEM*>& aItems ) const override;
+
 private:
+    /**
+     * Scratch state for one of the threads testing track clearances.
+     */
+    struct WORKER_CONTEXT
+    {
+        std::vector<BOARD_ITEM*>                 m_candidates;
+        wxString                                 m_msg;
+        std::unordered_map<const DRC_RULE*, int> m_stats;
+    };
+
+    void buildItemTrees();
+
     void testPadClearances();
 
     void testTrackClearances();
@@ -89,8 +117,13 @@ private:
 
     void testCopperDrawItem( BOARD_ITEM* aItem );
 
-    void doTrackDrc( TRACK* aRefSeg, PCB_LAYER_ID aLayer, TRACKS::iterator aStartIt,
-                     TRACKS::iterator aEndIt );
+    /**
+     * Test a track segment against pads, against the tracks following it in the board's
+     * track list (so that each pair is only tested once) and optionally against zones.
+     * @param aRefIndex is the index of aRefSeg in the board's track list
+     * @param aCtx is the calling thread's scratch state
+     */
+    void doTrackDrc( TRACK* aRefSeg, PCB_LAYER_ID aLayer, int aRefIndex, WORKER_CONTEXT& aCtx );
 
     /**
      * Test clearance of a pad hole with the pad hole of other pads.
@@ -102,6 +135,14 @@ private:
      * for each pad for the first in list to the last in list
      */
     void doPadToPadsDrc( int aRefPadIdx, std::vector<D_PAD*>& aSortedPadsList, int aX_limit );
+
+private:
+    // Spatial indexes of the board's pads and tracks, rebuilt at the start of each run.  Track
+    // indices in m_trackTree match their position in BOARD::Tracks().
+    DRC_RTREE                m_padTree;
+    DRC_RTREE                m_trackTree;
+
+    std::vector<BOARD_ITEM*> m_candidates;  // Scratch buffer for tree queries
 };
 
 
@@ -123,6 +164,8 @@ bool DRC_TEST_PROVIDER_COPPER_CLEARANCE::Run()
 
     reportAux( "Worst clearance : %d nm", m_largestClearance );
 
+    buildItemTrees();
+
     if( !reportPhase( _( "Checking pad clearances..." ) ) )
         return false;
 
@@ -148,13 +191,53 @@ bool DRC_TEST_PROVIDER_COPPER_CLEARANCE::Run()
     return true;
 }
 
+
+void DRC_TEST_PROVIDER_COPPER_CLEARANCE::buildItemTrees()
+{
+    LSET layers = LSET::AllCuMask();
+
+    m_padTree.clear();
+    m_trackTree.clear();
+
+    // Pad bounding boxes are inflated by the worst clearance which can apply to them.  This
+    // includes local overrides (which can exceed the worst rule clearance) so that the
+    // candidate set is never smaller than what a full walk of the pads would test.
+    for( MODULE* module : m_board->Modules() )
+    {
+        for( D_PAD* pad : module->Pads() )
+        {
+            if( !m_drcEngine->InDirtyRegion( pad ) )
+                continue;
+
+            int padClearance = std::max( pad->GetLocalClearanceOverrides( nullptr ),
+                                         pad->GetLocalClearance( nullptr ) );
+
+            m_padTree.Insert( pad, layers, std::max( m_largestClearance, padClearance ) );
+        }
+    }
+
+    // Tracks must be inserted in list order, and all of them, so that tree indices and list
+    // indices stay in sync.  Tracks outside the dirty region of an incremental run are indexed
+    // on no layers at all so that they are never reported as candidates.
+    for( TRACK* track : m_board->Tracks() )
+    {
+        if( m_drcEngine->InDirtyRegion( track ) )
+            m_trackTree.Insert( track, layers, m_largestClearance );
+        else
+            m_trackTree.Insert( track, track->GetBoundingBox(), LSET() );
+    }
+
+    reportAux( "Indexed %d pads and %d tracks", (int) m_padTree.size(),
+               (int) m_trackTree.size() );
+}
+
 void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testCopperTextAndGraphics()
 {
     // Test copper items for clearance violations with vias, tracks and pads
 
     for( BOARD_ITEM* brdItem : m_board->Drawings() )
     {
-        if( IsCopperLayer( brdItem->GetLayer() ) )
+        if( IsCopperLayer( brdItem->GetLayer() ) && m_drcEngine->InDirtyRegion( brdItem ) )
             testCopperDrawItem( brdItem );
     }
 
@@ -163,18 +246,24 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testCopperTextAndGraphics()
         TEXTE_MODULE& ref = module->Reference();
         TEXTE_MODULE& val = module->Value();
 
-        if( ref.IsVisible() && IsCopperLayer( ref.GetLayer() ) )
+        if( ref.IsVisible() && IsCopperLayer( ref.GetLayer() )
+                && m_drcEngine->InDirtyRegion( &ref ) )
+        {
             testCopperDrawItem( &ref );
+        }
 
-        if( val.IsVisible() && IsCopperLayer( val.GetLayer() ) )
+        if( val.IsVisible() && IsCopperLayer( val.GetLayer() )
+                && m_drcEngine->InDirtyRegion( &val ) )
+        {
             testCopperDrawItem( &val );
+        }
 
         if( module->IsNetTie() )
             continue;
 
         for( BOARD_ITEM* item : module->GraphicalItems() )
         {
-            if( IsCopperLayer( item->GetLayer() ) )
+            if( IsCopperLayer( item->GetLayer() ) && m_drcEngine->InDirtyRegion( item ) )
             {
                 if( item->Type() == PCB_MODULE_TEXT_T && ( (TEXTE_MODULE*) item )->IsVisible() )
                     testCopperDrawItem( item );
@@ -207,8 +296,12 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testCopperDrawItem( BOARD_ITEM* aItem )
     SHAPE_RECT bboxShape( bbox.GetX(), bbox.GetY(), bbox.GetWidth(), bbox.GetHeight() );
 
     // Test tracks and vias
-    for( TRACK* track : m_board->Tracks() )
+    m_trackTree.QueryColliding( bbox, layer, m_candidates );
+
+    for( BOARD_ITEM* candidate : m_candidates )
     {
+        TRACK* track = static_cast<TRACK*>( candidate );
+
         if( !track->IsOnLayer( aItem->GetLayer() ) )
             continue;
 
@@ -249,8 +342,12 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testCopperDrawItem( BOARD_ITEM* aItem )
     }
 
     // Test pads
-    for( D_PAD* pad : m_board->GetPads() )
+    m_padTree.QueryColliding( bbox, layer, m_candidates );
+
+    for( BOARD_ITEM* candidate : m_candidates )
     {
+        D_PAD* pad = static_cast<D_PAD*>( candidate );
+
         if( !pad->IsOnLayer( layer ) )
             continue;
 
@@ -300,24 +397,41 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testTrackClearances()
 
     reportAux( "Testing %d tracks...", count );
 
-    int ii = 0;
+    // The tracks are split into contiguous runs, each tested on its own thread.  The engine
+    // replays the violations in run order, so the report matches that of a single pass.
+    size_t                      chunks = m_drcEngine->GetThreadCount();
+    std::vector<WORKER_CONTEXT> contexts( chunks );
 
-    for( auto seg_it = m_board->Tracks().begin(); seg_it != m_board->Tracks().end(); seg_it++ )
-    {
-        if( !reportProgress( ii++, m_board->Tracks().size(), delta ) )
-            break;
+    m_drcEngine->ParallelFor( count, chunks,
+            [&]( size_t aChunk, size_t aBegin, size_t aEnd )
+            {
+                WORKER_CONTEXT& ctx = contexts[ aChunk ];
 
-        // Test segment against tracks and pads, optionally against copper zones
-        for( PCB_LAYER_ID layer : (*seg_it)->GetLayerSet().Seq() )
-        {
-            doTrackDrc( *seg_it, layer, seg_it + 1, m_board->Tracks().end() );
-        }
+                for( size_t ii = aBegin; ii < aEnd; ++ii )
+                {
+                    if( !reportProgress( ii, count, delta ) )
+                        break;
+
+                    TRACK* track = m_board->Tracks()[ ii ];
+
+                    if( !m_drcEngine->InDirtyRegion( track ) )
+                        continue;
+
+                    // Test segment against tracks and pads, optionally against copper zones
+                    for( PCB_LAYER_ID layer : track->GetLayerSet().Seq() )
+                        doTrackDrc( track, layer, ii, ctx );
+                }
+            } );
+
+    for( const WORKER_CONTEXT& ctx : contexts )
+    {
+        for( const std::pair<const DRC_RULE* const, int>& stat : ctx.m_stats )
+            m_stats[ stat.first ] += stat.second;
     }
 }
 
 void DRC_TEST_PROVIDER_COPPER_CLEARANCE::doTrackDrc( TRACK* aRefSeg, PCB_LAYER_ID aLayer,
-                                                     TRACKS::iterator aStartIt,
-                                                     TRACKS::iterator aEndIt )
+                                                     int aRefIndex, WORKER_CONTEXT& aCtx )
 {
     BOARD_DESIGN_SETTINGS&  bds = m_board->GetDesignSettings();
 
@@ -331,57 +445,52 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::doTrackDrc( TRACK* aRefSeg, PCB_LAYER_I
     /* Phase 1 : test DRC track to pads :     */
     /******************************************/
 
-    // Compute the min distance to pads
-    for( MODULE* mod : m_board->Modules() )
+    // Compute the min distance to pads.  The pad tree returns the candidates in module
+    // order, just as walking the modules would.
+    m_padTree.QueryColliding( aRefSeg->GetBoundingBox(), aLayer, aCtx.m_candidates );
+
+    for( BOARD_ITEM* candidate : aCtx.m_candidates )
     {
+        D_PAD* pad = static_cast<D_PAD*>( candidate );
+
         if( m_drcEngine->IsErrorLimitExceeded( DRCE_CLEARANCE ) )
             break;
 
-        // Don't preflight at the module level.  Getting a module's bounding box goes
-        // through all its pads anyway (so it's no faster), and also all its drawings
-        // (so it's in fact slower).
-
-        for( D_PAD* pad : mod->Pads() )
-        {
-            if( m_drcEngine->IsErrorLimitExceeded( DRCE_CLEARANCE ) )
-                break;
-
-            // Preflight based on bounding boxes.
-            if( !refSegInflatedBB.Intersects( pad->GetBoundingBox() ) )
-                continue;
+        // Preflight based on bounding boxes.
+        if( !refSegInflatedBB.Intersects( pad->GetBoundingBox() ) )
+            continue;
 
-            /// Skip checking pad copper when it has been removed
-            if( !pad->IsOnLayer( aLayer ) )
-                continue;
+        /// Skip checking pad copper when it has been removed
+        if( !pad->IsOnLayer( aLayer ) )
+            continue;
 
-            // No need to check pads with the same net as the refSeg.
-            if( pad->GetNetCode() && aRefSeg->GetNetCode() == pad->GetNetCode() )
-                continue;
+        // No need to check pads with the same net as the refSeg.
+        if( pad->GetNetCode() && aRefSeg->GetNetCode() == pad->GetNetCode() )
+            continue;
 
-            auto constraint = m_drcEngine->EvalRulesForItems( DRC_CONSTRAINT_TYPE_CLEARANCE,
-                                                              aRefSeg, pad, aLayer );
-            int  minClearance = constraint.GetValue().Min();
-            int  actual;
+        auto constraint = m_drcEngine->EvalRulesForItems( DRC_CONSTRAINT_TYPE_CLEARANCE,
+                                                          aRefSeg, pad, aLayer );
+        int  minClearance = constraint.GetValue().Min();
+        int  actual;
 
-            accountCheck( constraint );
+        aCtx.m_stats[ constraint.GetParentRule() ]++;
 
-            const std::shared_ptr<SHAPE>& padShape = pad->GetEffectiveShape();
+        const std::shared_ptr<SHAPE>& padShape = pad->GetEffectiveShape();
 
-            if( padShape->Collide( &refSeg, minClearance - bds.GetDRCEpsilon(), &actual ) )
-            {
-                std::shared_ptr<DRC_ITEM> drcItem = DRC_ITEM::Create( DRCE_CLEARANCE );
+        if( padShape->Collide( &refSeg, minClearance - bds.GetDRCEpsilon(), &actual ) )
+        {
+            std::shared_ptr<DRC_ITEM> drcItem = DRC_ITEM::Create( DRCE_CLEARANCE );
 
-                m_msg.Printf( drcItem->GetErrorText() + _( " (%s clearance %s; actual %s)" ),
-                              constraint.GetName(),
-                              MessageTextFromValue( userUnits(), minClearance, true ),
-                              MessageTextFromValue( userUnits(), actual, true ) );
+            aCtx.m_msg.Printf( drcItem->GetErrorText() + _( " (%s clearance %s; actual %s)" ),
+                          constraint.GetName(),
+                          MessageTextFromValue( userUnits(), minClearance, true ),
+                          MessageTextFromValue( userUnits(), actual, true ) );
 
-                drcItem->SetErrorMessage( m_msg );
-                drcItem->SetItems( aRefSeg, pad );
-                drcItem->SetViolatingRule( constraint.GetParentRule() );
+            drcItem->SetErrorMessage( aCtx.m_msg );
+            drcItem->SetItems( aRefSeg, pad );
+            drcItem->SetViolatingRule( constraint.GetParentRule() );
 
-                reportViolation( drcItem, pad->GetPosition());
-            }
+            reportViolation( drcItem, pad->GetPosition());
         }
     }
 
@@ -389,13 +498,16 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::doTrackDrc( TRACK* aRefSeg, PCB_LAYER_I
     /* Phase 2: test DRC with other track segments */
     /***********************************************/
 
-    // Test the reference segment with other track segments
-    for( auto it = aStartIt; it != aEndIt; it++ )
+    // Test the reference segment with the track segments which follow it in the list
+    m_trackTree.QueryColliding( aRefSeg->GetBoundingBox(), aLayer, aCtx.m_candidates,
+                                aRefIndex + 1 );
+
+    for( BOARD_ITEM* candidate : aCtx.m_candidates )
     {
         if( m_drcEngine->IsErrorLimitExceeded( DRCE_CLEARANCE ) )
             break;
 
-        TRACK* track = *it;
+        TRACK* track = static_cast<TRACK*>( candidate );
 
         if( track->Type() == PCB_VIA_T )
         {
@@ -422,7 +534,7 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::doTrackDrc( TRACK* aRefSeg, PCB_LAYER_I
         int           actual;
         SHAPE_SEGMENT trackSeg( track->GetStart(), track->GetEnd(), track->GetWidth() );
 
-        accountCheck( constraint );
+        aCtx.m_stats[ constraint.GetParentRule() ]++;
 
         /// Check to see if the via has a pad on this layer
         if( track->Type() == PCB_VIA_T )
@@ -447,12 +559,12 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::doTrackDrc( TRACK* aRefSeg, PCB_LAYER_I
             wxPoint   pos = getLocation( aRefSeg, trackSeg.GetSeg() );
             std::shared_ptr<DRC_ITEM> drcItem = DRC_ITEM::Create( DRCE_CLEARANCE );
 
-            m_msg.Printf( drcItem->GetErrorText() + _( " (%s clearance %s; actual %s)" ),
+            aCtx.m_msg.Printf( drcItem->GetErrorText() + _( " (%s clearance %s; actual %s)" ),
                           constraint.GetName(),
                           MessageTextFromValue( userUnits(), minClearance, true ),
                           MessageTextFromValue( userUnits(), actual, true ) );
 
-            drcItem->SetErrorMessage( m_msg );
+            drcItem->SetErrorMessage( aCtx.m_msg );
             drcItem->SetItems( aRefSeg, track );
             drcItem->SetViolatingRule( constraint.GetParentRule() );
 
@@ -480,6 +592,9 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::doTrackDrc( TRACK* aRefSeg, PCB_LAYER_I
             if( !zone->GetLayerSet().test( aLayer ) || zone->GetIsRuleArea() )
                 continue;
 
+            if( !m_drcEngine->InDirtyRegion( zone ) )
+                continue;
+
             if( zone->GetNetCode() && zone->GetNetCode() == aRefSeg->GetNetCode() )
                 continue;
 
@@ -496,19 +611,19 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::doTrackDrc( TRACK* aRefSeg, PCB_LAYER_I
             int  allowedDist  = minClearance + halfWidth - bds.GetDRCEpsilon();
             int  actual;
 
-            accountCheck( constraint );
+            aCtx.m_stats[ constraint.GetParentRule() ]++;
 
             if( zone->GetFilledPolysList( aLayer ).Collide( testSeg, allowedDist, &actual ) )
             {
                 actual = std::max( 0, actual - halfWidth );
                 std::shared_ptr<DRC_ITEM> drcItem = DRC_ITEM::Create( DRCE_CLEARANCE );
 
-                m_msg.Printf( drcItem->GetErrorText() + _( " (%s clearance %s; actual %s)" ),
+                aCtx.m_msg.Printf( drcItem->GetErrorText() + _( " (%s clearance %s; actual %s)" ),
                               constraint.GetName(),
                               MessageTextFromValue( userUnits(), minClearance, true ),
                               MessageTextFromValue( userUnits(), actual, true ) );
 
-                drcItem->SetErrorMessage( m_msg );
+                drcItem->SetErrorMessage( aCtx.m_msg );
                 drcItem->SetItems( aRefSeg, zone );
                 drcItem->SetViolatingRule( constraint.GetParentRule() );
 
@@ -526,6 +641,14 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testPadClearances( )
 
     m_board->GetSortedPadListByXthenYCoord( sortedPads );
 
+    // In an incremental run only pads in the dirty region are tested (and tested against)
+    sortedPads.erase( std::remove_if( sortedPads.begin(), sortedPads.end(),
+                                      [&]( D_PAD* aPad )
+                                      {
+                                          return !m_drcEngine->InDirtyRegion( aPad );
+                                      } ),
+                      sortedPads.end() );
+
     reportAux( "Testing %d pads...", sortedPads.size());
 
     if( sortedPads.empty() )
@@ -697,7 +820,7 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testZones()
 
             ZONE_CONTAINER* zoneRef = m_board->GetArea( ia );
 
-            if( !zoneRef->IsOnLayer( layer ) )
+            if( !zoneRef->IsOnLayer( layer ) || !m_drcEngine->InDirtyRegion( zoneRef ) )
                 continue;
 
             // If we are testing a single zone, then iterate through all other zones
@@ -710,7 +833,7 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testZones()
                     continue;
 
                 // test for same layer
-                if( !zoneToTest->IsOnLayer( layer ) )
+                if( !zoneToTest->IsOnLayer( layer ) || !m_drcEngine->InDirtyRegion( zoneToTest ) )
                     continue;
 
                 // Test for same net
@@ -847,6 +970,39 @@ void DRC_TEST_PROVIDER_COPPER_CLEARANCE::testZones()
 }
 
 
+bool DRC_TEST_PROVIDER_COPPER_CLEARANCE::RetestedIncrementally(
+        const DRC_ITEM* aItem, const std::vector<EDA_ITEM*>& aItems ) const
+{
+    if( m_drcEngine->GetTestTracksAgainstZones() )
+        return true;
+
+    // Tracks weren't tested against zones: their violations stand
+    bool hasTrack = false;
+    bool hasZone = false;
+
+    for( EDA_ITEM* item : aItems )
+    {
+        switch( item->Type() )
+        {
+        case PCB_TRACE_T:
+        case PCB_ARC_T:
+        case PCB_VIA_T:
+            hasTrack = true;
+            break;
+
+        case PCB_ZONE_AREA_T:
+            hasZone = true;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return !( hasTrack && hasZone );
+}
+
+
 int DRC_TEST_PROVIDER_COPPER_CLEARANCE::GetNumPhases() const
 {
     return 4;
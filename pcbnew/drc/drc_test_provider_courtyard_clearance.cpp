@@ -66,6 +66,11 @@ public:
 
     int GetNumPhases() const override;
 
+    bool SupportsIncremental() const override
+    {
+        return true;
+    }
+
 private:
     void testFootprintCourtyardDefinitions();
 
@@ -88,6 +93,9 @@ void DRC_TEST_PROVIDER_COURTYARD_CLEARANCE::testFootprintCourtyardDefinitions()
         if( !reportProgress( ii++, m_board->Modules().size(), delta ) )
             return;
 
+        if( !m_drcEngine->InDirtyRegion( footprint ) )
+            continue;
+
         if( footprint->BuildPolyCourtyard() )
         {
             if( footprint->GetPolyCourtyardFront().OutlineCount() == 0
@@ -147,9 +155,16 @@ void DRC_TEST_PROVIDER_COURTYARD_CLEARANCE::testOverlappingComponentCourtyards()
         if( footprintFront.OutlineCount() == 0 && footprintBack.OutlineCount() == 0 )
             continue; // No courtyards defined
 
+        if( !m_drcEngine->InDirtyRegion( footprint ) )
+            continue;
+
         for( auto it2 = it1 + 1; it2 != m_board->Modules().end(); it2++ )
         {
             MODULE*         test = *it2;
+
+            if( !m_drcEngine->InDirtyRegion( test ) )
+                continue;
+
             SHAPE_POLY_SET& testFront = test->GetPolyCourtyardFront();
             SHAPE_POLY_SET& testBack = test->GetPolyCourtyardBack();
             SHAPE_POLY_SET  intersection;
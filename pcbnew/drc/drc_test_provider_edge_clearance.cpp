@@ -28,6 +28,7 @@
 #include <drc/drc_engine.h>
 #include <drc/drc_item.h>
 #include <drc/drc_rule.h>
+#include <drc/drc_rtree.h>
 #include <drc/drc_test_provider_clearance_base.h>
 
 /*
@@ -67,6 +68,16 @@ public:
     virtual std::set<DRC_CONSTRAINT_TYPE_T> GetConstraintTypes() const override;
 
     int GetNumPhases() const override;
+
+    bool IsThreadSafe() const override
+    {
+        return true;
+    }
+
+    bool SupportsIncremental() const override
+    {
+        return true;
+    }
 };
 
 
@@ -93,7 +104,8 @@ bool DRC_TEST_PROVIDER_EDGE_CLEARANCE::Run()
         return false;
     
     std::vector<DRAWSEGMENT*> boardOutline;
-    std::vector<BOARD_ITEM*> boardItems;
+    DRC_RTREE                 boardItems;
+    std::vector<BOARD_ITEM*>  candidates;
 
     auto queryBoardOutlineItems =
             [&]( BOARD_ITEM *item ) -> bool
@@ -105,7 +117,7 @@ bool DRC_TEST_PROVIDER_EDGE_CLEARANCE::Run()
     auto queryBoardGeometryItems =
             [&]( BOARD_ITEM *item ) -> bool
             {
-                boardItems.push_back( item );
+                boardItems.Insert( item, LSET::AllCuMask(), m_largestClearance );
                 return true;
             };
 
@@ -125,7 +137,11 @@ bool DRC_TEST_PROVIDER_EDGE_CLEARANCE::Run()
 
         const std::shared_ptr<SHAPE>& refShape = outlineItem->GetEffectiveShape();
 
-        for( BOARD_ITEM* boardItem : boardItems )
+        // Only items whose bounding box comes within the worst edge clearance of the outline
+        // item can possibly violate it.
+        boardItems.QueryColliding( outlineItem->GetBoundingBox(), LSET::AllCuMask(), candidates );
+
+        for( BOARD_ITEM* boardItem : candidates )
         {
             if( m_drcEngine->IsErrorLimitExceeded( DRC_CONSTRAINT_TYPE_EDGE_CLEARANCE ) )
                 break;
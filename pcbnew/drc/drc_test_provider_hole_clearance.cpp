@@ -21,6 +21,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <algorithm>
+
 #include <common.h>
 #include <class_drawsegment.h>
 #include <class_pad.h>
@@ -69,6 +71,16 @@ public:
 
     int GetNumPhases() const override;
 
+    bool IsThreadSafe() const override
+    {
+        return true;
+    }
+
+    bool SupportsIncremental() const override
+    {
+        return true;
+    }
+
 private:
     void addHole( const VECTOR2I& aLocation, int aRadius, BOARD_ITEM* aOwner );
 
@@ -150,7 +162,7 @@ void DRC_TEST_PROVIDER_HOLE_CLEARANCE::buildDrilledHoleList()
         {
             int holeSize = std::min( pad->GetDrillSize().x, pad->GetDrillSize().y );
 
-            if( holeSize == 0 )
+            if( holeSize == 0 || !m_drcEngine->InDirtyRegion( pad ) )
                 continue;
 
             // Milled holes (slots) aren't required to meet the minimum hole-to-hole
@@ -162,7 +174,7 @@ void DRC_TEST_PROVIDER_HOLE_CLEARANCE::buildDrilledHoleList()
 
     for( TRACK* track : m_board->Tracks() )
     {
-        if( track->Type() == PCB_VIA_T )
+        if( track->Type() == PCB_VIA_T && m_drcEngine->InDirtyRegion( track ) )
         {
             VIA* via = static_cast<VIA*>( track );
             addHole( via->GetPosition(), via->GetDrillValue() / 2, via );
@@ -179,6 +191,14 @@ void DRC_TEST_PROVIDER_HOLE_CLEARANCE::testPads2Holes()
 
     m_board->GetSortedPadListByXthenYCoord( sortedPads );
 
+    // In an incremental run only pads in the dirty region are tested (and tested against)
+    sortedPads.erase( std::remove_if( sortedPads.begin(), sortedPads.end(),
+                                      [&]( D_PAD* aPad )
+                                      {
+                                          return !m_drcEngine->InDirtyRegion( aPad );
+                                      } ),
+                      sortedPads.end() );
+
     if( sortedPads.empty() )
         return;
 
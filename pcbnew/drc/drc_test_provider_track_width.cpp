@@ -61,6 +61,16 @@ public:
     virtual std::set<DRC_CONSTRAINT_TYPE_T> GetConstraintTypes() const override;
 
     int GetNumPhases() const override;
+
+    bool IsThreadSafe() const override
+    {
+        return true;
+    }
+
+    bool SupportsIncremental() const override
+    {
+        return true;
+    }
 };
 
 
@@ -146,6 +156,9 @@ bool DRC_TEST_PROVIDER_TRACK_WIDTH::Run()
         if( !reportProgress( ii++, m_drcEngine->GetBoard()->Tracks().size(), delta ) )
             break;
 
+        if( !m_drcEngine->InDirtyRegion( item ) )
+            continue;
+
         if( !checkTrackWidth( item ) )
             break;
     }
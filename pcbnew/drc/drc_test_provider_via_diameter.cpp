@@ -59,6 +59,16 @@ public:
     virtual std::set<DRC_CONSTRAINT_TYPE_T> GetConstraintTypes() const override;
 
     int GetNumPhases() const override;
+
+    bool IsThreadSafe() const override
+    {
+        return true;
+    }
+
+    bool SupportsIncremental() const override
+    {
+        return true;
+    }
 };
 
 
@@ -133,6 +143,9 @@ bool DRC_TEST_PROVIDER_VIA_DIAMETER::Run()
         if( !reportProgress( ii++, m_drcEngine->GetBoard()->Tracks().size(), delta ) )
             break;
 
+        if( !m_drcEngine->InDirtyRegion( item ) )
+            continue;
+
         if( !checkViaDiameter( item ) )
             break;
     }
@@ -0,0 +1,252 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <atomic>
+#include <chrono>
+#include <utility>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <common.h>
+#include <fab_output_job.h>
+#include <gendrill_Excellon_writer.h>
+#include <gendrill_gerber_writer.h>
+#include <gerber_placefile_writer.h>
+#include <ki_exception.h>
+#include <pcbplot.h>
+#include <plotter.h>
+#include <reporter.h>
+#include <thread_pool.h>
+
+
+/**
+ * Keeps the messages of an output made on a worker thread, until they can be passed on in
+ * the order of the outputs.
+ */
+class DEFERRED_REPORTER : public REPORTER
+{
+public:
+    DEFERRED_REPORTER() :
+            m_hasError( false ),
+            m_done( false )
+    {
+    }
+
+    REPORTER& Report( const wxString& aText, SEVERITY aSeverity = RPT_SEVERITY_UNDEFINED ) override
+    {
+        m_messages.emplace_back( aText, aSeverity );
+        m_hasError |= aSeverity == RPT_SEVERITY_ERROR;
+        return *this;
+    }
+
+    bool HasMessage() const override
+    {
+        return !m_messages.empty();
+    }
+
+    bool HasError() const
+    {
+        return m_hasError;
+    }
+
+    void ReportTo( REPORTER& aReporter ) const
+    {
+        for( const std::pair<wxString, SEVERITY>& message : m_messages )
+            aReporter.Report( message.first, message.second );
+    }
+
+    ///> Marks the output as done: its messages won't change anymore
+    void SetDone() { m_done = true; }
+
+    bool IsDone() const { return m_done; }
+
+private:
+    std::vector<std::pair<wxString, SEVERITY>> m_messages;
+    bool                                       m_hasError;
+    std::atomic<bool>                          m_done;
+};
+
+
+FAB_OUTPUT_JOB::FAB_OUTPUT_JOB( BOARD* aBoard ) :
+        m_board( aBoard )
+{
+}
+
+
+void FAB_OUTPUT_JOB::AddLayer( PCB_LAYER_ID aLayer, const wxString& aFullFileName,
+                               const PCB_PLOT_PARAMS& aPlotOpts, const wxString& aSheetDesc )
+{
+    BOARD* board = m_board;
+
+    m_outputs.push_back(
+            [board, aLayer, aFullFileName, aPlotOpts, aSheetDesc]( REPORTER& aReporter )
+            {
+                PCB_PLOT_PARAMS plotOpts = aPlotOpts;
+                PLOTTER*        plotter = StartPlotBoard( board, &plotOpts, aLayer,
+                                                          aFullFileName, aSheetDesc );
+                wxString        msg;
+
+                if( !plotter )
+                {
+                    msg.Printf( _( "Unable to create file \"%s\"." ), aFullFileName );
+                    aReporter.Report( msg, RPT_SEVERITY_ERROR );
+                    return;
+                }
+
+                PlotOneBoardLayer( board, plotter, aLayer, plotOpts );
+                plotter->EndPlot();
+                delete plotter->RenderSettings();
+                delete plotter;
+
+                msg.Printf( _( "Plot file \"%s\" created." ), aFullFileName );
+                aReporter.Report( msg, RPT_SEVERITY_ACTION );
+            } );
+}
+
+
+void FAB_OUTPUT_JOB::AddDrillFiles( EXCELLON_WRITER* aWriter, const wxString& aPlotDirectory,
+                                    bool aGenDrill, bool aGenMap )
+{
+    m_outputs.push_back(
+            [aWriter, aPlotDirectory, aGenDrill, aGenMap]( REPORTER& aReporter )
+            {
+                aWriter->CreateDrillandMapFilesSet( aPlotDirectory, aGenDrill, aGenMap,
+                                                    &aReporter );
+            } );
+}
+
+
+void FAB_OUTPUT_JOB::AddDrillFiles( GERBER_WRITER* aWriter, const wxString& aPlotDirectory,
+                                    bool aGenDrill, bool aGenMap )
+{
+    m_outputs.push_back(
+            [aWriter, aPlotDirectory, aGenDrill, aGenMap]( REPORTER& aReporter )
+            {
+                aWriter->CreateDrillandMapFilesSet( aPlotDirectory, aGenDrill, aGenMap,
+                                                    &aReporter );
+            } );
+}
+
+
+void FAB_OUTPUT_JOB::AddPlaceFile( PCB_LAYER_ID aSide, const wxString& aFullFileName,
+                                   bool aIncludeBoardEdges )
+{
+    BOARD* board = m_board;
+
+    m_outputs.push_back(
+            [board, aSide, aFullFileName, aIncludeBoardEdges]( REPORTER& aReporter )
+            {
+                PLACEFILE_GERBER_WRITER writer( board );
+                wxString                fileName = aFullFileName;
+                wxString                msg;
+
+                int count = writer.CreatePlaceFile( fileName, aSide, aIncludeBoardEdges );
+
+                if( count < 0 )
+                {
+                    msg.Printf( _( "Unable to create file \"%s\"." ), fileName );
+                    aReporter.Report( msg, RPT_SEVERITY_ERROR );
+                    return;
+                }
+
+                msg.Printf( aSide == B_Cu ? _( "Back side (bottom side) place file: \"%s\"." )
+                                          : _( "Front side (top side) place file: \"%s\"." ),
+                            fileName );
+                aReporter.Report( msg, RPT_SEVERITY_INFO );
+
+                msg.Printf( _( "Component count: %d." ), count );
+                aReporter.Report( msg, RPT_SEVERITY_INFO );
+            } );
+}
+
+
+bool FAB_OUTPUT_JOB::Run( REPORTER* aReporter, const std::function<void()>& aYield )
+{
+    // The C locale is kept for the whole job: the LOCALE_IO of each output then only adds to
+    // the count of this one, rather than switching the locale of the process under the others
+    LOCALE_IO toggle;
+
+    // Pads build their shapes when first needed.  Build them here rather than from several
+    // threads at once.
+    for( MODULE* module : m_board->Modules() )
+    {
+        for( D_PAD* pad : module->Pads() )
+            pad->GetBoundingBox();
+    }
+
+    std::vector<DEFERRED_REPORTER> reports( m_outputs.size() );
+    size_t                         reported = 0;
+    bool                           success = true;
+    TASK_GROUP                     tasks;
+
+    // Passes on the messages of the outputs done so far, in the order of the outputs
+    auto reportDone =
+            [&]()
+            {
+                for( ; reported < reports.size() && reports[reported].IsDone(); ++reported )
+                {
+                    if( aReporter )
+                        reports[reported].ReportTo( *aReporter );
+
+                    success &= !reports[reported].HasError();
+                }
+            };
+
+    for( size_t ii = 0; ii < m_outputs.size(); ++ii )
+    {
+        tasks.Run(
+                [this, &reports, ii]()
+                {
+                    try
+                    {
+                        m_outputs[ii]( reports[ii] );
+                    }
+                    catch( const IO_ERROR& ioe )
+                    {
+                        reports[ii].Report( ioe.What(), RPT_SEVERITY_ERROR );
+                    }
+
+                    reports[ii].SetDone();
+                } );
+    }
+
+    if( aYield )
+    {
+        while( !tasks.WaitFor( std::chrono::milliseconds( 100 ) ) )
+        {
+            reportDone();
+            aYield();
+        }
+    }
+
+    tasks.Wait();
+    m_outputs.clear();
+
+    reportDone();
+
+    if( aYield )
+        aYield();
+
+    return success;
+}
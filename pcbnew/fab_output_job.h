@@ -0,0 +1,94 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef FAB_OUTPUT_JOB_H
+#define FAB_OUTPUT_JOB_H
+
+#include <functional>
+#include <vector>
+
+#include <layers_id_colors_and_visibility.h>
+#include <pcb_plot_params.h>
+
+class BOARD;
+class EXCELLON_WRITER;
+class GERBER_WRITER;
+class REPORTER;
+
+
+/**
+ * FAB_OUTPUT_JOB
+ * generates a set of fabrication outputs of a board -- plotted layers, drill files and drill
+ * maps, placement files -- in parallel on the THREAD_POOL, each with its own plotter.
+ *
+ * The files are the same as when the outputs are made one after the other: nothing in the
+ * board is modified while plotting, and the messages of each output are passed on to the
+ * reporter in the order the outputs were added, once they are all done.
+ */
+class FAB_OUTPUT_JOB
+{
+public:
+    FAB_OUTPUT_JOB( BOARD* aBoard );
+
+    /**
+     * Adds the plot of \a aLayer to \a aFullFileName, as PlotOneBoardLayer() does it with
+     * \a aPlotOpts, which are copied.
+     */
+    void AddLayer( PCB_LAYER_ID aLayer, const wxString& aFullFileName,
+                   const PCB_PLOT_PARAMS& aPlotOpts, const wxString& aSheetDesc = wxEmptyString );
+
+    /**
+     * Adds the drill files and/or drill maps made by \a aWriter in \a aPlotDirectory.  The
+     * writer is not owned, and must be kept until Run() returns.
+     */
+    void AddDrillFiles( EXCELLON_WRITER* aWriter, const wxString& aPlotDirectory,
+                        bool aGenDrill, bool aGenMap );
+
+    void AddDrillFiles( GERBER_WRITER* aWriter, const wxString& aPlotDirectory,
+                        bool aGenDrill, bool aGenMap );
+
+    /**
+     * Adds the Gerber placement file of the footprints of \a aSide (F_Cu or B_Cu).
+     */
+    void AddPlaceFile( PCB_LAYER_ID aSide, const wxString& aFullFileName,
+                       bool aIncludeBoardEdges );
+
+    /**
+     * Generates all the outputs added since the last run, and waits for them.
+     * @param aReporter receives the messages of the outputs, if not null.
+     * @param aYield if not null, is called on the calling thread while waiting, after the
+     *               messages of the outputs done so far have been reported.  The calling
+     *               thread then doesn't run outputs itself, so that a dialog can show the
+     *               progress.
+     * @return true if all the files were created.
+     */
+    bool Run( REPORTER* aReporter = nullptr, const std::function<void()>& aYield = nullptr );
+
+private:
+    BOARD* m_board;
+
+    /// The outputs to generate.  An output failed if it reported an error.
+    std::vector<std::function<void( REPORTER& )>> m_outputs;
+};
+
+#endif // FAB_OUTPUT_JOB_H
@@ -50,12 +50,28 @@
 #include <settings/settings_manager.h>
 #include <project/project_file.h>
 #include <project/project_local_settings.h>
+#include <zone_filler.h>
+#include <zone_fill_cache.h>
+#include <pcb_snapshot_io.h>
+#include <thread_pool.h>
 
 
 //#define     USE_INSTRUMENTATION     1
 #define     USE_INSTRUMENTATION     0
 
 
+/**
+ * @return the name of the zone fill cache file kept next to \a aBoardFileName.
+ */
+static wxString zoneFillCacheFileName( const wxString& aBoardFileName )
+{
+    wxFileName fn( aBoardFileName );
+
+    fn.SetFullName( fn.GetFullName() + wxT( "-zone-fill-cache" ) );
+    return fn.GetFullPath();
+}
+
+
 /**
  * Function AskLoadBoardFileName
  * puts up a wxFileDialog asking for a BOARD filename to open.
@@ -586,11 +602,55 @@ bool PCB_EDIT_FRAME::OpenProjectFiles( const std::vector<wxString>& aFileSet, in
     {
         BOARD* loadedBoard = 0;   // it will be set to non-NULL if loaded OK
 
-        PLUGIN::RELEASER pi( IO_MGR::PluginFind( pluginType ) );
+        IO_MGR::PCB_FILE_T loadType = pluginType;
+
+        // Unchanged boards are loaded from their snapshot, once it is fully written
+        if( pluginType == IO_MGR::KICAD_SEXP && m_snapshotWriter )
+        {
+            m_snapshotWriter->Wait();
+            loadType = IO_MGR::KICAD_SNAPSHOT;
+        }
+
+        PLUGIN::RELEASER pi( IO_MGR::PluginFind( loadType ) );
 
         // This will rename the file if there is an autosave and the user want to recover
 		CheckForAutoSaveFile( fullFileName );
 
+        // The fills saved in the cache are those of the board file when it hasn't changed
+        // since, in which case they don't have to be parsed
+        bool     fillsCached = false;
+        uint64_t boardHash = 0;
+
+        if( m_zoneFillCache && m_zoneFillCache->Load( zoneFillCacheFileName( fullFileName ) ) )
+        {
+            fillsCached = PCB_SNAPSHOT_IO::HashBoardFile( fullFileName, boardHash )
+                          && boardHash == m_zoneFillCache->BoardHash();
+        }
+
+        if( fillsCached && pluginType == IO_MGR::KICAD_SEXP )
+        {
+            ZONE_FILL_CACHE* cache = m_zoneFillCache;
+
+            static_cast<PCB_IO*>( (PLUGIN*) pi )->SetFilledPolysSource(
+                    [cache]( ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer ) -> bool
+                    {
+                        uint64_t         slot = ZONE_FILL_CACHE::SlotFor( aZone->m_Uuid.Hash(),
+                                                                          aLayer );
+                        SHAPE_POLY_SET   polys;
+                        std::vector<int> islands;
+
+                        if( !cache->FindSavedFill( slot, polys, islands ) )
+                            return false;
+
+                        aZone->SetFilledPolysList( aLayer, polys );
+
+                        for( int island : islands )
+                            aZone->SetIsIsland( aLayer, island );
+
+                        return true;
+                    } );
+        }
+
         try
         {
             PROPERTIES  props;
@@ -630,6 +690,17 @@ bool PCB_EDIT_FRAME::OpenProjectFiles( const std::vector<wxString>& aFileSet, in
             return false;
         }
 
+        // Install the cached triangulations of the zone fills before the canvas computes them
+        if( m_zoneFillCache && m_zoneFillCache->size() )
+        {
+            std::vector<ZONE_CONTAINER*> zones( loadedBoard->Zones().begin(),
+                                                loadedBoard->Zones().end() );
+            ZONE_FILLER                  filler( loadedBoard, nullptr );
+
+            filler.SetFillCache( m_zoneFillCache );
+            filler.UseCachedTriangulations( zones );
+        }
+
         SetBoard( loadedBoard );
 
         // On save; design settings will be removed from the board
@@ -798,13 +869,30 @@ bool PCB_EDIT_FRAME::SavePcbFile( const wxString& aFileName, bool addToHistory,
     wxString    upperTxt;
     wxString    lowerTxt;
 
+    // The snapshot of the previous save may still be being written
+    if( m_snapshotWriter )
+        m_snapshotWriter->Wait();
+
+    std::shared_ptr<const std::string> snapshot;
+
     try
     {
-        PLUGIN::RELEASER    pi( IO_MGR::PluginFind( IO_MGR::KICAD_SEXP ) );
-
         wxASSERT( tempFile.IsAbsolute() );
 
-        pi->Save( tempFile.GetFullPath(), GetBoard(), NULL );
+        if( m_snapshotWriter )
+        {
+            // The snapshot is built from the same formatting of the board as the file
+            PCB_SNAPSHOT_IO io;
+
+            snapshot = std::make_shared<const std::string>(
+                    io.SaveWithSnapshot( tempFile.GetFullPath(), GetBoard() ) );
+        }
+        else
+        {
+            PLUGIN::RELEASER    pi( IO_MGR::PluginFind( IO_MGR::KICAD_SEXP ) );
+
+            pi->Save( tempFile.GetFullPath(), GetBoard(), NULL );
+        }
     }
     catch( const IO_ERROR& ioe )
     {
@@ -848,6 +936,52 @@ bool PCB_EDIT_FRAME::SavePcbFile( const wxString& aFileName, bool addToHistory,
             upperTxt.clear();
     }
 
+    uint64_t boardHash = 0;
+
+    if( m_zoneFillCache && PCB_SNAPSHOT_IO::HashBoardFile( pcbFileName.GetFullPath(), boardHash ) )
+    {
+        m_zoneFillCache->ClearSavedFills();
+
+        // Also keep the triangulations done outside of the zone filler (ie: by the canvas),
+        // and the fills as they are in the board file, to be used in place of parsing them
+        for( ZONE_CONTAINER* zone : GetBoard()->Zones() )
+        {
+            for( PCB_LAYER_ID layer : zone->GetLayerSet().Seq() )
+            {
+                if( zone->HasFilledPolysForLayer( layer ) )
+                {
+                    const SHAPE_POLY_SET& polys = zone->GetFilledPolysList( layer );
+                    uint64_t              slot = ZONE_FILL_CACHE::SlotFor( zone->m_Uuid.Hash(),
+                                                                           layer );
+                    std::vector<int>      islands;
+
+                    for( int ii = 0; ii < polys.OutlineCount(); ++ii )
+                    {
+                        if( zone->IsIsland( layer, ii ) )
+                            islands.push_back( ii );
+                    }
+
+                    m_zoneFillCache->StoreTriangulation( slot, polys );
+                    m_zoneFillCache->StoreSavedFill( slot, polys, islands );
+                }
+            }
+        }
+
+        m_zoneFillCache->Save( zoneFillCacheFileName( pcbFileName.GetFullPath() ), boardHash );
+    }
+
+    if( snapshot && !snapshot->empty() )
+    {
+        // It records the board file as written, so only writing it is left to the background
+        wxString boardFileName = pcbFileName.GetFullPath();
+
+        m_snapshotWriter->Run(
+                [snapshot, boardFileName]()
+                {
+                    PCB_SNAPSHOT_IO::WriteSnapshot( boardFileName, *snapshot );
+                } );
+    }
+
     GetBoard()->SetFileName( pcbFileName.GetFullPath() );
     UpdateTitle();
 
@@ -36,8 +36,8 @@
 #include <pgm_base.h>
 #include <wildcards_and_files_ext.h>
 #include <widgets/progress_reporter.h>
+#include <thread_pool.h>
 
-#include <thread>
 #include <mutex>
 
 
@@ -185,7 +185,6 @@ void FOOTPRINT_LIST_IMPL::StartWorkers( FP_LIB_TABLE* aTable, wxString const* aN
     m_count_finished.store( 0 );
     m_errors.clear();
     m_list.clear();
-    m_threads.clear();
     m_queue_in.clear();
     m_queue_out.clear();
 
@@ -199,10 +198,10 @@ void FOOTPRINT_LIST_IMPL::StartWorkers( FP_LIB_TABLE* aTable, wxString const* aN
 
     m_loader->m_total_libs = m_queue_in.size();
 
+    m_workers = std::make_unique<TASK_GROUP>();
+
     for( unsigned i = 0; i < aNThreads; ++i )
-    {
-        m_threads.emplace_back( &FOOTPRINT_LIST_IMPL::loader_job, this );
-    }
+        m_workers->Run( [this]() { loader_job(); } );
 }
 
 void FOOTPRINT_LIST_IMPL::StopWorkers()
@@ -213,10 +212,10 @@ void FOOTPRINT_LIST_IMPL::StopWorkers()
     // exit on their next safe loop location when this is set).  Then we need to wait
     // for all threads to finish as closing the implementation will free the queues
     // that the threads write to.
-    for( auto& i : m_threads )
-        i.join();
+    if( m_workers )
+        m_workers->Wait();
 
-    m_threads.clear();
+    m_workers.reset();
     m_queue_in.clear();
     m_count_finished.store( 0 );
 
@@ -230,31 +229,50 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
     {
         std::lock_guard<std::mutex> lock1( m_join );
 
-        for( auto& i : m_threads )
-            i.join();
+        if( m_workers )
+            m_workers->Wait();
 
-        m_threads.clear();
+        m_workers.reset();
         m_queue_in.clear();
         m_count_finished.store( 0 );
     }
 
     size_t total_count = m_queue_out.size();
 
-    LOCALE_IO toggle_locale;
+    // Parse the footprints in parallel.  The s-expression parser reads numbers without regard to
+    // the locale, but the other plugins (legacy, GEDA, Eagle...) still need the C locale, which
+    // is GLOBAL.  It is only threadsafe to construct the LOCALE_IO before the threads are
+    // created, destroy it after they finish, and block the main (GUI) thread while they work.
+    // Any deviation from this will cause nasal demons.  So only switch it when a library in
+    // the table is not a KiCad one.
+    std::unique_ptr<LOCALE_IO> toggle_locale;
+
+    for( const wxString& nickname : m_lib_table->GetLogicalLibs() )
+    {
+        const FP_LIB_TABLE_ROW* row = nullptr;
+
+        try
+        {
+            row = m_lib_table->FindRow( nickname );
+        }
+        catch( const IO_ERROR& )
+        {
+            // The workers will report it
+        }
 
-    // Parse the footprints in parallel. WARNING! This requires changing the locale, which is
-    // GLOBAL. It is only threadsafe to construct the LOCALE_IO before the threads are created,
-    // destroy it after they finish, and block the main (GUI) thread while they work. Any deviation
-    // from this will cause nasal demons.
-    //
-    // TODO: blast LOCALE_IO into the sun
+        if( !row || row->GetType() != IO_MGR::ShowType( IO_MGR::KICAD_SEXP ) )
+        {
+            toggle_locale = std::make_unique<LOCALE_IO>();
+            break;
+        }
+    }
 
     SYNC_QUEUE<std::unique_ptr<FOOTPRINT_INFO>> queue_parsed;
-    std::vector<std::thread>                    threads;
+    TASK_GROUP                                  tasks;
 
-    for( size_t ii = 0; ii < std::thread::hardware_concurrency() + 1; ++ii )
+    for( size_t ii = 0; ii < tasks.GetPool().GetWorkerCount(); ++ii )
     {
-        threads.emplace_back( [this, &queue_parsed]() {
+        tasks.Run( [this, &queue_parsed]() {
             wxString nickname;
 
             while( this->m_queue_out.pop( nickname ) && !m_cancelled )
@@ -303,11 +321,10 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
         if( m_progress_reporter && !m_progress_reporter->KeepRefreshing() )
             m_cancelled = true;
 
-        wxMilliSleep( 30 );
+        tasks.WaitFor( std::chrono::milliseconds( 30 ) );
     }
 
-    for( auto& thr : threads )
-        thr.join();
+    tasks.Wait();
 
     std::unique_ptr<FOOTPRINT_INFO> fpi;
 
@@ -23,13 +23,14 @@
 #include <atomic>
 #include <functional>
 #include <memory>
-#include <thread>
+#include <mutex>
 #include <vector>
 
 #include <footprint_info.h>
 #include <sync_queue.h>
 
 class LOCALE_IO;
+class TASK_GROUP;
 
 class FOOTPRINT_INFO_IMPL : public FOOTPRINT_INFO
 {
@@ -84,7 +85,7 @@ protected:
 class FOOTPRINT_LIST_IMPL : public FOOTPRINT_LIST
 {
     FOOTPRINT_ASYNC_LOADER*  m_loader;
-    std::vector<std::thread> m_threads;
+    std::unique_ptr<TASK_GROUP> m_workers;  // The loader_job()s, on the shared thread pool
     SYNC_QUEUE<wxString>     m_queue_in;
     SYNC_QUEUE<wxString>     m_queue_out;
     std::atomic_size_t       m_count_finished;
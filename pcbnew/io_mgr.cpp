@@ -32,6 +32,7 @@
 #include <kicad_plugin.h>
 #include <legacy_plugin.h>
 #include <pcad2kicadpcb_plugin/pcad_plugin.h>
+#include <pcb_snapshot_io.h>
 #include <plugins/altium/altium_circuit_maker_plugin.h>
 #include <plugins/altium/altium_circuit_studio_plugin.h>
 #include <plugins/altium/altium_designer_plugin.h>
@@ -223,3 +224,5 @@ static IO_MGR::REGISTER_PLUGIN registerGithubPlugin( IO_MGR::GITHUB, wxT("Github
 #endif /* BUILD_GITHUB_PLUGIN */
 static IO_MGR::REGISTER_PLUGIN registerLegacyPlugin( IO_MGR::LEGACY, wxT("Legacy"), []() -> PLUGIN* { return new LEGACY_PLUGIN; } );
 static IO_MGR::REGISTER_PLUGIN registerGPCBPlugin( IO_MGR::GEDA_PCB, wxT("GEDA/Pcb"), []() -> PLUGIN* { return new GPCB_PLUGIN; } );
+static IO_MGR::REGISTER_PLUGIN registerKicadSnapshotPlugin( IO_MGR::KICAD_SNAPSHOT,
+        wxT( "KiCad snapshot" ), []() -> PLUGIN* { return new PCB_SNAPSHOT_IO; } );
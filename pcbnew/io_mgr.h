@@ -62,6 +62,7 @@ public:
         ALTIUM_CIRCUIT_MAKER,
         CADSTAR_PCB_ARCHIVE,
         GEDA_PCB, ///< Geda PCB file formats.
+        KICAD_SNAPSHOT, ///< S-expression board, loaded from its binary snapshot when up to date.
 
     //N.B. This needs to be commented out to ensure compile-type errors
 #if defined(BUILD_GITHUB_PLUGIN)
@@ -192,6 +192,7 @@ void FP_CACHE::Save( MODULE* aModule )
 
             m_owner->SetOutputFormatter( &formatter );
             m_owner->Format( (BOARD_ITEM*) it->second->GetModule() );
+            formatter.Finish();
         }
 
 #ifdef USE_TMP_FILE
@@ -255,7 +256,7 @@ void FP_CACHE::Load()
             // Queue I/O errors so only files that fail to parse don't get loaded.
             try
             {
-                FILE_LINE_READER    reader( fn.GetFullPath() );
+                MAPPED_FILE_LINE_READER reader( fn.GetFullPath() );
 
                 m_owner->m_parser->SetLineReader( &reader );
 
@@ -358,6 +359,8 @@ void PCB_IO::Save( const wxString& aFileName, BOARD* aBoard, const PROPERTIES* a
     Format( aBoard, 1 );
 
     m_out->Print( 0, ")\n" );
+
+    formatter.Finish();
 }
 
 
@@ -451,9 +454,25 @@ void PCB_IO::Format( BOARD_ITEM* aItem, int aNestLevel ) const
 
 void PCB_IO::formatLayer( const BOARD_ITEM* aItem ) const
 {
+    // The canonical layer names never change, so they are only quoted once
+    static const std::vector<std::string> quotedNames =
+            []()
+            {
+                STRING_FORMATTER         formatter;
+                std::vector<std::string> names;
+
+                for( int layer = 0; layer < PCB_LAYER_ID_COUNT; ++layer )
+                    names.push_back( formatter.Quotew( LSET::Name( PCB_LAYER_ID( layer ) ) ) );
+
+                return names;
+            }();
+
     PCB_LAYER_ID layer = aItem->GetLayer();
 
-    m_out->Print( 0, " (layer %s)", m_out->Quotew( LSET::Name( layer ) ).c_str() );
+    if( layer >= 0 && layer < PCB_LAYER_ID_COUNT )
+        m_out->Print( 0, " (layer %s)", quotedNames[layer].c_str() );
+    else
+        m_out->Print( 0, " (layer %s)", m_out->Quotew( LSET::Name( layer ) ).c_str() );
 }
 
 
@@ -651,7 +670,20 @@ void PCB_IO::format( BOARD* aBoard, int aNestLevel ) const
 
     // Save the tracks and vias.
     for( auto track : sorted_tracks )
-        Format( track, aNestLevel );
+    {
+        // Grouped tracks stay in the snapshot text, for the group to find its members
+        if( ( m_ctl & CTL_MARK_SNAPSHOT_ITEMS ) && !track->IsInGroup() )
+        {
+            size_t begin = m_sf.GetString().size();
+
+            Format( track, aNestLevel );
+            markSnapshotItem( begin );
+        }
+        else
+        {
+            Format( track, aNestLevel );
+        }
+    }
 
     if( sorted_tracks.size() )
         m_out->Print( 0, "\n" );
@@ -688,7 +720,7 @@ void PCB_IO::format( DIMENSION* aDimension, int aNestLevel ) const
 
     formatLayer( aDimension );
 
-    m_out->Print( 0, " (tstamp %s)", TO_UTF8( aDimension->m_Uuid.AsString() ) );
+    m_out->Print( 0, " (tstamp %s)", aDimension->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( 0, "\n" );
 
@@ -841,7 +873,7 @@ void PCB_IO::format( DRAWSEGMENT* aSegment, int aNestLevel ) const
 
     m_out->Print( 0, " (width %s)", FormatInternalUnits( aSegment->GetWidth() ).c_str() );
 
-    m_out->Print( 0, " (tstamp %s)", TO_UTF8( aSegment->m_Uuid.AsString() ) );
+    m_out->Print( 0, " (tstamp %s)", aSegment->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( 0, ")\n" );
 }
@@ -926,7 +958,7 @@ void PCB_IO::format( EDGE_MODULE* aModuleDrawing, int aNestLevel ) const
 
     m_out->Print( 0, " (width %s)", FormatInternalUnits( aModuleDrawing->GetWidth() ).c_str() );
 
-    m_out->Print( 0, " (tstamp %s)", TO_UTF8( aModuleDrawing->m_Uuid.AsString() ) );
+    m_out->Print( 0, " (tstamp %s)", aModuleDrawing->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( 0, ")\n" );
 }
@@ -944,7 +976,7 @@ void PCB_IO::format( PCB_TARGET* aTarget, int aNestLevel ) const
 
     formatLayer( aTarget );
 
-    m_out->Print( 0, " (tstamp %s)", TO_UTF8( aTarget->m_Uuid.AsString() ) );
+    m_out->Print( 0, " (tstamp %s)", aTarget->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( 0, ")\n" );
 }
@@ -983,7 +1015,7 @@ void PCB_IO::format( MODULE* aModule, int aNestLevel ) const
     m_out->Print( 0, " (tedit %lX)", (unsigned long)aModule->GetLastEditTime() );
 
     if( !( m_ctl & CTL_OMIT_TSTAMPS ) )
-        m_out->Print( 0, " (tstamp %s)", TO_UTF8( aModule->m_Uuid.AsString() ) );
+        m_out->Print( 0, " (tstamp %s)", aModule->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( 0, "\n" );
 
@@ -1091,8 +1123,20 @@ void PCB_IO::format( MODULE* aModule, int aNestLevel ) const
         Format( gr, aNestLevel+1 );
 
     // Save pads.
-    for( auto pad : sorted_pads )
-        Format( pad, aNestLevel+1 );
+    if( ( m_ctl & CTL_MARK_SNAPSHOT_ITEMS ) && SnapshotsPads( aModule ) && !sorted_pads.empty() )
+    {
+        size_t begin = m_sf.GetString().size();
+
+        for( auto pad : sorted_pads )
+            Format( pad, aNestLevel+1 );
+
+        markSnapshotItem( begin );
+    }
+    else
+    {
+        for( auto pad : sorted_pads )
+            Format( pad, aNestLevel+1 );
+    }
 
     // Save zones.
     for( auto zone : sorted_zones )
@@ -1137,6 +1181,26 @@ void PCB_IO::format( MODULE* aModule, int aNestLevel ) const
 }
 
 
+bool PCB_IO::SnapshotsPads( const MODULE* aModule )
+{
+    for( D_PAD* pad : aModule->Pads() )
+    {
+        if( pad->GetShape() == PAD_SHAPE_CUSTOM )
+            return false;
+    }
+
+    return true;
+}
+
+
+void PCB_IO::markSnapshotItem( size_t aBegin ) const
+{
+    wxASSERT( m_out == &m_sf );
+
+    m_snapshotRanges.emplace_back( aBegin, m_sf.GetString().size() );
+}
+
+
 void PCB_IO::formatLayers( LSET aLayerMask, int aNestLevel ) const
 {
     std::string  output;
@@ -1521,7 +1585,7 @@ void PCB_IO::format( D_PAD* aPad, int aNestLevel ) const
         m_out->Print( aNestLevel+1, ")" );   // end of (basic_shapes
     }
 
-    m_out->Print( 0, " (tstamp %s)", TO_UTF8( aPad->m_Uuid.AsString() ) );
+    m_out->Print( 0, " (tstamp %s)", aPad->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( 0, ")\n" );
 }
@@ -1540,7 +1604,7 @@ void PCB_IO::format( TEXTE_PCB* aText, int aNestLevel ) const
 
     formatLayer( aText );
 
-    m_out->Print( 0, " (tstamp %s)", TO_UTF8( aText->m_Uuid.AsString() ) );
+    m_out->Print( 0, " (tstamp %s)", aText->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( 0, "\n" );
 
@@ -1553,14 +1617,14 @@ void PCB_IO::format( TEXTE_PCB* aText, int aNestLevel ) const
 void PCB_IO::format( PCB_GROUP* aGroup, int aNestLevel ) const
 {
     m_out->Print( aNestLevel, "(group %s (id %s)\n", m_out->Quotew( aGroup->GetName() ).c_str(),
-            TO_UTF8( aGroup->m_Uuid.AsString() ) );
+            aGroup->m_Uuid.AsStdString().c_str() );
     m_out->Print( aNestLevel + 2, "(members\n" );
     std::set<BOARD_ITEM*, BOARD_ITEM::ptr_cmp> sorted_items( aGroup->GetItems().begin(),
             aGroup->GetItems().end() );
 
     for( const auto& item : sorted_items )
     {
-        m_out->Print( aNestLevel + 4, "%s\n", TO_UTF8( item->m_Uuid.AsString() ) );
+        m_out->Print( aNestLevel + 4, "%s\n", item->m_Uuid.AsStdString().c_str() );
     }
 
     m_out->Print( 0, " )\n" );
@@ -1624,7 +1688,7 @@ void PCB_IO::format( TEXTE_MODULE* aText, int aNestLevel ) const
 
     aText->EDA_TEXT::Format( m_out, aNestLevel, m_ctl | CTL_OMIT_HIDE );
 
-    m_out->Print( aNestLevel + 1, "(tstamp %s)\n", TO_UTF8( aText->m_Uuid.AsString() ) );
+    m_out->Print( aNestLevel + 1, "(tstamp %s)\n", aText->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( aNestLevel, ")\n" );
 }
@@ -1709,7 +1773,7 @@ void PCB_IO::format( TRACK* aTrack, int aNestLevel ) const
 
     m_out->Print( 0, " (net %d)", m_mapping->Translate( aTrack->GetNetCode() ) );
 
-    m_out->Print( 0, " (tstamp %s)", TO_UTF8( aTrack->m_Uuid.AsString() ) );
+    m_out->Print( 0, " (tstamp %s)", aTrack->m_Uuid.AsStdString().c_str() );
 
     m_out->Print( 0, ")\n" );
 }
@@ -1734,7 +1798,7 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
         formatLayer( aZone );
     }
 
-    m_out->Print( 0, " (tstamp %s)", TO_UTF8( aZone->m_Uuid.AsString() ) );
+    m_out->Print( 0, " (tstamp %s)", aZone->m_Uuid.AsStdString().c_str() );
 
     if( !aZone->GetZoneName().empty() )
         m_out->Print( 0, " (name %s)", m_out->Quotew( aZone->GetZoneName() ).c_str() );
@@ -1930,6 +1994,8 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
         }
     }
 
+    bool markFills = ( m_ctl & CTL_MARK_SNAPSHOT_ITEMS ) && aZone->Type() == PCB_ZONE_AREA_T;
+
     // Save the PolysList (filled areas)
     for( PCB_LAYER_ID layer : aZone->GetLayerSet().Seq() )
     {
@@ -1938,9 +2004,10 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
 
         if( !fv.IsEmpty() )
         {
-            int  poly_index  = 0;
-            bool new_polygon = true;
-            bool is_closed   = false;
+            size_t begin       = markFills ? m_sf.GetString().size() : 0;
+            int    poly_index  = 0;
+            bool   new_polygon = true;
+            bool   is_closed   = false;
 
             for( auto it = fv.CIterate(); it; ++it )
             {
@@ -1993,6 +2060,9 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
 
             if( !is_closed ) // Should not happen, but...
                 m_out->Print( aNestLevel + 1, ")\n" );
+
+            if( markFills )
+                markSnapshotItem( begin );
         }
 
         // Save the filling segments list
@@ -2040,7 +2110,7 @@ PCB_IO::~PCB_IO()
 
 BOARD* PCB_IO::Load( const wxString& aFileName, BOARD* aAppendToMe, const PROPERTIES* aProperties )
 {
-    FILE_LINE_READER reader( aFileName );
+    MAPPED_FILE_LINE_READER reader( aFileName );
 
     BOARD* board = DoLoad( reader, aAppendToMe, aProperties );
 
@@ -2090,6 +2160,13 @@ BOARD* PCB_IO::DoLoad( LINE_READER& aReader, BOARD* aAppendToMe, const PROPERTIE
 }
 
 
+void PCB_IO::SetFilledPolysSource(
+        const std::function<bool( ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer )>& aSource )
+{
+    m_parser->SetFilledPolysSource( aSource );
+}
+
+
 void PCB_IO::init( const PROPERTIES* aProperties )
 {
     m_board = NULL;
@@ -2114,7 +2191,6 @@ void PCB_IO::validateCache( const wxString& aLibraryPath, bool checkModified )
 void PCB_IO::FootprintEnumerate( wxArrayString& aFootprintNames, const wxString& aLibPath,
                                  bool aBestEfforts, const PROPERTIES* aProperties )
 {
-    LOCALE_IO toggle;     // toggles on, then off, the C locale.
     wxDir     dir( aLibPath );
     wxString  errorMsg;
 
@@ -2145,8 +2221,6 @@ const MODULE* PCB_IO::getFootprint( const wxString& aLibraryPath,
                                     const PROPERTIES* aProperties,
                                     bool checkModified )
 {
-    LOCALE_IO   toggle;     // toggles on, then off, the C locale.
-
     init( aProperties );
 
     try
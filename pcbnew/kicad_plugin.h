@@ -26,7 +26,10 @@
 #define KICAD_PLUGIN_H_
 
 #include <io_mgr.h>
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 #include <layers_id_colors_and_visibility.h>
 
 class BOARD;
@@ -100,6 +103,8 @@ class TEXTE_PCB;
                                                 // (always saved with potion 0,0 and rotation = 0 in library)
 //#define CTL_OMIT_HIDE             (1 << 6)    // found and defined in eda_text.h
 #define CTL_OMIT_LIBNAME            (1 << 7)    ///< Omit lib alias when saving (used for board/not library)
+#define CTL_MARK_SNAPSHOT_ITEMS     (1 << 8)    ///< Record where the items PCB_SNAPSHOT_IO saves apart
+                                                // are in the output (see m_snapshotRanges)
 
 
 // common combinations of the above:
@@ -151,6 +156,13 @@ public:
 
     BOARD* DoLoad( LINE_READER& aReader, BOARD* aAppendToMe, const PROPERTIES* aProperties );
 
+    /**
+     * Sets where the filled polygons of zones come from when they are known without parsing
+     * them (see PCB_PARSER::SetFilledPolysSource()).
+     */
+    void SetFilledPolysSource(
+            const std::function<bool( ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer )>& aSource );
+
     void FootprintEnumerate( wxArrayString& aFootprintNames, const wxString& aLibraryPath,
                              bool aBestEfforts, const PROPERTIES* aProperties = NULL ) override;
 
@@ -208,6 +220,13 @@ public:
 
     BOARD_ITEM* Parse( const wxString& aClipboardSourceInput );
 
+    /**
+     * @return true if PCB_SNAPSHOT_IO saves the pads of \a aModule apart from its text.  Custom
+     *         shaped pads stay in the text, and so do the other pads of their footprint, to keep
+     *         the pads in order.
+     */
+    static bool SnapshotsPads( const MODULE* aModule );
+
 protected:
 
     wxString        m_error;        ///< for throwing exceptions
@@ -229,6 +248,11 @@ protected:
     NETINFO_MAPPING*    m_mapping;  ///< mapping for net codes, so only not empty net codes
                                     ///< are stored with consecutive integers as net codes
 
+    /// With CTL_MARK_SNAPSHOT_ITEMS, the [begin, end) offsets in m_sf of the ungrouped tracks,
+    /// of the filled polygons of board zones and of the pads of footprints for which
+    /// SnapshotsPads() is true, in output order.  Formatting must then go to m_sf.
+    mutable std::vector<std::pair<size_t, size_t>> m_snapshotRanges;
+
     void validateCache( const wxString& aLibraryPath, bool checkModified = true );
 
     const MODULE* getFootprint( const wxString& aLibraryPath, const wxString& aFootprintName,
@@ -282,6 +306,9 @@ private:
     void formatLayer( const BOARD_ITEM* aItem ) const;
 
     void formatLayers( LSET aLayerMask, int aNestLevel = 0 ) const;
+
+    /// Records the output from \a aBegin to now in m_snapshotRanges.
+    void markSnapshotItem( size_t aBegin ) const;
 };
 
 #endif  // KICAD_PLUGIN_H_
@@ -46,7 +46,7 @@
 
 #include <functional>
 #include <memory>
-#include <thread>
+#include <thread_pool.h>
 using namespace std::placeholders;
 
 const LAYER_NUM GAL_LAYER_ORDER[] =
@@ -151,23 +151,19 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( BOARD* aBoard )
 
     m_view->Clear();
 
-    auto zones = aBoard->Zones();
-    std::atomic<size_t> next( 0 );
-    std::atomic<size_t> count_done( 0 );
-    size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+    // Triangulate the zones in the background while the other items are added to the view
+    auto       zones = aBoard->Zones();
+    TASK_GROUP triangulation;
 
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-    {
-        std::thread t = std::thread( [ &count_done, &next, &zones ]( )
-        {
-            for( size_t i = next.fetch_add( 1 ); i < zones.size(); i = next.fetch_add( 1 ) )
-                zones[i]->CacheTriangulation();
-
-            count_done++;
-        } );
-
-        t.detach();
-    }
+    triangulation.Run(
+            [&zones]()
+            {
+                THREAD_POOL::Get().ParallelFor( zones.size(),
+                                                [&zones]( size_t ii )
+                                                {
+                                                    zones[ii]->CacheTriangulation();
+                                                } );
+            } );
 
     if( m_worksheet )
         m_worksheet->SetFileName( TO_UTF8( aBoard->GetFileName() ) );
@@ -188,9 +184,8 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( BOARD* aBoard )
     for( auto marker : aBoard->Markers() )
         m_view->Add( marker );
 
-    // Finalize the triangulation threads
-    while( count_done < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    // Finalize the triangulation
+    triangulation.Wait();
 
     // Load zones
     for( auto zone : aBoard->Zones() )
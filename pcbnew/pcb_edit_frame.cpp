@@ -94,6 +94,9 @@
 #include <widgets/appearance_controls.h>
 #include <widgets/panel_selection_filter.h>
 #include <kiplatform/app.h>
+#include <advanced_config.h>
+#include <zone_fill_cache.h>
+#include <thread_pool.h>
 
 
 #include <widgets/infobar.h>
@@ -191,6 +194,16 @@ PCB_EDIT_FRAME::PCB_EDIT_FRAME( KIWAY* aKiway, wxWindow* aParent ) :
     // assume dirty
     m_ZoneFillsDirty = true;
 
+    m_zoneFillCache = nullptr;
+
+    if( ADVANCED_CFG::GetCfg().m_ZoneFillCache )
+        m_zoneFillCache = new ZONE_FILL_CACHE();
+
+    m_snapshotWriter = nullptr;
+
+    if( ADVANCED_CFG::GetCfg().m_BoardSnapshot )
+        m_snapshotWriter = new TASK_GROUP();
+
     m_rotationAngle = 900;
     m_AboutTitle = "Pcbnew";
 
@@ -408,6 +421,8 @@ PCB_EDIT_FRAME::~PCB_EDIT_FRAME()
 
     delete m_selectionFilterPanel;
     delete m_appearancePanel;
+    delete m_zoneFillCache;
+    delete m_snapshotWriter;    // waits for the snapshot being written, if any
 }
 
 
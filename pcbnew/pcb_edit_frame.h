@@ -64,6 +64,8 @@ class IO_ERROR;
 class FP_LIB_TABLE;
 class BOARD_NETLIST_UPDATER;
 class ACTION_MENU;
+class ZONE_FILL_CACHE;
+class TASK_GROUP;
 enum LAST_PATH_TYPE : unsigned int;
 
 namespace PCB { struct IFACE; }     // KIFACE_I is in pcbnew.cpp
@@ -85,6 +87,13 @@ class PCB_EDIT_FRAME : public PCB_BASE_EDIT_FRAME
     /// The auxiliary right vertical tool bar used to access the microwave tools.
     ACTION_TOOLBAR*         m_microWaveToolBar;
 
+    /// Zone fills kept across sessions; nullptr unless enabled in the advanced config.
+    ZONE_FILL_CACHE*        m_zoneFillCache;
+
+    /// Writes the board snapshots in the background; nullptr unless enabled in the advanced
+    /// config (see PCB_SNAPSHOT_IO).
+    TASK_GROUP*             m_snapshotWriter;
+
 protected:
 
     /**
@@ -249,6 +258,12 @@ public:
 
     bool m_ZoneFillsDirty;                  // Board has been modified since last zone fill.
 
+    /**
+     * @return the on-disk cache of the board's zone fills, or nullptr when it is disabled
+     *         (see ADVANCED_CFG::m_ZoneFillCache).
+     */
+    ZONE_FILL_CACHE* GetZoneFillCache() const { return m_zoneFillCache; }
+
     virtual ~PCB_EDIT_FRAME();
 
     /**
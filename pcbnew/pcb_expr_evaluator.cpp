@@ -22,8 +22,10 @@
  */
 
 
+#include <algorithm>
 #include <cstdio>
 #include <memory>
+#include <set>
 #include <reporter.h>
 #include <class_board.h>
 #include <class_track.h>
@@ -357,8 +359,16 @@ LIBEVAL::VALUE PCB_EXPR_VAR_REF::GetValue( LIBEVAL::CONTEXT* aCtx )
 LIBEVAL::FUNC_CALL_REF PCB_EXPR_UCODE::CreateFuncCall( const wxString& aName )
 {
     PCB_EXPR_BUILTIN_FUNCTIONS& registry = PCB_EXPR_BUILTIN_FUNCTIONS::Instance();
+    wxString                    name = aName.Lower();
 
-    return registry.Get( aName.Lower() );
+    // These only look at an item's layers, via type or pad type
+    static const std::set<wxString> cacheableFuncs = { "onlayer", "isplated", "ismicrovia",
+                                                       "isblindburiedvia" };
+
+    if( !cacheableFuncs.count( name ) )
+        m_cacheable = false;
+
+    return registry.Get( name );
 }
 
 
@@ -389,6 +399,16 @@ std::unique_ptr<LIBEVAL::VAR_REF> PCB_EXPR_UCODE::CreateVarRef( const wxString&
     wxString field( aField );
     field.Replace( "_",  " " );
 
+    // Keep in sync with the item signature in DRC_ENGINE::EvalRulesForItems()
+    static const std::vector<wxString> cacheableProps = { "Type", "Layer", "NetClass",
+                                                          "Via Type", "Pad Type" };
+
+    if( std::none_of( cacheableProps.begin(), cacheableProps.end(),
+                      [&]( const wxString& prop ) { return prop.CmpNoCase( field ) == 0; } ) )
+    {
+        m_cacheable = false;
+    }
+
     for( const PROPERTY_MANAGER::CLASS_INFO& cls : propMgr.GetAllClasses() )
     {
         if( propMgr.IsOfType( cls.type, TYPE_HASH( BOARD_ITEM ) ) )
@@ -40,11 +40,25 @@ class PCB_EXPR_VAR_REF;
 class PCB_EXPR_UCODE final : public LIBEVAL::UCODE
 {
 public:
-    PCB_EXPR_UCODE() {};
+    PCB_EXPR_UCODE() :
+        m_cacheable( true )
+    {};
+
     virtual ~PCB_EXPR_UCODE() {};
 
     virtual std::unique_ptr<LIBEVAL::VAR_REF> CreateVarRef( const wxString& aVar, const wxString& aField ) override;
     virtual LIBEVAL::FUNC_CALL_REF CreateFuncCall( const wxString& aName ) override;
+
+    /**
+     * @return true if the compiled expression only reads properties which are shared by whole
+     * classes of items (type, layer, netclass, via and pad type), so that its result can be
+     * reused for any other pair of items with the same values for those.  Expressions using
+     * geometry (insideArea(), etc.) or per-item properties (position, width, ...) are not.
+     */
+    bool IsCacheable() const { return m_cacheable; }
+
+private:
+    bool m_cacheable;
 };
 
 
@@ -30,6 +30,7 @@
 #include <cerrno>
 #include <common.h>
 #include <confirm.h>
+#include <kicad_string.h>
 #include <macros.h>
 #include <title_block.h>
 #include <trigo.h>
@@ -52,10 +53,48 @@
 #include <pcb_parser.h>
 #include <convert_basic_shapes_to_polygon.h>    // for RECT_CHAMFER_POSITIONS definition
 #include <template_fieldnames.h>
+#include <thread_pool.h>
 
 using namespace PCB_KEYS_T;
 
 
+///> Size of the text above which no more items are added to a batch
+static const size_t ITEM_BATCH_SIZE = 64 * 1024;
+
+
+struct PCB_PARSER::ITEM_BATCH
+{
+    int                                      m_firstLine = 0;   ///< line number of m_text's first
+    int                                      m_lastLine = 0;    ///< line number of m_text's last
+    std::string                              m_text;            ///< empty if parsed in place
+    std::vector<std::unique_ptr<BOARD_ITEM>> m_items;           ///< in file order
+
+    // What the worker found which has to be dealt with on the thread which owns the board
+    std::exception_ptr                                m_error;
+    int                                               m_requiredVersion = 0;
+    std::set<wxString>                                m_undefinedLayers;
+    KIID_MAP                                          m_resetKIIDMap;
+    std::vector<std::pair<ZONE_CONTAINER*, wxString>> m_zoneNets;
+    bool                                              m_legacyZoneFill = false;
+};
+
+
+/**
+ * Reads the text of a batch of board items, numbering its lines as they are in the board
+ * file so that errors point to the right place.
+ */
+class ITEM_BATCH_LINE_READER : public STRING_LINE_READER
+{
+public:
+    ITEM_BATCH_LINE_READER( std::string& aText, int aFirstLine, const wxString& aSource ) :
+            STRING_LINE_READER( std::string(), aSource )
+    {
+        m_lines.swap( aText );
+        m_lineNum = aFirstLine - 1;
+    }
+};
+
+
 void PCB_PARSER::init()
 {
     m_showLegacyZoneWarning = true;
@@ -141,7 +180,7 @@ double PCB_PARSER::parseDouble()
 
     errno = 0;
 
-    double fval = strtod( CurText(), &tmp );
+    double fval = StrToDouble( CurText(), &tmp );
 
     if( errno )
     {
@@ -485,7 +524,6 @@ BOARD_ITEM* PCB_PARSER::Parse()
 {
     T               token;
     BOARD_ITEM*     item;
-    LOCALE_IO       toggle;
 
     // MODULEs can be prefixed with an initial block of single line comments and these
     // are kept for Format() so they round trip in s-expression form.  BOARDs might
@@ -538,108 +576,28 @@ BOARD* PCB_PARSER::parseBOARD()
 
 BOARD* PCB_PARSER::parseBOARD_unchecked()
 {
-    T token;
     std::map<wxString, wxString> properties;
+    std::vector<ITEM_BATCH>      batches;
 
     parseHeader();
 
-    for( token = NextTok();  token != T_RIGHT;  token = NextTok() )
+    try
     {
-        if( token != T_LEFT )
-            Expecting( T_LEFT );
-
-        token = NextTok();
-
-        if( token == T_page && m_requiredVersion <= 20200119 )
-            token = T_paper;
-
-        switch( token )
-        {
-        case T_general:
-            parseGeneralSection();
-            break;
-
-        case T_paper:
-            parsePAGE_INFO();
-            break;
-
-        case T_title_block:
-            parseTITLE_BLOCK();
-            break;
-
-        case T_layers:
-            parseLayers();
-            break;
-
-        case T_setup:
-            parseSetup();
-            break;
-
-        case T_property:
-            properties.insert( parseProperty() );
-            break;
-
-        case T_net:
-            parseNETINFO_ITEM();
-            break;
-
-        case T_net_class:
-            parseNETCLASS();
-            m_board->m_LegacyNetclassesLoaded = true;
-            break;
-
-        case T_gr_arc:
-        case T_gr_circle:
-        case T_gr_curve:
-        case T_gr_rect:
-        case T_gr_line:
-        case T_gr_poly:
-            m_board->Add( parseDRAWSEGMENT(), ADD_MODE::APPEND );
-            break;
-
-        case T_gr_text:
-            m_board->Add( parseTEXTE_PCB(), ADD_MODE::APPEND );
-            break;
-
-        case T_dimension:
-            m_board->Add( parseDIMENSION(), ADD_MODE::APPEND );
-            break;
-
-        case T_module:
-            m_board->Add( parseMODULE(), ADD_MODE::APPEND );
-            break;
-
-        case T_segment:
-            m_board->Add( parseTRACK(), ADD_MODE::APPEND );
-            break;
-
-        case T_arc:
-            m_board->Add( parseARC(), ADD_MODE::APPEND );
-            break;
-
-        case T_group:
-            parseGROUP();
-            break;
-
-        case T_via:
-            m_board->Add( parseVIA(), ADD_MODE::APPEND );
-            break;
-
-        case T_zone:
-            m_board->Add( parseZONE_CONTAINER( m_board ), ADD_MODE::APPEND );
-            break;
-
-        case T_target:
-            m_board->Add( parsePCB_TARGET(), ADD_MODE::APPEND );
-            break;
+        parseBoardSections( properties, batches );
+    }
+    catch( ... )
+    {
+        if( !m_parallelLoad )
+            throw;
 
-        default:
-            wxString err;
-            err.Printf( _( "Unknown token \"%s\"" ), GetChars( FromUTF8() ) );
-            THROW_PARSE_ERROR( err, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
-        }
+        // The batches captured so far come earlier in the file and may hold an error of
+        // their own, which is the one a serial parse would have reported
+        batches.emplace_back();
+        batches.back().m_error = std::current_exception();
     }
 
+    loadItemBatches( batches );
+
     m_board->SetProperties( properties );
 
     if( m_undefinedLayers.size() > 0 )
@@ -809,6 +767,319 @@ BOARD* PCB_PARSER::parseBOARD_unchecked()
 }
 
 
+BOARD_ITEM* PCB_PARSER::parseBoardItem( T aToken )
+{
+    switch( aToken )
+    {
+    case T_gr_arc:
+    case T_gr_circle:
+    case T_gr_curve:
+    case T_gr_rect:
+    case T_gr_line:
+    case T_gr_poly:
+        return parseDRAWSEGMENT();
+
+    case T_gr_text:
+        return parseTEXTE_PCB();
+
+    case T_dimension:
+        return parseDIMENSION();
+
+    case T_module:
+        return parseMODULE();
+
+    case T_segment:
+        return parseTRACK();
+
+    case T_arc:
+        return parseARC();
+
+    case T_via:
+        return parseVIA();
+
+    case T_zone:
+        return parseZONE_CONTAINER( m_board );
+
+    case T_target:
+        return parsePCB_TARGET();
+
+    default:
+        wxString err;
+        err.Printf( _( "Unknown token \"%s\"" ), GetChars( FromUTF8() ) );
+        THROW_PARSE_ERROR( err, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+    }
+}
+
+
+void PCB_PARSER::parseBoardSections( std::map<wxString, wxString>& aProperties,
+                                     std::vector<ITEM_BATCH>& aBatches )
+{
+    T token;
+
+    for( token = NextTok();  token != T_RIGHT;  token = NextTok() )
+    {
+        if( token != T_LEFT )
+            Expecting( T_LEFT );
+
+        int leftLine = CurLineNumber();
+        int leftOffset = curOffset;
+
+        token = NextTok();
+
+        if( token == T_page && m_requiredVersion <= 20200119 )
+            token = T_paper;
+
+        switch( token )
+        {
+        case T_general:
+            parseGeneralSection();
+            break;
+
+        case T_paper:
+            parsePAGE_INFO();
+            break;
+
+        case T_title_block:
+            parseTITLE_BLOCK();
+            break;
+
+        case T_layers:
+            parseLayers();
+            break;
+
+        case T_setup:
+            parseSetup();
+            break;
+
+        case T_property:
+            aProperties.insert( parseProperty() );
+            break;
+
+        case T_net:
+            parseNETINFO_ITEM();
+            break;
+
+        case T_net_class:
+            parseNETCLASS();
+            m_board->m_LegacyNetclassesLoaded = true;
+            break;
+
+        case T_gr_arc:
+        case T_gr_circle:
+        case T_gr_curve:
+        case T_gr_rect:
+        case T_gr_line:
+        case T_gr_poly:
+        case T_gr_text:
+        case T_dimension:
+        case T_module:
+        case T_segment:
+        case T_arc:
+        case T_via:
+        case T_zone:
+        case T_target:
+            if( !m_parallelLoad )
+            {
+                m_board->Add( parseBoardItem( token ), ADD_MODE::APPEND );
+            }
+            else if( leftLine == CurLineNumber() )
+            {
+                captureBoardItem( aBatches, leftLine, leftOffset );
+            }
+            else
+            {
+                // The text of the item can't be cut from its opening parenthesis, which was
+                // on a previous line.  Parse it here, keeping its place in the file order.
+                aBatches.emplace_back();
+                aBatches.back().m_items.emplace_back( parseBoardItem( token ) );
+            }
+
+            break;
+
+        case T_group:
+            parseGROUP();
+            break;
+
+        default:
+            wxString err;
+            err.Printf( _( "Unknown token \"%s\"" ), GetChars( FromUTF8() ) );
+            THROW_PARSE_ERROR( err, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+        }
+    }
+}
+
+
+void PCB_PARSER::captureBoardItem( std::vector<ITEM_BATCH>& aBatches, int aLine, int aOffset )
+{
+    if( aBatches.empty() || aBatches.back().m_text.empty()
+            || aBatches.back().m_lastLine + 1 != aLine
+            || aBatches.back().m_text.size() >= ITEM_BATCH_SIZE )
+    {
+        aBatches.emplace_back();
+        aBatches.back().m_firstLine = aLine;
+    }
+
+    ITEM_BATCH& batch = aBatches.back();
+
+    // Blank out what precedes the item on its first line, to keep the error offsets right
+    batch.m_text.append( aOffset, ' ' );
+
+    skipList( &batch.m_text, start + aOffset );
+
+    batch.m_text += '\n';
+    batch.m_lastLine = CurLineNumber();
+}
+
+
+void PCB_PARSER::skipList( std::string* aText, const char* aTextStart )
+{
+    // Only the nesting has to be followed to find the end of the list, which is much less
+    // work than lexing it.  The opening parenthesis and the keyword are already read.
+    const char* lineStart = aTextStart;
+    const char* cp = next;
+    int         depth = 1;
+    bool        quoted = false;
+
+    while( true )
+    {
+        if( cp >= limit )
+        {
+            if( aText )
+                aText->append( lineStart, limit );
+
+            if( readLine() == 0 )
+                Expecting( T_RIGHT );
+
+            cp = start;
+            lineStart = start;
+            quoted = false;
+
+            while( cp < limit && ( *cp == ' ' || *cp == '\t' ) )
+                ++cp;
+
+            // Comment lines are skipped by the lexer, which will see them again
+            if( cp < limit && *cp == '#' )
+                cp = limit;
+
+            continue;
+        }
+
+        char cc = *cp++;
+
+        if( quoted )
+        {
+            if( cc == '\\' && cp < limit )
+                ++cp;
+            else if( cc == '"' )
+                quoted = false;
+        }
+        else if( cc == '"' )
+        {
+            quoted = true;
+        }
+        else if( cc == '(' )
+        {
+            ++depth;
+        }
+        else if( cc == ')' && --depth == 0 )
+        {
+            break;
+        }
+    }
+
+    if( aText )
+        aText->append( lineStart, cp );
+
+    next = cp;
+}
+
+
+void PCB_PARSER::parseItemBatch( ITEM_BATCH& aBatch, const wxString& aSource ) const
+{
+    ITEM_BATCH_LINE_READER reader( aBatch.m_text, aBatch.m_firstLine, aSource );
+    PCB_PARSER             parser( &reader );
+
+    parser.m_board = m_board;
+    parser.m_layerIndices = m_layerIndices;
+    parser.m_layerMasks = m_layerMasks;
+    parser.m_netCodes = m_netCodes;
+    parser.m_tooRecent = m_tooRecent;
+    parser.m_requiredVersion = m_requiredVersion;
+    parser.m_resetKIIDs = m_resetKIIDs;
+    parser.m_filledPolysSource = m_filledPolysSource;
+    parser.m_batch = &aBatch;
+
+    try
+    {
+        for( T token = parser.NextTok(); token != T_EOF; token = parser.NextTok() )
+        {
+            if( token != T_LEFT )
+                parser.Expecting( T_LEFT );
+
+            std::unique_ptr<BOARD_ITEM> item( parser.parseBoardItem( parser.NextTok() ) );
+            aBatch.m_items.push_back( std::move( item ) );
+        }
+    }
+    catch( ... )
+    {
+        aBatch.m_error = std::current_exception();
+    }
+
+    aBatch.m_requiredVersion = parser.m_requiredVersion;
+    aBatch.m_undefinedLayers = std::move( parser.m_undefinedLayers );
+    aBatch.m_resetKIIDMap = std::move( parser.m_resetKIIDMap );
+}
+
+
+void PCB_PARSER::loadItemBatches( std::vector<ITEM_BATCH>& aBatches )
+{
+    const wxString& source = CurSource();
+
+    THREAD_POOL::Get().ParallelFor( aBatches.size(),
+            [&]( size_t ii )
+            {
+                if( !aBatches[ii].m_text.empty() )
+                    parseItemBatch( aBatches[ii], source );
+            } );
+
+    // A module can require a later version than the board, so check the version before
+    // reporting errors, as parseBOARD() turns them into FUTURE_FORMAT_ERRORs for newer files
+    for( const ITEM_BATCH& batch : aBatches )
+        m_requiredVersion = std::max( m_requiredVersion, batch.m_requiredVersion );
+
+    m_tooRecent = ( m_requiredVersion > SEXPR_BOARD_FILE_VERSION );
+
+    // Report the error which comes first in the file, as a serial parse would
+    for( const ITEM_BATCH& batch : aBatches )
+    {
+        if( batch.m_error )
+            std::rethrow_exception( batch.m_error );
+    }
+
+    for( ITEM_BATCH& batch : aBatches )
+    {
+        if( batch.m_legacyZoneFill )
+        {
+            confirmLegacyZoneFill();
+            break;
+        }
+    }
+
+    for( ITEM_BATCH& batch : aBatches )
+    {
+        m_undefinedLayers.insert( batch.m_undefinedLayers.begin(),
+                                  batch.m_undefinedLayers.end() );
+        m_resetKIIDMap.insert( batch.m_resetKIIDMap.begin(), batch.m_resetKIIDMap.end() );
+
+        for( const std::pair<ZONE_CONTAINER*, wxString>& zoneNet : batch.m_zoneNets )
+            resolveZoneNet( zoneNet.first, zoneNet.second );
+
+        for( std::unique_ptr<BOARD_ITEM>& item : batch.m_items )
+            m_board->Add( item.release(), ADD_MODE::APPEND );
+    }
+}
+
+
 void PCB_PARSER::parseHeader()
 {
     wxCHECK_RET( CurTok() == T_kicad_pcb,
@@ -4266,6 +4537,7 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent )
 
     // bigger scope since each filled_polygon is concatenated in here
     std::map<PCB_LAYER_ID, SHAPE_POLY_SET> pts;
+    std::set<PCB_LAYER_ID> sourcedLayers;   // layers whose fill m_filledPolysSource installed
     bool inModule = false;
     PCB_LAYER_ID filledLayer;
     bool addedFilledPolygons = false;
@@ -4410,25 +4682,8 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent )
 
                     if( token == T_segment )    // deprecated
                     {
-                        // SEGMENT fill mode no longer supported.  Make sure user is OK with converting them.
-                        if( m_showLegacyZoneWarning )
-                        {
-                            KIDIALOG dlg( nullptr,
-                                          _( "The legacy segment fill mode is no longer supported.\n"
-                                             "Convert zones to polygon fills?"),
-                                          _( "Legacy Zone Warning" ),
-                                          wxYES_NO | wxICON_WARNING );
-
-                            dlg.DoNotShowCheckbox( __FILE__, __LINE__ );
-
-                            if( dlg.ShowModal() == wxID_NO )
-                                THROW_IO_ERROR( wxT( "CANCEL" ) );
-
-                            m_showLegacyZoneWarning = false;
-                        }
-
+                        confirmLegacyZoneFill();
                         zone->SetFillMode( ZONE_FILL_MODE::POLYGONS );
-                        m_board->SetModified();
                     }
                     else if( token == T_hatch )
                         zone->SetFillMode( ZONE_FILL_MODE::HATCH_PATTERN );
@@ -4671,6 +4926,25 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent )
                 if( token != T_pts )
                     Expecting( T_pts );
 
+                // The source installs all the polygons of a layer at once, so the others
+                // are only skipped
+                bool skip = sourcedLayers.count( filledLayer ) > 0;
+
+                if( !skip && m_filledPolysSource && !m_resetKIIDs && !pts.count( filledLayer )
+                        && m_filledPolysSource( zone.get(), filledLayer ) )
+                {
+                    sourcedLayers.insert( filledLayer );
+                    skip = true;
+                }
+
+                if( skip )
+                {
+                    skipList();
+                    NeedRIGHT();
+                    addedFilledPolygons = true;
+                    break;
+                }
+
                 if( !pts.count( filledLayer ) )
                     pts[filledLayer] = SHAPE_POLY_SET();
 
@@ -4776,24 +5050,11 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent )
     // Ensure the zone net name is valid, and matches the net code, for copper zones
     if( zone_has_net && ( zone->GetNet()->GetNetname() != netnameFromfile ) )
     {
-        // Can happens which old boards, with nonexistent nets ...
-        // or after being edited by hand
-        // We try to fix the mismatch.
-        NETINFO_ITEM* net = m_board->FindNet( netnameFromfile );
-
-        if( net )   // An existing net has the same net name. use it for the zone
-            zone->SetNetCode( net->GetNet() );
-        else    // Not existing net: add a new net to keep trace of the zone netname
-        {
-            int newnetcode = m_board->GetNetCount();
-            net = new NETINFO_ITEM( m_board, netnameFromfile, newnetcode );
-            m_board->Add( net );
-
-            // Store the new code mapping
-            pushValueIntoMap( newnetcode, net->GetNet() );
-            // and update the zone netcode
-            zone->SetNetCode( net->GetNet() );
-        }
+        // The board's nets can't be changed from a worker thread
+        if( m_batch )
+            m_batch->m_zoneNets.emplace_back( zone.get(), netnameFromfile );
+        else
+            resolveZoneNet( zone.get(), netnameFromfile );
     }
 
     // Clear flags used in zone edition:
@@ -4803,6 +5064,59 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER( BOARD_ITEM_CONTAINER* aParent )
 }
 
 
+void PCB_PARSER::confirmLegacyZoneFill()
+{
+    // Dialogs can't be shown from a worker thread; the batch's owner asks instead
+    if( m_batch )
+    {
+        m_batch->m_legacyZoneFill = true;
+        return;
+    }
+
+    // SEGMENT fill mode no longer supported.  Make sure user is OK with converting them.
+    if( m_showLegacyZoneWarning )
+    {
+        KIDIALOG dlg( nullptr,
+                      _( "The legacy segment fill mode is no longer supported.\n"
+                         "Convert zones to polygon fills?"),
+                      _( "Legacy Zone Warning" ),
+                      wxYES_NO | wxICON_WARNING );
+
+        dlg.DoNotShowCheckbox( __FILE__, __LINE__ );
+
+        if( dlg.ShowModal() == wxID_NO )
+            THROW_IO_ERROR( wxT( "CANCEL" ) );
+
+        m_showLegacyZoneWarning = false;
+    }
+
+    m_board->SetModified();
+}
+
+
+void PCB_PARSER::resolveZoneNet( ZONE_CONTAINER* aZone, const wxString& aNetName )
+{
+    // Can happens which old boards, with nonexistent nets ...
+    // or after being edited by hand
+    // We try to fix the mismatch.
+    NETINFO_ITEM* net = m_board->FindNet( aNetName );
+
+    if( net )   // An existing net has the same net name. use it for the zone
+        aZone->SetNetCode( net->GetNet() );
+    else    // Not existing net: add a new net to keep trace of the zone netname
+    {
+        int newnetcode = m_board->GetNetCount();
+        net = new NETINFO_ITEM( m_board, aNetName, newnetcode );
+        m_board->Add( net );
+
+        // Store the new code mapping
+        pushValueIntoMap( newnetcode, net->GetNet() );
+        // and update the zone netcode
+        aZone->SetNetCode( net->GetNet() );
+    }
+}
+
+
 PCB_TARGET* PCB_PARSER::parsePCB_TARGET()
 {
     wxCHECK_MSG( CurTok() == T_target, NULL,
@@ -36,6 +36,7 @@
 #include <math/util.h>                           // KiROUND, Clamp
 #include <pcb_lexer.h>
 
+#include <functional>
 #include <unordered_map>
 
 
@@ -84,6 +85,17 @@ class PCB_PARSER : public PCB_LEXER
     KIID_MAP            m_resetKIIDMap;     ///< if resetting UUIDs, record new ones to update groups with
 
     bool                m_showLegacyZoneWarning;
+    bool                m_parallelLoad;     ///< parse the items of a board on the thread pool
+
+    // The items of a board are parsed in two phases: the top level is scanned in file order,
+    // and the text of the items is cut into batches which are parsed on the thread pool by
+    // copies of this parser.  The items are then added to the board in file order.
+    struct ITEM_BATCH;
+
+    ITEM_BATCH*         m_batch;            ///< the batch parsed by this copy, if it is one
+
+    ///> Installs the saved filled polygons of a zone layer, if known (see SetFilledPolysSource())
+    std::function<bool( ZONE_CONTAINER*, PCB_LAYER_ID )> m_filledPolysSource;
 
     // Group membership info refers to other Uuids in the file.
     // We don't want to rely on group declarations being last in the file, so
@@ -183,6 +195,55 @@ class PCB_PARSER : public PCB_LEXER
     BOARD*          parseBOARD();
     void            parseGROUP();
 
+    /**
+     * Parse a top level item of a board, the current token being its keyword.
+     */
+    BOARD_ITEM*     parseBoardItem( PCB_KEYS_T::T aToken );
+
+    /**
+     * Skip past the end of the list whose opening parenthesis and keyword are the last tokens
+     * read, appending its text to \a aText (if not null) from \a aTextStart on.
+     */
+    void            skipList( std::string* aText = nullptr, const char* aTextStart = nullptr );
+
+    /**
+     * Parse the sections of a board after its header, up to its closing parenthesis.  Board
+     * items are captured into \a aBatches when loading in parallel, and parsed later.
+     */
+    void            parseBoardSections( std::map<wxString, wxString>& aProperties,
+                                        std::vector<ITEM_BATCH>& aBatches );
+
+    /**
+     * Append the text of the top level item whose keyword is the current token to the
+     * last of \a aBatches, or to a new one, and skip past it.
+     *
+     * @param aLine is the line number of the item's opening parenthesis.
+     * @param aOffset is the offset of the opening parenthesis within that line.
+     */
+    void            captureBoardItem( std::vector<ITEM_BATCH>& aBatches, int aLine, int aOffset );
+
+    /**
+     * Parse the items of \a aBatch with a copy of this parser.  Called from worker threads.
+     */
+    void            parseItemBatch( ITEM_BATCH& aBatch, const wxString& aSource ) const;
+
+    /**
+     * Parse \a aBatches on the thread pool and add their items to the board, in file order.
+     */
+    void            loadItemBatches( std::vector<ITEM_BATCH>& aBatches );
+
+    /**
+     * Ask the user, once, whether zones with the legacy segment fill can be converted to
+     * polygon fills, and flag the board as modified.
+     */
+    void            confirmLegacyZoneFill();
+
+    /**
+     * Make the net of \a aZone match the net name it had in the file, adding the net to the
+     * board if needed.
+     */
+    void            resolveZoneNet( ZONE_CONTAINER* aZone, const wxString& aNetName );
+
     /**
      * Function parseBOARD_unchecked
      * Parse a module, but do not replace PARSE_ERROR with FUTURE_FORMAT_ERROR automatically.
@@ -345,7 +406,9 @@ public:
     PCB_PARSER( LINE_READER* aReader = NULL ) :
         PCB_LEXER( aReader ),
         m_board( 0 ),
-        m_resetKIIDs( false )
+        m_resetKIIDs( false ),
+        m_parallelLoad( true ),
+        m_batch( nullptr )
     {
         init();
     }
@@ -374,6 +437,29 @@ public:
             m_resetKIIDs = true;
     }
 
+    /**
+     * Set whether the items of a board are parsed on the thread pool (the default), or one
+     * after the other on the calling thread.
+     */
+    void SetParallelLoad( bool aParallel ) { m_parallelLoad = aParallel; }
+
+    /**
+     * Installs the filled polygons of \a aZone on \a aLayer as they were saved in the file
+     * being parsed, and returns true; or returns false if they aren't known.  May be called
+     * from worker threads.
+     */
+    typedef std::function<bool( ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer )> FILLED_POLYS_SOURCE;
+
+    /**
+     * Set where the filled polygons of zones come from when they are known without parsing
+     * them, in which case their text is skipped.  Must only be set while the file being
+     * parsed is the one the source knows the fills of.
+     */
+    void SetFilledPolysSource( const FILLED_POLYS_SOURCE& aSource )
+    {
+        m_filledPolysSource = aSource;
+    }
+
     BOARD_ITEM* Parse();
     /**
      * Function parseMODULE
@@ -397,6 +483,15 @@ public:
      */
     wxString GetRequiredVersion();
 
+    /**
+     * @return the code, in the board last parsed, of the net numbered \a aFileNetCode in the
+     *         file.
+     */
+    int GetBoardNetCode( int aFileNetCode )
+    {
+        return getNetCode( aFileNetCode );
+    }
+
 };
 
 
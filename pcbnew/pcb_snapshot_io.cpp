@@ -0,0 +1,1275 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <base_units.h>
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <kicad_string.h>
+#include <netinfo.h>
+#include <pcb_parser.h>
+#include <pcb_snapshot_io.h>
+#include <profile.h>
+#include <trigo.h>
+#include <zone_fill_cache.h>
+
+
+namespace
+{
+
+const char     SNAPSHOT_MAGIC[8] = { 'K', 'I', 'P', 'C', 'B', 'S', 'N', 'P' };
+const uint32_t SNAPSHOT_VERSION = 2;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct FILE_HEADER
+{
+    char     m_magic[8];
+    uint32_t m_version;
+    uint32_t m_byteOrder;
+    uint32_t m_boardVersion;    // SEXPR_BOARD_FILE_VERSION of the text section
+    uint32_t m_layerCount;      // PCB_LAYER_ID_COUNT, as the columns hold layer ids
+    uint64_t m_sourceSize;      // size and hash of the board file the snapshot was taken from
+    uint64_t m_sourceHash;
+    uint64_t m_textSize;        // in bytes
+    uint64_t m_trackCount;
+    uint64_t m_moduleCount;     // all the footprints, in file order
+    uint64_t m_padCount;        // the pads of the footprints which have their pads apart
+    uint64_t m_padStringSize;   // in bytes
+    uint64_t m_fillCount;
+};
+
+struct FILL_HEADER
+{
+    uint8_t  m_zone[16];        // see KIID::GetBytes()
+    int32_t  m_layer;
+    int32_t  m_islandCount;
+    uint64_t m_size;            // in int32s: the islands, then the polygons; always even
+};
+
+enum TRACK_KIND : uint8_t
+{
+    KIND_SEGMENT = 0,
+    KIND_ARC = 1,
+    KIND_VIA = 2
+};
+
+enum TRACK_FLAG : uint8_t
+{
+    FLAG_LOCKED = 1 << 0,
+    FLAG_REMOVE_UNCONNECTED = 1 << 1,
+    FLAG_KEEP_TOP_BOTTOM = 1 << 2
+};
+
+/// The int32 columns of the tracks, in file order
+enum TRACK_COLUMN
+{
+    COL_LAYER = 0,              // the top layer of vias
+    COL_BOTTOM_LAYER,           // vias only
+    COL_NET,                    // as numbered in the text section
+    COL_WIDTH,
+    COL_DRILL,                  // vias only
+    COL_START_X,
+    COL_START_Y,
+    COL_END_X,
+    COL_END_Y,
+    COL_MID_X,                  // arcs only
+    COL_MID_Y,
+    COL_COUNT
+};
+
+/// The uint8 columns of the pads
+enum PAD_BYTE_COLUMN
+{
+    PAD_ATTRIBUTE = 0,
+    PAD_SHAPE,                  // as saved in the board file, see PCB_IO::format( D_PAD* )
+    PAD_DRILL_SHAPE,
+    PAD_PROPERTY,
+    PAD_ZONE_CONNECTION,        // ZONE_CONNECTION + 1, so that INHERITED is 0
+    PAD_CHAMFERS,
+    PAD_FLAGS,                  // TRACK_FLAGs
+    PAD_BYTE_COUNT
+};
+
+/// The int32 columns of the pads
+enum PAD_COLUMN
+{
+    PAD_POS0_X = 0,
+    PAD_POS0_Y,
+    PAD_SIZE_X,
+    PAD_SIZE_Y,
+    PAD_DELTA_X,
+    PAD_DELTA_Y,
+    PAD_DRILL_X,
+    PAD_DRILL_Y,
+    PAD_OFFSET_X,
+    PAD_OFFSET_Y,
+    PAD_NET,                    // as numbered in the text section
+    PAD_DIE_LENGTH,
+    PAD_MASK_MARGIN,
+    PAD_PASTE_MARGIN,
+    PAD_CLEARANCE,
+    PAD_THERMAL_WIDTH,
+    PAD_THERMAL_GAP,
+    PAD_NAME,                   // offsets of nul terminated UTF8 strings in the pad strings
+    PAD_PIN_FUNCTION,
+    PAD_COLUMN_COUNT
+};
+
+/// The double columns of the pads.  They hold the values as read back from the board file,
+/// so that a board loaded from its snapshot is the board loaded from its file.
+enum PAD_DOUBLE_COLUMN
+{
+    PAD_ORIENTATION = 0,
+    PAD_PASTE_RATIO,
+    PAD_ROUNDRECT_RATIO,
+    PAD_CHAMFER_RATIO,
+    PAD_DOUBLE_COUNT
+};
+
+static_assert( PCB_LAYER_ID_COUNT <= 64, "pad layer sets are saved as 64 bit masks" );
+
+const wxChar traceSnapshot[] = wxT( "KICAD_PCB_SNAPSHOT" );
+
+
+/**
+ * A file mapped into memory or, where it can't be mapped, read into memory.
+ */
+class MAPPED_FILE
+{
+public:
+    MAPPED_FILE() :
+            m_data( nullptr ),
+            m_size( 0 ),
+            m_mapped( false )
+    {
+    }
+
+    ~MAPPED_FILE()
+    {
+        Close();
+    }
+
+    MAPPED_FILE( const MAPPED_FILE& ) = delete;
+    MAPPED_FILE& operator=( const MAPPED_FILE& ) = delete;
+
+    bool Open( const wxString& aFileName )
+    {
+        Close();
+
+        if( !wxFileName::FileExists( aFileName ) )
+            return false;
+
+#ifndef _WIN32
+        int fd = open( aFileName.fn_str(), O_RDONLY );
+
+        if( fd >= 0 )
+        {
+            struct stat st;
+
+            if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+            {
+                void* addr = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+                if( addr != MAP_FAILED )
+                {
+                    m_data = static_cast<const char*>( addr );
+                    m_size = st.st_size;
+                    m_mapped = true;
+                }
+            }
+
+            close( fd );
+        }
+#endif
+
+        if( !m_data )
+        {
+            wxFFile file( aFileName, "rb" );
+
+            if( !file.IsOpened() )
+                return false;
+
+            m_readData.resize( file.Length() );
+
+            if( m_readData.empty() || file.Read( m_readData.data(), m_readData.size() )
+                                              != m_readData.size() )
+            {
+                m_readData.clear();
+                return false;
+            }
+
+            m_data = m_readData.data();
+            m_size = m_readData.size();
+        }
+
+        return true;
+    }
+
+    void Close()
+    {
+#ifndef _WIN32
+        if( m_mapped )
+            munmap( const_cast<char*>( m_data ), m_size );
+#endif
+
+        m_data = nullptr;
+        m_size = 0;
+        m_mapped = false;
+        m_readData.clear();
+    }
+
+    const char* Data() const { return m_data; }
+    size_t      Size() const { return m_size; }
+
+private:
+    const char*       m_data;
+    size_t            m_size;
+    bool              m_mapped;
+    std::vector<char> m_readData;
+};
+
+
+/**
+ * Reads the sections of a snapshot one after the other, checking them against the end of
+ * the file.
+ */
+class SECTION_READER
+{
+public:
+    SECTION_READER( const char* aData, size_t aSize ) :
+            m_data( aData ),
+            m_size( aSize ),
+            m_offset( 0 )
+    {
+    }
+
+    size_t Remaining() const { return m_size - m_offset; }
+
+    /**
+     * @return the next section, of \a aSize bytes, or nullptr if the file is too short.
+     */
+    const char* Next( size_t aSize )
+    {
+        size_t padded = ( aSize + 7 ) & ~(size_t) 7;
+
+        if( padded < aSize || padded > Remaining() )
+            return nullptr;
+
+        const char* section = m_data + m_offset;
+        m_offset += padded;
+        return section;
+    }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+    size_t      m_offset;
+};
+
+
+/**
+ * Appends \a aSize bytes of \a aData, then zeroes up to the next multiple of 8 bytes.
+ */
+void appendSection( std::string& aOut, const void* aData, size_t aSize )
+{
+    if( aSize )
+        aOut.append( static_cast<const char*>( aData ), aSize );
+
+    aOut.append( ( 8 - aSize % 8 ) % 8, '\0' );
+}
+
+
+/**
+ * A fast 64-bit hash of the contents of a file, to tell whether a board file is still the one
+ * a snapshot was taken from.  The four lanes are independent, so their multiplies overlap.
+ */
+uint64_t hashBytes( const char* aData, size_t aSize )
+{
+    const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+    auto rotl =
+            []( uint64_t aValue, int aBits )
+            {
+                return ( aValue << aBits ) | ( aValue >> ( 64 - aBits ) );
+            };
+
+    auto mix =
+            [&]( uint64_t aLane, uint64_t aWord )
+            {
+                return rotl( aLane + aWord * PRIME2, 31 ) * PRIME1;
+            };
+
+    uint64_t lanes[4] = { PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1 };
+    size_t   ii = 0;
+
+    for( ; ii + sizeof( lanes ) <= aSize; ii += sizeof( lanes ) )
+    {
+        uint64_t words[4];
+
+        memcpy( words, aData + ii, sizeof( words ) );
+
+        for( int jj = 0; jj < 4; ++jj )
+            lanes[jj] = mix( lanes[jj], words[jj] );
+    }
+
+    uint64_t hash = aSize;
+
+    for( uint64_t lane : lanes )
+        hash = rotl( hash ^ mix( 0, lane ), 27 ) * PRIME1 + PRIME2;
+
+    for( ; ii < aSize; ++ii )
+        hash = rotl( hash ^ ( static_cast<uint8_t>( aData[ii] ) * PRIME1 ), 11 ) * PRIME2;
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME1;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+
+
+/**
+ * @return \a aValue as read back from the board file, where it is written by Double2Str().
+ */
+double readBack( double aValue )
+{
+    return StrToDouble( Double2Str( aValue ).c_str(), nullptr );
+}
+
+
+/**
+ * Writes \a aText to the file \a aFileName, as FILE_OUTPUTFORMATTER does.
+ * @return the bytes written, which are \a aText itself unless line ends are translated.
+ * @throw IO_ERROR if the file can't be written.
+ */
+const std::string& writeBoardFile( const wxString& aFileName, const std::string& aText,
+                                   std::string& aTranslated )
+{
+    const std::string* bytes = &aText;
+
+#ifdef __WINDOWS__
+    // FILE_OUTPUTFORMATTER writes in text mode
+    aTranslated.reserve( aText.size() + aText.size() / 16 );
+
+    for( char c : aText )
+    {
+        if( c == '\n' )
+            aTranslated += '\r';
+
+        aTranslated += c;
+    }
+
+    bytes = &aTranslated;
+#endif
+
+    FILE* fp = wxFopen( aFileName, wxT( "wb" ) );
+
+    if( !fp )
+        THROW_IO_ERROR( strerror( errno ) );
+
+    bool ok = fwrite( bytes->data(), 1, bytes->size(), fp ) == bytes->size();
+
+    ok &= fclose( fp ) == 0;
+
+    if( !ok )
+        THROW_IO_ERROR( strerror( errno ) );
+
+    return *bytes;
+}
+
+
+/**
+ * Appends the footprint records, then the pad columns, of the footprints of \a aBoard whose
+ * pads PCB_IO saved apart, in the order of the board file.
+ */
+void formatPads( BOARD* aBoard, NETINFO_MAPPING* aMapping, std::string& aOut,
+                 FILE_HEADER& aHeader )
+{
+    std::set<BOARD_ITEM*, BOARD_ITEM::ptr_cmp> sorted_modules( aBoard->Modules().begin(),
+            aBoard->Modules().end() );
+    std::vector<uint8_t>  moduleUuids( 16 * sorted_modules.size() );
+    std::vector<uint32_t> padCounts;
+    std::vector<D_PAD*>   pads;
+
+    for( BOARD_ITEM* item : sorted_modules )
+    {
+        MODULE* module = static_cast<MODULE*>( item );
+        size_t  first = pads.size();
+
+        if( PCB_IO::SnapshotsPads( module ) )
+        {
+            std::set<D_PAD*, MODULE::cmp_pads> sorted_pads( module->Pads().begin(),
+                    module->Pads().end() );
+
+            pads.insert( pads.end(), sorted_pads.begin(), sorted_pads.end() );
+        }
+
+        module->m_Uuid.GetBytes( &moduleUuids[16 * padCounts.size()] );
+        padCounts.push_back( pads.size() - first );
+    }
+
+    size_t                count = pads.size();
+    std::vector<uint8_t>  bytes[PAD_BYTE_COUNT];
+    std::vector<int32_t>  columns[PAD_COLUMN_COUNT];
+    std::vector<double>   doubles[PAD_DOUBLE_COUNT];
+    std::vector<uint64_t> layers( count );
+    std::vector<uint8_t>  uuids( 16 * count );
+    std::string           strings;
+
+    for( std::vector<uint8_t>& column : bytes )
+        column.resize( count, 0 );
+
+    for( std::vector<int32_t>& column : columns )
+        column.resize( count, 0 );
+
+    for( std::vector<double>& column : doubles )
+        column.resize( count, 0.0 );
+
+    auto addString =
+            [&strings]( const wxString& aString ) -> int32_t
+            {
+                int32_t offset = strings.size();
+
+                strings += TO_UTF8( aString );
+                strings += '\0';
+                return offset;
+            };
+
+    for( size_t ii = 0; ii < count; ++ii )
+    {
+        D_PAD* pad = pads[ii];
+
+        bytes[PAD_ATTRIBUTE][ii] = pad->GetAttribute();
+        bytes[PAD_SHAPE][ii] = pad->GetShape();
+        bytes[PAD_DRILL_SHAPE][ii] = pad->GetDrillShape();
+        bytes[PAD_PROPERTY][ii] = pad->GetProperty();
+        bytes[PAD_ZONE_CONNECTION][ii] = static_cast<int>( pad->GetEffectiveZoneConnection() ) + 1;
+        bytes[PAD_CHAMFERS][ii] = pad->GetChamferPositions();
+
+        if( pad->GetRemoveUnconnected() )
+            bytes[PAD_FLAGS][ii] |= FLAG_REMOVE_UNCONNECTED;
+
+        if( pad->GetKeepTopBottom() )
+            bytes[PAD_FLAGS][ii] |= FLAG_KEEP_TOP_BOTTOM;
+
+        columns[PAD_POS0_X][ii] = pad->GetPos0().x;
+        columns[PAD_POS0_Y][ii] = pad->GetPos0().y;
+        columns[PAD_SIZE_X][ii] = pad->GetSize().x;
+        columns[PAD_SIZE_Y][ii] = pad->GetSize().y;
+        columns[PAD_DELTA_X][ii] = pad->GetDelta().x;
+        columns[PAD_DELTA_Y][ii] = pad->GetDelta().y;
+        columns[PAD_DRILL_X][ii] = pad->GetDrillSize().x;
+        columns[PAD_DRILL_Y][ii] = pad->GetDrillSize().y;
+        columns[PAD_OFFSET_X][ii] = pad->GetOffset().x;
+        columns[PAD_OFFSET_Y][ii] = pad->GetOffset().y;
+        columns[PAD_NET][ii] = aMapping->Translate( pad->GetNetCode() );
+        columns[PAD_DIE_LENGTH][ii] = pad->GetPadToDieLength();
+        columns[PAD_MASK_MARGIN][ii] = pad->GetLocalSolderMaskMargin();
+        columns[PAD_PASTE_MARGIN][ii] = pad->GetLocalSolderPasteMargin();
+        columns[PAD_CLEARANCE][ii] = pad->GetLocalClearance();
+        columns[PAD_THERMAL_WIDTH][ii] = pad->GetThermalSpokeWidth();
+        columns[PAD_THERMAL_GAP][ii] = pad->GetThermalGap();
+        columns[PAD_NAME][ii] = addString( pad->GetName() );
+        columns[PAD_PIN_FUNCTION][ii] = addString( pad->GetPinFunction() );
+
+        doubles[PAD_ORIENTATION][ii] =
+                StrToDouble( FormatAngle( pad->GetOrientation() ).c_str(), nullptr ) * 10.0;
+        doubles[PAD_PASTE_RATIO][ii] = readBack( pad->GetLocalSolderPasteMarginRatio() );
+        doubles[PAD_ROUNDRECT_RATIO][ii] = readBack( pad->GetRoundRectRadiusRatio() );
+        doubles[PAD_CHAMFER_RATIO][ii] = readBack( pad->GetChamferRectRatio() );
+
+        layers[ii] = pad->GetLayerSet().to_ullong();
+        pad->m_Uuid.GetBytes( &uuids[16 * ii] );
+    }
+
+    aHeader.m_moduleCount = padCounts.size();
+    aHeader.m_padCount = count;
+    aHeader.m_padStringSize = strings.size();
+
+    appendSection( aOut, moduleUuids.data(), moduleUuids.size() );
+    appendSection( aOut, padCounts.data(), padCounts.size() * sizeof( uint32_t ) );
+
+    for( const std::vector<uint8_t>& column : bytes )
+        appendSection( aOut, column.data(), count );
+
+    for( const std::vector<int32_t>& column : columns )
+        appendSection( aOut, column.data(), count * sizeof( int32_t ) );
+
+    for( const std::vector<double>& column : doubles )
+        appendSection( aOut, column.data(), count * sizeof( double ) );
+
+    appendSection( aOut, layers.data(), count * sizeof( uint64_t ) );
+    appendSection( aOut, uuids.data(), uuids.size() );
+    appendSection( aOut, strings.data(), strings.size() );
+}
+
+
+/**
+ * Adds the pads saved by formatPads() to the footprints of \a aBoard, just parsed from the
+ * text section, as PCB_PARSER::parseD_PAD() would have read them from the board file.
+ * @return false if the pad sections don't check out.
+ */
+bool loadPads( BOARD* aBoard, PCB_PARSER* aParser, SECTION_READER& aReader,
+               const FILE_HEADER& aHeader )
+{
+    size_t moduleCount = aHeader.m_moduleCount;
+    size_t count = aHeader.m_padCount;
+
+    if( moduleCount != aBoard->Modules().size() || count > aReader.Remaining() )
+        return false;
+
+    const uint8_t*  moduleUuids = reinterpret_cast<const uint8_t*>(
+            aReader.Next( 16 * moduleCount ) );
+    const uint32_t* padCounts = reinterpret_cast<const uint32_t*>(
+            aReader.Next( moduleCount * sizeof( uint32_t ) ) );
+    const uint8_t*  bytes[PAD_BYTE_COUNT];
+    const int32_t*  columns[PAD_COLUMN_COUNT];
+    const double*   doubles[PAD_DOUBLE_COUNT];
+
+    for( const uint8_t*& column : bytes )
+        column = reinterpret_cast<const uint8_t*>( aReader.Next( count ) );
+
+    for( const int32_t*& column : columns )
+        column = reinterpret_cast<const int32_t*>( aReader.Next( count * sizeof( int32_t ) ) );
+
+    for( const double*& column : doubles )
+        column = reinterpret_cast<const double*>( aReader.Next( count * sizeof( double ) ) );
+
+    const uint64_t* layers = reinterpret_cast<const uint64_t*>(
+            aReader.Next( count * sizeof( uint64_t ) ) );
+    const uint8_t*  uuids = reinterpret_cast<const uint8_t*>( aReader.Next( 16 * count ) );
+    size_t          stringSize = aHeader.m_padStringSize;
+    const char*     strings = aReader.Next( stringSize );
+
+    if( !moduleUuids || !padCounts || !layers || !uuids || !strings
+            || std::find( bytes, bytes + PAD_BYTE_COUNT, nullptr ) != bytes + PAD_BYTE_COUNT
+            || std::find( columns, columns + PAD_COLUMN_COUNT, nullptr )
+                       != columns + PAD_COLUMN_COUNT
+            || std::find( doubles, doubles + PAD_DOUBLE_COUNT, nullptr )
+                       != doubles + PAD_DOUBLE_COUNT
+            || ( stringSize > 0 && strings[stringSize - 1] != '\0' ) )
+    {
+        return false;
+    }
+
+    auto getString =
+            [&]( int32_t aOffset, wxString& aString ) -> bool
+            {
+                if( aOffset < 0 || (size_t) aOffset >= stringSize )
+                    return false;
+
+                aString = FROM_UTF8( strings + aOffset );
+                return true;
+            };
+
+    const uint64_t validLayers = PCB_LAYER_ID_COUNT < 64 ? ( 1ULL << PCB_LAYER_ID_COUNT ) - 1
+                                                         : ~0ULL;
+    size_t         moduleIndex = 0;
+    size_t         ii = 0;
+
+    for( MODULE* module : aBoard->Modules() )
+    {
+        size_t padCount = padCounts[moduleIndex];
+
+        if( KIID::FromBytes( moduleUuids + 16 * moduleIndex ) != module->m_Uuid
+                || padCount > count - ii )
+        {
+            return false;
+        }
+
+        moduleIndex++;
+
+        for( size_t end = ii + padCount; ii < end; ++ii )
+        {
+            PAD_ATTR_T  attribute = static_cast<PAD_ATTR_T>( bytes[PAD_ATTRIBUTE][ii] );
+            PAD_SHAPE_T shape = static_cast<PAD_SHAPE_T>( bytes[PAD_SHAPE][ii] );
+            wxString    name;
+            wxString    pinFunction;
+
+            if( attribute > PAD_ATTRIB_HOLE_NOT_PLATED
+                    || shape > PAD_SHAPE_CHAMFERED_RECT || shape == PAD_SHAPE_CUSTOM
+                    || bytes[PAD_DRILL_SHAPE][ii] > PAD_DRILL_SHAPE_OBLONG
+                    || bytes[PAD_PROPERTY][ii] > PAD_PROP_CASTELLATED
+                    || bytes[PAD_ZONE_CONNECTION][ii]
+                               > static_cast<int>( ZONE_CONNECTION::THT_THERMAL ) + 1
+                    || ( layers[ii] & ~validLayers )
+                    || !getString( columns[PAD_NAME][ii], name )
+                    || !getString( columns[PAD_PIN_FUNCTION][ii], pinFunction ) )
+            {
+                return false;
+            }
+
+            std::unique_ptr<D_PAD> pad( new D_PAD( module ) );
+
+            pad->SetName( name );
+            pad->SetAttribute( attribute );
+
+            // Default D_PAD object is thru hole with drill
+            if( attribute == PAD_ATTRIB_SMD || attribute == PAD_ATTRIB_CONN )
+                pad->SetDrillSize( wxSize( 0, 0 ) );
+
+            // Chamfered pads are saved as rounded rectangles with chamfers
+            pad->SetShape( shape == PAD_SHAPE_CHAMFERED_RECT ? PAD_SHAPE_ROUNDRECT : shape );
+            pad->SetPos0( wxPoint( columns[PAD_POS0_X][ii], columns[PAD_POS0_Y][ii] ) );
+
+            if( doubles[PAD_ORIENTATION][ii] != 0.0 )
+                pad->SetOrientation( doubles[PAD_ORIENTATION][ii] );
+
+            pad->SetSize( wxSize( columns[PAD_SIZE_X][ii], columns[PAD_SIZE_Y][ii] ) );
+            pad->SetDelta( wxSize( columns[PAD_DELTA_X][ii], columns[PAD_DELTA_Y][ii] ) );
+
+            wxSize  drill( columns[PAD_DRILL_X][ii], columns[PAD_DRILL_Y][ii] );
+            wxPoint offset( columns[PAD_OFFSET_X][ii], columns[PAD_OFFSET_Y][ii] );
+
+            if( drill.x > 0 || drill.y > 0 || offset.x != 0 || offset.y != 0 )
+            {
+                wxSize drillSize = pad->GetDrillSize();
+
+                if( bytes[PAD_DRILL_SHAPE][ii] == PAD_DRILL_SHAPE_OBLONG )
+                    pad->SetDrillShape( PAD_DRILL_SHAPE_OBLONG );
+
+                // The width is only saved when positive, and the height when it differs
+                if( drill.x > 0 )
+                    drillSize = wxSize( drill.x, drill.x );
+
+                if( drill.y > 0 && drill.y != drill.x )
+                {
+                    if( drill.x > 0 )
+                        drillSize.y = drill.y;
+                    else
+                        drillSize = wxSize( drill.y, drill.y );
+                }
+
+                pad->SetOffset( offset );
+
+                if( attribute != PAD_ATTRIB_SMD && attribute != PAD_ATTRIB_CONN )
+                    pad->SetDrillSize( drillSize );
+                else
+                    pad->SetDrillSize( wxSize( 0, 0 ) );
+            }
+
+            pad->SetProperty( static_cast<PAD_PROP_T>( bytes[PAD_PROPERTY][ii] ) );
+
+            LSET layerSet;
+
+            for( int layer = 0; layer < PCB_LAYER_ID_COUNT; ++layer )
+            {
+                if( layers[ii] & ( 1ULL << layer ) )
+                    layerSet.set( layer );
+            }
+
+            pad->SetLayerSet( layerSet );
+
+            if( attribute == PAD_ATTRIB_STANDARD
+                    && ( bytes[PAD_FLAGS][ii] & FLAG_REMOVE_UNCONNECTED ) )
+            {
+                pad->SetRemoveUnconnected( true );
+                pad->SetKeepTopBottom( bytes[PAD_FLAGS][ii] & FLAG_KEEP_TOP_BOTTOM );
+            }
+
+            if( shape == PAD_SHAPE_ROUNDRECT || shape == PAD_SHAPE_CHAMFERED_RECT )
+                pad->SetRoundRectRadiusRatio( doubles[PAD_ROUNDRECT_RATIO][ii] );
+
+            if( shape == PAD_SHAPE_CHAMFERED_RECT )
+            {
+                pad->SetChamferRectRatio( doubles[PAD_CHAMFER_RATIO][ii] );
+                pad->SetChamferPositions( bytes[PAD_CHAMFERS][ii] );
+
+                if( pad->GetChamferRectRatio() > 0
+                        || pad->GetChamferPositions() != RECT_NO_CHAMFER )
+                {
+                    pad->SetShape( PAD_SHAPE_CHAMFERED_RECT );
+                }
+            }
+
+            if( columns[PAD_NET][ii] != NETINFO_LIST::UNCONNECTED
+                    && !pad->SetNetCode( aParser->GetBoardNetCode( columns[PAD_NET][ii] ), true ) )
+            {
+                return false;
+            }
+
+            if( !pinFunction.IsEmpty() )
+                pad->SetPinFunction( pinFunction );
+
+            if( columns[PAD_DIE_LENGTH][ii] != 0 )
+                pad->SetPadToDieLength( columns[PAD_DIE_LENGTH][ii] );
+
+            if( columns[PAD_MASK_MARGIN][ii] != 0 )
+                pad->SetLocalSolderMaskMargin( columns[PAD_MASK_MARGIN][ii] );
+
+            if( columns[PAD_PASTE_MARGIN][ii] != 0 )
+                pad->SetLocalSolderPasteMargin( columns[PAD_PASTE_MARGIN][ii] );
+
+            if( doubles[PAD_PASTE_RATIO][ii] != 0.0 )
+                pad->SetLocalSolderPasteMarginRatio( doubles[PAD_PASTE_RATIO][ii] );
+
+            if( columns[PAD_CLEARANCE][ii] != 0 )
+                pad->SetLocalClearance( columns[PAD_CLEARANCE][ii] );
+
+            if( bytes[PAD_ZONE_CONNECTION][ii] != 0 )
+            {
+                pad->SetZoneConnection(
+                        static_cast<ZONE_CONNECTION>( bytes[PAD_ZONE_CONNECTION][ii] - 1 ) );
+            }
+
+            if( columns[PAD_THERMAL_WIDTH][ii] != 0 )
+                pad->SetThermalSpokeWidth( columns[PAD_THERMAL_WIDTH][ii] );
+
+            if( columns[PAD_THERMAL_GAP][ii] != 0 )
+                pad->SetThermalGap( columns[PAD_THERMAL_GAP][ii] );
+
+            const_cast<KIID&>( pad->m_Uuid ) = KIID::FromBytes( uuids + 16 * ii );
+
+            wxPoint pt = pad->GetPos0();
+
+            RotatePoint( &pt, module->GetOrientation() );
+            pad->SetPosition( pt + module->GetPosition() );
+            module->Add( pad.release(), ADD_MODE::APPEND );
+        }
+
+        if( padCount )
+            module->CalculateBoundingBox();
+    }
+
+    return ii == count;
+}
+
+} // anonymous namespace
+
+
+wxString PCB_SNAPSHOT_IO::SnapshotFileName( const wxString& aBoardFileName )
+{
+    wxFileName fn( aBoardFileName );
+
+    fn.SetFullName( fn.GetFullName() + wxT( "-snapshot" ) );
+    return fn.GetFullPath();
+}
+
+
+void PCB_SNAPSHOT_IO::Save( const wxString& aFileName, BOARD* aBoard,
+                            const PROPERTIES* aProperties )
+{
+    std::string snapshot = SaveWithSnapshot( aFileName, aBoard, aProperties );
+
+    if( !snapshot.empty() )
+        WriteSnapshot( aFileName, snapshot );
+}
+
+
+BOARD* PCB_SNAPSHOT_IO::Load( const wxString& aFileName, BOARD* aAppendToMe,
+                              const PROPERTIES* aProperties )
+{
+    // A snapshot holds a whole board: appending always goes through the board file
+    if( !aAppendToMe )
+    {
+        if( BOARD* board = LoadSnapshot( aFileName, aProperties ) )
+        {
+            board->SetFileName( aFileName );
+            return board;
+        }
+    }
+
+    return PCB_IO::Load( aFileName, aAppendToMe, aProperties );
+}
+
+
+std::string PCB_SNAPSHOT_IO::SaveWithSnapshot( const wxString& aFileName, BOARD* aBoard,
+                                               const PROPERTIES* aProperties )
+{
+    // Leave it to PCB_IO::Save() to ask what to do with a corrupt group structure
+    if( aBoard->GroupsSanityCheck() != wxEmptyString )
+    {
+        PCB_IO::Save( aFileName, aBoard, aProperties );
+        return std::string();
+    }
+
+    LOCALE_IO   toggle;     // toggles on, then off, the C locale.
+
+    init( aProperties );
+
+    m_board = aBoard;       // after init()
+    m_mapping->SetBoard( aBoard );
+
+    // Format the board once, noting where the items saved apart in the snapshot are
+    int ctl = m_ctl;
+
+    m_ctl |= CTL_MARK_SNAPSHOT_ITEMS;
+    m_sf.Clear();
+    m_out = &m_sf;
+    m_snapshotRanges.clear();
+
+    try
+    {
+        m_out->Print( 0, "(kicad_pcb (version %d) (generator pcbnew)\n",
+                      SEXPR_BOARD_FILE_VERSION );
+        Format( aBoard, 1 );
+        m_out->Print( 0, ")\n" );
+    }
+    catch( ... )
+    {
+        m_ctl = ctl;
+        throw;
+    }
+
+    m_ctl = ctl;
+
+    const std::string& boardText = m_sf.GetString();
+    std::string        translated;
+    const std::string& written = writeBoardFile( aFileName, boardText, translated );
+
+    // The text section: the board file less what the other sections hold
+    std::string text;
+    size_t      pos = 0;
+
+    text.reserve( boardText.size() );
+
+    for( const std::pair<size_t, size_t>& range : m_snapshotRanges )
+    {
+        text.append( boardText, pos, range.first - pos );
+        pos = range.second;
+    }
+
+    text.append( boardText, pos, std::string::npos );
+
+    FILE_HEADER header;
+
+    memcpy( header.m_magic, SNAPSHOT_MAGIC, sizeof( SNAPSHOT_MAGIC ) );
+    header.m_version = SNAPSHOT_VERSION;
+    header.m_byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.m_boardVersion = SEXPR_BOARD_FILE_VERSION;
+    header.m_layerCount = PCB_LAYER_ID_COUNT;
+    header.m_sourceSize = written.size();
+    header.m_sourceHash = hashBytes( written.data(), written.size() );
+    header.m_textSize = text.size();
+
+    m_sf.Clear();
+    m_snapshotRanges.clear();
+    translated.clear();
+
+    // The tracks, in the order they are saved in the board file
+    std::set<TRACK*, TRACK::cmp_tracks> sorted_tracks( aBoard->Tracks().begin(),
+            aBoard->Tracks().end() );
+    std::vector<TRACK*> tracks;
+
+    for( TRACK* track : sorted_tracks )
+    {
+        if( !track->IsInGroup() )
+            tracks.push_back( track );
+    }
+
+    size_t               count = tracks.size();
+    std::vector<uint8_t> kinds( count, KIND_SEGMENT );
+    std::vector<uint8_t> flags( count, 0 );
+    std::vector<uint8_t> viaTypes( count, 0 );
+    std::vector<int32_t> columns[COL_COUNT];
+    std::vector<uint8_t> uuids( 16 * count );
+
+    for( std::vector<int32_t>& column : columns )
+        column.resize( count, 0 );
+
+    for( size_t ii = 0; ii < count; ++ii )
+    {
+        TRACK* track = tracks[ii];
+
+        columns[COL_LAYER][ii] = track->GetLayer();
+        columns[COL_NET][ii] = m_mapping->Translate( track->GetNetCode() );
+        columns[COL_WIDTH][ii] = track->GetWidth();
+        columns[COL_START_X][ii] = track->GetStart().x;
+        columns[COL_START_Y][ii] = track->GetStart().y;
+        columns[COL_END_X][ii] = track->GetEnd().x;
+        columns[COL_END_Y][ii] = track->GetEnd().y;
+
+        if( track->IsLocked() )
+            flags[ii] |= FLAG_LOCKED;
+
+        track->m_Uuid.GetBytes( &uuids[16 * ii] );
+
+        if( track->Type() == PCB_VIA_T )
+        {
+            VIA*         via = static_cast<VIA*>( track );
+            PCB_LAYER_ID top, bottom;
+
+            via->LayerPair( &top, &bottom );
+
+            kinds[ii] = KIND_VIA;
+            viaTypes[ii] = static_cast<uint8_t>( via->GetViaType() );
+            columns[COL_LAYER][ii] = top;
+            columns[COL_BOTTOM_LAYER][ii] = bottom;
+            columns[COL_DRILL][ii] = via->GetDrill();
+
+            if( via->GetRemoveUnconnected() )
+                flags[ii] |= FLAG_REMOVE_UNCONNECTED;
+
+            if( via->GetKeepTopBottom() )
+                flags[ii] |= FLAG_KEEP_TOP_BOTTOM;
+        }
+        else if( track->Type() == PCB_ARC_T )
+        {
+            ARC* arc = static_cast<ARC*>( track );
+
+            kinds[ii] = KIND_ARC;
+            columns[COL_MID_X][ii] = arc->GetMid().x;
+            columns[COL_MID_Y][ii] = arc->GetMid().y;
+        }
+    }
+
+    header.m_trackCount = count;
+
+    // The pads
+    std::string pads;
+
+    formatPads( aBoard, m_mapping, pads, header );
+
+    // The zone fills
+    std::string fills;
+    uint64_t    fillCount = 0;
+
+    for( ZONE_CONTAINER* zone : aBoard->Zones() )
+    {
+        for( PCB_LAYER_ID layer : zone->GetLayerSet().Seq() )
+        {
+            if( !zone->HasFilledPolysForLayer( layer ) )
+                continue;
+
+            const SHAPE_POLY_SET& polys = zone->GetFilledPolysList( layer );
+
+            if( polys.IsEmpty() )
+                continue;
+
+            std::vector<int32_t> blob;
+
+            for( int ii = 0; ii < polys.OutlineCount(); ++ii )
+            {
+                if( zone->IsIsland( layer, ii ) )
+                    blob.push_back( ii );
+            }
+
+            FILL_HEADER fill;
+
+            zone->m_Uuid.GetBytes( fill.m_zone );
+            fill.m_layer = layer;
+            fill.m_islandCount = (int32_t) blob.size();
+
+            ZONE_FILL_CACHE::WritePolys( polys, blob );
+
+            if( blob.size() % 2 )
+                blob.push_back( 0 );
+
+            fill.m_size = blob.size();
+
+            appendSection( fills, &fill, sizeof( fill ) );
+            appendSection( fills, blob.data(), blob.size() * sizeof( int32_t ) );
+            fillCount++;
+        }
+    }
+
+    header.m_fillCount = fillCount;
+
+    std::string snapshot;
+
+    appendSection( snapshot, &header, sizeof( header ) );
+    appendSection( snapshot, text.data(), text.size() );
+    appendSection( snapshot, kinds.data(), count );
+    appendSection( snapshot, flags.data(), count );
+    appendSection( snapshot, viaTypes.data(), count );
+
+    for( const std::vector<int32_t>& column : columns )
+        appendSection( snapshot, column.data(), count * sizeof( int32_t ) );
+
+    appendSection( snapshot, uuids.data(), uuids.size() );
+    snapshot += pads;
+    snapshot += fills;
+
+    return snapshot;
+}
+
+
+bool PCB_SNAPSHOT_IO::HashBoardFile( const wxString& aBoardFileName, uint64_t& aHash )
+{
+    MAPPED_FILE source;
+
+    if( !source.Open( aBoardFileName ) )
+        return false;
+
+    aHash = hashBytes( source.Data(), source.Size() );
+    return true;
+}
+
+
+bool PCB_SNAPSHOT_IO::WriteSnapshot( const wxString& aBoardFileName, const std::string& aSnapshot )
+{
+    // Write to a temporary file first, so that a snapshot is either complete or absent
+    wxString fileName = SnapshotFileName( aBoardFileName );
+    wxString tempName = fileName + wxT( ".tmp" );
+    wxFFile  file( tempName, "wb" );
+
+    if( !file.IsOpened() )
+        return false;
+
+    bool ok = file.Write( aSnapshot.data(), aSnapshot.size() ) == aSnapshot.size();
+
+    ok &= file.Close();
+
+    if( !ok )
+    {
+        wxRemoveFile( tempName );
+        return false;
+    }
+
+    return wxRenameFile( tempName, fileName, true );
+}
+
+
+BOARD* PCB_SNAPSHOT_IO::LoadSnapshot( const wxString& aBoardFileName,
+                                      const PROPERTIES* aProperties )
+{
+    PROF_COUNTER timer;
+    MAPPED_FILE  snapshot;
+    MAPPED_FILE  source;
+    FILE_HEADER  header;
+
+    if( !snapshot.Open( SnapshotFileName( aBoardFileName ) ) || !source.Open( aBoardFileName )
+            || snapshot.Size() < sizeof( header ) )
+    {
+        return nullptr;
+    }
+
+    memcpy( &header, snapshot.Data(), sizeof( header ) );
+
+    if( memcmp( header.m_magic, SNAPSHOT_MAGIC, sizeof( SNAPSHOT_MAGIC ) ) != 0
+            || header.m_version != SNAPSHOT_VERSION
+            || header.m_byteOrder != SNAPSHOT_BYTE_ORDER
+            || header.m_boardVersion != SEXPR_BOARD_FILE_VERSION
+            || header.m_layerCount != PCB_LAYER_ID_COUNT
+            || header.m_sourceSize != source.Size()
+            || header.m_trackCount > snapshot.Size()
+            || header.m_moduleCount > snapshot.Size()
+            || header.m_padCount > snapshot.Size()
+            || header.m_padStringSize > snapshot.Size()
+            || header.m_fillCount > snapshot.Size() )
+    {
+        return nullptr;
+    }
+
+    if( header.m_sourceHash != hashBytes( source.Data(), source.Size() ) )
+        return nullptr;
+
+    source.Close();
+
+    SECTION_READER reader( snapshot.Data() + sizeof( header ), snapshot.Size() - sizeof( header ) );
+    const char*    text = reader.Next( header.m_textSize );
+
+    if( !text )
+        return nullptr;
+
+    std::unique_ptr<BOARD> board;
+
+    try
+    {
+        STRING_LINE_READER lineReader( std::string( text, header.m_textSize ), aBoardFileName );
+
+        board.reset( DoLoad( lineReader, NULL, aProperties ) );
+    }
+    catch( const IO_ERROR& )
+    {
+        return nullptr;
+    }
+
+    // The tracks
+    size_t         count = header.m_trackCount;
+    const uint8_t* kinds = reinterpret_cast<const uint8_t*>( reader.Next( count ) );
+    const uint8_t* flags = reinterpret_cast<const uint8_t*>( reader.Next( count ) );
+    const uint8_t* viaTypes = reinterpret_cast<const uint8_t*>( reader.Next( count ) );
+    const int32_t* columns[COL_COUNT];
+
+    for( const int32_t*& column : columns )
+        column = reinterpret_cast<const int32_t*>( reader.Next( count * sizeof( int32_t ) ) );
+
+    const uint8_t* uuids = reinterpret_cast<const uint8_t*>( reader.Next( 16 * count ) );
+
+    if( !kinds || !flags || !viaTypes || !uuids
+            || std::find( columns, columns + COL_COUNT, nullptr ) != columns + COL_COUNT )
+    {
+        return nullptr;
+    }
+
+    auto isLayer =
+            []( int32_t aLayer )
+            {
+                return aLayer >= 0 && aLayer < PCB_LAYER_ID_COUNT;
+            };
+
+    for( size_t ii = 0; ii < count; ++ii )
+    {
+        std::unique_ptr<TRACK> track;
+
+        if( !isLayer( columns[COL_LAYER][ii] ) )
+            return nullptr;
+
+        switch( kinds[ii] )
+        {
+        case KIND_SEGMENT:
+            track.reset( new TRACK( board.get() ) );
+            break;
+
+        case KIND_ARC:
+        {
+            ARC* arc = new ARC( board.get() );
+
+            arc->SetMid( wxPoint( columns[COL_MID_X][ii], columns[COL_MID_Y][ii] ) );
+            track.reset( arc );
+            break;
+        }
+
+        case KIND_VIA:
+        {
+            if( !isLayer( columns[COL_BOTTOM_LAYER][ii] )
+                    || viaTypes[ii] < static_cast<uint8_t>( VIATYPE::MICROVIA )
+                    || viaTypes[ii] > static_cast<uint8_t>( VIATYPE::THROUGH ) )
+            {
+                return nullptr;
+            }
+
+            VIA* via = new VIA( board.get() );
+
+            via->SetViaType( static_cast<VIATYPE>( viaTypes[ii] ) );
+            via->SetLayerPair( static_cast<PCB_LAYER_ID>( columns[COL_LAYER][ii] ),
+                               static_cast<PCB_LAYER_ID>( columns[COL_BOTTOM_LAYER][ii] ) );
+            via->SetDrill( columns[COL_DRILL][ii] );
+            via->SetRemoveUnconnected( flags[ii] & FLAG_REMOVE_UNCONNECTED );
+            via->SetKeepTopBottom( flags[ii] & FLAG_KEEP_TOP_BOTTOM );
+            track.reset( via );
+            break;
+        }
+
+        default:
+            return nullptr;
+        }
+
+        if( kinds[ii] != KIND_VIA )
+            track->SetLayer( static_cast<PCB_LAYER_ID>( columns[COL_LAYER][ii] ) );
+
+        track->SetStart( wxPoint( columns[COL_START_X][ii], columns[COL_START_Y][ii] ) );
+        track->SetEnd( wxPoint( columns[COL_END_X][ii], columns[COL_END_Y][ii] ) );
+        track->SetWidth( columns[COL_WIDTH][ii] );
+        track->SetLocked( flags[ii] & FLAG_LOCKED );
+        const_cast<KIID&>( track->m_Uuid ) = KIID::FromBytes( uuids + 16 * ii );
+
+        if( !track->SetNetCode( m_parser->GetBoardNetCode( columns[COL_NET][ii] ), true ) )
+            return nullptr;
+
+        board->Add( track.release(), ADD_MODE::APPEND );
+    }
+
+    if( !loadPads( board.get(), m_parser, reader, header ) )
+        return nullptr;
+
+    // The zone fills
+    std::map<KIID, ZONE_CONTAINER*> zones;
+    std::set<ZONE_CONTAINER*>       filledZones;
+
+    for( ZONE_CONTAINER* zone : board->Zones() )
+        zones[zone->m_Uuid] = zone;
+
+    for( uint64_t ii = 0; ii < header.m_fillCount; ++ii )
+    {
+        FILL_HEADER fill;
+        const char* fillHeader = reader.Next( sizeof( fill ) );
+
+        if( !fillHeader )
+            return nullptr;
+
+        memcpy( &fill, fillHeader, sizeof( fill ) );
+
+        if( fill.m_size > reader.Remaining() / sizeof( int32_t ) )
+            return nullptr;
+
+        const int32_t* data = reinterpret_cast<const int32_t*>(
+                reader.Next( fill.m_size * sizeof( int32_t ) ) );
+        auto           zone = zones.find( KIID::FromBytes( fill.m_zone ) );
+
+        if( !data || zone == zones.end() || !isLayer( fill.m_layer )
+                || !zone->second->GetLayerSet().test( fill.m_layer )
+                || fill.m_islandCount < 0 || (uint64_t) fill.m_islandCount > fill.m_size )
+        {
+            return nullptr;
+        }
+
+        PCB_LAYER_ID   layer = static_cast<PCB_LAYER_ID>( fill.m_layer );
+        const int32_t* islands = data;
+        const int32_t* end = data + fill.m_size;
+        SHAPE_POLY_SET polys;
+
+        data += fill.m_islandCount;
+
+        if( !ZONE_FILL_CACHE::ReadPolys( data, end, polys ) )
+            return nullptr;
+
+        zone->second->SetFilledPolysList( layer, polys );
+
+        for( int32_t jj = 0; jj < fill.m_islandCount; ++jj )
+        {
+            if( islands[jj] < 0 || islands[jj] >= polys.OutlineCount() )
+                return nullptr;
+
+            zone->second->SetIsIsland( layer, islands[jj] );
+        }
+
+        filledZones.insert( zone->second );
+    }
+
+    for( ZONE_CONTAINER* zone : filledZones )
+        zone->CalculateFilledArea();
+
+    timer.Stop();
+    wxLogTrace( traceSnapshot, "Loaded %s from its snapshot in %0.1f ms: %llu tracks, "
+                "%llu pads apart from the text, %llu zone fills",
+                aBoardFileName, timer.msecs(), (unsigned long long) header.m_trackCount,
+                (unsigned long long) header.m_padCount, (unsigned long long) header.m_fillCount );
+
+    return board.release();
+}
@@ -0,0 +1,107 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef PCB_SNAPSHOT_IO_H
+#define PCB_SNAPSHOT_IO_H
+
+#include <cstdint>
+#include <string>
+
+#include <kicad_plugin.h>
+
+
+/**
+ * PCB_SNAPSHOT_IO
+ * is a PCB_IO which keeps a binary snapshot of the boards it saves in a file next to the board
+ * file, and loads a board from its snapshot as long as the board file hasn't changed since.
+ *
+ * The board file stays the reference: a snapshot records the size and the hash of the board
+ * file it was taken from, and is ignored (the board file is then parsed as usual) when they
+ * don't match the board file or when anything in the snapshot doesn't check out.
+ *
+ * A snapshot is a header followed by:
+ *  - the s-expression text of the board, without its tracks (except those in groups), without
+ *    the pads of its footprints (except footprints with custom pads) and without the filled
+ *    polygons of its zones;
+ *  - the tracks, arcs and vias, one column per field;
+ *  - the pads, one column per field, after the number of pads of each footprint;
+ *  - the filled polygons of the zones, one record per zone layer.
+ * Each section starts on a multiple of 8 bytes, so that the columns are used in place once the
+ * file is memory-mapped.
+ */
+class PCB_SNAPSHOT_IO : public PCB_IO
+{
+public:
+
+    //-----<PLUGIN API>---------------------------------------------------------
+
+    const wxString PluginName() const override
+    {
+        return wxT( "KiCad snapshot" );
+    }
+
+    void Save( const wxString& aFileName, BOARD* aBoard,
+               const PROPERTIES* aProperties = NULL ) override;
+
+    BOARD* Load( const wxString& aFileName, BOARD* aAppendToMe,
+                 const PROPERTIES* aProperties = NULL ) override;
+
+    //-----</PLUGIN API>--------------------------------------------------------
+
+    /**
+     * @return the name of the snapshot file kept next to \a aBoardFileName.
+     */
+    static wxString SnapshotFileName( const wxString& aBoardFileName );
+
+    /**
+     * Saves \a aBoard to \a aFileName like PCB_IO::Save(), and builds its snapshot from the
+     * same formatting of the board.  The snapshot records the size and hash of the bytes
+     * written, so it can be written by WriteSnapshot() for the board file \a aFileName is
+     * renamed to.  Reads the whole board, so must be called from the thread which owns it.
+     * @return the snapshot, or an empty string if the board was saved without a snapshot.
+     * @throw IO_ERROR if the board file can't be written.
+     */
+    std::string SaveWithSnapshot( const wxString& aFileName, BOARD* aBoard,
+                                  const PROPERTIES* aProperties = NULL );
+
+    /**
+     * Writes \a aSnapshot, built by SaveWithSnapshot(), as the snapshot of the board file
+     * \a aBoardFileName.  Only writes the snapshot file, so may be called from any thread.
+     * @return false if the snapshot can't be written.
+     */
+    static bool WriteSnapshot( const wxString& aBoardFileName, const std::string& aSnapshot );
+
+    /**
+     * Computes the hash a snapshot records of the board file it was taken from.
+     * @return false if the file can't be read.
+     */
+    static bool HashBoardFile( const wxString& aBoardFileName, uint64_t& aHash );
+
+    /**
+     * Loads the board of \a aBoardFileName from its snapshot.
+     * @return the board, or nullptr if there is no valid snapshot of the board file as it is now.
+     */
+    BOARD* LoadSnapshot( const wxString& aBoardFileName, const PROPERTIES* aProperties = NULL );
+};
+
+#endif // PCB_SNAPSHOT_IO_H
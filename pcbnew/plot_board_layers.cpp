@@ -30,6 +30,7 @@
 
 
 #include <fctsys.h>
+#include <advanced_config.h>
 #include <base_struct.h>
 #include <gr_text.h>
 #include <geometry/geometry_utils.h>
@@ -280,65 +281,76 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
             // Now offset the pad size by margin + width_adj
             wxSize padPlotsSize = pad->GetSize() + margin * 2 + wxSize( width_adj, width_adj );
 
-            // Store these parameters that can be modified to plot inflated/deflated pads shape
-            PAD_SHAPE_T padShape = pad->GetShape();
-            wxSize      padSize = pad->GetSize();
-            wxSize      padDelta = pad->GetDelta(); // has meaning only for trapezoidal pads
-            double      padCornerRadius = pad->GetRoundRectCornerRadius();
-
             // Don't draw a null size item :
             if( padPlotsSize.x <= 0 || padPlotsSize.y <= 0 )
                 continue;
 
+            if( ( pad->GetShape() == PAD_SHAPE_CIRCLE || pad->GetShape() == PAD_SHAPE_OVAL ) &&
+                aPlotOpt.GetSkipPlotNPTH_Pads() &&
+                ( aPlotOpt.GetDrillMarksType() == PCB_PLOT_PARAMS::NO_DRILL_SHAPE ) &&
+                ( padPlotsSize == pad->GetDrillSize() ) &&
+                ( pad->GetAttribute() == PAD_ATTRIB_HOLE_NOT_PLATED ) )
+                continue;
+
+            // Most pads are plotted with their own shape
+            if( margin.x == 0 && margin.y == 0 && width_adj == 0 )
+            {
+                itemplotter.PlotPad( pad, color, padPlotMode );
+                continue;
+            }
+
+            // The inflated/deflated pad shape is plotted from a copy of the pad, so that the
+            // board isn't modified and several layers can be plotted at the same time.
+            // The copy constructor recomputes the orientation from the footprint one and drops
+            // the drill of SMD pads: keep them as they are.
+            D_PAD  plotPad( *pad );
+            wxSize padSize = pad->GetSize();
+            wxSize padDelta = pad->GetDelta(); // has meaning only for trapezoidal pads
+
+            plotPad.SetOrientation( pad->GetOrientation() );
+            plotPad.SetDrillSize( pad->GetDrillSize() );
+
             switch( pad->GetShape() )
             {
             case PAD_SHAPE_CIRCLE:
             case PAD_SHAPE_OVAL:
-                pad->SetSize( padPlotsSize );
-
-                if( aPlotOpt.GetSkipPlotNPTH_Pads() &&
-                    ( aPlotOpt.GetDrillMarksType() == PCB_PLOT_PARAMS::NO_DRILL_SHAPE ) &&
-                    ( pad->GetSize() == pad->GetDrillSize() ) &&
-                    ( pad->GetAttribute() == PAD_ATTRIB_HOLE_NOT_PLATED ) )
-                    break;
-
-                itemplotter.PlotPad( pad, color, padPlotMode );
+                plotPad.SetSize( padPlotsSize );
+                itemplotter.PlotPad( &plotPad, color, padPlotMode );
                 break;
 
             case PAD_SHAPE_RECT:
-                pad->SetSize( padPlotsSize );
+                plotPad.SetSize( padPlotsSize );
 
                 if( margin.x > 0 )
                 {
-                    pad->SetShape( PAD_SHAPE_ROUNDRECT );
-                    pad->SetRoundRectCornerRadius( margin.x );
+                    plotPad.SetShape( PAD_SHAPE_ROUNDRECT );
+                    plotPad.SetRoundRectCornerRadius( margin.x );
                 }
 
-                itemplotter.PlotPad( pad, color, padPlotMode );
+                itemplotter.PlotPad( &plotPad, color, padPlotMode );
                 break;
 
             case PAD_SHAPE_TRAPEZOID:
             {
                 wxSize scale( padPlotsSize.x / padSize.x, padPlotsSize.y / padSize.y );
-                pad->SetDelta( wxSize( padDelta.x * scale.x, padDelta.y * scale.y ) );
-                pad->SetSize( padPlotsSize );
+                plotPad.SetDelta( wxSize( padDelta.x * scale.x, padDelta.y * scale.y ) );
+                plotPad.SetSize( padPlotsSize );
 
-                itemplotter.PlotPad( pad, color, padPlotMode );
+                itemplotter.PlotPad( &plotPad, color, padPlotMode );
             }
                 break;
 
             case PAD_SHAPE_ROUNDRECT:
             case PAD_SHAPE_CHAMFERED_RECT:
                 // Chamfer and rounding are stored as a percent and so don't need scaling
-                pad->SetSize( padPlotsSize );
-                itemplotter.PlotPad( pad, color, padPlotMode );
+                plotPad.SetSize( padPlotsSize );
+                itemplotter.PlotPad( &plotPad, color, padPlotMode );
                 break;
 
             case PAD_SHAPE_CUSTOM:
             {
                 // inflate/deflate a custom shape is a bit complex.
                 // so build a similar pad shape, and inflate/deflate the polygonal shape
-                D_PAD dummy( *pad );
                 SHAPE_POLY_SET shape;
                 pad->MergePrimitivesAsPolygon( &shape, UNDEFINED_LAYER );
                 // Shape polygon can have holes so use InflateWithLinkedHoles(), not Inflate()
@@ -346,25 +358,19 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
                 int maxError = aBoard->GetDesignSettings().m_MaxError;
                 int numSegs = GetArcToSegmentCount( margin.x, maxError, 360.0 );
                 shape.InflateWithLinkedHoles( margin.x, numSegs, SHAPE_POLY_SET::PM_FAST );
-                dummy.DeletePrimitivesList();
-                dummy.AddPrimitivePoly( shape, 0 );
+                plotPad.DeletePrimitivesList();
+                plotPad.AddPrimitivePoly( shape, 0 );
 
                 // Be sure the anchor pad is not bigger than the deflated shape because this
                 // anchor will be added to the pad shape when plotting the pad. So now the
                 // polygonal shape is built, we can clamp the anchor size
                 if( margin.x < 0 )  // we expect margin.x = margin.y for custom pads
-                    dummy.SetSize( padPlotsSize );
+                    plotPad.SetSize( padPlotsSize );
 
-                itemplotter.PlotPad( &dummy, color, padPlotMode );
+                itemplotter.PlotPad( &plotPad, color, padPlotMode );
             }
                 break;
             }
-
-            // Restore the pad parameters modified by the plot code
-            pad->SetSize( padSize );
-            pad->SetDelta( padDelta );
-            pad->SetShape( padShape );
-            pad->SetRoundRectCornerRadius( padCornerRadius );
         }
 
         aPlotter->EndBlock( NULL );
@@ -1097,7 +1103,10 @@ PLOTTER* StartPlotBoard( BOARD *aBoard, PCB_PLOT_PARAMS *aPlotOpts, int aLayer,
         break;
 
     case PLOT_FORMAT::PDF:
-        plotter = new PDF_PLOTTER();
+        PDF_PLOTTER* PDF_plotter;
+        PDF_plotter = new PDF_PLOTTER();
+        PDF_plotter->SetCompressionLevel( ADVANCED_CFG::GetCfg().m_PdfCompressionLevel );
+        plotter = PDF_plotter;
         break;
 
     case PLOT_FORMAT::HPGL:
@@ -472,6 +472,9 @@ void BRDITEMS_PLOTTER::PlotPcbTarget( PCB_TARGET* aMire )
 // Plot footprints graphic items (outlines)
 void BRDITEMS_PLOTTER::PlotFootprintGraphicItems( MODULE* aModule )
 {
+    // The graphics are the same for all the footprints of a kind with the same orientation
+    m_plotter->StartReusableBlock( aModule->GetPosition() );
+
     for( BOARD_ITEM* item : aModule->GraphicalItems() )
     {
         EDGE_MODULE* edge = dynamic_cast<EDGE_MODULE*>( item );
@@ -479,6 +482,8 @@ void BRDITEMS_PLOTTER::PlotFootprintGraphicItems( MODULE* aModule )
         if( edge && m_layerMask[ edge->GetLayer() ] )
             PlotFootprintGraphicItem( edge );
     }
+
+    m_plotter->EndReusableBlock();
 }
 
 
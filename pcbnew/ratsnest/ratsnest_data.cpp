@@ -40,9 +40,12 @@ using namespace std::placeholders;
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <limits>
 
 #include <delaunator.hpp>
+#include <geometry/rtree.h>
+#include <math/util.h>     // for KiROUND, Clamp
 
 class disjoint_set
 {
@@ -134,8 +137,42 @@ void RN_NET::kruskalMST( const std::vector<CN_EDGE> &aEdges )
 class RN_NET::TRIANGULATOR_STATE
 {
 private:
+    using ANCHOR_LIST = std::vector<CN_ANCHOR_PTR>;
+
+    ///> Edge of the last full triangulation, between two indices of m_basePoints
+    struct BASE_EDGE
+    {
+        int      m_source;
+        int      m_target;
+        unsigned m_weight;
+    };
+
+    ///> Nets with fewer unique node positions are always triangulated from scratch
+    static constexpr size_t MIN_INCREMENTAL_NODES = 128;
+
+    ///> Updates that add or remove more than 1/MAX_CHANGED_FRACTION of the positions
+    ///> of the last full triangulation fall back to a full triangulation
+    static constexpr size_t MAX_CHANGED_FRACTION = 8;
+
+    ///> Number of angular sectors searched for the nearest neighbours of a changed node
+    static constexpr int SECTOR_COUNT = 6;
+
     std::multiset<CN_ANCHOR_PTR, CN_PTR_CMP> m_allNodes;
 
+    ///> Unique node positions of the last full triangulation, in m_allNodes order
+    std::vector<VECTOR2I>  m_basePoints;
+
+    ///> Edges of the last full triangulation, sorted by weight
+    std::vector<BASE_EDGE> m_baseEdges;
+
+    ///> Neighbours of the base point i are m_baseAdjacency[m_baseAdjacencyStart[i]] up to
+    ///> m_baseAdjacency[m_baseAdjacencyStart[i + 1]]
+    std::vector<int>       m_baseAdjacencyStart;
+    std::vector<int>       m_baseAdjacency;
+
+    ///> m_basePoints, by position
+    RTree<const VECTOR2I*, int, 2, double> m_baseIndex;
+
 
     // Checks if all nodes in aNodes lie on a single line. Requires the nodes to
     // have unique coordinates!
@@ -158,45 +195,269 @@ private:
         return true;
     }
 
-public:
+    // Collects one anchor for each unique node position, and the chain of all the nodes
+    // sharing that position.
+    void collectAnchors( ANCHOR_LIST& aAnchors, std::vector<ANCHOR_LIST>& aAnchorChains ) const
+    {
+        aAnchors.reserve( m_allNodes.size() );
+        aAnchorChains.resize( m_allNodes.size() );
 
-    void Clear()
+        CN_ANCHOR_PTR prev = nullptr;
+
+        for( const auto& n : m_allNodes )
+        {
+            if( !prev || prev->Pos() != n->Pos() )
+            {
+                aAnchors.push_back( n );
+                prev = n;
+            }
+
+            aAnchorChains[aAnchors.size() - 1].push_back( n );
+        }
+
+        aAnchorChains.resize( aAnchors.size() );
+    }
+
+    void addChainEdges( std::vector<ANCHOR_LIST>& aAnchorChains, std::vector<CN_EDGE>& mstEdges )
     {
-        m_allNodes.clear();
+        for( size_t i = 0; i < aAnchorChains.size(); i++ )
+        {
+            auto& chain = aAnchorChains[i];
+
+            if( chain.size() < 2 )
+                continue;
+
+            std::sort( chain.begin(), chain.end(),
+                    [] ( const CN_ANCHOR_PTR& a, const CN_ANCHOR_PTR& b ) {
+                return a->GetCluster().get() < b->GetCluster().get();
+            } );
+
+            for( unsigned int j = 1; j < chain.size(); j++ )
+            {
+                const auto& prevNode    = chain[j - 1];
+                const auto& curNode     = chain[j];
+                int weight = prevNode->GetCluster() != curNode->GetCluster() ? 1 : 0;
+                mstEdges.emplace_back( prevNode, curNode, weight );
+            }
+        }
     }
 
-    void AddNode( CN_ANCHOR_PTR aNode )
+    void clearBase()
     {
-        m_allNodes.insert( aNode );
+        m_basePoints.clear();
+        m_baseEdges.clear();
+        m_baseAdjacencyStart.clear();
+        m_baseAdjacency.clear();
+        m_baseIndex.RemoveAll();
     }
 
-    void Triangulate( std::vector<CN_EDGE>& mstEdges)
+    void storeBase( const ANCHOR_LIST& aAnchors, std::vector<BASE_EDGE>&& aEdges )
     {
-        std::vector<double>          node_pts;
+        m_basePoints.reserve( aAnchors.size() );
 
-        using ANCHOR_LIST = std::vector<CN_ANCHOR_PTR>;
+        for( const auto& anchor : aAnchors )
+            m_basePoints.push_back( anchor->Pos() );
 
-        ANCHOR_LIST              anchors;
-        std::vector<ANCHOR_LIST> anchorChains( m_allNodes.size() );
+        for( const VECTOR2I& point : m_basePoints )
+        {
+            const int pos[2] = { point.x, point.y };
+
+            m_baseIndex.Insert( pos, pos, &point );
+        }
 
-        node_pts.reserve( 2 * m_allNodes.size() );
-        anchors.reserve( m_allNodes.size() );
+        m_baseEdges = std::move( aEdges );
 
-        CN_ANCHOR_PTR prev = nullptr;
+        std::sort( m_baseEdges.begin(), m_baseEdges.end(),
+                []( const BASE_EDGE& a, const BASE_EDGE& b )
+                {
+                    return a.m_weight < b.m_weight;
+                } );
 
-        for( const auto& n : m_allNodes )
+        m_baseAdjacencyStart.assign( m_basePoints.size() + 1, 0 );
+
+        for( const BASE_EDGE& edge : m_baseEdges )
         {
-            if( !prev || prev->Pos() != n->Pos() )
+            m_baseAdjacencyStart[edge.m_source + 1]++;
+            m_baseAdjacencyStart[edge.m_target + 1]++;
+        }
+
+        for( size_t i = 1; i < m_baseAdjacencyStart.size(); i++ )
+            m_baseAdjacencyStart[i] += m_baseAdjacencyStart[i - 1];
+
+        std::vector<int> fill( m_baseAdjacencyStart.begin(), m_baseAdjacencyStart.end() - 1 );
+        m_baseAdjacency.resize( m_baseAdjacencyStart.back() );
+
+        for( const BASE_EDGE& edge : m_baseEdges )
+        {
+            m_baseAdjacency[fill[edge.m_source]++] = edge.m_target;
+            m_baseAdjacency[fill[edge.m_target]++] = edge.m_source;
+        }
+    }
+
+    // Returns the squared distance from aPos to the farthest point of aBBox in the given
+    // sector around aPos: no node of the sector lies further.
+    static double sectorReach( const VECTOR2I& aPos, const BOX2I& aBBox, int aSector )
+    {
+        const double a0 = aSector * 2 * M_PI / SECTOR_COUNT - M_PI;
+        const double a1 = a0 + 2 * M_PI / SECTOR_COUNT;
+
+        // The box is slightly inflated, so that the rounding of the clipping can't drop the
+        // nodes on a side of the box which is also a side of the sector
+        const double          x0 = aBBox.GetX() - aPos.x - 1.0;
+        const double          y0 = aBBox.GetY() - aPos.y - 1.0;
+        const double          x1 = aBBox.GetRight() - aPos.x + 1.0;
+        const double          y1 = aBBox.GetBottom() - aPos.y + 1.0;
+        std::vector<VECTOR2D> poly = { VECTOR2D( x0, y0 ), VECTOR2D( x1, y0 ),
+                                       VECTOR2D( x1, y1 ), VECTOR2D( x0, y1 ) };
+
+        // Keeps the part of the box on the positive side of each edge of the sector
+        auto clip =
+                [&]( const VECTOR2D& aNormal )
+                {
+                    std::vector<VECTOR2D> clipped;
+
+                    for( size_t i = 0; i < poly.size(); i++ )
+                    {
+                        const VECTOR2D& a = poly[i];
+                        const VECTOR2D& b = poly[( i + 1 ) % poly.size()];
+                        double          da = aNormal.Dot( a );
+                        double          db = aNormal.Dot( b );
+
+                        if( da >= 0 )
+                            clipped.push_back( a );
+
+                        if( ( da >= 0 ) != ( db >= 0 ) )
+                            clipped.push_back( a + ( b - a ) * ( da / ( da - db ) ) );
+                    }
+
+                    poly = std::move( clipped );
+                };
+
+        clip( VECTOR2D( -sin( a0 ), cos( a0 ) ) );
+        clip( VECTOR2D( sin( a1 ), -cos( a1 ) ) );
+
+        double reach = 0.0;
+
+        for( const VECTOR2D& corner : poly )
+            reach = std::max( reach, corner.SquaredEuclideanNorm() );
+
+        // Leave some room for the rounding of the clipping
+        return ( sqrt( reach ) + 2.0 ) * ( sqrt( reach ) + 2.0 );
+    }
+
+    // Finds the nearest anchor to aAnchors[aIndex] in each of SECTOR_COUNT angular sectors
+    // around it.  These edges contain every minimum spanning tree edge of the anchor, so
+    // they stand in for the triangulation edges near a change.
+    // The unchanged anchors are looked up in m_baseIndex, in boxes growing from aRadius until
+    // they hold the nearest anchor of each sector, or all the anchors the sector can have in
+    // aBBox.  aAddedAnchors, which are not in the index, are all checked.
+    void addSectorNeighbours( const ANCHOR_LIST& aAnchors, int aIndex,
+                              const std::vector<int>& aBaseToAnchor,
+                              const std::vector<int>& aAddedAnchors, const BOX2I& aBBox,
+                              int aRadius, std::vector<std::pair<int, int>>& aPairs ) const
+    {
+        using ecoord = VECTOR2I::extended_type;
+
+        const VECTOR2I p = aAnchors[aIndex]->Pos();
+
+        ecoord best[SECTOR_COUNT];
+        int    bestIndex[SECTOR_COUNT];
+
+        std::fill( best, best + SECTOR_COUNT, VECTOR2I::ECOORD_MAX );
+        std::fill( bestIndex, bestIndex + SECTOR_COUNT, -1 );
+
+        auto visit =
+                [&]( int i )
+                {
+                    if( i == aIndex )
+                        return;
+
+                    const VECTOR2I d = aAnchors[i]->Pos() - p;
+                    const ecoord   dist2 = (ecoord) d.x * d.x + (ecoord) d.y * d.y;
+                    double         angle = atan2( (double) d.y, (double) d.x ) + M_PI;
+                    int            sector = (int) ( angle * SECTOR_COUNT / ( 2 * M_PI ) );
+
+                    sector = std::min( sector, SECTOR_COUNT - 1 );
+
+                    if( dist2 < best[sector] )
+                    {
+                        best[sector] = dist2;
+                        bestIndex[sector] = i;
+                    }
+                };
+
+        for( int i : aAddedAnchors )
+            visit( i );
+
+        double reach[SECTOR_COUNT];
+
+        for( int sector = 0; sector < SECTOR_COUNT; sector++ )
+            reach[sector] = sectorReach( p, aBBox, sector );
+
+        auto toCoord =
+                []( ecoord aValue ) -> int
+                {
+                    return (int) Clamp<ecoord>( std::numeric_limits<int>::min(), aValue,
+                                                std::numeric_limits<int>::max() );
+                };
+
+        for( ecoord radius = std::max( aRadius, 1 ); ; radius *= 2 )
+        {
+            const int mmin[2] = { toCoord( p.x - radius ), toCoord( p.y - radius ) };
+            const int mmax[2] = { toCoord( p.x + radius ), toCoord( p.y + radius ) };
+
+            m_baseIndex.Search( mmin, mmax,
+                    [&]( const VECTOR2I* const& aPoint ) -> bool
+                    {
+                        int anchor = aBaseToAnchor[aPoint - m_basePoints.data()];
+
+                        if( anchor >= 0 )
+                            visit( anchor );
+
+                        return true;
+                    } );
+
+            // Every anchor closer than radius has been seen
+            const double radius2 = (double) radius * radius;
+            bool         done = true;
+
+            for( int sector = 0; sector < SECTOR_COUNT; sector++ )
             {
-                node_pts.push_back( n->Pos().x );
-                node_pts.push_back( n->Pos().y );
-                anchors.push_back( n );
-                prev = n;
+                if( radius2 < std::min( (double) best[sector], reach[sector] ) )
+                    done = false;
             }
 
-            anchorChains[anchors.size() - 1].push_back( n );
+            if( done )
+                break;
         }
 
+        for( int i : bestIndex )
+        {
+            if( i >= 0 )
+                aPairs.emplace_back( std::min( i, aIndex ), std::max( i, aIndex ) );
+        }
+    }
+
+public:
+
+    void Clear()
+    {
+        m_allNodes.clear();
+    }
+
+    void AddNode( CN_ANCHOR_PTR aNode )
+    {
+        m_allNodes.insert( aNode );
+    }
+
+    void Triangulate( std::vector<CN_EDGE>& mstEdges)
+    {
+        ANCHOR_LIST              anchors;
+        std::vector<ANCHOR_LIST> anchorChains;
+
+        collectAnchors( anchors, anchorChains );
+        clearBase();
+
         if( anchors.size() < 2 )
         {
             return;
@@ -215,55 +476,196 @@ public:
         }
         else
         {
+            std::vector<double> node_pts;
+            node_pts.reserve( 2 * anchors.size() );
+
+            for( const auto& anchor : anchors )
+            {
+                node_pts.push_back( anchor->Pos().x );
+                node_pts.push_back( anchor->Pos().y );
+            }
+
             delaunator::Delaunator delaunator( node_pts );
             auto& triangles = delaunator.triangles;
+            auto& halfedges = delaunator.halfedges;
 
-            for( size_t i = 0; i < triangles.size(); i += 3 )
+            std::vector<BASE_EDGE> edges;
+            edges.reserve( triangles.size() / 2 + anchors.size() );
+
+            // Each edge once: halfedge i runs from triangles[i] to the next vertex of its
+            // triangle, and is skipped when its twin has already been visited
+            for( size_t i = 0; i < triangles.size(); i++ )
             {
-                auto src = anchors[triangles[i]];
-                auto dst = anchors[triangles[i + 1]];
-                mstEdges.emplace_back( src, dst, src->Dist( *dst ) );
+                if( halfedges[i] != delaunator::INVALID_INDEX && halfedges[i] < i )
+                    continue;
 
-                src = anchors[triangles[i + 1]];
-                dst = anchors[triangles[i + 2]];
-                mstEdges.emplace_back( src, dst, src->Dist( *dst ) );
+                int src = triangles[i];
+                int dst = triangles[ i % 3 == 2 ? i - 2 : i + 1 ];
 
-                src = anchors[triangles[i + 2]];
-                dst = anchors[triangles[i]];
-                mstEdges.emplace_back( src, dst, src->Dist( *dst ) );
+                edges.push_back( { src, dst, anchors[src]->Dist( *anchors[dst] ) } );
+                mstEdges.emplace_back( anchors[src], anchors[dst], edges.back().m_weight );
             }
 
-            for( size_t i = 0; i < delaunator.halfedges.size(); i++ )
+            if( anchors.size() >= MIN_INCREMENTAL_NODES )
+                storeBase( anchors, std::move( edges ) );
+        }
+
+        addChainEdges( anchorChains, mstEdges );
+    }
+
+    /**
+     * Builds the sorted candidate edges of the minimum spanning tree by patching the last
+     * full triangulation, when only a small part of the nodes moved since then.
+     *
+     * Edges of the last triangulation between unchanged positions are kept.  Edges that the
+     * triangulation of the current nodes would add run between added positions and the
+     * neighbours of removed ones, and are replaced by the nearest anchors in each sector
+     * around those positions.  The result is compared to the last full triangulation, so it
+     * does not depend on the edits made in between.
+     *
+     * @param aBoardEdges are the connections that already exist in the net.
+     * @param mstEdges receives aBoardEdges and the candidate edges, sorted by weight.
+     * @return false, leaving mstEdges untouched, if a full triangulation is needed instead.
+     */
+    bool Update( const std::vector<CN_EDGE>& aBoardEdges, std::vector<CN_EDGE>& mstEdges )
+    {
+        if( m_basePoints.empty() )
+            return false;
+
+        ANCHOR_LIST              anchors;
+        std::vector<ANCHOR_LIST> anchorChains;
+
+        collectAnchors( anchors, anchorChains );
+
+        if( anchors.size() < MIN_INCREMENTAL_NODES )
+            return false;
+
+        // Both lists are sorted by x, then y: match the unchanged positions
+        std::vector<int>  baseToAnchor( m_basePoints.size(), -1 );
+        std::vector<bool> changed( anchors.size(), false );
+        size_t            changeCount = 0;
+        size_t            b = 0;
+
+        auto less =
+                []( const VECTOR2I& a, const VECTOR2I& b )
+                {
+                    return a.x < b.x || ( a.x == b.x && a.y < b.y );
+                };
+
+        for( size_t i = 0; i < anchors.size(); i++ )
+        {
+            const VECTOR2I& pos = anchors[i]->Pos();
+
+            while( b < m_basePoints.size() && less( m_basePoints[b], pos ) )
             {
-                if( delaunator.halfedges[i] == delaunator::INVALID_INDEX )
-                    continue;
+                b++;
+                changeCount++;
+            }
 
-                auto src = anchors[triangles[i]];
-                auto dst = anchors[triangles[delaunator.halfedges[i]]];
-                mstEdges.emplace_back( src, dst, src->Dist( *dst ) );
+            if( b < m_basePoints.size() && m_basePoints[b] == pos )
+            {
+                baseToAnchor[b++] = i;
+            }
+            else
+            {
+                changed[i] = true;
+                changeCount++;
             }
         }
 
-        for( size_t i = 0; i < anchorChains.size(); i++ )
+        changeCount += m_basePoints.size() - b;
+
+        if( changeCount * MAX_CHANGED_FRACTION > m_basePoints.size() )
+            return false;
+
+        if( areNodesColinear( anchors ) )
+            return false;
+
+        // The added positions are not in m_baseIndex
+        std::vector<int> added;
+        BOX2I            bbox( anchors[0]->Pos() );
+
+        for( size_t i = 0; i < anchors.size(); i++ )
         {
-            auto& chain = anchorChains[i];
+            if( changed[i] )
+                added.push_back( i );
 
-            if( chain.size() < 2 )
-                continue;
+            bbox.Merge( anchors[i]->Pos() );
+        }
 
-            std::sort( chain.begin(), chain.end(),
-                    [] ( const CN_ANCHOR_PTR& a, const CN_ANCHOR_PTR& b ) {
-                return a->GetCluster().get() < b->GetCluster().get();
-            } );
+        // About the spacing of the anchors, to start the neighbour searches with
+        int radius = KiROUND( sqrt( (double) bbox.GetWidth() * bbox.GetHeight()
+                                    / anchors.size() ) );
 
-            for( unsigned int j = 1; j < chain.size(); j++ )
+        // Neighbours of removed positions may gain new triangulation edges between them
+        for( size_t i = 0; i < m_basePoints.size(); i++ )
+        {
+            if( baseToAnchor[i] >= 0 )
+                continue;
+
+            for( int j = m_baseAdjacencyStart[i]; j < m_baseAdjacencyStart[i + 1]; j++ )
             {
-                const auto& prevNode    = chain[j - 1];
-                const auto& curNode     = chain[j];
-                int weight = prevNode->GetCluster() != curNode->GetCluster() ? 1 : 0;
-                mstEdges.emplace_back( prevNode, curNode, weight );
+                int neighbour = baseToAnchor[m_baseAdjacency[j]];
+
+                if( neighbour >= 0 )
+                    changed[neighbour] = true;
             }
         }
+
+        std::vector<std::pair<int, int>> pairs;
+
+        for( size_t i = 0; i < anchors.size(); i++ )
+        {
+            if( changed[i] )
+                addSectorNeighbours( anchors, i, baseToAnchor, added, bbox, radius, pairs );
+        }
+
+        std::sort( pairs.begin(), pairs.end() );
+        pairs.erase( std::unique( pairs.begin(), pairs.end() ), pairs.end() );
+
+        std::vector<CN_EDGE> addedEdges;
+        addedEdges.reserve( pairs.size() );
+
+        for( const auto& pair : pairs )
+        {
+            const auto& src = anchors[pair.first];
+            const auto& dst = anchors[pair.second];
+            addedEdges.emplace_back( src, dst, src->Dist( *dst ) );
+        }
+
+        std::sort( addedEdges.begin(), addedEdges.end() );
+
+        std::vector<CN_EDGE> keptEdges;
+        keptEdges.reserve( m_baseEdges.size() );
+
+        for( const BASE_EDGE& edge : m_baseEdges )
+        {
+            int src = baseToAnchor[edge.m_source];
+            int dst = baseToAnchor[edge.m_target];
+
+            if( src >= 0 && dst >= 0 )
+                keptEdges.emplace_back( anchors[src], anchors[dst], edge.m_weight );
+        }
+
+        // Board edges and chain edges weigh 0 or 1, and go in front of the rest
+        mstEdges.reserve( mstEdges.size() + aBoardEdges.size() + anchorChains.size()
+                          + keptEdges.size() + addedEdges.size() );
+        mstEdges.insert( mstEdges.end(), aBoardEdges.begin(), aBoardEdges.end() );
+
+        size_t chainStart = mstEdges.size();
+
+        addChainEdges( anchorChains, mstEdges );
+
+        std::stable_partition( mstEdges.begin() + chainStart, mstEdges.end(),
+                               []( const CN_EDGE& aEdge )
+                               {
+                                   return aEdge.GetWeight() == 0;
+                               } );
+
+        std::merge( keptEdges.begin(), keptEdges.end(), addedEdges.begin(), addedEdges.end(),
+                    std::back_inserter( mstEdges ) );
+
+        return true;
     }
 };
 
@@ -313,21 +715,27 @@ void RN_NET::compute()
     }
 
     std::vector<CN_EDGE> triangEdges;
-    triangEdges.reserve( m_nodes.size() + m_boardEdges.size() );
+    triangEdges.reserve( 3 * m_nodes.size() + m_boardEdges.size() );
 
     #ifdef PROFILE
     PROF_COUNTER cnt("triangulate");
     #endif
-    m_triangulator->Triangulate( triangEdges );
+
+    // Small changes to a large net patch the last triangulation instead of redoing it
+    if( !m_triangulator->Update( m_boardEdges, triangEdges ) )
+    {
+        m_triangulator->Triangulate( triangEdges );
+
+        for( const auto& e : m_boardEdges )
+            triangEdges.emplace_back( e );
+
+        std::sort( triangEdges.begin(), triangEdges.end() );
+    }
+
     #ifdef PROFILE
     cnt.Show();
     #endif
 
-    for( const auto& e : m_boardEdges )
-        triangEdges.emplace_back( e );
-
-    std::sort( triangEdges.begin(), triangEdges.end() );
-
 // Get the minimal spanning tree
 #ifdef PROFILE
     PROF_COUNTER cnt2("mst");
@@ -365,7 +773,7 @@ void RN_NET::AddCluster( CN_CLUSTER_PTR aCluster )
     for( auto item : *aCluster )
     {
         bool isZone = dynamic_cast<CN_ZONE_LAYER*>(item) != nullptr;
-        auto& anchors = item->Anchors();
+        CN_ANCHORS anchors = item->Anchors();
         unsigned int nAnchors = isZone ? 1 : anchors.size();
 
         if( nAnchors > anchors.size() )
@@ -373,19 +781,21 @@ void RN_NET::AddCluster( CN_CLUSTER_PTR aCluster )
 
         for( unsigned int i = 0; i < nAnchors; i++ )
         {
-            anchors[i]->SetCluster( aCluster );
-            m_nodes.insert( anchors[i] );
+            CN_ANCHOR_PTR anchor = anchors.Ptr( i );
+
+            anchor->SetCluster( aCluster );
+            m_nodes.insert( anchor );
 
             if( firstAnchor )
             {
-                if( firstAnchor != anchors[i] )
+                if( firstAnchor != anchor )
                 {
-                    m_boardEdges.emplace_back( firstAnchor, anchors[i], 0 );
+                    m_boardEdges.emplace_back( firstAnchor, anchor, 0 );
                 }
             }
             else
             {
-                firstAnchor = anchors[i];
+                firstAnchor = anchor;
             }
         }
     }
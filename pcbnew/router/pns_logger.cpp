@@ -32,6 +32,8 @@
 #include <geometry/shape_circle.h>
 #include <geometry/shape_simple.h>
 
+#include <algorithm>
+
 namespace PNS {
 
 LOGGER::LOGGER( )
@@ -47,6 +49,7 @@ LOGGER::~LOGGER()
 void LOGGER::Clear()
 {
     m_events.clear();
+    m_stats = STATS();
 }
 
 
@@ -66,6 +69,8 @@ void LOGGER::Save( const std::string& aFilename )
         }
     }
 
+    fprintf( f, "%s\n", FormatStats().c_str() );
+
     fclose( f );
 }
 
@@ -82,4 +87,29 @@ void LOGGER::Log( LOGGER::EVENT_TYPE evt, VECTOR2I pos, const ITEM* item )
 
 }
 
+
+std::string LOGGER::FormatStats() const
+{
+    char buf[256];
+
+    snprintf( buf, sizeof( buf ),
+              "stats queries %lld cache-hits %lld shove-iterations %lld shove-time-us %lld "
+              "max-shove-iteration-time-us %lld",
+              (long long) m_stats.collisionQueries, (long long) m_stats.collisionCacheHits,
+              (long long) m_stats.shoveIterations, (long long) m_stats.shoveTime,
+              (long long) m_stats.maxShoveIterationTime );
+
+    return buf;
+}
+
+
+void LOGGER::LogShoveIteration( int aQueries, int aCacheHits, int64_t aTime )
+{
+    m_stats.collisionQueries += aQueries;
+    m_stats.collisionCacheHits += aCacheHits;
+    m_stats.shoveIterations++;
+    m_stats.shoveTime += aTime;
+    m_stats.maxShoveIterationTime = std::max( m_stats.maxShoveIterationTime, aTime );
+}
+
 }
@@ -22,6 +22,7 @@
 #ifndef __PNS_LOGGER_H
 #define __PNS_LOGGER_H
 
+#include <cstdint>
 #include <cstdio>
 #include <vector>
 #include <string>
@@ -54,6 +55,15 @@ public:
         const ITEM* item;
     };
 
+    ///> Router instrumentation, accumulated until Clear()
+    struct STATS {
+        int64_t collisionQueries = 0;
+        int64_t collisionCacheHits = 0;
+        int64_t shoveIterations = 0;
+        int64_t shoveTime = 0;              ///< total time of the shove iterations, in us
+        int64_t maxShoveIterationTime = 0;  ///< in us
+    };
+
     LOGGER();
     ~LOGGER();
 
@@ -61,13 +71,28 @@ public:
     void Clear();
     void Log( EVENT_TYPE evt, VECTOR2I pos, const ITEM* item = nullptr );
 
+    /**
+     * Records a shove iteration, which made aQueries collision queries (aCacheHits of them
+     * answered from the collision cache) and took aTime microseconds.
+     */
+    void LogShoveIteration( int aQueries, int aCacheHits, int64_t aTime );
+
     const std::vector<EVENT_ENTRY>& GetEvents()
     {
         return m_events;
     }
 
+    const STATS& GetStats() const
+    {
+        return m_stats;
+    }
+
+    ///> Returns the stats as a "stats" line of the log file
+    std::string FormatStats() const;
+
 private:
     std::vector<EVENT_ENTRY> m_events;
+    STATS m_stats;
 };
 
 }
@@ -23,6 +23,7 @@
 #include <cassert>
 #include <utility>
 
+#include <hash_eda.h>
 #include <math/vector2d.h>
 
 #include <geometry/seg.h>
@@ -32,6 +33,7 @@
 #include "pns_item.h"
 #include "pns_line.h"
 #include "pns_node.h"
+#include "pns_segment.h"
 #include "pns_via.h"
 #include "pns_solid.h"
 #include "pns_joint.h"
@@ -53,6 +55,7 @@ NODE::NODE()
     m_maxClearance = 800000;    // fixme: depends on how thick traces are.
     m_ruleResolver = NULL;
     m_index = new INDEX;
+    m_collisionCache = std::make_shared<COLLISION_CACHE>();
 
 #ifdef DEBUG
     allocNodes.insert( this );
@@ -128,6 +131,10 @@ NODE* NODE::Branch()
 
         child->m_joints = m_joints;
         child->m_override = m_override;
+
+        // Same world, so same collisions until something is added or removed: share the cache
+        // rather than copying it
+        child->m_collisionCache = m_collisionCache;
     }
 
     wxLogTrace( "PNS", "%d items, %d joints, %d overrides",
@@ -275,6 +282,106 @@ int NODE::QueryColliding( const ITEM* aItem, OBSTACLE_VISITOR& aVisitor )
 }
 
 
+// Past this number of entries, the collision cache of a branch is dropped and started over
+static const size_t COLLISION_CACHE_MAX_SIZE = 8192;
+
+
+bool NODE::COLLISION_QUERY::operator==( const COLLISION_QUERY& aOther ) const
+{
+    return m_kind == aOther.m_kind && m_a == aOther.m_a && m_b == aOther.m_b
+            && m_width == aOther.m_width && m_drill == aOther.m_drill
+            && m_layerStart == aOther.m_layerStart && m_layerEnd == aOther.m_layerEnd
+            && m_net == aOther.m_net && m_parent == aOther.m_parent
+            && m_kindMask == aOther.m_kindMask && m_limitCount == aOther.m_limitCount
+            && m_differentNetsOnly == aOther.m_differentNetsOnly
+            && m_forceClearance == aOther.m_forceClearance;
+}
+
+
+std::size_t NODE::COLLISION_QUERY_HASH::operator()( const COLLISION_QUERY& aQuery ) const
+{
+    return hash_val( aQuery.m_kind, aQuery.m_a.x, aQuery.m_a.y, aQuery.m_b.x, aQuery.m_b.y,
+                     aQuery.m_width, aQuery.m_layerStart, aQuery.m_net, aQuery.m_kindMask );
+}
+
+
+bool NODE::makeCollisionQuery( const ITEM* aItem, int aKindMask, int aLimitCount,
+                               bool aDifferentNetsOnly, int aForceClearance,
+                               COLLISION_QUERY& aQuery ) const
+{
+    // Only the branches cache their queries: they live for one routing operation, so the
+    // design rules can't change under them
+    if( isRoot() )
+        return false;
+
+    if( aItem->Kind() == ITEM::SEGMENT_T )
+    {
+        const SEGMENT* seg = static_cast<const SEGMENT*>( aItem );
+
+        aQuery.m_a = seg->Seg().A;
+        aQuery.m_b = seg->Seg().B;
+        aQuery.m_width = seg->Width();
+        aQuery.m_drill = 0;
+    }
+    else if( aItem->Kind() == ITEM::VIA_T )
+    {
+        const VIA* via = static_cast<const VIA*>( aItem );
+
+        aQuery.m_a = via->Pos();
+        aQuery.m_b = via->Pos();
+        aQuery.m_width = via->Diameter();
+        aQuery.m_drill = via->Drill();
+    }
+    else
+    {
+        return false;
+    }
+
+    aQuery.m_kind = aItem->Kind();
+    aQuery.m_layerStart = aItem->Layers().Start();
+    aQuery.m_layerEnd = aItem->Layers().End();
+    aQuery.m_net = aItem->Net();
+    aQuery.m_parent = aItem->Parent();
+    aQuery.m_kindMask = aKindMask;
+    aQuery.m_limitCount = aLimitCount;
+    aQuery.m_differentNetsOnly = aDifferentNetsOnly;
+    aQuery.m_forceClearance = aForceClearance;
+    return true;
+}
+
+
+void NODE::invalidateCollisionCache()
+{
+    // The other branches sharing the cache still see the same world: leave it to them
+    auto dropCache =
+            []( NODE* aNode )
+            {
+                if( aNode->m_collisionCache.use_count() > 1 )
+                    aNode->m_collisionCache = std::make_shared<COLLISION_CACHE>();
+                else
+                    aNode->m_collisionCache->clear();
+            };
+
+    dropCache( this );
+
+    // All the branches look up the root index: their results may have changed, too
+    if( isRoot() )
+    {
+        std::vector<NODE*> branches( m_children.begin(), m_children.end() );
+
+        while( !branches.empty() )
+        {
+            NODE* branch = branches.back();
+
+            branches.pop_back();
+            dropCache( branch );
+            branches.insert( branches.end(), branch->m_children.begin(),
+                             branch->m_children.end() );
+        }
+    }
+}
+
+
 int NODE::QueryColliding( const ITEM* aItem, NODE::OBSTACLES& aObstacles, int aKindMask,
                           int aLimitCount, bool aDifferentNetsOnly, int aForceClearance )
 {
@@ -284,6 +391,36 @@ int NODE::QueryColliding( const ITEM* aItem, NODE::OBSTACLES& aObstacles, int aK
     assert( allocNodes.find( this ) != allocNodes.end() );
 #endif
 
+    m_queryStats.m_queries++;
+
+    COLLISION_QUERY query;
+    bool            cacheable = makeCollisionQuery( aItem, aKindMask, aLimitCount,
+                                                    aDifferentNetsOnly, aForceClearance, query );
+
+    if( cacheable )
+    {
+        auto it = m_collisionCache->find( query );
+
+        if( it != m_collisionCache->end() )
+        {
+            m_queryStats.m_cacheHits++;
+
+            for( ITEM* item : it->second )
+            {
+                OBSTACLE obs;
+
+                obs.m_item = item;
+                obs.m_head = aItem;
+                aObstacles.push_back( obs );
+            }
+
+            return aObstacles.size();
+        }
+    }
+
+    // aObstacles may already hold the obstacles of other queries
+    size_t firstObstacle = aObstacles.size();
+
     visitor.SetCountLimit( aLimitCount );
     visitor.SetWorld( this, NULL );
     visitor.m_forceClearance = aForceClearance;
@@ -297,6 +434,17 @@ int NODE::QueryColliding( const ITEM* aItem, NODE::OBSTACLES& aObstacles, int aK
         m_root->m_index->Query( aItem, m_maxClearance, visitor );
     }
 
+    if( cacheable )
+    {
+        if( m_collisionCache->size() >= COLLISION_CACHE_MAX_SIZE )
+            m_collisionCache->clear();
+
+        ITEM_VECTOR& items = ( *m_collisionCache )[query];
+
+        for( size_t i = firstObstacle; i < aObstacles.size(); i++ )
+            items.push_back( aObstacles[i].m_item );
+    }
+
     return aObstacles.size();
 }
 
@@ -542,6 +690,7 @@ void NODE::addSolid( SOLID* aSolid )
         linkJoint( aSolid->Pos(), aSolid->Layers(), aSolid->Net(), aSolid );
 
     m_index->Add( aSolid );
+    invalidateCollisionCache();
 }
 
 void NODE::Add( std::unique_ptr< SOLID > aSolid )
@@ -555,6 +704,7 @@ void NODE::addVia( VIA* aVia )
     linkJoint( aVia->Pos(), aVia->Layers(), aVia->Net(), aVia );
 
     m_index->Add( aVia );
+    invalidateCollisionCache();
 }
 
 void NODE::Add( std::unique_ptr< VIA > aVia )
@@ -616,6 +766,7 @@ void NODE::addSegment( SEGMENT* aSeg )
     linkJoint( aSeg->Seg().B, aSeg->Layers(), aSeg->Net(), aSeg );
 
     m_index->Add( aSeg );
+    invalidateCollisionCache();
 }
 
 bool NODE::Add( std::unique_ptr< SEGMENT > aSegment, bool aAllowRedundant )
@@ -641,6 +792,7 @@ void NODE::addArc( ARC* aArc )
     linkJoint( aArc->Anchor( 1 ), aArc->Layers(), aArc->Net(), aArc );
 
     m_index->Add( aArc );
+    invalidateCollisionCache();
 }
 
 void NODE::Add( std::unique_ptr< ARC > aArc )
@@ -681,6 +833,8 @@ void NODE::doRemove( ITEM* aItem )
     else if( !aItem->BelongsTo( m_root ) || isRoot() )
         m_index->Remove( aItem );
 
+    invalidateCollisionCache();
+
     // the item belongs to this particular branch: un-reference it
     if( aItem->BelongsTo( this ) )
     {
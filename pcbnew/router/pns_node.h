@@ -24,6 +24,7 @@
 
 #include <vector>
 #include <list>
+#include <memory>
 #include <unordered_set>
 #include <unordered_map>
 
@@ -149,6 +150,13 @@ public:
     typedef std::vector<ITEM*>          ITEM_VECTOR;
     typedef std::vector<OBSTACLE>       OBSTACLES;
 
+    ///> Counters of the collision queries made in a node
+    struct QUERY_STATS
+    {
+        int m_queries = 0;      ///< calls to QueryColliding()
+        int m_cacheHits = 0;    ///< of them answered from the collision cache
+    };
+
     NODE();
     ~NODE();
 
@@ -165,12 +173,14 @@ public:
     void SetMaxClearance( int aClearance )
     {
         m_maxClearance = aClearance;
+        invalidateCollisionCache();
     }
 
     ///> Assigns a clerance resolution function object
     void SetRuleResolver( RULE_RESOLVER* aFunc )
     {
         m_ruleResolver = aFunc;
+        invalidateCollisionCache();
     }
 
     RULE_RESOLVER* GetRuleResolver() const
@@ -190,10 +200,18 @@ public:
         return m_depth;
     }
 
+    ///> Returns the counters of the collision queries made in this node
+    const QUERY_STATS& QueryStats() const
+    {
+        return m_queryStats;
+    }
+
     /**
      * Function QueryColliding()
      *
      * Finds items collliding (closer than clearance) with the item aItem.
+     * In a branch, the results for segments and vias are cached until an item is added to
+     * or removed from the branch (or the root).
      * @param aItem item to check collisions against
      * @param aObstacles set of colliding objects found
      * @param aKindMask mask of obstacle types to take into account
@@ -438,6 +456,35 @@ public:
 
 private:
     struct DEFAULT_OBSTACLE_VISITOR;
+
+    ///> What the result of QueryColliding() for a segment or a via depends on
+    struct COLLISION_QUERY
+    {
+        int                         m_kind;
+        VECTOR2I                    m_a;            ///< segment start or via position
+        VECTOR2I                    m_b;            ///< segment end
+        int                         m_width;        ///< segment width or via diameter
+        int                         m_drill;
+        int                         m_layerStart;
+        int                         m_layerEnd;
+        int                         m_net;
+        const BOARD_CONNECTED_ITEM* m_parent;
+        int                         m_kindMask;
+        int                         m_limitCount;
+        bool                        m_differentNetsOnly;
+        int                         m_forceClearance;
+
+        bool operator==( const COLLISION_QUERY& aOther ) const;
+    };
+
+    struct COLLISION_QUERY_HASH
+    {
+        std::size_t operator()( const COLLISION_QUERY& aQuery ) const;
+    };
+
+    typedef std::unordered_map<COLLISION_QUERY, ITEM_VECTOR, COLLISION_QUERY_HASH>
+            COLLISION_CACHE;
+
     typedef std::unordered_multimap<JOINT::HASH_TAG, JOINT, JOINT::JOINT_TAG_HASH> JOINT_MAP;
     typedef JOINT_MAP::value_type TagJointPair;
 
@@ -470,6 +517,14 @@ private:
 
     void doRemove( ITEM* aItem );
     void unlinkParent();
+
+    ///> Fills aQuery from the arguments of QueryColliding(), if the result can be cached
+    bool makeCollisionQuery( const ITEM* aItem, int aKindMask, int aLimitCount,
+                             bool aDifferentNetsOnly, int aForceClearance,
+                             COLLISION_QUERY& aQuery ) const;
+
+    ///> Drops the cached collisions which may have changed after adding or removing an item
+    void invalidateCollisionCache();
     void releaseChildren();
     void releaseGarbage();
     void rebuildJoint( JOINT* aJoint, ITEM* aItem );
@@ -520,6 +575,12 @@ private:
     int m_depth;
 
     std::unordered_set<ITEM*> m_garbageItems;
+
+    ///> obstacles found by QueryColliding() in this branch, by query.  Shared with the branches
+    ///> which see the same world, until one of them adds or removes an item
+    std::shared_ptr<COLLISION_CACHE> m_collisionCache;
+
+    QUERY_STATS m_queryStats;
 };
 
 }
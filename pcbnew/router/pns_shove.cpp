@@ -22,6 +22,7 @@
 #include <deque>
 #include <cassert>
 #include <math/box2.h>
+#include <profile.h>
 
 #include "pns_arc.h"
 #include "pns_line.h"
@@ -1230,10 +1231,25 @@ SHOVE::SHOVE_STATUS SHOVE::shoveMainLoop()
         pushLineStack( LINE( *m_draggedVia ));
     }
 
+    LOGGER*      logger = Router()->Logger();
+    PROF_COUNTER iterTime;
+
     while( !m_lineStack.empty() )
     {
+        NODE::QUERY_STATS queryStats = m_currentNode->QueryStats();
+
+        iterTime.Start();
         st = shoveIteration( m_iter );
 
+        if( logger )
+        {
+            const NODE::QUERY_STATS& stats = m_currentNode->QueryStats();
+
+            logger->LogShoveIteration( stats.m_queries - queryStats.m_queries,
+                                       stats.m_cacheHits - queryStats.m_cacheHits,
+                                       iterTime.SinceStart<std::chrono::microseconds>().count() );
+        }
+
         m_iter++;
 
         if( st == SH_INCOMPLETE || timeLimit.Expired() || m_iter >= iterLimit )
@@ -482,6 +482,8 @@ void ROUTER_TOOL::handleCommonEvents( const TOOL_EVENT& aEvent )
                 fprintf(f, "event %d %d %d %s\n", evt.p.x, evt.p.y, evt.type, (const char*) id.c_str() );
             }
 
+            fprintf( f, "%s\n", logger->FormatStats().c_str() );
+
             fclose(f);
 
             // Export as *.kicad_pcb format, using a strategy which is specifically chosen
@@ -35,6 +35,10 @@
 #include <widgets/progress_reporter.h>
 #include <drc/drc_results_provider.h>
 #include <netlist_reader/pcb_netlist.h>
+#include <drc/drc_engine.h>
+#include <drc/drc_item.h>
+#include <view/view.h>
+#include <set>
 
 DRC_TOOL::DRC_TOOL() :
         PCB_TOOL_BASE( "pcbnew.DRCTool" ),
@@ -214,6 +218,72 @@ void DRC_TOOL::RunTests( PROGRESS_REPORTER* aProgressReporter, bool aTestTracksA
 }
 
 
+void DRC_TOOL::RunIncrementalTests( const std::vector<EDA_RECT>& aDirtyAreas )
+{
+    if( m_drcRunning || !m_drcEngine || aDirtyAreas.empty() )
+        return;
+
+    KIGFX::VIEW*             view = getView();
+    std::vector<MARKER_PCB*> newMarkers;
+    std::set<wxString>       exclusions;
+    bool                     selectionCleared = false;
+
+    m_drcRunning = true;
+
+    m_drcEngine->SetViolationHandler(
+            [&]( const std::shared_ptr<DRC_ITEM>& aItem, wxPoint aPos )
+            {
+                newMarkers.push_back( new MARKER_PCB( aItem, aPos ) );
+            } );
+
+    m_drcEngine->RunTestsIncremental( aDirtyAreas, m_editFrame->GetUserUnits() );
+
+    m_drcEngine->ClearViolationHandler();
+
+    // Drop the markers which the run has either re-reported or found to be fixed
+    MARKERS stale;
+
+    for( MARKER_PCB* marker : m_pcb->Markers() )
+    {
+        const DRC_ITEM* drcItem = static_cast<const DRC_ITEM*>( marker->GetRCItem().get() );
+
+        if( m_drcEngine->IsSupersededByIncrementalRun( drcItem ) )
+            stale.push_back( marker );
+    }
+
+    for( MARKER_PCB* marker : stale )
+    {
+        if( marker->IsExcluded() )
+            exclusions.insert( marker->Serialize() );
+
+        if( marker->IsSelected() && !selectionCleared )
+        {
+            m_toolMgr->RunAction( PCB_ACTIONS::selectionClear, true );
+            selectionCleared = true;
+        }
+
+        view->Remove( marker );
+        m_pcb->Remove( marker );
+        delete marker;
+    }
+
+    for( MARKER_PCB* marker : newMarkers )
+    {
+        // A violation which is still there keeps its exclusion
+        if( exclusions.count( marker->Serialize() ) )
+            marker->SetExcluded( true );
+
+        m_pcb->Add( marker );
+        view->Add( marker );
+    }
+
+    m_drcRunning = false;
+
+    if( m_drcDialog )
+        updatePointers();
+}
+
+
 void DRC_TOOL::updatePointers()
 {
     // update my pointers, m_editFrame is the only unchangeable one
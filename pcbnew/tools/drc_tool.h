@@ -117,6 +117,15 @@ public:
      */
     void RunTests( PROGRESS_REPORTER* aProgressReporter, bool aTestTracksAgainstZones,
                    bool aRefillZones, bool aReportAllTrackErrors, bool aTestFootprints );
+
+    /**
+     * Re-run the DRC tests which support it around a set of changed areas of the board and
+     * update the existing markers in place (see DRC_ENGINE::RunTestsIncremental()).
+     *
+     * No undo entry is created and zones are not refilled, so this is cheap enough to run
+     * after each edit.
+     */
+    void RunIncrementalTests( const std::vector<EDA_RECT>& aDirtyAreas );
 };
 
 
@@ -64,6 +64,7 @@ void ZONE_FILLER_TOOL::CheckAllZones( wxWindow* aCaller, PROGRESS_REPORTER* aRep
     BOARD_COMMIT commit( this );
 
     ZONE_FILLER filler( frame()->GetBoard(), &commit );
+    filler.SetFillCache( getEditFrame<PCB_EDIT_FRAME>()->GetZoneFillCache() );
 
     if( aReporter )
         filler.SetProgressReporter( aReporter );
@@ -101,6 +102,7 @@ void ZONE_FILLER_TOOL::FillAllZones( wxWindow* aCaller, PROGRESS_REPORTER* aRepo
         toFill.push_back( zone );
 
     ZONE_FILLER filler( board(), &commit );
+    filler.SetFillCache( getEditFrame<PCB_EDIT_FRAME>()->GetZoneFillCache() );
 
     if( aReporter )
         filler.SetProgressReporter( aReporter );
@@ -146,6 +148,7 @@ int ZONE_FILLER_TOOL::ZoneFill( const TOOL_EVENT& aEvent )
     }
 
     ZONE_FILLER filler( board(), &commit );
+    filler.SetFillCache( getEditFrame<PCB_EDIT_FRAME>()->GetZoneFillCache() );
     filler.InstallNewProgressReporter( frame(), _( "Fill Zone" ), 4 );
 
     if( filler.Fill( toFill ) )
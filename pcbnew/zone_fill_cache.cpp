@@ -0,0 +1,564 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <geometry/shape_poly_set.h>
+#include <hash_eda.h>
+#include <zone_fill_cache.h>
+
+
+namespace
+{
+
+const char     CACHE_MAGIC[8] = { 'K', 'I', 'Z', 'F', 'C', 'A', 'C', 'H' };
+const uint32_t CACHE_VERSION = 2;
+const uint32_t CACHE_BYTE_ORDER = 0x01020304;
+
+struct FILE_HEADER
+{
+    char     m_magic[8];
+    uint32_t m_version;
+    uint32_t m_byteOrder;
+    uint64_t m_recordCount;
+    uint64_t m_boardHash;       // hash of the board file whose fills are the saved fills
+};
+
+struct RECORD_HEADER
+{
+    uint32_t m_kind;
+    uint32_t m_reserved;
+    uint64_t m_slot;
+    uint64_t m_key;
+    uint64_t m_size;        // in int32s; always even so that the next header stays aligned
+};
+
+} // anonymous namespace
+
+
+ZONE_FILL_CACHE::ZONE_FILL_CACHE() :
+        m_boardHash( 0 ),
+        m_mappedData( nullptr ),
+        m_mappedSize( 0 )
+{
+}
+
+
+ZONE_FILL_CACHE::~ZONE_FILL_CACHE()
+{
+    unmap();
+}
+
+
+uint64_t ZONE_FILL_CACHE::SlotFor( size_t aZoneUuidHash, int aLayer )
+{
+    return hash_val( aZoneUuidHash, aLayer );
+}
+
+
+void ZONE_FILL_CACHE::WritePolys( const SHAPE_POLY_SET& aPolys, std::vector<int32_t>& aData )
+{
+    aData.push_back( aPolys.OutlineCount() );
+
+    for( int ii = 0; ii < aPolys.OutlineCount(); ++ii )
+    {
+        const SHAPE_POLY_SET::POLYGON& poly = aPolys.CPolygon( ii );
+
+        aData.push_back( (int32_t) poly.size() );
+
+        for( const SHAPE_LINE_CHAIN& chain : poly )
+        {
+            aData.push_back( chain.PointCount() );
+
+            for( int jj = 0; jj < chain.PointCount(); ++jj )
+            {
+                aData.push_back( chain.CPoint( jj ).x );
+                aData.push_back( chain.CPoint( jj ).y );
+            }
+        }
+    }
+}
+
+
+bool ZONE_FILL_CACHE::ReadPolys( const int32_t*& aData, const int32_t* aEnd,
+                                 SHAPE_POLY_SET& aPolys )
+{
+    aPolys.RemoveAllContours();
+
+    if( aData >= aEnd )
+        return false;
+
+    int32_t outlineCount = *aData++;
+
+    for( int32_t ii = 0; ii < outlineCount; ++ii )
+    {
+        if( aData >= aEnd )
+            return false;
+
+        int32_t chainCount = *aData++;
+        int     outline = -1;
+
+        for( int32_t jj = 0; jj < chainCount; ++jj )
+        {
+            if( aData >= aEnd )
+                return false;
+
+            int32_t          pointCount = *aData++;
+            SHAPE_LINE_CHAIN chain;
+
+            if( pointCount < 0 || aEnd - aData < 2 * (ptrdiff_t) pointCount )
+                return false;
+
+            for( int32_t kk = 0; kk < pointCount; ++kk, aData += 2 )
+                chain.Append( aData[0], aData[1], true );
+
+            chain.SetClosed( true );
+
+            if( jj == 0 )
+                outline = aPolys.AddOutline( chain );
+            else
+                aPolys.AddHole( chain, outline );
+        }
+    }
+
+    return true;
+}
+
+
+uint64_t ZONE_FILL_CACHE::polysKey( const SHAPE_POLY_SET& aPolys )
+{
+    return hash_val( aPolys.GetHash().Format() );
+}
+
+
+void ZONE_FILL_CACHE::Clear()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    for( std::map<uint64_t, ENTRY>& entries : m_entries )
+        entries.clear();
+
+    m_boardHash = 0;
+    unmap();
+}
+
+
+void ZONE_FILL_CACHE::ClearSavedFills()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_entries[SAVED_FILL].clear();
+}
+
+
+uint64_t ZONE_FILL_CACHE::BoardHash() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    return m_boardHash;
+}
+
+
+size_t ZONE_FILL_CACHE::size() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    return m_entries[FILL].size() + m_entries[TRIANGULATION].size()
+                + m_entries[SAVED_FILL].size();
+}
+
+
+void ZONE_FILL_CACHE::unmap()
+{
+#ifndef _WIN32
+    if( m_mappedData && m_readData.empty() )
+        munmap( const_cast<char*>( m_mappedData ), m_mappedSize );
+#endif
+
+    m_mappedData = nullptr;
+    m_mappedSize = 0;
+    m_readData.clear();
+}
+
+
+bool ZONE_FILL_CACHE::Load( const wxString& aFileName )
+{
+    Clear();
+
+    if( !wxFileName::FileExists( aFileName ) )
+        return false;
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+#ifndef _WIN32
+    int fd = open( aFileName.fn_str(), O_RDONLY );
+
+    if( fd >= 0 )
+    {
+        struct stat st;
+
+        if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+        {
+            void* addr = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+            if( addr != MAP_FAILED )
+            {
+                m_mappedData = static_cast<const char*>( addr );
+                m_mappedSize = st.st_size;
+            }
+        }
+
+        close( fd );
+    }
+#endif
+
+    if( !m_mappedData )
+    {
+        wxFFile file( aFileName, "rb" );
+
+        if( !file.IsOpened() )
+            return false;
+
+        m_readData.resize( file.Length() );
+
+        if( m_readData.empty() || file.Read( m_readData.data(), m_readData.size() )
+                                          != m_readData.size() )
+        {
+            m_readData.clear();
+            return false;
+        }
+
+        m_mappedData = m_readData.data();
+        m_mappedSize = m_readData.size();
+    }
+
+    FILE_HEADER header;
+
+    if( m_mappedSize < sizeof( header ) )
+    {
+        unmap();
+        return false;
+    }
+
+    memcpy( &header, m_mappedData, sizeof( header ) );
+
+    if( memcmp( header.m_magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) ) != 0
+            || header.m_version != CACHE_VERSION || header.m_byteOrder != CACHE_BYTE_ORDER )
+    {
+        unmap();
+        return false;
+    }
+
+    size_t offset = sizeof( header );
+
+    for( uint64_t ii = 0; ii < header.m_recordCount; ++ii )
+    {
+        RECORD_HEADER record;
+
+        if( m_mappedSize - offset < sizeof( record ) )
+            break;
+
+        memcpy( &record, m_mappedData + offset, sizeof( record ) );
+        offset += sizeof( record );
+
+        if( record.m_kind > SAVED_FILL
+                || record.m_size > ( m_mappedSize - offset ) / sizeof( int32_t ) )
+        {
+            break;
+        }
+
+        ENTRY& entry = m_entries[record.m_kind][record.m_slot];
+
+        entry.m_key = record.m_key;
+        entry.m_mapped = reinterpret_cast<const int32_t*>( m_mappedData + offset );
+        entry.m_size = record.m_size;
+
+        offset += record.m_size * sizeof( int32_t );
+    }
+
+    m_boardHash = header.m_boardHash;
+    return true;
+}
+
+
+bool ZONE_FILL_CACHE::Save( const wxString& aFileName, uint64_t aBoardHash ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    // Write to a temporary file first: the current file may be the one we are mapping
+    wxString tempName = aFileName + wxT( ".tmp" );
+    wxFFile  file( tempName, "wb" );
+
+    if( !file.IsOpened() )
+        return false;
+
+    FILE_HEADER header;
+
+    memcpy( header.m_magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) );
+    header.m_version = CACHE_VERSION;
+    header.m_byteOrder = CACHE_BYTE_ORDER;
+    header.m_recordCount = m_entries[FILL].size() + m_entries[TRIANGULATION].size()
+                                + m_entries[SAVED_FILL].size();
+    header.m_boardHash = aBoardHash;
+
+    bool ok = file.Write( &header, sizeof( header ) ) == sizeof( header );
+
+    for( uint32_t kind : { FILL, TRIANGULATION, SAVED_FILL } )
+    {
+        for( const std::pair<const uint64_t, ENTRY>& pair : m_entries[kind] )
+        {
+            const ENTRY&   entry = pair.second;
+            const int32_t* data = entry.m_mapped ? entry.m_mapped : entry.m_data.data();
+            const int32_t  padding = 0;
+            RECORD_HEADER  record;
+
+            record.m_kind = kind;
+            record.m_reserved = 0;
+            record.m_slot = pair.first;
+            record.m_key = entry.m_key;
+            record.m_size = entry.m_size + ( entry.m_size % 2 );
+
+            ok &= file.Write( &record, sizeof( record ) ) == sizeof( record );
+            ok &= file.Write( data, entry.m_size * sizeof( int32_t ) )
+                        == entry.m_size * sizeof( int32_t );
+
+            if( entry.m_size % 2 )
+                ok &= file.Write( &padding, sizeof( padding ) ) == sizeof( padding );
+        }
+    }
+
+    ok &= file.Close();
+
+    if( !ok )
+    {
+        wxRemoveFile( tempName );
+        return false;
+    }
+
+    // On Windows a mapped file can't be replaced, but there it was read rather than mapped
+    return wxRenameFile( tempName, aFileName, true );
+}
+
+
+bool ZONE_FILL_CACHE::FindFill( uint64_t aSlot, uint64_t aKey, SHAPE_POLY_SET& aRawPolys,
+                                SHAPE_POLY_SET& aFinalPolys ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    auto it = m_entries[FILL].find( aSlot );
+
+    if( it == m_entries[FILL].end() || it->second.m_key != aKey )
+        return false;
+
+    const ENTRY&   entry = it->second;
+    const int32_t* data = entry.m_mapped ? entry.m_mapped : entry.m_data.data();
+    const int32_t* end = data + entry.m_size;
+
+    return ReadPolys( data, end, aRawPolys ) && ReadPolys( data, end, aFinalPolys );
+}
+
+
+void ZONE_FILL_CACHE::StoreFill( uint64_t aSlot, uint64_t aKey, const SHAPE_POLY_SET& aRawPolys,
+                                 const SHAPE_POLY_SET& aFinalPolys )
+{
+    ENTRY entry;
+
+    entry.m_key = aKey;
+    WritePolys( aRawPolys, entry.m_data );
+    WritePolys( aFinalPolys, entry.m_data );
+    entry.m_size = entry.m_data.size();
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_entries[FILL][aSlot] = std::move( entry );
+}
+
+
+bool ZONE_FILL_CACHE::FindTriangulation( uint64_t aSlot, SHAPE_POLY_SET& aPolys ) const
+{
+    uint64_t key = polysKey( aPolys );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    auto it = m_entries[TRIANGULATION].find( aSlot );
+
+    if( it == m_entries[TRIANGULATION].end() || it->second.m_key != key )
+        return false;
+
+    const ENTRY&   entry = it->second;
+    const int32_t* data = entry.m_mapped ? entry.m_mapped : entry.m_data.data();
+    const int32_t* end = data + entry.m_size;
+
+    using TRIANGULATED_POLYGON = SHAPE_POLY_SET::TRIANGULATED_POLYGON;
+    std::vector<std::unique_ptr<TRIANGULATED_POLYGON>> triangulation;
+
+    if( end - data < 2 || data[0] != aPolys.TotalVertices() )
+        return false;
+
+    int32_t count = data[1];
+    data += 2;
+
+    for( int32_t ii = 0; ii < count; ++ii )
+    {
+        triangulation.push_back( std::make_unique<TRIANGULATED_POLYGON>() );
+        TRIANGULATED_POLYGON* poly = triangulation.back().get();
+
+        if( data >= end )
+            return false;
+
+        int32_t vertexCount = *data++;
+
+        if( vertexCount < 0 || end - data < 2 * (ptrdiff_t) vertexCount + 1 )
+            return false;
+
+        for( int32_t jj = 0; jj < vertexCount; ++jj, data += 2 )
+            poly->AddVertex( VECTOR2I( data[0], data[1] ) );
+
+        int32_t triangleCount = *data++;
+
+        if( triangleCount < 0 || end - data < 3 * (ptrdiff_t) triangleCount )
+            return false;
+
+        for( int32_t jj = 0; jj < triangleCount; ++jj, data += 3 )
+        {
+            if( std::max( { data[0], data[1], data[2] } ) >= vertexCount
+                    || std::min( { data[0], data[1], data[2] } ) < 0 )
+            {
+                return false;
+            }
+
+            poly->AddTriangle( data[0], data[1], data[2] );
+        }
+    }
+
+    aPolys.SetTriangulation( triangulation );
+    return true;
+}
+
+
+void ZONE_FILL_CACHE::StoreTriangulation( uint64_t aSlot, const SHAPE_POLY_SET& aPolys )
+{
+    if( !aPolys.IsTriangulationUpToDate() )
+        return;
+
+    ENTRY entry;
+
+    entry.m_key = polysKey( aPolys );
+    entry.m_data.push_back( aPolys.TotalVertices() );
+    entry.m_data.push_back( aPolys.TriangulatedPolyCount() );
+
+    for( unsigned ii = 0; ii < aPolys.TriangulatedPolyCount(); ++ii )
+    {
+        const SHAPE_POLY_SET::TRIANGULATED_POLYGON* poly = aPolys.TriangulatedPolygon( ii );
+
+        entry.m_data.push_back( poly->GetVertexCount() );
+
+        for( size_t jj = 0; jj < poly->GetVertexCount(); ++jj )
+        {
+            entry.m_data.push_back( poly->GetVertex( jj ).x );
+            entry.m_data.push_back( poly->GetVertex( jj ).y );
+        }
+
+        entry.m_data.push_back( poly->GetTriangleCount() );
+
+        for( size_t jj = 0; jj < poly->GetTriangleCount(); ++jj )
+        {
+            int a, b, c;
+
+            poly->GetTriangleIndices( jj, a, b, c );
+            entry.m_data.push_back( a );
+            entry.m_data.push_back( b );
+            entry.m_data.push_back( c );
+        }
+    }
+
+    entry.m_size = entry.m_data.size();
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_entries[TRIANGULATION][aSlot] = std::move( entry );
+}
+
+
+bool ZONE_FILL_CACHE::FindSavedFill( uint64_t aSlot, SHAPE_POLY_SET& aPolys,
+                                     std::vector<int>& aIslands ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    auto it = m_entries[SAVED_FILL].find( aSlot );
+
+    if( it == m_entries[SAVED_FILL].end() )
+        return false;
+
+    const ENTRY&   entry = it->second;
+    const int32_t* data = entry.m_mapped ? entry.m_mapped : entry.m_data.data();
+    const int32_t* end = data + entry.m_size;
+
+    aPolys.RemoveAllContours();
+    aIslands.clear();
+
+    if( !ReadPolys( data, end, aPolys ) || data >= end )
+        return false;
+
+    int32_t islandCount = *data++;
+
+    if( islandCount < 0 || end - data < islandCount )
+        return false;
+
+    for( int32_t ii = 0; ii < islandCount; ++ii )
+    {
+        if( data[ii] < 0 || data[ii] >= aPolys.OutlineCount() )
+            return false;
+
+        aIslands.push_back( data[ii] );
+    }
+
+    return true;
+}
+
+
+void ZONE_FILL_CACHE::StoreSavedFill( uint64_t aSlot, const SHAPE_POLY_SET& aPolys,
+                                      const std::vector<int>& aIslands )
+{
+    ENTRY entry;
+
+    WritePolys( aPolys, entry.m_data );
+    entry.m_data.push_back( (int32_t) aIslands.size() );
+    entry.m_data.insert( entry.m_data.end(), aIslands.begin(), aIslands.end() );
+    entry.m_size = entry.m_data.size();
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_entries[SAVED_FILL][aSlot] = std::move( entry );
+}
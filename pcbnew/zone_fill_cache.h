@@ -0,0 +1,173 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef ZONE_FILL_CACHE_H
+#define ZONE_FILL_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <wx/string.h>
+
+class SHAPE_POLY_SET;
+
+
+/**
+ * ZONE_FILL_CACHE
+ * keeps the results of zone fills across sessions, in a file next to the project.
+ *
+ * There is one slot per zone layer (see SlotFor()).  A slot holds:
+ *  - the raw and final polygons computed by the zone filler, under a key hashing everything
+ *    the fill depends on (see ZONE_FILLER), and
+ *  - the triangulation of the zone layer's filled polygons, under a hash of those polygons.
+ *
+ * Storing a new fill or triangulation in a slot replaces the previous one, so the file only
+ * ever holds one entry of each kind per zone layer.
+ *
+ * A slot also holds the filled polygons of the zone layer as they were last saved in the board
+ * file, along with the hash of that board file.  When the board file hasn't changed since, they
+ * are used in place of the filled polygons of the file, which then don't have to be parsed.
+ *
+ * The file is a short header followed by a list of records, each made of a fixed-size header
+ * and a blob of native 32-bit integers.  It is memory-mapped on load and only the record
+ * headers are read; a blob is decoded when (and if) its entry is looked up.
+ *
+ * All the methods may be called from the zone filler threads.
+ */
+class ZONE_FILL_CACHE
+{
+public:
+    ZONE_FILL_CACHE();
+    ~ZONE_FILL_CACHE();
+
+    /**
+     * @return the slot of the given zone layer.
+     */
+    static uint64_t SlotFor( size_t aZoneUuidHash, int aLayer );
+
+    /**
+     * Replaces the contents of the cache with those of the given file.
+     * @return false if the file doesn't exist or isn't a valid cache file for this build (the
+     *         cache is then left empty).
+     */
+    bool Load( const wxString& aFileName );
+
+    /**
+     * Writes the cache to the given file.
+     * @param aBoardHash is the hash of the board file the saved fills were saved in (see
+     *                   PCB_SNAPSHOT_IO::HashBoardFile()).
+     */
+    bool Save( const wxString& aFileName, uint64_t aBoardHash ) const;
+
+    void Clear();
+
+    /**
+     * @return the hash of the board file the saved fills of the loaded cache were saved in.
+     */
+    uint64_t BoardHash() const;
+
+    size_t size() const;
+
+    bool FindFill( uint64_t aSlot, uint64_t aKey, SHAPE_POLY_SET& aRawPolys,
+                   SHAPE_POLY_SET& aFinalPolys ) const;
+
+    void StoreFill( uint64_t aSlot, uint64_t aKey, const SHAPE_POLY_SET& aRawPolys,
+                    const SHAPE_POLY_SET& aFinalPolys );
+
+    /**
+     * Looks up the triangulation of \a aPolys and, if found, installs it (see
+     * SHAPE_POLY_SET::SetTriangulation()).
+     */
+    bool FindTriangulation( uint64_t aSlot, SHAPE_POLY_SET& aPolys ) const;
+
+    /**
+     * Stores the (up to date) triangulation of \a aPolys.
+     */
+    void StoreTriangulation( uint64_t aSlot, const SHAPE_POLY_SET& aPolys );
+
+    /**
+     * Looks up the filled polygons of a zone layer as they were saved in the board file.
+     * @param aIslands receives the indices of the polygons which are islands.
+     */
+    bool FindSavedFill( uint64_t aSlot, SHAPE_POLY_SET& aPolys, std::vector<int>& aIslands ) const;
+
+    /**
+     * Stores the filled polygons of a zone layer as they are saved in the board file.
+     */
+    void StoreSavedFill( uint64_t aSlot, const SHAPE_POLY_SET& aPolys,
+                         const std::vector<int>& aIslands );
+
+    /**
+     * Forgets the saved fills, before storing those of a new save of the board.
+     */
+    void ClearSavedFills();
+
+    /**
+     * Appends \a aPolys to \a aData: the outline count, then for each outline its chain
+     * count, then for each chain its point count followed by the coordinates of its points.
+     */
+    static void WritePolys( const SHAPE_POLY_SET& aPolys, std::vector<int32_t>& aData );
+
+    /**
+     * Reads back a polygon set written by WritePolys(), advancing \a aData past it.  Blobs come
+     * from a file, so every count is checked against \a aEnd.
+     * @return false if the blob is truncated.
+     */
+    static bool ReadPolys( const int32_t*& aData, const int32_t* aEnd, SHAPE_POLY_SET& aPolys );
+
+private:
+    enum RECORD_KIND
+    {
+        FILL = 0,
+        TRIANGULATION = 1,
+        SAVED_FILL = 2
+    };
+
+    struct ENTRY
+    {
+        uint64_t             m_key = 0;
+        std::vector<int32_t> m_data;        ///< Blob of an entry stored in this session
+        const int32_t*       m_mapped = nullptr;   ///< Blob of an entry read from the file
+        size_t               m_size = 0;    ///< Size of the blob, in int32s
+    };
+
+    void unmap();
+
+    static uint64_t polysKey( const SHAPE_POLY_SET& aPolys );
+
+    // Slots, per record kind
+    std::map<uint64_t, ENTRY> m_entries[3];
+
+    uint64_t                  m_boardHash;
+
+    mutable std::mutex        m_mutex;
+
+    // The mapped (or, where mapping isn't available, read) file
+    const char*               m_mappedData;
+    size_t                    m_mappedSize;
+    std::vector<char>         m_readData;
+};
+
+#endif // ZONE_FILL_CACHE_H
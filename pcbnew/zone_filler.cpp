@@ -23,9 +23,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
-#include <thread>
 #include <algorithm>
-#include <future>
+#include <limits>
 
 #include <advanced_config.h>
 #include <class_board.h>
@@ -46,6 +45,11 @@
 #include <confirm.h>
 #include <convert_to_biu.h>
 #include <math/util.h>      // for KiROUND
+#include <drc/drc_rtree.h>
+#include <profile.h>
+#include <hash_eda.h>
+#include <thread_pool.h>
+#include "zone_fill_cache.h"
 #include "zone_filler.h"
 
 static const double s_RoundPadThermalSpokeAngle = 450;      // in deci-degrees
@@ -56,7 +60,11 @@ ZONE_FILLER::ZONE_FILLER(  BOARD* aBoard, COMMIT* aCommit ) :
         m_brdOutlinesValid( false ),
         m_commit( aCommit ),
         m_progressReporter( nullptr ),
-        m_maxError( ARC_HIGH_DEF )
+        m_maxError( ARC_HIGH_DEF ),
+        m_tiledPolygonOps( false ),
+        m_clearanceBuildTime( 0 ),
+        m_fillCache( nullptr ),
+        m_boardOutlineHash( 0 )
 {
     // To enable add "DebugZoneFiller=true" to kicad_advanced settings file.
     m_debugZoneFiller = ADVANCED_CFG::GetCfg().m_DebugZoneFiller;
@@ -84,6 +92,87 @@ void ZONE_FILLER::SetProgressReporter( PROGRESS_REPORTER* aReporter )
 
 
 bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWindow* aParent )
+{
+    return fillZones( aZones, nullptr, aCheck, aParent );
+}
+
+
+bool ZONE_FILLER::FillIncremental( const std::vector<std::pair<EDA_RECT, LSET>>& aDirtyAreas,
+                                   std::vector<ZONE_CONTAINER*>& aRefilledZones )
+{
+    BOARD_DESIGN_SETTINGS&          bds = m_board->GetDesignSettings();
+    int                             worstClearance = bds.GetBiggestClearanceValue();
+    std::vector<ZONE_CONTAINER*>    zones;
+    std::map<ZONE_CONTAINER*, LSET> layers;
+
+    aRefilledZones.clear();
+
+    for( ZONE_CONTAINER* zone : m_board->Zones() )
+    {
+        if( zone->GetIsRuleArea() )
+            continue;
+
+        zone->CacheBoundingBox();
+        zones.push_back( zone );
+    }
+
+    // Visit the zones from the highest priority down so that a zone layer which gets refilled
+    // has been marked by the time the lower-priority zones it knocks out are looked at.
+    std::stable_sort( zones.begin(), zones.end(),
+                      []( const ZONE_CONTAINER* lhs, const ZONE_CONTAINER* rhs )
+                      {
+                          return lhs->GetPriority() > rhs->GetPriority();
+                      } );
+
+    for( ZONE_CONTAINER* zone : zones )
+    {
+        EDA_RECT inflatedBBox = zone->GetCachedBoundingBox();
+        LSET     zoneLayers;
+
+        inflatedBBox.Inflate( worstClearance );
+
+        for( const std::pair<EDA_RECT, LSET>& area : aDirtyAreas )
+        {
+            if( ( zone->GetLayerSet() & area.second ).any()
+                    && inflatedBBox.Intersects( area.first ) )
+            {
+                zoneLayers |= zone->GetLayerSet() & area.second;
+            }
+        }
+
+        // Same-net and equal-priority zones don't knock each other out; others knock out
+        // the fill of higher-priority zones (see buildCopperItemClearances())
+        for( const std::pair<ZONE_CONTAINER* const, LSET>& other : layers )
+        {
+            if( other.first->GetPriority() <= zone->GetPriority()
+                    || other.first->GetNetCode() == zone->GetNetCode()
+                    || !inflatedBBox.Intersects( other.first->GetCachedBoundingBox() ) )
+            {
+                continue;
+            }
+
+            zoneLayers |= zone->GetLayerSet() & other.second;
+        }
+
+        if( zoneLayers.any() )
+        {
+            layers[ zone ] = zoneLayers;
+            aRefilledZones.push_back( zone );
+        }
+    }
+
+    if( aRefilledZones.empty() )
+        return true;
+
+    std::vector<ZONE_CONTAINER*> toFill = aRefilledZones;
+
+    return fillZones( toFill, &layers, false, nullptr );
+}
+
+
+bool ZONE_FILLER::fillZones( std::vector<ZONE_CONTAINER*>& aZones,
+                             const std::map<ZONE_CONTAINER*, LSET>* aLayers, bool aCheck,
+                             wxWindow* aParent )
 {
     std::vector<std::pair<ZONE_CONTAINER*, PCB_LAYER_ID>> toFill;
     std::vector<CN_ZONE_ISOLATED_ISLAND_LIST> islandsList;
@@ -97,6 +186,18 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
     if( !lock )
         return false;
 
+    auto layersToFill =
+            [&]( ZONE_CONTAINER* aZone ) -> LSET
+            {
+                if( aLayers )
+                {
+                    auto it = aLayers->find( aZone );
+                    return it != aLayers->end() ? it->second : LSET();
+                }
+
+                return aZone->GetLayerSet();
+            };
+
     if( m_progressReporter )
     {
         m_progressReporter->Report( aCheck ? _( "Checking zone fills..." )
@@ -108,6 +209,7 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
     // The board outlines is used to clip solid areas inside the board (when outlines are valid)
     m_boardOutline.RemoveAllContours();
     m_brdOutlinesValid = m_board->GetBoardPolygonOutlines( m_boardOutline );
+    m_boardOutlineHash = m_brdOutlinesValid ? hash_val( m_boardOutline.GetHash().Format() ) : 0;
 
     // Update the bounding box and shape caches in the pads to prevent multi-threaded rebuilds.
     for( MODULE* module : m_board->Modules() )
@@ -119,6 +221,12 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
         }
     }
 
+    // The knockout indexes are part of gathering the clearances
+    PROF_COUNTER indexTimer;
+
+    buildKnockoutIndexes();
+    m_clearanceBuildTime = indexTimer.SinceStart<std::chrono::microseconds>().count();
+
     // Sort by priority to reduce deferrals waiting on higher priority zones.
     std::sort( aZones.begin(), aZones.end(),
                []( const ZONE_CONTAINER* lhs, const ZONE_CONTAINER* rhs )
@@ -139,7 +247,7 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
 
         // calculate the hash value for filled areas. it will be used later
         // to know if the current filled areas are up to date
-        for( PCB_LAYER_ID layer : zone->GetLayerSet().Seq() )
+        for( PCB_LAYER_ID layer : layersToFill( zone ).Seq() )
         {
             zone->BuildHashValue( layer );
 
@@ -149,16 +257,30 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
 
         islandsList.emplace_back( CN_ZONE_ISOLATED_ISLAND_LIST( zone ) );
 
-        // Remove existing fill first to prevent drawing invalid polygons
-        // on some platforms
-        zone->UnFill();
+        if( aLayers )
+        {
+            // The other layers keep their fill (and so don't hold up any other zone)
+            for( PCB_LAYER_ID layer : layersToFill( zone ).Seq() )
+                zone->SetFillFlag( layer, false );
+        }
+        else
+        {
+            // Remove existing fill first to prevent drawing invalid polygons
+            // on some platforms
+            zone->UnFill();
+        }
 
         zone->SetFillVersion( bds.m_ZoneFillVersion );
     }
 
-    size_t cores = std::thread::hardware_concurrency();
+    THREAD_POOL&        pool = THREAD_POOL::Get();
+    size_t              cores = pool.GetWorkerCount();
     std::atomic<size_t> nextItem;
 
+    // A few large zones would leave most of the cores idle; let them tile their polygon
+    // operations instead.
+    m_tiledPolygonOps = toFill.size() < cores;
+
     auto check_fill_dependency =
             [&]( ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer, ZONE_CONTAINER* aOtherZone ) -> bool
             {
@@ -169,6 +291,11 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
                 if( aOtherZone->GetFillFlag( aLayer ) )
                     return false;
 
+                // When refilling incrementally only the zone layers being refilled are waited
+                // on; the others already have their final fill.
+                if( aLayers && !layersToFill( aOtherZone ).test( aLayer ) )
+                    return false;
+
                 // Even if keepouts exclude copper pours the exclusion is by outline, not by
                 // filled area, so we're good-to-go here too.
                 if( aOtherZone->GetIsRuleArea() )
@@ -238,7 +365,22 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
 
                     // Now we're ready to fill.
                     SHAPE_POLY_SET rawPolys, finalPolys;
-                    fillSingleZone( zone, layer, rawPolys, finalPolys );
+                    uint64_t       slot = 0;
+                    uint64_t       key = 0;
+
+                    if( m_fillCache )
+                    {
+                        slot = ZONE_FILL_CACHE::SlotFor( zone->m_Uuid.Hash(), layer );
+                        key = fillCacheKey( zone, layer );
+                    }
+
+                    if( !m_fillCache || !m_fillCache->FindFill( slot, key, rawPolys, finalPolys ) )
+                    {
+                        fillSingleZone( zone, layer, rawPolys, finalPolys );
+
+                        if( m_fillCache )
+                            m_fillCache->StoreFill( slot, key, rawPolys, finalPolys );
+                    }
 
                     std::unique_lock<std::mutex> zoneLock( zone->GetLock() );
 
@@ -257,8 +399,8 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
 
     while( !toFill.empty() )
     {
-        size_t parallelThreadCount = std::min( cores, toFill.size() );
-        std::vector<std::future<size_t>> returns( parallelThreadCount );
+        size_t     parallelThreadCount = std::min( cores, toFill.size() );
+        TASK_GROUP fillTasks( pool );
 
         nextItem = 0;
 
@@ -267,20 +409,21 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
         else
         {
             for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-                returns[ii] = std::async( std::launch::async, fill_lambda, m_progressReporter );
+                fillTasks.Run( [&]() { fill_lambda( m_progressReporter ); } );
 
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            // Here we wait with a 100ms timeout to allow UI updating
+            while( !fillTasks.WaitFor( std::chrono::milliseconds( 100 ) ) )
             {
-                // Here we balance returns with a 100ms timeout to allow UI updating
-                std::future_status status;
-                do
+                if( m_progressReporter )
                 {
-                    if( m_progressReporter )
-                        m_progressReporter->KeepRefreshing();
+                    m_progressReporter->KeepRefreshing();
 
-                    status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-                } while( status != std::future_status::ready );
+                    if( m_progressReporter->IsCancelled() )
+                        fillTasks.Cancel();
+                }
             }
+
+            fillTasks.Wait();
         }
 
         toFill.erase( std::remove_if( toFill.begin(), toFill.end(),
@@ -324,7 +467,7 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
     // Now remove insulated copper islands
     for( CN_ZONE_ISOLATED_ISLAND_LIST& zone : islandsList )
     {
-        for( PCB_LAYER_ID layer : zone.m_zone->GetLayerSet().Seq() )
+        for( PCB_LAYER_ID layer : layersToFill( zone.m_zone ).Seq() )
         {
             if( m_debugZoneFiller && LSET::InternalCuMask().Contains( layer ) )
                 continue;
@@ -365,7 +508,7 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
     // Now remove islands outside the board edge
     for( ZONE_CONTAINER* zone : aZones )
     {
-        for( PCB_LAYER_ID layer : zone->GetLayerSet().Seq() )
+        for( PCB_LAYER_ID layer : layersToFill( zone ).Seq() )
         {
             if( m_debugZoneFiller && LSET::InternalCuMask().Contains( layer ) )
                 continue;
@@ -438,7 +581,23 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
 
                 for( size_t i = nextItem++; i < islandsList.size(); i = nextItem++ )
                 {
-                    islandsList[i].m_zone->CacheTriangulation();
+                    ZONE_CONTAINER* zone = islandsList[i].m_zone;
+
+                    if( m_fillCache )
+                    {
+                        for( PCB_LAYER_ID layer : layersToFill( zone ).Seq() )
+                            cacheTriangulation( zone, layer );
+                    }
+                    else if( aLayers )
+                    {
+                        for( PCB_LAYER_ID layer : layersToFill( zone ).Seq() )
+                            zone->CacheTriangulation( layer );
+                    }
+                    else
+                    {
+                        zone->CacheTriangulation();
+                    }
+
                     num++;
 
                     if( m_progressReporter )
@@ -453,33 +612,29 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
                 return num;
             };
 
-    size_t parallelThreadCount = std::min( cores, islandsList.size() );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
+    size_t     parallelThreadCount = std::min( cores, islandsList.size() );
+    TASK_GROUP triangulationTasks( pool );
 
     if( parallelThreadCount <= 1 )
         tri_lambda( m_progressReporter );
     else
     {
         for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, tri_lambda, m_progressReporter );
+            triangulationTasks.Run( [&]() { tri_lambda( m_progressReporter ); } );
 
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        // Here we wait with a 100ms timeout to allow UI updating
+        while( !triangulationTasks.WaitFor( std::chrono::milliseconds( 100 ) ) )
         {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
+            if( m_progressReporter )
             {
-                if( m_progressReporter )
-                {
-                    m_progressReporter->KeepRefreshing();
-
-                    if( m_progressReporter->IsCancelled() )
-                        break;
-                }
+                m_progressReporter->KeepRefreshing();
 
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
+                if( m_progressReporter->IsCancelled() )
+                    triangulationTasks.Cancel();
+            }
         }
+
+        triangulationTasks.Wait();
     }
 
     if( m_progressReporter )
@@ -496,6 +651,213 @@ bool ZONE_FILLER::Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck, wxWin
 }
 
 
+void ZONE_FILLER::UseCachedTriangulations( std::vector<ZONE_CONTAINER*>& aZones )
+{
+    if( !m_fillCache )
+        return;
+
+    for( ZONE_CONTAINER* zone : aZones )
+    {
+        for( PCB_LAYER_ID layer : zone->GetLayerSet().Seq() )
+        {
+            if( zone->GetIsRuleArea() || !zone->HasFilledPolysForLayer( layer ) )
+                continue;
+
+            uint64_t       slot = ZONE_FILL_CACHE::SlotFor( zone->m_Uuid.Hash(), layer );
+            SHAPE_POLY_SET polys = zone->GetFilledPolysList( layer );
+
+            if( m_fillCache->FindTriangulation( slot, polys ) )
+                zone->SetFilledPolysList( layer, polys );
+        }
+    }
+}
+
+
+void ZONE_FILLER::cacheTriangulation( ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer )
+{
+    if( !m_fillCache )
+    {
+        aZone->CacheTriangulation( aLayer );
+        return;
+    }
+
+    if( !aZone->HasFilledPolysForLayer( aLayer ) )
+        return;
+
+    uint64_t       slot = ZONE_FILL_CACHE::SlotFor( aZone->m_Uuid.Hash(), aLayer );
+    SHAPE_POLY_SET polys = aZone->GetFilledPolysList( aLayer );
+
+    if( m_fillCache->FindTriangulation( slot, polys ) )
+    {
+        // Copying a poly set keeps its triangulation when it is up to date
+        aZone->SetFilledPolysList( aLayer, polys );
+    }
+    else
+    {
+        aZone->CacheTriangulation( aLayer );
+        m_fillCache->StoreTriangulation( slot, aZone->GetFilledPolysList( aLayer ) );
+    }
+}
+
+
+/**
+ * Hashes the parts of a pad which change its knockout and which hash_eda() leaves out: the
+ * hole, the corner and custom shapes, and the local overrides.
+ */
+static size_t hashPadFill( const D_PAD* aPad )
+{
+    size_t ret = hash_val( aPad->GetDrillSize().x, aPad->GetDrillSize().y );
+
+    hash_combine( ret, static_cast<int>( aPad->GetAttribute() ) );
+    hash_combine( ret, aPad->GetRoundRectRadiusRatio(), aPad->GetChamferRectRatio() );
+    hash_combine( ret, aPad->GetChamferPositions() );
+    hash_combine( ret, static_cast<int>( aPad->GetAnchorPadShape() ) );
+    hash_combine( ret, static_cast<int>( aPad->GetCustomShapeInZoneOpt() ) );
+    hash_combine( ret, aPad->GetRemoveUnconnected(), aPad->GetKeepTopBottom() );
+    hash_combine( ret, aPad->GetLocalClearance(), aPad->GetLocalSolderMaskMargin() );
+    hash_combine( ret, aPad->GetLocalSolderPasteMargin(),
+                  aPad->GetLocalSolderPasteMarginRatio() );
+
+    for( const std::shared_ptr<DRAWSEGMENT>& primitive : aPad->GetPrimitives() )
+        hash_combine( ret, hash_eda( primitive.get(), HASH_POS ) );
+
+    return ret;
+}
+
+
+uint64_t ZONE_FILLER::FillCacheKey( const ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer )
+{
+    m_boardOutline.RemoveAllContours();
+    m_brdOutlinesValid = m_board->GetBoardPolygonOutlines( m_boardOutline );
+    m_boardOutlineHash = m_brdOutlinesValid ? hash_val( m_boardOutline.GetHash().Format() ) : 0;
+
+    buildKnockoutIndexes();
+
+    return fillCacheKey( aZone, aLayer );
+}
+
+
+uint64_t ZONE_FILLER::fillCacheKey( const ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer ) const
+{
+    BOARD_DESIGN_SETTINGS& bds = m_board->GetDesignSettings();
+    int                    extra_margin = Millimeter2iu( ADVANCED_CFG::GetCfg().m_ExtraClearance );
+    const int              itemFlags = HASH_POS | HASH_ROT | HASH_LAYER | HASH_NET | HASH_REF
+                                               | HASH_VALUE;
+
+    size_t key = hash_eda( aZone );
+    hash_combine( key, aLayer, bds.m_ZoneFillVersion, m_maxError, extra_margin );
+    hash_combine( key, bds.GetHolePlatingThickness(), m_boardOutlineHash );
+
+    // The same area buildCopperItemClearances() gathers knockouts from
+    EDA_RECT zone_boundingbox = aZone->GetCachedBoundingBox();
+    int      biggest_clearance = std::max( aZone->GetLocalClearance(),
+                                           bds.GetBiggestClearanceValue() );
+    zone_boundingbox.Inflate( biggest_clearance + extra_margin );
+
+    std::vector<BOARD_ITEM*> candidates;
+
+    // The clearances and thermal reliefs are hashed as resolved, which covers any change to
+    // the netclasses and rules
+    m_padIndex->QueryColliding( zone_boundingbox, aLayer, candidates );
+
+    for( BOARD_ITEM* candidate : candidates )
+    {
+        D_PAD* pad = static_cast<D_PAD*>( candidate );
+
+        hash_combine( key, hash_eda( pad, itemFlags ), hashPadFill( pad ) );
+        hash_combine( key, aZone->GetClearance( aLayer, pad ) );
+        hash_combine( key, static_cast<int>( aZone->GetPadConnection( pad ) ) );
+        hash_combine( key, aZone->GetThermalReliefGap( pad ),
+                      aZone->GetThermalReliefSpokeWidth( pad ) );
+    }
+
+    m_trackIndex->QueryColliding( zone_boundingbox, aLayer, candidates );
+
+    for( BOARD_ITEM* candidate : candidates )
+    {
+        hash_combine( key, hash_eda( candidate, itemFlags ) );
+        hash_combine( key, aZone->GetClearance( aLayer, candidate ) );
+    }
+
+    m_graphicsIndex->QueryColliding( zone_boundingbox, aLayer, candidates );
+
+    for( BOARD_ITEM* candidate : candidates )
+    {
+        switch( candidate->Type() )
+        {
+        case PCB_LINE_T:
+        case PCB_MODULE_EDGE_T:
+            hash_combine( key, hash_eda( candidate, itemFlags ) );
+            break;
+
+        case PCB_TEXT_T:
+        {
+            TEXTE_PCB* text = static_cast<TEXTE_PCB*>( candidate );
+
+            hash_combine( key, hash_eda( text, itemFlags ), text->GetEffectiveTextPenWidth() );
+            break;
+        }
+
+        case PCB_MODULE_TEXT_T:
+        {
+            TEXTE_MODULE* text = static_cast<TEXTE_MODULE*>( candidate );
+
+            hash_combine( key, hash_eda( text, itemFlags ), text->GetEffectiveTextPenWidth() );
+            hash_combine( key, text->IsVisible() );
+            break;
+        }
+
+        default:
+            // Dimensions and targets: their bounding box is as much as hash_eda() would know
+            hash_combine( key, candidate->Type(), candidate->GetLayer() );
+            hash_combine( key, candidate->GetBoundingBox().GetX(),
+                          candidate->GetBoundingBox().GetY() );
+            hash_combine( key, candidate->GetBoundingBox().GetWidth(),
+                          candidate->GetBoundingBox().GetHeight() );
+            break;
+        }
+    }
+
+    // Keepouts and higher-priority zones, and the fill of the latter when they knock out by fill
+    auto hashZone =
+            [&]( ZONE_CONTAINER* aOther )
+            {
+                if( aOther == aZone || !aOther->GetLayerSet().test( aLayer ) )
+                    return;
+
+                if( !aOther->GetBoundingBox().Intersects( zone_boundingbox ) )
+                    return;
+
+                hash_combine( key, hash_eda( aOther ) );
+
+                if( aOther->GetIsRuleArea() || aOther->GetPriority() <= aZone->GetPriority()
+                        || aOther->GetNetCode() == aZone->GetNetCode() )
+                {
+                    return;
+                }
+
+                std::unique_lock<std::mutex> zoneLock( aOther->GetLock() );
+
+                if( aOther->HasFilledPolysForLayer( aLayer ) )
+                {
+                    hash_combine( key, aZone->GetClearance( aLayer, aOther ) );
+                    hash_combine( key, aOther->GetFilledPolysList( aLayer ).GetHash().Format() );
+                }
+            };
+
+    for( ZONE_CONTAINER* otherZone : m_board->Zones() )
+        hashZone( otherZone );
+
+    for( MODULE* module : m_board->Modules() )
+    {
+        for( ZONE_CONTAINER* otherZone : module->Zones() )
+            hashZone( otherZone );
+    }
+
+    return key;
+}
+
+
 /**
  * Return true if the given pad has a thermal connection with the given zone.
  */
@@ -684,6 +1046,66 @@ void ZONE_FILLER::knockoutThermalReliefs( const ZONE_CONTAINER* aZone, PCB_LAYER
 }
 
 
+void ZONE_FILLER::buildKnockoutIndexes()
+{
+    int platingThickness = m_board->GetDesignSettings().GetHolePlatingThickness();
+
+    m_padIndex = std::make_unique<DRC_RTREE>();
+    m_trackIndex = std::make_unique<DRC_RTREE>();
+    m_graphicsIndex = std::make_unique<DRC_RTREE>();
+
+    // Pads with holes knock out their hole on the copper layers they don't have a pad on
+    for( MODULE* module : m_board->Modules() )
+    {
+        for( D_PAD* pad : module->Pads() )
+        {
+            EDA_RECT bbox = pad->GetBoundingBox();
+            LSET     layers = pad->GetLayerSet();
+
+            if( pad->GetDrillSize().x > 0 || pad->GetDrillSize().y > 0 )
+            {
+                EDA_RECT hole( pad->GetPosition() - pad->GetDrillSize() / 2, pad->GetDrillSize() );
+                hole.Inflate( platingThickness );
+
+                bbox.Merge( hole );
+                layers |= LSET::AllCuMask();
+            }
+
+            bbox.Normalize();
+            m_padIndex->Insert( pad, bbox, layers );
+        }
+    }
+
+    for( TRACK* track : m_board->Tracks() )
+        m_trackIndex->Insert( track, LSET::AllLayersMask() );
+
+    // Items on Edge_Cuts are knocked out of every layer
+    auto addGraphicItem =
+            [&]( BOARD_ITEM* aItem )
+            {
+                EDA_RECT bbox = aItem->GetBoundingBox();
+                bbox.Normalize();
+
+                if( aItem->IsOnLayer( Edge_Cuts ) )
+                    m_graphicsIndex->Insert( aItem, bbox, LSET::AllLayersMask() );
+                else
+                    m_graphicsIndex->Insert( aItem, bbox, aItem->GetLayerSet() );
+            };
+
+    for( MODULE* module : m_board->Modules() )
+    {
+        addGraphicItem( &module->Reference() );
+        addGraphicItem( &module->Value() );
+
+        for( BOARD_ITEM* item : module->GraphicalItems() )
+            addGraphicItem( item );
+    }
+
+    for( BOARD_ITEM* item : m_board->Drawings() )
+        addGraphicItem( item );
+}
+
+
 /**
  * Removes clearance from the shape for copper items which share the zone's layer but are
  * not connected to it.
@@ -717,45 +1139,52 @@ void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, PCB_LA
     MODULE  dummymodule( m_board );
     D_PAD   dummypad( &dummymodule );
 
+    std::vector<BOARD_ITEM*> candidates;
+
     // Add non-connected pad clearances
     //
-    for( MODULE* module : m_board->Modules() )
+    m_padIndex->QueryColliding( zone_boundingbox, aLayer, candidates );
+
+    for( BOARD_ITEM* candidate : candidates )
     {
-        for( D_PAD* pad : module->Pads() )
+        D_PAD* pad = static_cast<D_PAD*>( candidate );
+
+        if( !pad->IsPadOnLayer( aLayer ) )
         {
-            if( !pad->IsPadOnLayer( aLayer ) )
-            {
-                if( pad->GetDrillSize().x == 0 && pad->GetDrillSize().y == 0 )
-                    continue;
+            if( pad->GetDrillSize().x == 0 && pad->GetDrillSize().y == 0 )
+                continue;
 
-                setupDummyPadForHole( pad, dummypad );
-                pad = &dummypad;
-            }
+            setupDummyPadForHole( pad, dummypad );
+            pad = &dummypad;
+        }
 
-            if( pad->GetNetCode() != aZone->GetNetCode() || pad->GetNetCode() <= 0
-                    || aZone->GetPadConnection( pad ) == ZONE_CONNECTION::NONE )
+        if( pad->GetNetCode() != aZone->GetNetCode() || pad->GetNetCode() <= 0
+                || aZone->GetPadConnection( pad ) == ZONE_CONNECTION::NONE )
+        {
+            if( pad->GetBoundingBox().Intersects( zone_boundingbox ) )
             {
-                if( pad->GetBoundingBox().Intersects( zone_boundingbox ) )
-                {
-                    int gap;
+                int gap;
 
-                    // for pads having the same netcode as the zone, the net clearance has no
-                    // meaning so use the greater of the zone clearance and the thermal relief
-                    if( pad->GetNetCode() > 0 && pad->GetNetCode() == aZone->GetNetCode() )
-                        gap = std::max( zone_clearance, aZone->GetThermalReliefGap( pad ) );
-                    else
-                        gap = aZone->GetClearance( aLayer, pad );
+                // for pads having the same netcode as the zone, the net clearance has no
+                // meaning so use the greater of the zone clearance and the thermal relief
+                if( pad->GetNetCode() > 0 && pad->GetNetCode() == aZone->GetNetCode() )
+                    gap = std::max( zone_clearance, aZone->GetThermalReliefGap( pad ) );
+                else
+                    gap = aZone->GetClearance( aLayer, pad );
 
-                    addKnockout( pad, aLayer, gap, aHoles );
-                }
+                addKnockout( pad, aLayer, gap, aHoles );
             }
         }
     }
 
     // Add non-connected track clearances
     //
-    for( TRACK* track : m_board->Tracks() )
+    m_trackIndex->QueryColliding( zone_boundingbox, aLayer, candidates );
+
+    for( BOARD_ITEM* candidate : candidates )
     {
+        TRACK* track = static_cast<TRACK*>( candidate );
+
         if( !track->IsOnLayer( aLayer ) )
             continue;
 
@@ -814,16 +1243,9 @@ void ZONE_FILLER::buildCopperItemClearances( const ZONE_CONTAINER* aZone, PCB_LA
                 }
             };
 
-    for( MODULE* module : m_board->Modules() )
-    {
-        doGraphicItem( &module->Reference() );
-        doGraphicItem( &module->Value() );
-
-        for( BOARD_ITEM* item : module->GraphicalItems() )
-            doGraphicItem( item );
-    }
+    m_graphicsIndex->QueryColliding( zone_boundingbox, aLayer, candidates );
 
-    for( BOARD_ITEM* item : m_board->Drawings() )
+    for( BOARD_ITEM* item : candidates )
         doGraphicItem( item );
 
     // Add keepout zones and higher-priority zones
@@ -950,6 +1372,11 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone, PCB_LAYER_I
     else
         cornerStrategy = SHAPE_POLY_SET::CHAMFER_ACUTE_CORNERS;
 
+    // When there are spare cores the big polygon operations are split into tiles and run
+    // on all of them (see SHAPE_POLY_SET::TiledBooleanSubtract()).
+    int minTiled = m_tiledPolygonOps ? SHAPE_POLY_SET::TILED_MIN_VERTICES
+                                     : std::numeric_limits<int>::max();
+
     std::deque<SHAPE_LINE_CHAIN> thermalSpokes;
     SHAPE_POLY_SET clearanceHoles;
 
@@ -965,8 +1392,12 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone, PCB_LAYER_I
     if( m_progressReporter && m_progressReporter->IsCancelled() )
         return;
 
+    PROF_COUNTER clearanceTimer;
+
     buildCopperItemClearances( aZone, aLayer, clearanceHoles );
 
+    m_clearanceBuildTime += clearanceTimer.SinceStart<std::chrono::microseconds>().count();
+
     if( m_progressReporter && m_progressReporter->IsCancelled() )
         return;
 
@@ -979,16 +1410,16 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone, PCB_LAYER_I
     // because the "real" subtract-clearance-holes has to be done after the spokes are added.
     static const bool USE_BBOX_CACHES = true;
     SHAPE_POLY_SET testAreas = aRawPolys;
-    testAreas.BooleanSubtract( clearanceHoles, SHAPE_POLY_SET::PM_FAST );
+    testAreas.TiledBooleanSubtract( clearanceHoles, SHAPE_POLY_SET::PM_FAST, minTiled );
     DUMP_POLYS_TO_COPPER_LAYER( testAreas, In3_Cu, "minus-clearance-holes" );
 
     // Prune features that don't meet minimum-width criteria
     if( half_min_width - epsilon > epsilon )
     {
-        testAreas.Deflate( half_min_width - epsilon, numSegs, cornerStrategy );
+        testAreas.TiledDeflate( half_min_width - epsilon, numSegs, cornerStrategy, minTiled );
         DUMP_POLYS_TO_COPPER_LAYER( testAreas, In4_Cu, "spoke-test-deflated" );
 
-        testAreas.Inflate( half_min_width - epsilon, numSegs, cornerStrategy );
+        testAreas.TiledInflate( half_min_width - epsilon, numSegs, cornerStrategy, minTiled );
         DUMP_POLYS_TO_COPPER_LAYER( testAreas, In5_Cu, "spoke-test-reinflated" );
     }
 
@@ -1035,12 +1466,12 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone, PCB_LAYER_I
     if( m_progressReporter && m_progressReporter->IsCancelled() )
         return;
 
-    aRawPolys.BooleanSubtract( clearanceHoles, SHAPE_POLY_SET::PM_FAST );
+    aRawPolys.TiledBooleanSubtract( clearanceHoles, SHAPE_POLY_SET::PM_FAST, minTiled );
     DUMP_POLYS_TO_COPPER_LAYER( aRawPolys, In7_Cu, "trimmed-spokes" );
 
     // Prune features that don't meet minimum-width criteria
     if( half_min_width - epsilon > epsilon )
-        aRawPolys.Deflate( half_min_width - epsilon, numSegs, cornerStrategy );
+        aRawPolys.TiledDeflate( half_min_width - epsilon, numSegs, cornerStrategy, minTiled );
 
     DUMP_POLYS_TO_COPPER_LAYER( aRawPolys, In8_Cu, "deflated" );
 
@@ -1064,15 +1495,15 @@ void ZONE_FILLER::computeRawFilledArea( const ZONE_CONTAINER* aZone, PCB_LAYER_I
     }
     else if( half_min_width - epsilon > epsilon )
     {
-        aRawPolys.Inflate( half_min_width - epsilon, numSegs, cornerStrategy );
+        aRawPolys.TiledInflate( half_min_width - epsilon, numSegs, cornerStrategy, minTiled );
     }
 
     DUMP_POLYS_TO_COPPER_LAYER( aRawPolys, In10_Cu, "after-reinflating" );
 
     // Ensure additive changes (thermal stubs and particularly inflating acute corners) do not
     // add copper outside the zone boundary or inside the clearance holes
-    aRawPolys.BooleanIntersection( aSmoothedOutline, SHAPE_POLY_SET::PM_FAST );
-    aRawPolys.BooleanSubtract( clearanceHoles, SHAPE_POLY_SET::PM_FAST );
+    aRawPolys.TiledBooleanIntersection( aSmoothedOutline, SHAPE_POLY_SET::PM_FAST, minTiled );
+    aRawPolys.TiledBooleanSubtract( clearanceHoles, SHAPE_POLY_SET::PM_FAST, minTiled );
 
     aRawPolys.Fracture( SHAPE_POLY_SET::PM_FAST );
 
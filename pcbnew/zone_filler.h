@@ -26,14 +26,19 @@
 #ifndef __ZONE_FILLER_H
 #define __ZONE_FILLER_H
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <vector>
 #include <class_zone.h>
 
 class WX_PROGRESS_REPORTER;
+class DRC_RTREE;
 class BOARD;
 class COMMIT;
 class SHAPE_POLY_SET;
 class SHAPE_LINE_CHAIN;
+class ZONE_FILL_CACHE;
 
 
 class ZONE_FILLER
@@ -47,7 +52,74 @@ public:
     bool Fill( std::vector<ZONE_CONTAINER*>& aZones, bool aCheck = false,
                wxWindow* aParent = nullptr );
 
+    /**
+     * Refills only the zone layers which can be affected by a change to the board.
+     *
+     * A zone layer is refilled when its outline (inflated by the worst clearance) intersects
+     * one of \a aDirtyAreas on one of the area's layers, or when it is knocked out by the fill
+     * of a higher-priority zone layer which is itself being refilled.  The other zone layers
+     * keep their current fill.
+     *
+     * @param aDirtyAreas the bounding boxes (and layers) of the items which changed, both
+     *                    before and after the change
+     * @param aRefilledZones receives the zones which had at least one layer refilled
+     * @return false if the fill could not be run (ie: the connectivity is busy)
+     */
+    bool FillIncremental( const std::vector<std::pair<EDA_RECT, LSET>>& aDirtyAreas,
+                          std::vector<ZONE_CONTAINER*>& aRefilledZones );
+
+    /**
+     * Reuses the fills and triangulations held in \a aCache when they are still valid, and
+     * records the ones which have to be computed.  May be nullptr (the default).
+     */
+    void SetFillCache( ZONE_FILL_CACHE* aCache ) { m_fillCache = aCache; }
+
+    /**
+     * Installs the triangulations found in the fill cache for the filled polygons of \a aZones.
+     * Used on zones filled elsewhere, such as the ones read from a board file; the others are
+     * left to be triangulated as usual.
+     */
+    void UseCachedTriangulations( std::vector<ZONE_CONTAINER*>& aZones );
+
+    /**
+     * @return the time spent gathering copper item clearances during the last Fill(), in
+     *         microseconds: building the knockout indexes, plus the queries summed over all
+     *         the fill threads.
+     */
+    int64_t GetClearanceBuildTime() const { return m_clearanceBuildTime; }
+
+    /**
+     * @return the key the fill of \a aLayer of \a aZone is stored under in the fill cache, for
+     * the board as it is now.  Fill() computes its keys itself; this is for checking them.
+     */
+    uint64_t FillCacheKey( const ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer );
+
 private:
+    /**
+     * Fills \a aZones.  When \a aLayers is given only the listed layers of each zone are
+     * refilled, and only those layers are waited on by lower-priority zones.
+     */
+    bool fillZones( std::vector<ZONE_CONTAINER*>& aZones,
+                    const std::map<ZONE_CONTAINER*, LSET>* aLayers, bool aCheck,
+                    wxWindow* aParent );
+
+    /**
+     * Builds the spatial indexes of the pads, tracks and graphic items which can knock out
+     * zone fill.  Called once per Fill(); the fill threads only read them.
+     */
+    void buildKnockoutIndexes();
+
+    /**
+     * @return a hash of everything the fill of \a aLayer of \a aZone depends on: the zone
+     * itself, the board outline, the items within clearance of the zone and the fill of the
+     * higher-priority zones around it.  Must be called once the latter are filled.
+     */
+    uint64_t fillCacheKey( const ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer ) const;
+
+    /**
+     * Triangulates the fill of \a aLayer of \a aZone, going through the fill cache if any.
+     */
+    void cacheTriangulation( ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer );
 
     void addKnockout( D_PAD* aPad, PCB_LAYER_ID aLayer, int aGap, SHAPE_POLY_SET& aHoles );
 
@@ -120,6 +192,19 @@ private:
     int                   m_maxError;
 
     bool                  m_debugZoneFiller;
+
+    // Split the large polygon operations of each fill into tiles run on all the cores
+    bool                  m_tiledPolygonOps;
+
+    // Knockout candidates, indexed by layer.  Query results come back in board order.
+    std::unique_ptr<DRC_RTREE> m_padIndex;
+    std::unique_ptr<DRC_RTREE> m_trackIndex;
+    std::unique_ptr<DRC_RTREE> m_graphicsIndex;
+
+    std::atomic<int64_t>  m_clearanceBuildTime;
+
+    ZONE_FILL_CACHE*      m_fillCache;
+    size_t                m_boardOutlineHash;
 };
 
 #endif
@@ -26,7 +26,11 @@
 #include <base_units.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <vector>
 
 struct UnitFixture
 {
@@ -74,4 +78,61 @@ BOOST_AUTO_TEST_CASE( wxPointUnitFormat )
 }
 
 
+/**
+ * The printf() formatting FormatInternalUnits() used to do, which it must still match.
+ */
+static std::string printfInternalUnits( int aValue )
+{
+    char   buf[50];
+    double engUnits = aValue / IU_PER_MM;
+    int    len;
+
+    if( engUnits != 0.0 && fabs( engUnits ) <= 0.0001 )
+    {
+        len = snprintf( buf, sizeof( buf ), "%.10f", engUnits );
+
+        while( --len > 0 && buf[len] == '0' )
+            buf[len] = '\0';
+
+        if( buf[len] == '.' )
+            buf[len] = '\0';
+        else
+            ++len;
+    }
+    else
+    {
+        len = snprintf( buf, sizeof( buf ), "%.10g", engUnits );
+    }
+
+    return std::string( buf, len );
+}
+
+
+/**
+ * Check that formatting doesn't depend on printf() any more, but still gives the same output
+ */
+BOOST_AUTO_TEST_CASE( SameAsPrintf )
+{
+    std::vector<int> values = { std::numeric_limits<int>::min(), std::numeric_limits<int>::max() };
+
+    for( int value = -100000; value <= 100000; value++ )
+        values.push_back( value );
+
+    for( int value = 1; value < std::numeric_limits<int>::max() / 7; value = value * 7 + 3 )
+    {
+        values.push_back( value );
+        values.push_back( -value );
+        values.push_back( value / 1000 * 1000 );
+    }
+
+    for( int value : values )
+    {
+        BOOST_TEST_CONTEXT( "Value: " << value )
+        {
+            BOOST_CHECK_EQUAL( FormatInternalUnits( value ), printfInternalUnits( value ) );
+        }
+    }
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -28,6 +28,9 @@
 
 #include <unit_test_utils/unit_test_utils.h>
 
+#include <cerrno>
+#include <cmath>
+
 // Code under test
 #include <kicad_string.h>
 
@@ -107,4 +110,41 @@ BOOST_AUTO_TEST_CASE( NaturalNumberCompare )
     }
 }
 
+/**
+ * Test the #StrToDouble function against strtod in the C locale
+ */
+BOOST_AUTO_TEST_CASE( StrToDouble )
+{
+    const std::vector<std::string> cases = {
+        "0", "-0", "1", "-1", "0.5", "1.27", "-25.4", "3.14159265358979",
+        "0.000001", "1e10", "1.5E-7", "+2.54", ".25", "100.", "123456789012345678",
+        "12345678901234567890123", "0.1234567890123456789012", "1e308", "4.9e-324",
+        "2.2250738585072014e-308", "42mm", "1.2.3"
+    };
+
+    for( const std::string& text : cases )
+    {
+        char*  end = nullptr;
+        char*  ref_end = nullptr;
+        double val = ::StrToDouble( text.c_str(), &end );
+        double ref = strtod( text.c_str(), &ref_end );
+
+        BOOST_TEST_CONTEXT( text )
+        {
+            BOOST_CHECK_EQUAL( val, ref );
+            BOOST_CHECK_EQUAL( std::signbit( val ), std::signbit( ref ) );
+            BOOST_CHECK_EQUAL( end - text.c_str(), ref_end - text.c_str() );
+        }
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    BOOST_CHECK_EQUAL( ::StrToDouble( "1e400", &end ), HUGE_VAL );
+    BOOST_CHECK_EQUAL( errno, ERANGE );
+
+    const char* text = "abc";
+    BOOST_CHECK_EQUAL( ::StrToDouble( text, &end ), 0.0 );
+    BOOST_CHECK( end == text );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,191 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for PDF_PLOTTER: reusable blocks shared as form XObjects and the compression
+ * of the streams
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <plotter.h>
+
+#include <ws_painter.h>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <functional>
+
+
+class PDF_PLOTTER_FIXTURE
+{
+public:
+    PDF_PLOTTER_FIXTURE() :
+            m_fileName( wxFileName::CreateTempFileName( "pdf_plotter" ) )
+    {
+    }
+
+    ~PDF_PLOTTER_FIXTURE()
+    {
+        wxRemoveFile( m_fileName );
+    }
+
+    /**
+     * Plots \a aPages pages, each with the same rectangle in a reusable block and a
+     * rectangle of its own.
+     * @return the content of the PDF file
+     */
+    std::string Plot( int aPages, int aCompressionLevel )
+    {
+        return Plot( aPages, aCompressionLevel,
+                     []( PDF_PLOTTER& aPlotter, int aPage )
+                     {
+                         aPlotter.StartReusableBlock( wxPoint( 0, 0 ) );
+                         aPlotter.Rect( wxPoint( 1000, 1000 ), wxPoint( 20000, 10000 ), NO_FILL,
+                                        50 );
+                         aPlotter.EndReusableBlock();
+
+                         aPlotter.Rect( wxPoint( 2000, 2000 ), wxPoint( 3000, 3000 + aPage ),
+                                        NO_FILL, 50 );
+                     } );
+    }
+
+    /**
+     * Plots \a aPages pages with \a aPlotPage.
+     * @return the content of the PDF file
+     */
+    std::string Plot( int aPages, int aCompressionLevel,
+                      const std::function<void( PDF_PLOTTER&, int )>& aPlotPage )
+    {
+        PDF_PLOTTER plotter;
+
+        plotter.SetRenderSettings( &m_renderSettings );
+        plotter.SetPageSettings( PAGE_INFO( PAGE_INFO::A4 ) );
+        plotter.SetViewport( wxPoint( 0, 0 ), 1.0, 1.0, false );
+        plotter.SetCompressionLevel( aCompressionLevel );
+
+        BOOST_REQUIRE( plotter.OpenFile( m_fileName ) );
+        plotter.StartPlot();
+
+        for( int page = 0; page < aPages; page++ )
+        {
+            if( page > 0 )
+            {
+                plotter.ClosePage();
+                plotter.StartPage();
+            }
+
+            aPlotPage( plotter, page );
+        }
+
+        plotter.EndPlot();
+
+        wxFFile     file( m_fileName, "rb" );
+        std::string content( file.Length(), '\0' );
+
+        BOOST_REQUIRE( file.Read( &content[0], content.size() ) == content.size() );
+        return content;
+    }
+
+    static int Count( const std::string& aText, const std::string& aToken )
+    {
+        int count = 0;
+
+        for( size_t pos = aText.find( aToken ); pos != std::string::npos;
+                pos = aText.find( aToken, pos + 1 ) )
+        {
+            count++;
+        }
+
+        return count;
+    }
+
+    wxString                    m_fileName;
+    KIGFX::WS_RENDER_SETTINGS   m_renderSettings;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PdfPlotter, PDF_PLOTTER_FIXTURE )
+
+
+/**
+ * The block plotted on every page is emitted once, and every page references it
+ */
+BOOST_AUTO_TEST_CASE( ReusableBlockSharedAsForm )
+{
+    std::string pdf = Plot( 3, 9 );
+
+    BOOST_CHECK_EQUAL( Count( pdf, "/Type /Page\n" ), 3 );
+    BOOST_CHECK_EQUAL( Count( pdf, "/Subtype /Form" ), 1 );
+    BOOST_CHECK_EQUAL( Count( pdf, "/XObject <<" ), 3 );
+
+    // Every object of the xref table was written: 3 pages and their streams, the form
+    BOOST_CHECK_EQUAL( Count( pdf, " 0 obj\n" ), Count( pdf, " 00000 n \n" ) );
+    BOOST_CHECK_EQUAL( Count( pdf, "endstream\n" ), 4 );
+}
+
+
+/**
+ * Blocks are shared when their items are the same relative to their anchor, and painted
+ * translated to it
+ */
+BOOST_AUTO_TEST_CASE( ReusableBlockAnchor )
+{
+    // Stored streams, to look at the page content
+    std::string pdf = Plot( 2, 0,
+            []( PDF_PLOTTER& aPlotter, int aPage )
+            {
+                for( const wxPoint& anchor : { wxPoint( 5000, 5000 ), wxPoint( 12000, 7000 ) } )
+                {
+                    aPlotter.StartReusableBlock( anchor );
+                    aPlotter.Rect( anchor, anchor + wxPoint( 1000, 2000 ), NO_FILL, 50 );
+                    aPlotter.EndReusableBlock();
+                }
+
+                aPlotter.StartReusableBlock( wxPoint( 5000, 5000 ) );
+                aPlotter.Circle( wxPoint( 5000, 5000 ), 1000, NO_FILL, 50 );
+                aPlotter.EndReusableBlock();
+            } );
+
+    BOOST_CHECK_EQUAL( Count( pdf, "/Subtype /Form" ), 2 );
+    BOOST_CHECK_EQUAL( Count( pdf, "/XObject << /Fm0 " ), 2 );
+    BOOST_CHECK_EQUAL( Count( pdf, " cm /Fm0 Do Q\n" ), 4 );
+    BOOST_CHECK_EQUAL( Count( pdf, " cm /Fm1 Do Q\n" ), 2 );
+    BOOST_CHECK_EQUAL( Count( pdf, " 0 obj\n" ), Count( pdf, " 00000 n \n" ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( CompressionLevel )
+{
+    std::string stored = Plot( 3, 0 );
+    std::string best = Plot( 3, 9 );
+
+    BOOST_CHECK_EQUAL( Count( stored, "endstream\n" ), Count( best, "endstream\n" ) );
+    BOOST_CHECK_GT( stored.size(), best.size() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
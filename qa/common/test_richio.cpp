@@ -0,0 +1,177 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <richio.h>
+
+
+/**
+ * Writes aContents to a temporary file, removed at the end of the test.
+ */
+class TEMP_FILE
+{
+public:
+    TEMP_FILE( const std::string& aContents ) :
+            m_fileName( wxFileName::CreateTempFileName( "richio" ) )
+    {
+        wxFFile file( m_fileName, "wb" );
+        file.Write( aContents.data(), aContents.size() );
+    }
+
+    ~TEMP_FILE()
+    {
+        wxRemoveFile( m_fileName );
+    }
+
+    wxString m_fileName;
+};
+
+
+/**
+ * Checks that MAPPED_FILE_LINE_READER returns the same nul terminated lines as
+ * STRING_LINE_READER.
+ */
+static void checkLines( const std::string& aContents )
+{
+    TEMP_FILE               file( aContents );
+    MAPPED_FILE_LINE_READER mapped( file.m_fileName );
+
+    // The second pass reads the file again after a rewind
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        STRING_LINE_READER expected( aContents, "test" );
+
+        while( true )
+        {
+            char* expectedLine = expected.ReadLine();
+            char* mappedLine = mapped.ReadLine();
+
+            BOOST_CHECK_EQUAL( mapped.LineNumber(), expected.LineNumber() );
+
+            if( !expectedLine )
+            {
+                BOOST_CHECK( !mappedLine );
+                break;
+            }
+
+            BOOST_REQUIRE( mappedLine );
+            BOOST_CHECK_EQUAL( mapped.Length(), expected.Length() );
+            BOOST_CHECK_EQUAL( strlen( mappedLine ), mapped.Length() );
+            BOOST_CHECK_EQUAL( std::string( mappedLine ), std::string( expectedLine ) );
+        }
+
+        mapped.Rewind();
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE( RichIO )
+
+
+BOOST_AUTO_TEST_CASE( MappedFileLines )
+{
+    checkLines( "(kicad_pcb (version 20200828)\n\n  (general (thickness 1.6))\n)\n" );
+}
+
+
+BOOST_AUTO_TEST_CASE( MappedFileNoFinalNewline )
+{
+    checkLines( "first\nsecond\nlast line" );
+}
+
+
+BOOST_AUTO_TEST_CASE( MappedFileEmpty )
+{
+    checkLines( "" );
+}
+
+
+BOOST_AUTO_TEST_CASE( MappedFileMissing )
+{
+    BOOST_CHECK_THROW( MAPPED_FILE_LINE_READER( "/this/file/does/not/exist" ), IO_ERROR );
+}
+
+
+BOOST_AUTO_TEST_CASE( PrintPlainFormats )
+{
+    STRING_FORMATTER formatter;
+
+    // Formatted without printf
+    formatter.Print( 2, "(net %d %s)%c%%\n", -2147483647 - 1, "\"GND\"", 'x' );
+    formatter.Print( 0, "%d %d %s", 0, 2147483647, "" );
+
+    // Formatted by printf
+    formatter.Print( 1, "(%3d %-4s %x %.2f)", 7, "ab", 255, 1.005 );
+
+    char expected[200];
+
+    snprintf( expected, sizeof( expected ), "    (net %d %s)x%%\n%d %d %s  (%3d %-4s %x %.2f)",
+              -2147483647 - 1, "\"GND\"", 0, 2147483647, "", 7, "ab", 255, 1.005 );
+
+    BOOST_CHECK_EQUAL( formatter.GetString(), std::string( expected ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( FileFormatterBuffering )
+{
+    TEMP_FILE   file( "" );
+    std::string expected;
+
+    {
+        FILE_OUTPUTFORMATTER formatter( file.m_fileName, wxT( "wb" ) );
+
+        // Enough to go through the buffer several times, plus a write larger than the buffer
+        for( int ii = 0; ii < 20000; ii++ )
+        {
+            formatter.Print( ii % 4, "(xy %d %d)\n", ii, -ii );
+            expected += std::string( 2 * ( ii % 4 ), ' ' ) + "(xy " + std::to_string( ii ) + " "
+                        + std::to_string( -ii ) + ")\n";
+        }
+
+        std::string large( FILE_OUTPUTFMTBUFZ + 10, 'a' );
+
+        formatter.Print( 0, "%s", large.c_str() );
+        expected += large;
+
+        formatter.Finish();
+    }
+
+    wxFFile     written( file.m_fileName, "rb" );
+    std::string contents;
+
+    contents.resize( written.Length() );
+    written.Read( &contents[0], contents.size() );
+
+    BOOST_CHECK( contents == expected );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
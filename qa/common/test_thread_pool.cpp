@@ -0,0 +1,150 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <stdexcept>
+
+#include <thread_pool.h>
+
+
+BOOST_AUTO_TEST_SUITE( ThreadPool )
+
+
+BOOST_AUTO_TEST_CASE( ParallelForVisitsAll )
+{
+    THREAD_POOL       pool( 3 );
+    std::vector<int>  visits( 1000, 0 );
+
+    pool.ParallelFor( visits.size(), [&]( size_t ii ) { visits[ii]++; } );
+
+    for( int count : visits )
+        BOOST_CHECK_EQUAL( count, 1 );
+
+    // Nothing to do is fine too
+    pool.ParallelFor( 0, [&]( size_t ii ) { visits[ii]++; } );
+}
+
+
+/**
+ * Tasks run from tasks, and waits from inside the pool, must not deadlock even with a single
+ * worker
+ */
+BOOST_AUTO_TEST_CASE( Nested )
+{
+    THREAD_POOL      pool( 1 );
+    TASK_GROUP       outer( pool );
+    std::atomic<int> count( 0 );
+
+    for( int ii = 0; ii < 4; ++ii )
+    {
+        outer.Run(
+                [&]()
+                {
+                    pool.ParallelFor( 10, [&]( size_t ) { count++; } );
+
+                    TASK_GROUP inner( pool );
+
+                    for( int jj = 0; jj < 10; ++jj )
+                        inner.Run( [&]() { count++; } );
+
+                    inner.Wait();
+                } );
+    }
+
+    outer.Wait();
+
+    BOOST_CHECK_EQUAL( count, 80 );
+}
+
+
+BOOST_AUTO_TEST_CASE( Cancel )
+{
+    THREAD_POOL      pool( 2 );
+    TASK_GROUP       group( pool );
+    std::atomic<int> count( 0 );
+
+    group.Cancel();
+
+    for( int ii = 0; ii < 10; ++ii )
+        group.Run( [&]() { count++; } );
+
+    group.Wait();
+    BOOST_CHECK_EQUAL( count, 0 );
+
+    TASK_GROUP loopGroup( pool );
+
+    loopGroup.Cancel();
+    pool.ParallelFor( 100, [&]( size_t ) { count++; }, &loopGroup );
+    BOOST_CHECK_EQUAL( count, 0 );
+}
+
+
+BOOST_AUTO_TEST_CASE( Exceptions )
+{
+    THREAD_POOL pool( 2 );
+
+    {
+        TASK_GROUP group( pool );
+
+        group.Run( []() { throw std::runtime_error( "task" ); } );
+
+        BOOST_CHECK_THROW( group.Wait(), std::runtime_error );
+        BOOST_CHECK( group.IsCancelled() );
+    }
+
+    BOOST_CHECK_THROW( pool.ParallelFor( 100,
+                                         []( size_t ii )
+                                         {
+                                             if( ii == 50 )
+                                                 throw std::runtime_error( "index" );
+                                         } ),
+                       std::runtime_error );
+}
+
+
+BOOST_AUTO_TEST_CASE( WaitFor )
+{
+    THREAD_POOL       pool( 1 );
+    TASK_GROUP        group( pool );
+    std::atomic<bool> release( false );
+
+    group.Run(
+            [&]()
+            {
+                while( !release )
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+            } );
+
+    BOOST_CHECK( !group.WaitFor( std::chrono::milliseconds( 10 ) ) );
+
+    release = true;
+
+    while( !group.WaitFor( std::chrono::milliseconds( 100 ) ) )
+        ;
+
+    group.Wait();
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
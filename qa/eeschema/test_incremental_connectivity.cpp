@@ -0,0 +1,273 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_incremental_connectivity.cpp
+ * Checks that updating the connection graph after an edit gives the same nets as a full
+ * rebuild, and reports the time taken by both.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+#include "eeschema_test_utils.h"
+
+#include <map>
+
+#include <connection_graph.h>
+#include <profile.h>
+#include <project.h>
+#include <sch_component.h>
+#include <sch_io_mgr.h>
+#include <sch_line.h>
+#include <sch_pin.h>
+#include <sch_screen.h>
+#include <sch_sheet.h>
+#include <sch_text.h>
+#include <schematic.h>
+#include <settings/settings_manager.h>
+#include <wildcards_and_files_ext.h>
+
+
+/// Net name of every item of the graph, by sheet and item
+using NET_SNAPSHOT = std::map<wxString, wxString>;
+
+
+class TEST_INCREMENTAL_CONNECTIVITY_FIXTURE
+{
+public:
+    TEST_INCREMENTAL_CONNECTIVITY_FIXTURE() :
+            m_schematic( nullptr ),
+            m_manager( true )
+    {
+        m_pi = SCH_IO_MGR::FindPlugin( SCH_IO_MGR::SCH_KICAD );
+    }
+
+    void loadSchematic( const wxString& aBaseName );
+
+    NET_SNAPSHOT snapshot();
+
+    /**
+     * Updates the connection graph after an edit, then checks the result against a full
+     * rebuild.
+     *
+     * @return true if the update was incremental, rather than a fallback to a full rebuild.
+     */
+    bool checkUpdate( const wxString& aEdit );
+
+    SCHEMATIC        m_schematic;
+    SCH_PLUGIN*      m_pi;
+    SETTINGS_MANAGER m_manager;
+};
+
+
+void TEST_INCREMENTAL_CONNECTIVITY_FIXTURE::loadSchematic( const wxString& aBaseName )
+{
+    wxFileName fn = KI_TEST::GetEeschemaTestDataDir();
+    fn.AppendDir( "netlists" );
+    fn.AppendDir( aBaseName );
+    fn.SetName( aBaseName );
+    fn.SetExt( KiCadSchematicFileExtension );
+
+    wxFileName pro( fn );
+    pro.SetExt( ProjectFileExtension );
+
+    m_manager.LoadProject( pro.GetFullPath() );
+    m_manager.Prj().SetElem( PROJECT::ELEM_SCH_PART_LIBS, nullptr );
+
+    m_schematic.Reset();
+    m_schematic.SetProject( &m_manager.Prj() );
+    m_schematic.SetRoot( m_pi->Load( fn.GetFullPath(), &m_schematic ) );
+
+    BOOST_REQUIRE_EQUAL( m_pi->GetError().IsEmpty(), true );
+
+    m_schematic.CurrentSheet().push_back( &m_schematic.Root() );
+
+    SCH_SCREENS screens( m_schematic.Root() );
+
+    for( SCH_SCREEN* screen = screens.GetFirst(); screen; screen = screens.GetNext() )
+        screen->UpdateLocalLibSymbolLinks();
+
+    SCH_SHEET_LIST sheets = m_schematic.GetSheets();
+
+    sheets.UpdateSymbolInstances( m_schematic.RootScreen()->GetSymbolInstances() );
+    sheets.AnnotatePowerSymbols();
+
+    for( SCH_SHEET_PATH& sheet : sheets )
+        sheet.UpdateAllScreenReferences();
+
+    PROF_COUNTER timer;
+
+    m_schematic.ConnectionGraph()->Recalculate( sheets, true );
+
+    BOOST_TEST_MESSAGE( wxString::Format( "%s: full rebuild %0.3f ms", aBaseName,
+                                          timer.msecs() ) );
+}
+
+
+NET_SNAPSHOT TEST_INCREMENTAL_CONNECTIVITY_FIXTURE::snapshot()
+{
+    NET_SNAPSHOT nets;
+
+    auto addItem =
+            [&]( const SCH_SHEET_PATH& aSheet, SCH_ITEM* aItem, const wxString& aKey )
+            {
+                SCH_CONNECTION* connection = aItem->Connection( aSheet );
+                nets[aSheet.PathAsString() + aKey] = connection ? connection->Name()
+                                                                : wxString( "<none>" );
+            };
+
+    for( const SCH_SHEET_PATH& sheet : m_schematic.GetSheets() )
+    {
+        for( SCH_ITEM* item : sheet.LastScreen()->Items() )
+        {
+            if( !item->IsConnectable() )
+                continue;
+
+            if( item->Type() == SCH_COMPONENT_T )
+            {
+                SCH_COMPONENT* component = static_cast<SCH_COMPONENT*>( item );
+
+                for( SCH_PIN* pin : component->GetPins( &sheet ) )
+                    addItem( sheet, pin, item->m_Uuid.AsString() + ":" + pin->GetNumber() );
+            }
+            else if( item->Type() == SCH_SHEET_T )
+            {
+                for( SCH_SHEET_PIN* pin : static_cast<SCH_SHEET*>( item )->GetPins() )
+                    addItem( sheet, pin, pin->m_Uuid.AsString() );
+            }
+            else
+            {
+                addItem( sheet, item, item->m_Uuid.AsString() );
+            }
+        }
+    }
+
+    return nets;
+}
+
+
+bool TEST_INCREMENTAL_CONNECTIVITY_FIXTURE::checkUpdate( const wxString& aEdit )
+{
+    SCH_SHEET_LIST sheets = m_schematic.GetSheets();
+    PROF_COUNTER   update_timer;
+
+    m_schematic.ConnectionGraph()->Recalculate( sheets, false );
+
+    update_timer.Stop();
+
+    bool incremental = m_schematic.ConnectionGraph()->LastRecalcWasIncremental();
+
+    NET_SNAPSHOT updated = snapshot();
+    PROF_COUNTER rebuild_timer;
+
+    m_schematic.ConnectionGraph()->Recalculate( sheets, true );
+
+    rebuild_timer.Stop();
+
+    NET_SNAPSHOT rebuilt = snapshot();
+
+    BOOST_TEST_MESSAGE( wxString::Format( "%s: update %0.3f ms, full rebuild %0.3f ms", aEdit,
+                                          update_timer.msecs(), rebuild_timer.msecs() ) );
+
+    BOOST_REQUIRE_EQUAL( updated.size(), rebuilt.size() );
+
+    for( const auto& it : rebuilt )
+    {
+        BOOST_TEST_CONTEXT( aEdit << ": " << it.first )
+        {
+            BOOST_CHECK_EQUAL( updated[it.first], it.second );
+        }
+    }
+
+    return incremental;
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( IncrementalConnectivity, TEST_INCREMENTAL_CONNECTIVITY_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( NoChange )
+{
+    loadSchematic( "video" );
+
+    checkUpdate( "no change" );
+}
+
+
+BOOST_AUTO_TEST_CASE( AddRemoveWire )
+{
+    loadSchematic( "video" );
+
+    SCH_SCREEN* screen = m_schematic.RootScreen();
+    SCH_LINE*   wire = nullptr;
+
+    for( SCH_ITEM* item : screen->Items().OfType( SCH_LINE_T ) )
+    {
+        if( item->GetLayer() == LAYER_WIRE )
+        {
+            wire = static_cast<SCH_LINE*>( item );
+            break;
+        }
+    }
+
+    BOOST_REQUIRE( wire );
+
+    // A dangling stub off the end of an existing wire
+    SCH_LINE* stub = new SCH_LINE( wire->GetEndPoint(), LAYER_WIRE );
+    stub->SetEndPoint( wire->GetEndPoint() + wxPoint( 0, Mils2iu( 500 ) ) );
+
+    screen->Append( stub );
+
+    BOOST_CHECK( checkUpdate( "add wire" ) );
+
+    screen->Remove( stub );
+
+    BOOST_CHECK( checkUpdate( "remove wire" ) );
+
+    delete stub;
+}
+
+
+BOOST_AUTO_TEST_CASE( RenameLabel )
+{
+    loadSchematic( "video" );
+
+    SCH_TEXT* label = nullptr;
+
+    for( const SCH_SHEET_PATH& sheet : m_schematic.GetSheets() )
+    {
+        for( SCH_ITEM* item : sheet.LastScreen()->Items().OfType( SCH_LABEL_T ) )
+        {
+            label = static_cast<SCH_TEXT*>( item );
+            break;
+        }
+
+        if( label )
+            break;
+    }
+
+    BOOST_REQUIRE( label );
+
+    label->SetText( label->GetText() + "_RENAMED" );
+    label->SetConnectivityDirty();
+
+    BOOST_CHECK( checkUpdate( "rename label" ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
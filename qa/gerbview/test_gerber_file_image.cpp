@@ -0,0 +1,129 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file test_gerber_file_image.cpp
+ * Checks that the items found by the spatial index of a GERBER_FILE_IMAGE are the ones a
+ * hit test of all the items finds.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <convert_to_biu.h>
+#include <gerber_file_image.h>
+
+
+static const char gerberFile[] =
+        "%FSLAX46Y46*%\n"
+        "%MOMM*%\n"
+        "%ADD10C,0.250000*%\n"
+        "%ADD11R,1.000000X0.500000*%\n"
+        "%ADD12O,0.800000X0.400000*%\n"
+        "%AMROTRECT*\n"
+        "21,1,0.6,0.3,0.2,0.1,30*\n"
+        "1,1,0.3,-0.3,0*%\n"
+        "%ADD13ROTRECT*%\n"
+        "D10*\n"
+        "X0Y0D02*\n"
+        "X1000000Y0D01*\n"
+        "X1000000Y2000000D01*\n"
+        "G75*\n"
+        "X0Y3000000D02*\n"
+        "G03X2000000Y3000000I1000000J0D01*\n"
+        "G01*\n"
+        "D11*\n"
+        "X0Y1000000D02*\n"
+        "X2000000Y1500000D01*\n"
+        "X3000000Y3000000D03*\n"
+        "D12*\n"
+        "X1000000Y1000000D03*\n"
+        "G36*\n"
+        "X2500000Y0D02*\n"
+        "X3500000Y0D01*\n"
+        "X3500000Y1000000D01*\n"
+        "X2500000Y0D01*\n"
+        "G37*\n"
+        "D13*\n"
+        "X4000000Y500000D03*\n"
+        "X4000000Y2500000D03*\n"
+        "M02*\n";
+
+
+BOOST_AUTO_TEST_SUITE( GerberFileImage )
+
+
+BOOST_AUTO_TEST_CASE( ItemIndexSameAsHitTest )
+{
+    wxString fileName = wxFileName::CreateTempFileName( "gerbview_index" );
+
+    {
+        wxFFile file( fileName, "wb" );
+        file.Write( wxString( gerberFile ) );
+    }
+
+    GERBER_FILE_IMAGE image( 0 );
+
+    BOOST_REQUIRE( image.LoadGerberFile( fileName ) );
+    wxRemoveFile( fileName );
+
+    // The two flashes of the macro share the cached bounding box of its shape
+    BOOST_REQUIRE_EQUAL( image.GetItemsCount(), 9 );
+
+    const int step = Millimeter2iu( 0.05 );
+    int       hits = 0;
+
+    for( int x = Millimeter2iu( -1 ); x <= Millimeter2iu( 5 ); x += step )
+    {
+        for( int y = Millimeter2iu( -5 ); y <= Millimeter2iu( 1 ); y += step )
+        {
+            wxPoint                        pos( x, y );
+            std::vector<GERBER_DRAW_ITEM*> expected;
+            std::vector<GERBER_DRAW_ITEM*> found;
+
+            for( GERBER_DRAW_ITEM* item : image.GetItems() )
+            {
+                if( item->HitTest( pos ) )
+                    expected.push_back( item );
+            }
+
+            for( GERBER_DRAW_ITEM* item : image.GetItemsAt( pos, Millimeter2iu( 0.01 ) ) )
+            {
+                if( item->HitTest( pos ) )
+                    found.push_back( item );
+            }
+
+            BOOST_CHECK_EQUAL_COLLECTIONS( found.begin(), found.end(),
+                                           expected.begin(), expected.end() );
+            hits += expected.size();
+        }
+    }
+
+    // Make sure the points actually hit something
+    BOOST_CHECK_GT( hits, 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,183 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file test_gerber_file_image_list.cpp
+ * Checks that the files read at once by GERBER_FILE_IMAGE_LIST::LoadImages() give the same
+ * images as when they are read one at a time.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <dcode.h>
+#include <excellon_image.h>
+#include <gerber_file_image.h>
+#include <gerber_file_image_list.h>
+
+
+static const char gerberFile[] =
+        "%FSLAX46Y46*%\n"
+        "%MOMM*%\n"
+        "%ADD10C,0.250000*%\n"
+        "%ADD11R,1.000000X0.500000*%\n"
+        "D10*\n"
+        "X0Y0D02*\n"
+        "X1000000Y0D01*\n"
+        "X1000000Y2000000D01*\n"
+        "D11*\n"
+        "X0Y1000000D02*\n"
+        "X2000000Y1500000D01*\n"
+        "X3000000Y3000000D03*\n"
+        "M02*\n";
+
+static const char drillFile[] =
+        "M48\n"
+        "METRIC\n"
+        "T1C0.800\n"
+        "%\n"
+        "T1\n"
+        "X1.0Y2.0\n"
+        "X3.0Y4.0\n"
+        "M30\n";
+
+
+class GERBER_FILE_IMAGE_LIST_FIXTURE
+{
+public:
+    GERBER_FILE_IMAGE_LIST_FIXTURE()
+    {
+        for( int ii = 0; ii < 8; ii++ )
+        {
+            bool     drill = ii % 4 == 3;
+            wxString fileName = wxFileName::CreateTempFileName( "gerbview_load" );
+            wxFFile  file( fileName, "wb" );
+
+            file.Write( wxString( drill ? drillFile : gerberFile ) );
+            file.Close();
+
+            m_fileNames.push_back( fileName );
+            m_isDrill.push_back( drill );
+        }
+    }
+
+    ~GERBER_FILE_IMAGE_LIST_FIXTURE()
+    {
+        for( const wxString& fileName : m_fileNames )
+            wxRemoveFile( fileName );
+    }
+
+    std::vector<wxString> m_fileNames;
+    std::vector<bool>     m_isDrill;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( GerberFileImageList, GERBER_FILE_IMAGE_LIST_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( LoadImagesSameAsSerial )
+{
+    std::vector<std::unique_ptr<GERBER_FILE_IMAGE>> images =
+            GERBER_FILE_IMAGE_LIST::LoadImages( m_fileNames, m_isDrill );
+
+    BOOST_REQUIRE_EQUAL( images.size(), m_fileNames.size() );
+
+    for( size_t ii = 0; ii < images.size(); ii++ )
+    {
+        BOOST_TEST_CONTEXT( m_fileNames[ii] )
+        {
+            std::unique_ptr<GERBER_FILE_IMAGE> serial;
+
+            if( m_isDrill[ii] )
+            {
+                EXCELLON_IMAGE* drill = new EXCELLON_IMAGE( 0 );
+                serial.reset( drill );
+                BOOST_REQUIRE( drill->LoadFile( m_fileNames[ii] ) );
+            }
+            else
+            {
+                serial = std::make_unique<GERBER_FILE_IMAGE>( 0 );
+                BOOST_REQUIRE( serial->LoadGerberFile( m_fileNames[ii] ) );
+            }
+
+            BOOST_REQUIRE( images[ii] );
+            BOOST_CHECK_EQUAL( images[ii]->GetItemsCount(), m_isDrill[ii] ? 2 : 4 );
+            BOOST_REQUIRE_EQUAL( images[ii]->GetItemsCount(), serial->GetItemsCount() );
+
+            auto item = images[ii]->GetItems().begin();
+
+            for( GERBER_DRAW_ITEM* expected : serial->GetItems() )
+            {
+                BOOST_CHECK_EQUAL( (int) ( *item )->m_Shape, (int) expected->m_Shape );
+                BOOST_CHECK( ( *item )->m_Start == expected->m_Start );
+                BOOST_CHECK( ( *item )->m_End == expected->m_End );
+                BOOST_CHECK( ( *item )->m_Size == expected->m_Size );
+                ++item;
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( MissingFile )
+{
+    wxRemoveFile( m_fileNames[1] );
+
+    std::vector<std::unique_ptr<GERBER_FILE_IMAGE>> images =
+            GERBER_FILE_IMAGE_LIST::LoadImages( m_fileNames, m_isDrill );
+
+    BOOST_CHECK( images[0] );
+    BOOST_CHECK( !images[1] );
+    BOOST_CHECK( images[2] );
+}
+
+
+BOOST_AUTO_TEST_CASE( RectSegmentBoundingBox )
+{
+    GERBER_FILE_IMAGE image( 0 );
+
+    BOOST_REQUIRE( image.LoadGerberFile( m_fileNames[0] ) );
+
+    // The segment drawn with the rectangular aperture D11
+    GERBER_DRAW_ITEM* segment = image.GetItems()[2];
+
+    BOOST_REQUIRE_EQUAL( (int) segment->m_Shape, (int) GBR_SEGMENT );
+    BOOST_REQUIRE_EQUAL( segment->m_Polygon.OutlineCount(), 0 );
+
+    // Before the polygon is built, the bounding box is the one of the polygon
+    EDA_RECT bbox = segment->GetBoundingBox();
+
+    segment->ConvertSegmentToPolygon();
+
+    EDA_RECT expected = segment->GetBoundingBox();
+
+    BOOST_CHECK_LE( std::abs( bbox.GetX() - expected.GetX() ), 1 );
+    BOOST_CHECK_LE( std::abs( bbox.GetY() - expected.GetY() ), 1 );
+    BOOST_CHECK_LE( std::abs( bbox.GetRight() - expected.GetRight() ), 1 );
+    BOOST_CHECK_LE( std::abs( bbox.GetBottom() - expected.GetBottom() ), 1 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,3 +1,33 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Sanity checks and a microbenchmark for the expression evaluator used by DRC rule conditions.
+ *
+ * Usage: libeval_compiler_test [evaluations per expression]
+ */
+
 #include <wx/wx.h>
 #include <cstdio>
 
@@ -6,108 +36,150 @@
 
 #include <pcb_expr_evaluator.h>
 
-#include <io_mgr.h>
-#include <kicad_plugin.h>
-
-#include <unordered_set>
-
 #include <profile.h>
 
-bool testEvalExpr( const std::string expr, LIBEVAL::VALUE expectedResult, bool expectError = false, BOARD_ITEM* itemA = nullptr, BOARD_ITEM* itemB = nullptr )
+
+bool testEvalExpr( const wxString& expr, LIBEVAL::VALUE expectedResult, bool expectError = false,
+                   BOARD_ITEM* itemA = nullptr, BOARD_ITEM* itemB = nullptr )
 {
     PCB_EXPR_COMPILER compiler;
-    PCB_EXPR_UCODE ucode;
-    bool ok = true;
+    PCB_EXPR_UCODE    ucode;
+    PCB_EXPR_CONTEXT  preflightContext( F_Cu );
+    PCB_EXPR_CONTEXT  context( F_Cu );
 
-    ucode.SetItems( itemA, itemB );
+    context.SetItems( itemA, itemB );
 
-    bool error = !compiler.Compile( expr, &ucode );
+    bool error = !compiler.Compile( expr, &ucode, &preflightContext );
 
     if( error )
+        return expectError;
+
+    return *ucode.Run( &context ) == expectedResult;
+}
+
+
+/**
+ * Evaluates a compiled condition the way DRC_RULE_CONDITION::EvaluateFor() does: with a
+ * fresh context, trying the items in both orders.
+ */
+static bool evalCondition( PCB_EXPR_UCODE& aUcode, BOARD_ITEM* aItemA, BOARD_ITEM* aItemB )
+{
+    PCB_EXPR_CONTEXT ctx( F_Cu );
+
+    ctx.SetItems( aItemA, aItemB );
+
+    if( aUcode.Run( &ctx )->AsDouble() != 0.0 )
+        return true;
+
+    ctx.SetItems( aItemB, aItemA );
+
+    return aUcode.Run( &ctx )->AsDouble() != 0.0;
+}
+
+
+static void benchmark( const wxString& aExpr, BOARD_ITEM* aItemA, BOARD_ITEM* aItemB,
+                       long aCount )
+{
+    PCB_EXPR_COMPILER compiler;
+    PCB_EXPR_UCODE    ucode;
+    PCB_EXPR_CONTEXT  preflightContext( F_Cu );
+
+    if( !compiler.Compile( aExpr, &ucode, &preflightContext ) )
     {
-        if ( expectError )
-        {
-            ok = true;
-            return ok;
-        }
-        else
-        {
-            ok = false;
-        }
+        printf( "%-60s  compile error: %s\n", (const char*) aExpr.c_str(),
+                (const char*) compiler.GetError().message.c_str() );
+        return;
     }
 
-    LIBEVAL::VALUE result;
+    long         matches = 0;
+    PROF_COUNTER timer;
 
-    if( ok )
+    for( long ii = 0; ii < aCount; ++ii )
     {
-        result = *ucode.Run();
-        ok = (result == expectedResult);
+        if( evalCondition( ucode, aItemA, aItemB ) )
+            matches++;
     }
 
-    return ok;
-}
+    timer.Stop();
 
-bool EvaluatePCBExpression( const std::string& aExpr, int& aResult )
-{
-    PCB_EXPR_COMPILER compiler;
-    PCB_EXPR_UCODE ucode;
-    if( !compiler.Compile( aExpr, &ucode ) )
-        return false;
+    double secs = timer.msecs() / 1000.0;
 
-    auto result = ucode.Run();
-    return true;
+    printf( "%-60s  %12.0f evals/s  (%d ops, %ld matched)\n", (const char*) aExpr.c_str(),
+            secs > 0.0 ? aCount / secs : 0.0,
+            (int) ucode.Dump().Freq( '\n' ), matches );
 }
 
+
 int main( int argc, char *argv[] )
 {
+    long count = 1000000;
+
+    if( argc > 1 )
+        count = atol( argv[1] );
+
     PROPERTY_MANAGER& propMgr = PROPERTY_MANAGER::Instance();
     propMgr.Rebuild();
 
-
     using VAL = LIBEVAL::VALUE;
 
-/*    testEvalExpr( "10mm + 20 mm", VAL(30e6) );
-    testEvalExpr( "3*(7+8)", VAL(3*(7+8)) );
-    testEvalExpr( "3*7+8", VAL(3*7+8) );
-    testEvalExpr( "(3*7)+8", VAL(3*7+8) );
-    testEvalExpr( "10mm + 20)", VAL(0), true );
-  */
-
     BOARD brd;
 
-    NETINFO_LIST& netInfo = brd.GetNetInfo();
-
-    NETCLASSPTR netclass1( new NETCLASS("HV") );
-    NETCLASSPTR netclass2( new NETCLASS("otherClass" ) );
+    NETCLASSPTR netclass1( new NETCLASS( "HV" ) );
+    NETCLASSPTR netclass2( new NETCLASS( "otherClass" ) );
 
-    auto net1info = new NETINFO_ITEM( &brd, "net1", 1);
-    auto net2info = new NETINFO_ITEM( &brd, "net2", 2);
+    auto net1info = new NETINFO_ITEM( &brd, "net1", 1 );
+    auto net2info = new NETINFO_ITEM( &brd, "net2", 2 );
 
     net1info->SetClass( netclass1 );
     net2info->SetClass( netclass2 );
 
-    TRACK trackA(&brd);
-    TRACK trackB(&brd);
+    TRACK trackA( &brd );
+    TRACK trackB( &brd );
+    VIA   via( &brd );
 
     trackA.SetNet( net1info );
     trackB.SetNet( net2info );
+    via.SetNet( net2info );
 
     trackB.SetLayer( F_Cu );
+    via.SetViaType( VIATYPE::MICROVIA );
 
-    trackA.SetWidth( Mils2iu( 10 ));
-    trackB.SetWidth( Mils2iu( 20 ));
+    trackA.SetWidth( Mils2iu( 10 ) );
+    trackB.SetWidth( Mils2iu( 20 ) );
 
-//    testEvalExpr( "A.onlayer('F.Cu') || A.onlayer('B.Cu')", VAL( 1.0 ), false, &trackA, &trackB );
-    testEvalExpr( "A.type == 'Pad' && B.type == 'Pad' && (A.onLayer('F.Cu'))", VAL( 0.0 ), false, &trackA, &trackB );
-        return 0;
-    testEvalExpr( "A.Width > B.Width", VAL( 0.0 ), false, &trackA, &trackB );
-    testEvalExpr( "A.Width + B.Width", VAL( Mils2iu(10) + Mils2iu(20) ), false, &trackA, &trackB );
+    struct
+    {
+        wxString expr;
+        VAL      result;
+    } checks[] =
+    {
+        { "10mm + 20 mm", VAL( 30e6 ) },
+        { "3*(7+8)", VAL( 3 * ( 7 + 8 ) ) },
+        { "A.Width > B.Width", VAL( 0.0 ) },
+        { "A.Width + B.Width", VAL( Mils2iu( 10 ) + Mils2iu( 20 ) ) },
+        { "A.NetClass", VAL( "HV" ) },
+        { "(A.NetClass == 'HV') && (B.NetClass == 'otherClass')", VAL( 1.0 ) },
+        { "0 && A.NetClass == 'HV'", VAL( 0.0 ) },
+        { "A.NetClass == 'HV' || 2 > 1", VAL( 1.0 ) }
+    };
+
+    for( const auto& check : checks )
+    {
+        bool ok = testEvalExpr( check.expr, check.result, false, &trackA, &trackB );
+        printf( "%-60s  %s\n", (const char*) check.expr.c_str(), ok ? "OK" : "FAIL" );
+    }
 
-    testEvalExpr( "A.Netclass", VAL( (const char*) trackA.GetNetClassName().c_str() ), false, &trackA, &trackB );
-    testEvalExpr( "(A.Netclass == 'HV') && (B.netclass == 'otherClass') && (B.netclass != 'F.Cu')", VAL( 1.0 ), false, &trackA, &trackB );
-    testEvalExpr( "A.Netclass + 1.0", VAL( 1.0 ), false, &trackA, &trackB );
-    testEvalExpr( "A.type == 'Track' && B.type == 'Track' && A.layer == 'F.Cu'", VAL( 0.0 ), false, &trackA, &trackB );
-    testEvalExpr( "(A.type == 'Track') && (B.type == 'Track') && (A.layer == 'F.Cu')", VAL( 0.0 ), false, &trackA, &trackB );
+    printf( "\n%ld evaluations per expression:\n", count );
+
+    // The implicit rules generated by DRC_ENGINE, followed by typical user rules
+    benchmark( "A.NetClass == 'HV' || B.NetClass == 'HV'", &trackA, &trackB, count );
+    benchmark( "A.NetClass == 'none' || B.NetClass == 'none'", &trackA, &trackB, count );
+    benchmark( "A.Via_Type == 'micro_via'", &via, &trackA, count );
+    benchmark( "A.Via_Type == 'buried_via'", &via, &trackA, count );
+    benchmark( "A.Type == 'Via' && A.isMicroVia()", &via, &trackA, count );
+    benchmark( "A.onLayer('F.Cu') && B.NetClass != 'HV'", &trackB, &trackA, count );
+    benchmark( "A.Width > 0.2mm || B.Width > 8mil + 2mil", &trackA, &trackB, count );
+    benchmark( "(1mm > 2mm) && A.NetClass == 'HV'", &trackA, &trackB, count );
 
     return 0;
 }
@@ -0,0 +1,194 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Checks that the tiled SHAPE_POLY_SET operations give the same results as the plain ones.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <geometry/shape_poly_set.h>
+
+
+static SHAPE_LINE_CHAIN square( int aX, int aY, int aSize )
+{
+    SHAPE_LINE_CHAIN chain;
+
+    chain.Append( aX, aY );
+    chain.Append( aX + aSize, aY );
+    chain.Append( aX + aSize, aY + aSize );
+    chain.Append( aX, aY + aSize );
+    chain.SetClosed( true );
+
+    return chain;
+}
+
+
+static double area( const SHAPE_POLY_SET& aSet )
+{
+    double total = 0.0;
+
+    for( int ii = 0; ii < aSet.OutlineCount(); ++ii )
+    {
+        total += std::abs( aSet.COutline( ii ).Area() );
+
+        for( int jj = 0; jj < aSet.HoleCount( ii ); ++jj )
+            total -= std::abs( aSet.CHole( ii, jj ).Area() );
+    }
+
+    return total;
+}
+
+
+class TILED_POLY_SET_FIXTURE
+{
+public:
+    TILED_POLY_SET_FIXTURE()
+    {
+        // A large square pour...
+        m_pour.AddOutline( square( 0, 0, 1000000 ) );
+
+        // ... and a lattice of square knockouts which the tile seams will cut through
+        for( int ii = 0; ii < 7; ++ii )
+        {
+            for( int jj = 0; jj < 7; ++jj )
+                m_holes.AddOutline( square( 50000 + ii * 135000, 50000 + jj * 135000, 80000 ) );
+        }
+    }
+
+    SHAPE_POLY_SET m_pour;
+    SHAPE_POLY_SET m_holes;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ShapePolySetTiled, TILED_POLY_SET_FIXTURE )
+
+
+/**
+ * The seams between the tiles must vanish: the result is still one outline with all its holes
+ */
+BOOST_AUTO_TEST_CASE( Subtract )
+{
+    SHAPE_POLY_SET plain = m_pour;
+    SHAPE_POLY_SET tiled = m_pour;
+
+    plain.BooleanSubtract( m_holes, SHAPE_POLY_SET::PM_FAST );
+    tiled.TiledBooleanSubtract( m_holes, SHAPE_POLY_SET::PM_FAST, 0 );
+
+    BOOST_REQUIRE_EQUAL( tiled.OutlineCount(), 1 );
+    BOOST_CHECK_EQUAL( tiled.HoleCount( 0 ), plain.HoleCount( 0 ) );
+    BOOST_CHECK_CLOSE( area( tiled ), area( plain ), 1e-6 );
+}
+
+
+BOOST_AUTO_TEST_CASE( Intersection )
+{
+    SHAPE_POLY_SET plain = m_holes;
+    SHAPE_POLY_SET tiled = m_holes;
+    SHAPE_POLY_SET clip;
+
+    clip.AddOutline( square( 100000, 100000, 500000 ) );
+
+    plain.BooleanIntersection( clip, SHAPE_POLY_SET::PM_FAST );
+    tiled.TiledBooleanIntersection( clip, SHAPE_POLY_SET::PM_FAST, 0 );
+
+    BOOST_CHECK_EQUAL( tiled.OutlineCount(), plain.OutlineCount() );
+    BOOST_CHECK_CLOSE( area( tiled ), area( plain ), 1e-6 );
+}
+
+
+/**
+ * Deflating and re-inflating (as the zone filler does to prune narrow features) must not
+ * be affected by the tile boundaries either
+ */
+BOOST_AUTO_TEST_CASE( Inflate )
+{
+    SHAPE_POLY_SET plain = m_pour;
+
+    plain.BooleanSubtract( m_holes, SHAPE_POLY_SET::PM_FAST );
+
+    SHAPE_POLY_SET tiled = plain;
+
+    for( SHAPE_POLY_SET::CORNER_STRATEGY strategy : { SHAPE_POLY_SET::ROUND_ALL_CORNERS,
+                                                      SHAPE_POLY_SET::CHAMFER_ACUTE_CORNERS } )
+    {
+        plain.Deflate( 20000, 32, strategy );
+        plain.Inflate( 10000, 32, strategy );
+        tiled.TiledDeflate( 20000, 32, strategy, 0 );
+        tiled.TiledInflate( 10000, 32, strategy, 0 );
+
+        BOOST_REQUIRE_EQUAL( tiled.OutlineCount(), plain.OutlineCount() );
+        BOOST_CHECK_EQUAL( tiled.HoleCount( 0 ), plain.HoleCount( 0 ) );
+        BOOST_CHECK_CLOSE( area( tiled ), area( plain ), 1e-3 );
+    }
+}
+
+
+static size_t s_parallelForCalls = 0;
+static size_t s_firstLoopCount = 0;
+
+
+/**
+ * Runs the loop backwards, as a parallel loop may finish the indices in any order
+ */
+static void reverseFor( size_t aCount, const std::function<void( size_t )>& aFunc )
+{
+    if( s_parallelForCalls++ == 0 )
+        s_firstLoopCount = aCount;
+
+    for( size_t ii = aCount; ii > 0; --ii )
+        aFunc( ii - 1 );
+}
+
+
+/**
+ * The tiles go through the installed parallel loop, and the order they are processed in
+ * doesn't change the result
+ */
+BOOST_AUTO_TEST_CASE( InstalledParallelFor )
+{
+    SHAPE_POLY_SET serial = m_pour;
+    SHAPE_POLY_SET parallel = m_pour;
+
+    serial.TiledBooleanSubtract( m_holes, SHAPE_POLY_SET::PM_FAST, 0 );
+
+    s_parallelForCalls = 0;
+    SHAPE_POLY_SET::SetParallelFor( reverseFor,
+            []() -> size_t
+            {
+                return 8;
+            } );
+    parallel.TiledBooleanSubtract( m_holes, SHAPE_POLY_SET::PM_FAST, 0 );
+    SHAPE_POLY_SET::SetParallelFor( nullptr, nullptr );
+
+    // The tile grid is sized for the workers of the loop: 4 x 4 tiles for 8 of them
+    BOOST_CHECK_GT( s_parallelForCalls, 0 );
+    BOOST_CHECK_EQUAL( s_firstLoopCount, 16 );
+    BOOST_REQUIRE_EQUAL( parallel.OutlineCount(), serial.OutlineCount() );
+    BOOST_CHECK_EQUAL( parallel.HoleCount( 0 ), serial.HoleCount( 0 ) );
+    BOOST_CHECK_CLOSE( area( parallel ), area( serial ), 1e-6 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for DRC_RTREE
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <convert_to_biu.h>
+#include <class_board.h>
+#include <class_track.h>
+
+// Code under test
+#include <drc/drc_rtree.h>
+
+
+class TEST_DRC_RTREE_FIXTURE
+{
+public:
+    TEST_DRC_RTREE_FIXTURE()
+    {
+        // A row of parallel horizontal tracks, 1mm apart, alternating between F_Cu and B_Cu
+        for( int ii = 0; ii < 10; ++ii )
+        {
+            TRACK* track = new TRACK( &m_board );
+
+            track->SetStart( wxPoint( 0, Millimeter2iu( ii ) ) );
+            track->SetEnd( wxPoint( Millimeter2iu( 10 ), Millimeter2iu( ii ) ) );
+            track->SetWidth( Millimeter2iu( 0.2 ) );
+            track->SetLayer( ii % 2 ? B_Cu : F_Cu );
+
+            m_board.Add( track );
+            m_tree.Insert( track, LSET::AllCuMask(), Millimeter2iu( 0.5 ) );
+        }
+    }
+
+    BOARD     m_board;
+    DRC_RTREE m_tree;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( DrcRtree, TEST_DRC_RTREE_FIXTURE )
+
+
+/**
+ * Items are only reported on their own layers
+ */
+BOOST_AUTO_TEST_CASE( Layers )
+{
+    std::vector<BOARD_ITEM*> result;
+    EDA_RECT                 all( wxPoint( 0, 0 ), wxSize( Millimeter2iu( 10 ),
+                                                           Millimeter2iu( 10 ) ) );
+
+    BOOST_CHECK_EQUAL( m_tree.size(), 10 );
+
+    m_tree.QueryColliding( all, F_Cu, result );
+    BOOST_CHECK_EQUAL( result.size(), 5 );
+
+    m_tree.QueryColliding( all, In1_Cu, result );
+    BOOST_CHECK_EQUAL( result.size(), 0 );
+
+    // Items on several of the queried layers must only be reported once
+    m_tree.QueryColliding( all, LSET::AllCuMask(), result );
+    BOOST_CHECK_EQUAL( result.size(), 10 );
+}
+
+
+/**
+ * Candidates come back in insertion (ie: board list) order
+ */
+BOOST_AUTO_TEST_CASE( Order )
+{
+    std::vector<BOARD_ITEM*> result;
+    EDA_RECT                 all( wxPoint( 0, 0 ), wxSize( Millimeter2iu( 10 ),
+                                                           Millimeter2iu( 10 ) ) );
+
+    m_tree.QueryColliding( all, LSET::AllCuMask(), result );
+
+    BOOST_REQUIRE_EQUAL( result.size(), m_board.Tracks().size() );
+
+    for( size_t ii = 0; ii < result.size(); ++ii )
+        BOOST_CHECK_EQUAL( result[ii], m_board.Tracks()[ii] );
+
+    // Only items at or after the given index
+    m_tree.QueryColliding( all, LSET::AllCuMask(), result, 7 );
+
+    BOOST_REQUIRE_EQUAL( result.size(), 3 );
+    BOOST_CHECK_EQUAL( result[0], m_board.Tracks()[7] );
+}
+
+
+/**
+ * Bounding boxes are inflated by the clearance given at insertion
+ */
+BOOST_AUTO_TEST_CASE( Clearance )
+{
+    std::vector<BOARD_ITEM*> result;
+
+    // A small box 0.25mm below the third track's edge is within its 0.5mm clearance...
+    EDA_RECT nearTrack( wxPoint( Millimeter2iu( 5 ), Millimeter2iu( 2.35 ) ),
+                        wxSize( Millimeter2iu( 0.01 ), Millimeter2iu( 0.01 ) ) );
+
+    m_tree.QueryColliding( nearTrack, F_Cu, result );
+
+    BOOST_REQUIRE_EQUAL( result.size(), 1 );
+    BOOST_CHECK_EQUAL( result[0], m_board.Tracks()[2] );
+
+    // ... but too far from the fourth (on B_Cu)
+    m_tree.QueryColliding( nearTrack, B_Cu, result );
+    BOOST_CHECK_EQUAL( result.size(), 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
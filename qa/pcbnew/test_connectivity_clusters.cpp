@@ -0,0 +1,303 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file test_connectivity_clusters.cpp
+ * Checks that the connectivity clusters found by the parallel union-find are the ones of a
+ * breadth-first search over the connected items.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <connectivity/connectivity_algo.h>
+#include <profile.h>
+
+
+using CLUSTERS = CN_CONNECTIVITY_ALGO::CLUSTERS;
+
+
+class CONNECTIVITY_CLUSTERS_FIXTURE
+{
+public:
+    static constexpr int GRID = 80;
+    static constexpr int PITCH = 1000000;
+    static constexpr int NETS = 4;
+
+    /**
+     * Builds a grid of tracks, each end shared by up to four tracks and sometimes a via.  The
+     * tracks meeting at a point are often on different nets, and a few are left out to split
+     * the grid.  That is more than one chunk of the union-find, so it runs in parallel.
+     */
+    CONNECTIVITY_CLUSTERS_FIXTURE() :
+            m_rng( 15 )
+    {
+        for( int net = 1; net <= NETS; net++ )
+            m_board.Add( new NETINFO_ITEM( &m_board, wxString::Format( "N%d", net ), net ) );
+
+        std::uniform_int_distribution<int> netCode( 0, NETS );
+        std::uniform_int_distribution<int> percent( 0, 99 );
+
+        for( int x = 0; x < GRID; x++ )
+        {
+            for( int y = 0; y < GRID; y++ )
+            {
+                wxPoint pos( x * PITCH, y * PITCH );
+
+                if( x + 1 < GRID && percent( m_rng ) >= 10 )
+                    addTrack( pos, pos + wxPoint( PITCH, 0 ), netCode( m_rng ) );
+
+                if( y + 1 < GRID && percent( m_rng ) >= 10 )
+                    addTrack( pos, pos + wxPoint( 0, PITCH ), netCode( m_rng ) );
+
+                if( percent( m_rng ) < 20 )
+                {
+                    VIA* via = new VIA( &m_board );
+
+                    via->SetPosition( pos );
+                    via->SetWidth( 600000 );
+                    via->SetDrill( 300000 );
+                    via->SetLayerPair( F_Cu, B_Cu );
+                    via->SetNetCode( netCode( m_rng ) );
+                    m_board.Add( via );
+                }
+            }
+        }
+
+        m_algo.Build( &m_board );
+    }
+
+    void addTrack( const wxPoint& aStart, const wxPoint& aEnd, int aNet )
+    {
+        TRACK* track = new TRACK( &m_board );
+
+        track->SetStart( aStart );
+        track->SetEnd( aEnd );
+        track->SetWidth( 200000 );
+        track->SetLayer( F_Cu );
+        track->SetNetCode( aNet );
+        m_board.Add( track );
+    }
+
+    /**
+     * Finds the clusters as SearchClusters() did before the union-find: a breadth-first
+     * search from each item not yet in a cluster, in list order.
+     */
+    std::vector<std::vector<CN_ITEM*>> searchBfs( bool aWithinAnyNet, const KICAD_T aTypes[] )
+    {
+        std::unordered_set<CN_ITEM*> pending;
+
+        for( CN_ITEM* item : m_algo.ItemList() )
+        {
+            if( aWithinAnyNet && item->Net() <= 0 )
+                continue;
+
+            if( !item->Valid() )
+                continue;
+
+            for( int j = 0; aTypes[j] != EOT; j++ )
+            {
+                if( item->Parent()->Type() == aTypes[j] )
+                {
+                    pending.insert( item );
+                    break;
+                }
+            }
+        }
+
+        std::vector<std::vector<CN_ITEM*>> clusters;
+
+        for( CN_ITEM* root : m_algo.ItemList() )
+        {
+            if( !pending.erase( root ) )
+                continue;
+
+            std::vector<CN_ITEM*> cluster( 1, root );
+
+            for( size_t head = 0; head < cluster.size(); head++ )
+            {
+                for( CN_ITEM* connected : cluster[head]->ConnectedItems() )
+                {
+                    if( aWithinAnyNet && connected->Net() != root->Net() )
+                        continue;
+
+                    if( pending.erase( connected ) )
+                        cluster.push_back( connected );
+                }
+            }
+
+            clusters.push_back( cluster );
+        }
+
+        return canonical( clusters );
+    }
+
+    /**
+     * Checks that the items of the list are the ones found by their index, and that their
+     * connections go both ways between items which are still there.
+     */
+    void checkStorage()
+    {
+        const CN_LIST& list = m_algo.ItemList();
+        int            used = 0;
+
+        for( int i = 0; i < list.IndexCount(); i++ )
+        {
+            if( list.ItemByIndex( i ) )
+                used++;
+        }
+
+        BOOST_CHECK_EQUAL( used, list.Size() );
+
+        for( CN_ITEM* item : list )
+        {
+            BOOST_REQUIRE( list.ItemByIndex( item->Index() ) == item );
+
+            for( CN_ITEM* connected : item->ConnectedItems() )
+            {
+                BOOST_REQUIRE( list.ItemByIndex( connected->Index() ) == connected );
+
+                bool back = false;
+
+                for( CN_ITEM* other : connected->ConnectedItems() )
+                    back |= ( other == item );
+
+                BOOST_CHECK( back );
+            }
+
+            for( CN_ANCHOR* anchor : item->Anchors() )
+                BOOST_CHECK( anchor->Item() == item );
+        }
+    }
+
+    static std::vector<std::vector<CN_ITEM*>> canonical( const CLUSTERS& aClusters )
+    {
+        std::vector<std::vector<CN_ITEM*>> clusters;
+
+        for( const CN_CLUSTER_PTR& cluster : aClusters )
+            clusters.emplace_back( cluster->begin(), cluster->end() );
+
+        return canonical( clusters );
+    }
+
+    static std::vector<std::vector<CN_ITEM*>> canonical(
+            std::vector<std::vector<CN_ITEM*>> aClusters )
+    {
+        for( std::vector<CN_ITEM*>& cluster : aClusters )
+            std::sort( cluster.begin(), cluster.end() );
+
+        std::sort( aClusters.begin(), aClusters.end() );
+        return aClusters;
+    }
+
+    BOARD                m_board;
+    CN_CONNECTIVITY_ALGO m_algo;
+    std::mt19937         m_rng;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ConnectivityClusters, CONNECTIVITY_CLUSTERS_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( UnionFindMatchesBfs )
+{
+    const KICAD_T types[] = { PCB_TRACE_T, PCB_ARC_T, PCB_PAD_T, PCB_VIA_T, PCB_ZONE_AREA_T,
+                              PCB_MODULE_T, EOT };
+
+    // More items than one chunk of the union-find
+    BOOST_REQUIRE_GT( m_algo.ItemList().Size(), 4096 );
+
+    // Within nets, the items meeting at a point are split by net
+    CLUSTERS checkClusters = m_algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_CONNECTIVITY_CHECK,
+                                                    types, -1 );
+
+    BOOST_CHECK( canonical( checkClusters ) == searchBfs( true, types ) );
+
+    // Across nets, the items meeting at a point are joined
+    CLUSTERS propagateClusters = m_algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_PROPAGATE,
+                                                        types, -1 );
+
+    BOOST_CHECK( canonical( propagateClusters ) == searchBfs( false, types ) );
+
+    BOOST_CHECK_LT( propagateClusters.size(), checkClusters.size() );
+}
+
+
+/**
+ * Removing items frees their indices and anchors, and the items added next reuse them
+ */
+BOOST_AUTO_TEST_CASE( FlatStorage )
+{
+    const KICAD_T types[] = { PCB_TRACE_T, PCB_VIA_T, EOT };
+
+    CN_CONNECTIVITY_ALGO rebuilt;
+    PROF_COUNTER         build_timer;
+
+    rebuilt.Build( &m_board );
+    build_timer.Stop();
+
+    BOOST_TEST_MESSAGE( wxString::Format( "build: %d items, %0.3f ms, %d kB",
+                                          rebuilt.ItemList().Size(), build_timer.msecs(),
+                                          (int) ( rebuilt.ItemList().MemoryUsage() / 1024 ) ) );
+
+    m_algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_PROPAGATE, types, -1 );
+    checkStorage();
+
+    // Enough of the tracks to leave most of the anchors dead, so the arena is compacted
+    std::vector<TRACK*> removed;
+    int                 count = 0;
+
+    for( TRACK* track : m_board.Tracks() )
+    {
+        if( track->Type() == PCB_TRACE_T && count++ % 3 != 2 )
+        {
+            m_algo.Remove( track );
+            removed.push_back( track );
+        }
+    }
+
+    int indexCount = m_algo.ItemList().IndexCount();
+
+    BOOST_CHECK( canonical( m_algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_PROPAGATE, types,
+                                                   -1 ) ) == searchBfs( false, types ) );
+    checkStorage();
+
+    for( TRACK* track : removed )
+        m_algo.Add( track );
+
+    BOOST_CHECK( canonical( m_algo.SearchClusters( CN_CONNECTIVITY_ALGO::CSM_PROPAGATE, types,
+                                                   -1 ) ) == searchBfs( false, types ) );
+    checkStorage();
+
+    // The tracks added back took the indices of the removed ones
+    BOOST_CHECK_EQUAL( m_algo.ItemList().IndexCount(), indexCount );
+    BOOST_CHECK_EQUAL( m_algo.ItemList().Size(), rebuilt.ItemList().Size() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -79,7 +79,12 @@ const static std::vector<EXPR_TO_TEST> introspectionExpressions = {
     { "A.Netclass + 1.0", false, VAL( 1.0 ) },
     { "A.type == 'Track' && B.type == 'Track' && A.layer == 'F.Cu'", false, VAL( 1.0 ) },
     { "(A.type == 'Track') && (B.type == 'Track') && (A.layer == 'F.Cu')", false, VAL( 1.0 ) },
-    { "A.type == 'Via' && A.isMicroVia()", false, VAL(0.0) }
+    { "A.type == 'Via' && A.isMicroVia()", false, VAL(0.0) },
+    // Constant and dead-branch folding
+    { "0 && A.Netclass == 'HV'", false, VAL( 0.0 ) },
+    { "A.Width > B.Width || 1", false, VAL( 1.0 ) },
+    { "A.Netclass == 'HV' && 1", false, VAL( 1.0 ) },
+    { "(A.Netclass == 'HV') && (B.netclass == 'HV' || 1mm + 1mm == 2mm)", false, VAL( 1.0 ) }
 };
 
 
@@ -176,4 +181,70 @@ BOOST_AUTO_TEST_CASE( IntrospectedProperties )
     }
 }
 
+/**
+ * Constant subexpressions and operands which can't change the result are compiled away
+ */
+BOOST_AUTO_TEST_CASE( ConstantFolding )
+{
+    const static std::vector<std::pair<wxString, int>> expressions = {
+        { "3*(7+8)", 1 },
+        { "1mm + 1mm > 1.5mm", 1 },
+        { "0 && A.Width > B.Width", 1 },
+        { "A.Width > B.Width || (2 > 1)", 1 },
+        { "A.Width > 2 * 0.1mm", 3 },
+        { "A.NetClass == 'HV' || B.NetClass == 'HV'", 7 },
+        // Method calls are never dropped
+        { "0 && A.onLayer('F.Cu')", 4 }
+    };
+
+    PROPERTY_MANAGER& propMgr = PROPERTY_MANAGER::Instance();
+    propMgr.Rebuild();
+
+    for( const std::pair<wxString, int>& expr : expressions )
+    {
+        PCB_EXPR_COMPILER compiler;
+        PCB_EXPR_UCODE    ucode;
+        PCB_EXPR_CONTEXT  preflightContext( F_Cu );
+
+        BOOST_TEST_CONTEXT( expr.first.c_str() )
+        {
+            BOOST_CHECK( compiler.Compile( expr.first, &ucode, &preflightContext ) );
+            BOOST_CHECK_EQUAL( (int) ucode.Dump().Freq( '\n' ), expr.second );
+        }
+    }
+}
+
+
+/**
+ * Only expressions reading item-class properties may have their results shared between items
+ */
+BOOST_AUTO_TEST_CASE( Cacheability )
+{
+    const static std::vector<std::pair<wxString, bool>> expressions = {
+        { "A.NetClass == 'HV' || B.NetClass == 'HV'", true },
+        { "A.type == 'Via' && A.isMicroVia()", true },
+        { "A.Via_Type == 'micro_via'", true },
+        { "A.onLayer('F.Cu') && B.layer == 'B.Cu'", true },
+        { "A.Width > B.Width", false },
+        { "A.NetClass == 'HV' && A.insideArea('zone1')", false },
+        { "A.memberOf('group1')", false }
+    };
+
+    PROPERTY_MANAGER& propMgr = PROPERTY_MANAGER::Instance();
+    propMgr.Rebuild();
+
+    for( const std::pair<wxString, bool>& expr : expressions )
+    {
+        PCB_EXPR_COMPILER compiler;
+        PCB_EXPR_UCODE    ucode;
+        PCB_EXPR_CONTEXT  preflightContext( F_Cu );
+
+        BOOST_TEST_CONTEXT( expr.first.c_str() )
+        {
+            BOOST_CHECK( compiler.Compile( expr.first, &ucode, &preflightContext ) );
+            BOOST_CHECK_EQUAL( ucode.IsCacheable(), expr.second );
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
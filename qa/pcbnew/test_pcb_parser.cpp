@@ -0,0 +1,223 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file test_pcb_parser.cpp
+ * Checks that parsing the items of a board on the thread pool gives the same board, and the
+ * same errors, as parsing them one after the other.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <memory>
+#include <string>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <kicad_plugin.h>
+#include <pcb_parser.h>
+#include <richio.h>
+
+
+class PCB_PARSER_FIXTURE
+{
+public:
+    PCB_PARSER_FIXTURE()
+    {
+        BOARD board;
+
+        for( int net = 1; net <= 10; net++ )
+            board.Add( new NETINFO_ITEM( &board, wxString::Format( "N%d", net ), net ) );
+
+        for( int i = 0; i < 20; i++ )
+        {
+            MODULE* module = new MODULE( &board );
+            module->SetReference( wxString::Format( "U%d", i ) );
+            module->SetPosition( wxPoint( i * 5000000, 0 ) );
+            board.Add( module );
+
+            for( int p = 0; p < 8; p++ )
+            {
+                D_PAD* pad = new D_PAD( module );
+                pad->SetName( wxString::Format( "%d", p + 1 ) );
+                pad->SetPosition( module->GetPosition() + wxPoint( 0, p * 1000000 ) );
+                module->Add( pad );
+                pad->SetNetCode( 1 + p );
+            }
+        }
+
+        // Enough tracks to fill several batches
+        for( int i = 0; i < 5000; i++ )
+        {
+            TRACK* track = new TRACK( &board );
+            track->SetStart( wxPoint( i * 1000, 0 ) );
+            track->SetEnd( wxPoint( i * 1000, 1000000 ) );
+            track->SetWidth( 250000 );
+            track->SetLayer( i % 2 ? B_Cu : F_Cu );
+            board.Add( track );
+            track->SetNetCode( 1 + i % 10 );
+        }
+
+        ZONE_CONTAINER* zone = new ZONE_CONTAINER( &board );
+        zone->SetLayer( F_Cu );
+        zone->Outline()->NewOutline();
+        zone->Outline()->Append( 0, 0 );
+        zone->Outline()->Append( 10000000, 0 );
+        zone->Outline()->Append( 10000000, 10000000 );
+        board.Add( zone );
+        zone->SetNetCode( 2 );
+
+        PCB_IO io;
+        io.Format( &board );
+        m_text = io.GetStringOutput( true );
+    }
+
+    static std::unique_ptr<BOARD> parse( const std::string& aText, bool aParallel )
+    {
+        STRING_LINE_READER reader( aText, "test board" );
+        PCB_PARSER         parser( &reader );
+
+        parser.SetParallelLoad( aParallel );
+
+        return std::unique_ptr<BOARD>( static_cast<BOARD*>( parser.Parse() ) );
+    }
+
+    std::string m_text;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PcbParser, PCB_PARSER_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( ParallelLoad )
+{
+    std::unique_ptr<BOARD> serial = parse( m_text, false );
+    std::unique_ptr<BOARD> parallel = parse( m_text, true );
+
+    BOOST_REQUIRE_EQUAL( serial->Modules().size(), parallel->Modules().size() );
+    BOOST_REQUIRE_EQUAL( serial->Tracks().size(), parallel->Tracks().size() );
+    BOOST_REQUIRE_EQUAL( serial->Zones().size(), parallel->Zones().size() );
+
+    auto module = parallel->Modules().begin();
+
+    for( MODULE* expected : serial->Modules() )
+    {
+        BOOST_CHECK_EQUAL( expected->m_Uuid.AsString(), ( *module )->m_Uuid.AsString() );
+        BOOST_CHECK_EQUAL( expected->GetReference(), ( *module )->GetReference() );
+        BOOST_REQUIRE_EQUAL( expected->Pads().size(), ( *module )->Pads().size() );
+
+        for( size_t ii = 0; ii < expected->Pads().size(); ii++ )
+        {
+            BOOST_CHECK_EQUAL( expected->Pads()[ii]->GetNetCode(),
+                               ( *module )->Pads()[ii]->GetNetCode() );
+        }
+
+        ++module;
+    }
+
+    auto track = parallel->Tracks().begin();
+
+    for( TRACK* expected : serial->Tracks() )
+    {
+        BOOST_CHECK_EQUAL( expected->m_Uuid.AsString(), ( *track )->m_Uuid.AsString() );
+        BOOST_CHECK( expected->GetEnd() == ( *track )->GetEnd() );
+        BOOST_CHECK_EQUAL( expected->GetNetCode(), ( *track )->GetNetCode() );
+        ++track;
+    }
+
+    BOOST_CHECK_EQUAL( serial->Zones()[0]->GetNetCode(), parallel->Zones()[0]->GetNetCode() );
+}
+
+
+BOOST_AUTO_TEST_CASE( ParallelLoadError )
+{
+    // Break a track far enough into the file to be in a later batch
+    size_t pos = 0;
+
+    for( int i = 0; i < 4000; i++ )
+        pos = m_text.find( "(segment", pos + 1 );
+
+    pos = m_text.find( "(width", pos );
+    BOOST_REQUIRE( pos != std::string::npos );
+    m_text.replace( pos, 6, "(wdth" );
+
+    int serialLine = 0;
+    int serialOffset = 0;
+
+    try
+    {
+        parse( m_text, false );
+    }
+    catch( const PARSE_ERROR& error )
+    {
+        serialLine = error.lineNumber;
+        serialOffset = error.byteIndex;
+    }
+
+    BOOST_REQUIRE( serialLine > 0 );
+
+    BOOST_CHECK_EXCEPTION( parse( m_text, true ), PARSE_ERROR,
+            [&]( const PARSE_ERROR& aError )
+            {
+                return aError.lineNumber == serialLine && aError.byteIndex == serialOffset;
+            } );
+}
+
+
+BOOST_AUTO_TEST_CASE( ParallelLoadErrorOrder )
+{
+    // Break a track in a batch which is parsed after the rest of the file is read, and add
+    // an error the loading thread finds on its own at the end of the file
+    size_t pos = m_text.find( "(segment" );
+    pos = m_text.find( "(width", pos );
+    BOOST_REQUIRE( pos != std::string::npos );
+    m_text.replace( pos, 6, "(wdth" );
+
+    pos = m_text.rfind( ')' );
+    m_text.insert( pos, "(bogus)\n" );
+
+    int serialLine = 0;
+
+    try
+    {
+        parse( m_text, false );
+    }
+    catch( const PARSE_ERROR& error )
+    {
+        serialLine = error.lineNumber;
+    }
+
+    BOOST_REQUIRE( serialLine > 0 );
+
+    BOOST_CHECK_EXCEPTION( parse( m_text, true ), PARSE_ERROR,
+            [&]( const PARSE_ERROR& aError )
+            {
+                return aError.lineNumber == serialLine;
+            } );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
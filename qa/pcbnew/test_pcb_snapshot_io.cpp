@@ -0,0 +1,324 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file test_pcb_snapshot_io.cpp
+ * Checks that a board loaded from its snapshot is the board which was saved, and that a
+ * snapshot is only used while the board file is unchanged.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <memory>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_pcb_group.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <pcb_snapshot_io.h>
+
+
+class PCB_SNAPSHOT_IO_FIXTURE
+{
+public:
+    PCB_SNAPSHOT_IO_FIXTURE() :
+            m_fileName( wxFileName::CreateTempFileName( "pcb_snapshot_io" ) )
+    {
+        for( int net = 1; net <= 4; net++ )
+            m_board.Add( new NETINFO_ITEM( &m_board, wxString::Format( "N%d", net ), net ) );
+
+        MODULE* module = new MODULE( &m_board );
+        module->SetReference( "U1" );
+        m_board.Add( module );
+
+        module->SetPosition( wxPoint( 20000000, 10000000 ) );
+        module->SetOrientation( 450 );
+
+        for( int p = 0; p < 4; p++ )
+        {
+            D_PAD* pad = new D_PAD( module );
+            pad->SetName( wxString::Format( "%d", p + 1 ) );
+            pad->SetPos0( wxPoint( 0, p * 1000000 ) );
+            pad->SetOrientation( 450 + p * 100 );
+            module->Add( pad );
+            pad->SetNetCode( 1 + p );
+        }
+
+        // Pads which use most of the fields
+        D_PAD* chamfered = module->Pads()[0];
+        chamfered->SetAttribute( PAD_ATTRIB_SMD );
+        chamfered->SetShape( PAD_SHAPE_CHAMFERED_RECT );
+        chamfered->SetLayerSet( D_PAD::SMDMask() );
+        chamfered->SetRoundRectRadiusRatio( 0.15 );
+        chamfered->SetChamferRectRatio( 0.2 );
+        chamfered->SetChamferPositions( RECT_CHAMFER_TOP_LEFT | RECT_CHAMFER_BOTTOM_RIGHT );
+        chamfered->SetPinFunction( "GND" );
+        chamfered->SetLocalSolderPasteMarginRatio( -0.1 );
+        chamfered->SetLocalClearance( 200000 );
+
+        D_PAD* oval = module->Pads()[1];
+        oval->SetShape( PAD_SHAPE_OVAL );
+        oval->SetSize( wxSize( 1500000, 2500000 ) );
+        oval->SetDrillShape( PAD_DRILL_SHAPE_OBLONG );
+        oval->SetDrillSize( wxSize( 800000, 1600000 ) );
+        oval->SetOffset( wxPoint( 0, 100000 ) );
+        oval->SetRemoveUnconnected( true );
+        oval->SetKeepTopBottom( true );
+        oval->SetZoneConnection( ZONE_CONNECTION::FULL );
+        oval->SetPadToDieLength( 1234 );
+
+        // A footprint with a custom pad keeps all its pads in the text
+        MODULE* custom = new MODULE( &m_board );
+        custom->SetReference( "U2" );
+        m_board.Add( custom );
+
+        for( int p = 0; p < 2; p++ )
+        {
+            D_PAD* pad = new D_PAD( custom );
+            pad->SetName( wxString::Format( "%d", p + 1 ) );
+            pad->SetPos0( wxPoint( p * 1000000, 0 ) );
+            custom->Add( pad );
+        }
+
+        custom->Pads()[1]->SetShape( PAD_SHAPE_CUSTOM );
+        custom->Pads()[1]->AddPrimitiveCircle( wxPoint( 0, 0 ), 500000, 0 );
+
+        for( int i = 0; i < 100; i++ )
+        {
+            TRACK* track = new TRACK( &m_board );
+            track->SetStart( wxPoint( i * 1000, 0 ) );
+            track->SetEnd( wxPoint( i * 1000, 1000000 ) );
+            track->SetWidth( 250000 );
+            track->SetLayer( i % 2 ? B_Cu : F_Cu );
+            m_board.Add( track );
+            track->SetNetCode( 1 + i % 4 );
+        }
+
+        ARC* arc = new ARC( &m_board );
+        arc->SetStart( wxPoint( 0, 0 ) );
+        arc->SetMid( wxPoint( 500000, 500000 ) );
+        arc->SetEnd( wxPoint( 1000000, 0 ) );
+        arc->SetWidth( 200000 );
+        arc->SetLayer( B_Cu );
+        m_board.Add( arc );
+        arc->SetNetCode( 2 );
+
+        VIA* via = new VIA( &m_board );
+        via->SetViaType( VIATYPE::BLIND_BURIED );
+        via->SetPosition( wxPoint( 2000000, 2000000 ) );
+        via->SetWidth( 600000 );
+        via->SetDrill( 300000 );
+        via->SetLayerPair( F_Cu, B_Cu );
+        via->SetRemoveUnconnected( true );
+        via->SetLocked( true );
+        m_board.Add( via );
+        via->SetNetCode( 3 );
+
+        // Grouped tracks stay in the text section of the snapshot
+        TRACK* grouped = new TRACK( &m_board );
+        grouped->SetStart( wxPoint( 0, 5000000 ) );
+        grouped->SetEnd( wxPoint( 1000000, 5000000 ) );
+        grouped->SetWidth( 250000 );
+        m_board.Add( grouped );
+        grouped->SetNetCode( 4 );
+
+        PCB_GROUP* group = new PCB_GROUP( &m_board );
+        m_board.Add( group );
+        group->AddItem( grouped );
+
+        ZONE_CONTAINER* zone = new ZONE_CONTAINER( &m_board );
+        zone->SetLayer( F_Cu );
+        zone->Outline()->NewOutline();
+        zone->Outline()->Append( 0, 0 );
+        zone->Outline()->Append( 10000000, 0 );
+        zone->Outline()->Append( 10000000, 10000000 );
+        m_board.Add( zone );
+        zone->SetNetCode( 2 );
+
+        SHAPE_POLY_SET fill;
+
+        fill.NewOutline();
+        fill.Append( 0, 0 );
+        fill.Append( 4000000, 0 );
+        fill.Append( 4000000, 4000000 );
+        fill.NewOutline();
+        fill.Append( 6000000, 6000000 );
+        fill.Append( 8000000, 6000000 );
+        fill.Append( 8000000, 8000000 );
+
+        zone->SetIsFilled( true );
+        zone->SetFilledPolysList( F_Cu, fill );
+        zone->SetIsIsland( F_Cu, 1 );
+    }
+
+    ~PCB_SNAPSHOT_IO_FIXTURE()
+    {
+        wxRemoveFile( m_fileName );
+        wxRemoveFile( PCB_SNAPSHOT_IO::SnapshotFileName( m_fileName ) );
+    }
+
+    wxString m_fileName;
+    BOARD    m_board;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PcbSnapshotIo, PCB_SNAPSHOT_IO_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( RoundTrip )
+{
+    PCB_SNAPSHOT_IO io;
+
+    io.Save( m_fileName, &m_board );
+
+    std::unique_ptr<BOARD> loaded( io.LoadSnapshot( m_fileName ) );
+
+    BOOST_REQUIRE( loaded );
+    BOOST_REQUIRE_EQUAL( loaded->Modules().size(), 2 );
+    BOOST_REQUIRE_EQUAL( loaded->Tracks().size(), m_board.Tracks().size() );
+    BOOST_REQUIRE_EQUAL( loaded->Zones().size(), 1 );
+    BOOST_REQUIRE_EQUAL( loaded->Groups().size(), 1 );
+    BOOST_CHECK_EQUAL( ( *loaded->Groups().begin() )->GetItems().size(), 1 );
+
+    for( TRACK* expected : m_board.Tracks() )
+    {
+        TRACK* track = static_cast<TRACK*>( loaded->GetItem( expected->m_Uuid ) );
+
+        BOOST_REQUIRE( track && track->m_Uuid == expected->m_Uuid );
+        BOOST_CHECK_EQUAL( track->Type(), expected->Type() );
+        BOOST_CHECK( track->GetStart() == expected->GetStart() );
+        BOOST_CHECK( track->GetEnd() == expected->GetEnd() );
+        BOOST_CHECK_EQUAL( track->GetWidth(), expected->GetWidth() );
+        BOOST_CHECK( track->GetLayerSet() == expected->GetLayerSet() );
+        BOOST_CHECK_EQUAL( track->GetNetname(), expected->GetNetname() );
+        BOOST_CHECK_EQUAL( track->IsLocked(), expected->IsLocked() );
+    }
+
+    const ZONE_CONTAINER* zone = loaded->Zones()[0];
+    const SHAPE_POLY_SET& fill = zone->GetFilledPolysList( F_Cu );
+
+    BOOST_CHECK( fill.GetHash() == m_board.Zones()[0]->GetFilledPolysList( F_Cu ).GetHash() );
+    BOOST_CHECK( !loaded->Zones()[0]->IsIsland( F_Cu, 0 ) );
+    BOOST_CHECK( loaded->Zones()[0]->IsIsland( F_Cu, 1 ) );
+    BOOST_CHECK_EQUAL( zone->GetNetname(), "N2" );
+}
+
+
+BOOST_AUTO_TEST_CASE( SameAsBoardFile )
+{
+    PCB_SNAPSHOT_IO io;
+
+    io.Save( m_fileName, &m_board );
+
+    // The board file is the one PCB_IO saves
+    wxString reference = wxFileName::CreateTempFileName( "pcb_snapshot_io" );
+    PCB_IO   pcbIo;
+
+    pcbIo.Save( reference, &m_board );
+
+    wxString savedText;
+    wxString referenceText;
+
+    BOOST_REQUIRE( wxFFile( m_fileName, "rb" ).ReadAll( &savedText ) );
+    BOOST_REQUIRE( wxFFile( reference, "rb" ).ReadAll( &referenceText ) );
+    BOOST_CHECK( savedText == referenceText );
+    wxRemoveFile( reference );
+
+    // The pads loaded from the snapshot are the ones loaded from the board file
+    std::unique_ptr<BOARD> fromSnapshot( io.LoadSnapshot( m_fileName ) );
+    std::unique_ptr<BOARD> fromFile( pcbIo.Load( m_fileName, nullptr ) );
+
+    BOOST_REQUIRE( fromSnapshot && fromFile );
+    BOOST_REQUIRE_EQUAL( fromSnapshot->Modules().size(), fromFile->Modules().size() );
+
+    for( size_t ii = 0; ii < fromFile->Modules().size(); ii++ )
+    {
+        MODULE* expectedModule = fromFile->Modules()[ii];
+        MODULE* module = fromSnapshot->Modules()[ii];
+
+        BOOST_REQUIRE( module->m_Uuid == expectedModule->m_Uuid );
+        BOOST_REQUIRE_EQUAL( module->Pads().size(), expectedModule->Pads().size() );
+        BOOST_CHECK( module->GetBoundingBox() == expectedModule->GetBoundingBox() );
+
+        for( size_t jj = 0; jj < module->Pads().size(); jj++ )
+        {
+            D_PAD* expected = expectedModule->Pads()[jj];
+            D_PAD* pad = module->Pads()[jj];
+
+            BOOST_CHECK( pad->m_Uuid == expected->m_Uuid );
+            BOOST_CHECK_EQUAL( pad->GetName(), expected->GetName() );
+            BOOST_CHECK_EQUAL( pad->GetAttribute(), expected->GetAttribute() );
+            BOOST_CHECK_EQUAL( pad->GetShape(), expected->GetShape() );
+            BOOST_CHECK( pad->GetPosition() == expected->GetPosition() );
+            BOOST_CHECK( pad->GetPos0() == expected->GetPos0() );
+            BOOST_CHECK_EQUAL( pad->GetOrientation(), expected->GetOrientation() );
+            BOOST_CHECK( pad->GetSize() == expected->GetSize() );
+            BOOST_CHECK( pad->GetDrillSize() == expected->GetDrillSize() );
+            BOOST_CHECK_EQUAL( pad->GetDrillShape(), expected->GetDrillShape() );
+            BOOST_CHECK( pad->GetOffset() == expected->GetOffset() );
+            BOOST_CHECK( pad->GetLayerSet() == expected->GetLayerSet() );
+            BOOST_CHECK_EQUAL( pad->GetNetname(), expected->GetNetname() );
+            BOOST_CHECK_EQUAL( pad->GetPinFunction(), expected->GetPinFunction() );
+            BOOST_CHECK_EQUAL( pad->GetRoundRectRadiusRatio(),
+                               expected->GetRoundRectRadiusRatio() );
+            BOOST_CHECK_EQUAL( pad->GetChamferRectRatio(), expected->GetChamferRectRatio() );
+            BOOST_CHECK_EQUAL( pad->GetChamferPositions(), expected->GetChamferPositions() );
+            BOOST_CHECK_EQUAL( pad->GetLocalSolderPasteMarginRatio(),
+                               expected->GetLocalSolderPasteMarginRatio() );
+            BOOST_CHECK_EQUAL( pad->GetLocalClearance(), expected->GetLocalClearance() );
+            BOOST_CHECK_EQUAL( pad->GetPadToDieLength(), expected->GetPadToDieLength() );
+            BOOST_CHECK( pad->GetZoneConnection() == expected->GetZoneConnection() );
+            BOOST_CHECK_EQUAL( pad->GetRemoveUnconnected(), expected->GetRemoveUnconnected() );
+            BOOST_CHECK_EQUAL( pad->GetKeepTopBottom(), expected->GetKeepTopBottom() );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( ChangedBoardFile )
+{
+    PCB_SNAPSHOT_IO io;
+
+    io.Save( m_fileName, &m_board );
+
+    {
+        wxFFile file( m_fileName, "ab" );
+        file.Write( wxString( "\n" ) );
+    }
+
+    BOOST_CHECK( !io.LoadSnapshot( m_fileName ) );
+
+    // The board file is then read instead
+    std::unique_ptr<BOARD> loaded( io.Load( m_fileName, nullptr ) );
+
+    BOOST_REQUIRE( loaded );
+    BOOST_CHECK_EQUAL( loaded->Tracks().size(), m_board.Tracks().size() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
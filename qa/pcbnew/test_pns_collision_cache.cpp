@@ -0,0 +1,225 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+
+#include <router/pns_node.h>
+#include <router/pns_segment.h>
+#include <router/pns_via.h>
+
+using namespace PNS;
+
+
+/**
+ * Collects the obstacles of an item as QueryColliding() does, without its cache
+ */
+class REFERENCE_VISITOR : public OBSTACLE_VISITOR
+{
+public:
+    REFERENCE_VISITOR( const ITEM* aItem, NODE::ITEM_VECTOR& aItems ) :
+            OBSTACLE_VISITOR( aItem ),
+            m_items( aItems )
+    {
+    }
+
+    bool operator()( ITEM* aCandidate ) override
+    {
+        if( visit( aCandidate ) )
+            return true;
+
+        int clearance = m_node->GetClearance( aCandidate, m_item );
+
+        if( aCandidate->Collide( m_item, clearance, false, nullptr, m_node, true ) )
+            m_items.push_back( aCandidate );
+
+        return true;
+    }
+
+private:
+    NODE::ITEM_VECTOR& m_items;
+};
+
+
+class PNS_COLLISION_CACHE_FIXTURE
+{
+public:
+    PNS_COLLISION_CACHE_FIXTURE() :
+            m_rng( 4242 ),
+            m_root( new NODE )
+    {
+        for( int i = 0; i < 200; i++ )
+        {
+            std::unique_ptr<VIA> via = makeVia();
+
+            m_rootVias.push_back( via.get() );
+            m_root->Add( std::move( via ) );
+        }
+
+        // Segment and via queries are the ones which are cached
+        for( int i = 0; i < 50; i++ )
+        {
+            m_queries.push_back( makeVia() );
+            m_queries.push_back( makeSegment() );
+        }
+    }
+
+    ~PNS_COLLISION_CACHE_FIXTURE()
+    {
+        m_root->KillChildren();
+    }
+
+    // Single layer items need the router's interface to collide: the items of the tests span
+    // all the layers
+    std::unique_ptr<VIA> makeVia()
+    {
+        VECTOR2I pos( coord(), coord() );
+
+        return std::make_unique<VIA>( pos, LAYER_RANGE( 0, 31 ), 600000, 300000, net() );
+    }
+
+    std::unique_ptr<SEGMENT> makeSegment()
+    {
+        std::unique_ptr<SEGMENT> seg( new SEGMENT( SEG( VECTOR2I( coord(), coord() ),
+                                                         VECTOR2I( coord(), coord() ) ),
+                                                   net() ) );
+
+        seg->SetWidth( 250000 );
+        seg->SetLayers( LAYER_RANGE( 0, 31 ) );
+        return seg;
+    }
+
+    int coord()
+    {
+        return std::uniform_int_distribution<int>( 0, 20000000 )( m_rng );
+    }
+
+    int net()
+    {
+        return std::uniform_int_distribution<int>( 1, 5 )( m_rng );
+    }
+
+    /**
+     * Checks that the cached obstacles of all the queries in \a aNode are the uncached ones
+     */
+    void CheckQueries( NODE* aNode )
+    {
+        for( const std::unique_ptr<ITEM>& query : m_queries )
+        {
+            NODE::OBSTACLES   obstacles;
+            NODE::ITEM_VECTOR cached;
+            NODE::ITEM_VECTOR uncached;
+            REFERENCE_VISITOR visitor( query.get(), uncached );
+
+            aNode->QueryColliding( query.get(), obstacles );
+            aNode->QueryColliding( query.get(), visitor );
+
+            for( const OBSTACLE& obs : obstacles )
+                cached.push_back( obs.m_item );
+
+            std::sort( cached.begin(), cached.end() );
+            std::sort( uncached.begin(), uncached.end() );
+
+            BOOST_CHECK( cached == uncached );
+        }
+    }
+
+    std::mt19937                        m_rng;
+    std::unique_ptr<NODE>               m_root;
+    std::vector<VIA*>                   m_rootVias;
+    std::vector<std::unique_ptr<ITEM>>  m_queries;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PnsCollisionCache, PNS_COLLISION_CACHE_FIXTURE )
+
+
+/**
+ * Branches share their parent's cache until their world changes, and the cached obstacles
+ * must always be the ones of an uncached query
+ */
+BOOST_AUTO_TEST_CASE( CachedMatchesUncached )
+{
+    NODE*             parent = m_root->Branch();
+    std::vector<VIA*> parentVias;
+
+    for( int i = 0; i < 50; i++ )
+    {
+        std::unique_ptr<VIA> via = makeVia();
+
+        parentVias.push_back( via.get() );
+        parent->Add( std::move( via ) );
+    }
+
+    NODE* first = parent->Branch();
+    NODE* second = parent->Branch();
+
+    // Twice: the first pass fills the cache, the second one reads it
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        CheckQueries( parent );
+        CheckQueries( first );
+        CheckQueries( second );
+    }
+
+    // The branches see the same world as their parent, so they find all its results
+    BOOST_CHECK_EQUAL( parent->QueryStats().m_cacheHits, (int) m_queries.size() );
+    BOOST_CHECK_EQUAL( first->QueryStats().m_cacheHits, first->QueryStats().m_queries );
+    BOOST_CHECK_EQUAL( second->QueryStats().m_cacheHits, second->QueryStats().m_queries );
+
+    // A change in a branch must not show in the others, which keep their cached results
+    for( int i = 0; i < 50; i++ )
+        first->Add( makeVia() );
+
+    second->Remove( parentVias[0] );
+    second->Remove( m_rootVias[0] );
+
+    int parentHits = parent->QueryStats().m_cacheHits;
+    int firstHits = first->QueryStats().m_cacheHits;
+    int secondHits = second->QueryStats().m_cacheHits;
+
+    CheckQueries( parent );
+    CheckQueries( first );
+    CheckQueries( second );
+
+    BOOST_CHECK_EQUAL( parent->QueryStats().m_cacheHits, parentHits + (int) m_queries.size() );
+    BOOST_CHECK_EQUAL( first->QueryStats().m_cacheHits, firstHits );
+    BOOST_CHECK_EQUAL( second->QueryStats().m_cacheHits, secondHits );
+
+    // A change in the root changes the world of all the branches
+    m_root->Add( makeVia() );
+
+    parentHits = parent->QueryStats().m_cacheHits;
+
+    CheckQueries( parent );
+    CheckQueries( first );
+    CheckQueries( second );
+
+    BOOST_CHECK_EQUAL( parent->QueryStats().m_cacheHits, parentHits );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
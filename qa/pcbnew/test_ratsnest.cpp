@@ -0,0 +1,171 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file test_ratsnest.cpp
+ * Checks that updating the ratsnest of a large net after small changes gives the same
+ * unconnected length as computing it from scratch.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <memory>
+#include <random>
+
+#include <class_track.h>
+#include <profile.h>
+#include <ratsnest/ratsnest_data.h>
+
+
+class RATSNEST_FIXTURE
+{
+public:
+    RATSNEST_FIXTURE() :
+            m_rng( 1 )
+    {
+        std::uniform_int_distribution<int> coord( 0, 100000000 );
+
+        for( int i = 0; i < 2000; i++ )
+            m_points.emplace_back( coord( m_rng ), coord( m_rng ) );
+    }
+
+    /**
+     * Rebuilds the nodes of aNet from m_points, one cluster per point, and updates it.
+     * Every seventh cluster is a track, with a second node, so that some clusters span several
+     * nodes.  aList and aItems hold the items of aNet, and must outlive it.
+     */
+    void build( RN_NET& aNet, CN_LIST& aList,
+                std::vector<std::unique_ptr<BOARD_CONNECTED_ITEM>>& aItems )
+    {
+        aNet.Clear();
+        aList.Clear();
+        aItems.clear();
+
+        for( size_t i = 0; i < m_points.size(); i++ )
+        {
+            wxPoint  pos( m_points[i].x, m_points[i].y );
+            CN_ITEM* item;
+
+            if( i % 7 == 0 )
+            {
+                TRACK* track = new TRACK( nullptr );
+
+                track->SetStart( pos );
+                track->SetEnd( pos + wxPoint( 100000, 0 ) );
+                aItems.emplace_back( track );
+                item = aList.Add( track );
+            }
+            else
+            {
+                VIA* via = new VIA( nullptr );
+
+                via->SetPosition( pos );
+                aItems.emplace_back( via );
+                item = aList.Add( via );
+            }
+
+            auto cluster = std::make_shared<CN_CLUSTER>();
+            cluster->Add( item );
+            aNet.AddCluster( cluster );
+        }
+
+        aNet.Update();
+    }
+
+    /// Moves, removes or adds up to aCount points
+    void edit( int aCount )
+    {
+        std::uniform_int_distribution<int> coord( 0, 100000000 );
+        std::uniform_int_distribution<int> offset( -1000000, 1000000 );
+
+        for( int i = 0; i < aCount; i++ )
+        {
+            size_t index = m_rng() % m_points.size();
+
+            switch( m_rng() % 3 )
+            {
+            case 0: m_points[index] += VECTOR2I( offset( m_rng ), offset( m_rng ) ); break;
+            case 1: m_points.erase( m_points.begin() + index );                      break;
+            default: m_points.emplace_back( coord( m_rng ), coord( m_rng ) );        break;
+            }
+        }
+    }
+
+    static long long length( const RN_NET& aNet )
+    {
+        long long total = 0;
+
+        for( const CN_EDGE& edge : aNet.GetEdges() )
+            total += edge.GetWeight();
+
+        return total;
+    }
+
+    std::mt19937          m_rng;
+    std::vector<VECTOR2I> m_points;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( Ratsnest, RATSNEST_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( IncrementalUpdate )
+{
+    std::vector<std::unique_ptr<BOARD_CONNECTED_ITEM>> updatedItems;
+    CN_LIST                                            updatedList;
+    RN_NET                                             updated;
+
+    build( updated, updatedList, updatedItems );
+
+    for( int round = 0; round < 50; round++ )
+    {
+        edit( 1 + m_rng() % 8 );
+
+        PROF_COUNTER update_timer;
+        build( updated, updatedList, updatedItems );
+        update_timer.Stop();
+
+        long long updatedLength = length( updated );
+        size_t    updatedCount = updated.GetEdges().size();
+
+        std::vector<std::unique_ptr<BOARD_CONNECTED_ITEM>> rebuiltItems;
+        CN_LIST                                            rebuiltList;
+        RN_NET                                             rebuilt;
+
+        PROF_COUNTER rebuild_timer;
+        build( rebuilt, rebuiltList, rebuiltItems );
+        rebuild_timer.Stop();
+
+        BOOST_TEST_MESSAGE( wxString::Format( "round %d: update %0.3f ms, full %0.3f ms", round,
+                                              update_timer.msecs(), rebuild_timer.msecs() ) );
+
+        BOOST_TEST_CONTEXT( "round " << round )
+        {
+            BOOST_CHECK_EQUAL( updatedCount, rebuilt.GetEdges().size() );
+            BOOST_CHECK_EQUAL( updatedLength, length( rebuilt ) );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
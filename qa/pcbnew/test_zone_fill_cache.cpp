@@ -0,0 +1,276 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_zone.h>
+#include <geometry/shape_poly_set.h>
+#include <kicad_plugin.h>
+#include <pcb_parser.h>
+#include <richio.h>
+#include <zone_fill_cache.h>
+#include <zone_filler.h>
+
+
+class ZONE_FILL_CACHE_FIXTURE
+{
+public:
+    ZONE_FILL_CACHE_FIXTURE() :
+            m_fileName( wxFileName::CreateTempFileName( "zone_fill_cache" ) )
+    {
+        SHAPE_LINE_CHAIN outline;
+        SHAPE_LINE_CHAIN hole;
+
+        outline.Append( 0, 0 );
+        outline.Append( 100000, 0 );
+        outline.Append( 100000, 100000 );
+        outline.Append( 0, 100000 );
+        outline.SetClosed( true );
+
+        hole.Append( 10000, 10000 );
+        hole.Append( 20000, 10000 );
+        hole.Append( 20000, 20000 );
+        hole.SetClosed( true );
+
+        m_raw.AddOutline( outline );
+        m_raw.AddHole( hole );
+
+        m_final = m_raw;
+        m_final.Fracture( SHAPE_POLY_SET::PM_FAST );
+    }
+
+    ~ZONE_FILL_CACHE_FIXTURE()
+    {
+        wxRemoveFile( m_fileName );
+    }
+
+    wxString       m_fileName;
+    SHAPE_POLY_SET m_raw;
+    SHAPE_POLY_SET m_final;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ZoneFillCache, ZONE_FILL_CACHE_FIXTURE )
+
+
+/**
+ * Fills and triangulations must come back unchanged from the file, and only under their key
+ */
+BOOST_AUTO_TEST_CASE( RoundTrip )
+{
+    uint64_t slot = ZONE_FILL_CACHE::SlotFor( 1234, 0 );
+
+    {
+        ZONE_FILL_CACHE cache;
+        SHAPE_POLY_SET  triangulated = m_final;
+
+        triangulated.CacheTriangulation();
+
+        cache.StoreFill( slot, 42, m_raw, m_final );
+        cache.StoreTriangulation( slot, triangulated );
+
+        BOOST_REQUIRE( cache.Save( m_fileName, 0 ) );
+    }
+
+    ZONE_FILL_CACHE cache;
+
+    BOOST_REQUIRE( cache.Load( m_fileName ) );
+    BOOST_CHECK_EQUAL( cache.size(), 2 );
+
+    SHAPE_POLY_SET raw, fractured;
+
+    BOOST_CHECK( !cache.FindFill( slot, 43, raw, fractured ) );
+    BOOST_CHECK( !cache.FindFill( ZONE_FILL_CACHE::SlotFor( 1234, 1 ), 42, raw, fractured ) );
+    BOOST_REQUIRE( cache.FindFill( slot, 42, raw, fractured ) );
+
+    BOOST_CHECK_EQUAL( raw.OutlineCount(), 1 );
+    BOOST_CHECK_EQUAL( raw.HoleCount( 0 ), 1 );
+    BOOST_CHECK( raw.GetHash() == m_raw.GetHash() );
+    BOOST_CHECK( fractured.GetHash() == m_final.GetHash() );
+
+    BOOST_REQUIRE( cache.FindTriangulation( slot, fractured ) );
+    BOOST_CHECK( fractured.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( fractured.TriangulatedPolyCount(), 1 );
+
+    // A triangulation is only handed out for the polygons it was made from
+    SHAPE_POLY_SET other = m_final;
+
+    other.Move( VECTOR2I( 1, 0 ) );
+    BOOST_CHECK( !cache.FindTriangulation( slot, other ) );
+}
+
+
+/**
+ * The fills saved with a board file come back with the hash of the board file
+ */
+BOOST_AUTO_TEST_CASE( SavedFill )
+{
+    uint64_t slot = ZONE_FILL_CACHE::SlotFor( 1234, 0 );
+
+    {
+        ZONE_FILL_CACHE cache;
+
+        cache.StoreSavedFill( slot, m_final, { 0 } );
+        BOOST_REQUIRE( cache.Save( m_fileName, 77 ) );
+    }
+
+    ZONE_FILL_CACHE  cache;
+    SHAPE_POLY_SET   polys;
+    std::vector<int> islands;
+
+    BOOST_REQUIRE( cache.Load( m_fileName ) );
+    BOOST_CHECK_EQUAL( cache.BoardHash(), 77 );
+    BOOST_CHECK( !cache.FindSavedFill( ZONE_FILL_CACHE::SlotFor( 1234, 1 ), polys, islands ) );
+    BOOST_REQUIRE( cache.FindSavedFill( slot, polys, islands ) );
+    BOOST_CHECK( polys.GetHash() == m_final.GetHash() );
+    BOOST_CHECK( islands == std::vector<int>( { 0 } ) );
+
+    cache.ClearSavedFills();
+    BOOST_CHECK( !cache.FindSavedFill( slot, polys, islands ) );
+}
+
+
+/**
+ * The parser takes the fills its source knows in place of those of the file, and parses the
+ * others
+ */
+BOOST_AUTO_TEST_CASE( SkipSavedFill )
+{
+    BOARD board;
+
+    for( int ii = 0; ii < 2; ++ii )
+    {
+        ZONE_CONTAINER* zone = new ZONE_CONTAINER( &board );
+        zone->SetLayer( F_Cu );
+        zone->Outline()->NewOutline();
+        zone->Outline()->Append( 0, 0 );
+        zone->Outline()->Append( 100000, 0 );
+        zone->Outline()->Append( 100000, 100000 );
+        zone->SetFilledPolysList( F_Cu, m_final );
+        board.Add( zone );
+    }
+
+    PCB_IO io;
+    io.Format( &board );
+
+    std::string        text = io.GetStringOutput( true );
+    STRING_LINE_READER reader( text, "test board" );
+    PCB_PARSER         parser( &reader );
+    SHAPE_POLY_SET     other = m_final;
+    KIID               sourced = board.Zones()[0]->m_Uuid;
+
+    other.Move( VECTOR2I( 1, 0 ) );
+
+    parser.SetFilledPolysSource(
+            [&]( ZONE_CONTAINER* aZone, PCB_LAYER_ID aLayer ) -> bool
+            {
+                if( aZone->m_Uuid != sourced )
+                    return false;
+
+                aZone->SetFilledPolysList( aLayer, other );
+                return true;
+            } );
+
+    std::unique_ptr<BOARD> loaded( static_cast<BOARD*>( parser.Parse() ) );
+
+    BOOST_REQUIRE_EQUAL( loaded->Zones().size(), 2 );
+    BOOST_CHECK( loaded->Zones()[0]->GetFilledPolysList( F_Cu ).CVertex( 0 )
+                 == other.CVertex( 0 ) );
+    BOOST_CHECK( loaded->Zones()[1]->GetFilledPolysList( F_Cu ).CVertex( 0 )
+                 == m_final.CVertex( 0 ) );
+}
+
+
+/**
+ * The key of a zone fill changes with the holes and texts it knocks out
+ */
+BOOST_AUTO_TEST_CASE( FillCacheKey )
+{
+    BOARD           board;
+    ZONE_CONTAINER* zone = new ZONE_CONTAINER( &board );
+
+    zone->SetLayer( F_Cu );
+    zone->Outline()->NewOutline();
+    zone->Outline()->Append( 0, 0 );
+    zone->Outline()->Append( 10000000, 0 );
+    zone->Outline()->Append( 10000000, 10000000 );
+    zone->Outline()->Append( 0, 10000000 );
+    board.Add( zone );
+    zone->CacheBoundingBox();
+
+    MODULE* module = new MODULE( &board );
+    module->SetReference( "U1" );
+    board.Add( module );
+    module->SetPosition( wxPoint( 5000000, 5000000 ) );
+
+    D_PAD* pad = new D_PAD( module );
+    pad->SetSize( wxSize( 2000000, 2000000 ) );
+    pad->SetDrillSize( wxSize( 1000000, 1000000 ) );
+    module->Add( pad );
+    pad->SetPosition( module->GetPosition() );
+
+    module->Reference().SetLayer( F_Cu );
+    module->Reference().SetPosition( wxPoint( 5000000, 7000000 ) );
+
+    ZONE_FILLER filler( &board, nullptr );
+    uint64_t    key = filler.FillCacheKey( zone, F_Cu );
+
+    BOOST_CHECK_EQUAL( filler.FillCacheKey( zone, F_Cu ), key );
+
+    // The hole knocks out the zone with the hole clearance
+    pad->SetDrillSize( wxSize( 1200000, 1200000 ) );
+
+    uint64_t drilled = filler.FillCacheKey( zone, F_Cu );
+
+    BOOST_CHECK_NE( drilled, key );
+
+    module->Reference().SetText( "U2" );
+
+    BOOST_CHECK_NE( filler.FillCacheKey( zone, F_Cu ), drilled );
+}
+
+
+/**
+ * A file which isn't a cache (or was written by another version) is rejected as a whole
+ */
+BOOST_AUTO_TEST_CASE( BadFile )
+{
+    {
+        wxFFile file( m_fileName, "wb" );
+        file.Write( wxString( "(kicad_pcb (version 20200829))" ) );
+    }
+
+    ZONE_FILL_CACHE cache;
+
+    BOOST_CHECK( !cache.Load( m_fileName ) );
+    BOOST_CHECK_EQUAL( cache.size(), 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
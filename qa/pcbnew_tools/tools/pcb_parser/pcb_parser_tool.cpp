@@ -23,7 +23,10 @@
 
 #include <qa_utils/utility_registry.h>
 
+#include <algorithm>
 #include <cstdio>
+#include <fstream>
+#include <memory>
 #include <string>
 
 #include <common.h>
@@ -49,9 +52,11 @@ using PARSE_DURATION = std::chrono::microseconds;
  * Parse a PCB or footprint file from the given input stream
  *
  * @param aStream the input stream to read from
- * @return success, duration (in us)
+ * @param aParallel parse the items of a board on the thread pool
+ * @param aDuration set to the time the parse took
+ * @return success
  */
-bool parse( std::istream& aStream, bool aVerbose )
+bool parse( std::istream& aStream, bool aParallel, PARSE_DURATION& aDuration )
 {
     // Take input from stdin
     STDISTREAM_LINE_READER reader;
@@ -60,28 +65,61 @@ bool parse( std::istream& aStream, bool aVerbose )
     PCB_PARSER parser;
 
     parser.SetLineReader( &reader );
+    parser.SetParallelLoad( aParallel );
 
-    BOARD_ITEM* board = nullptr;
+    std::unique_ptr<BOARD_ITEM> board;
 
-    PARSE_DURATION duration{};
+    aDuration = PARSE_DURATION{};
 
     try
     {
         PROF_COUNTER timer;
-        board = parser.Parse();
+        board.reset( parser.Parse() );
 
-        duration = timer.SinceStart<PARSE_DURATION>();
+        aDuration = timer.SinceStart<PARSE_DURATION>();
     }
     catch( const IO_ERROR& )
     {
     }
 
+    return board != nullptr;
+}
+
+
+bool parse( std::istream& aStream, bool aVerbose, bool aParallel )
+{
+    PARSE_DURATION duration;
+    bool           ok = parse( aStream, aParallel, duration );
+
     if( aVerbose )
     {
         std::cout << "Took: " << duration.count() << "us" << std::endl;
     }
 
-    return board != nullptr;
+    return ok;
+}
+
+
+/**
+ * Parse a file serially and then in parallel, and print the speedup
+ */
+bool compare( const std::string& aFilename )
+{
+    PARSE_DURATION serial;
+    PARSE_DURATION parallel;
+
+    std::ifstream serialStream( aFilename );
+    std::ifstream parallelStream( aFilename );
+
+    if( !parse( serialStream, false, serial ) || !parse( parallelStream, true, parallel ) )
+        return false;
+
+    std::cout << aFilename << ": serial " << serial.count() << "us, parallel "
+              << parallel.count() << "us, speedup "
+              << double( serial.count() ) / std::max<long long>( parallel.count(), 1 ) << "x"
+              << std::endl;
+
+    return true;
 }
 
 
@@ -89,6 +127,9 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
     { wxCMD_LINE_SWITCH, "h", "help", _( "displays help on the command line parameters" ).mb_str(),
             wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
     { wxCMD_LINE_SWITCH, "v", "verbose", _( "print parsing information" ).mb_str() },
+    { wxCMD_LINE_SWITCH, "s", "serial", _( "parse board items on a single thread" ).mb_str() },
+    { wxCMD_LINE_SWITCH, "c", "compare",
+            _( "parse the files serially and in parallel, and print the speedup" ).mb_str() },
     { wxCMD_LINE_PARAM, nullptr, nullptr, _( "input file" ).mb_str(), wxCMD_LINE_VAL_STRING,
             wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE },
     { wxCMD_LINE_NONE }
@@ -123,6 +164,8 @@ int pcb_parser_main_func( int argc, char** argv )
     }
 
     const bool verbose = cl_parser.Found( "verbose" );
+    const bool parallel = !cl_parser.Found( "serial" );
+    const bool comparing = cl_parser.Found( "compare" );
 
     bool ok = true;
 
@@ -134,7 +177,7 @@ int pcb_parser_main_func( int argc, char** argv )
         // program
         // while (__AFL_LOOP(2))
         {
-            ok = parse( std::cin, verbose );
+            ok = parse( std::cin, verbose, parallel );
         }
     }
     else
@@ -149,10 +192,16 @@ int pcb_parser_main_func( int argc, char** argv )
             if( verbose )
                 std::cout << "Parsing: " << filename << std::endl;
 
+            if( comparing )
+            {
+                ok = ok && compare( filename );
+                continue;
+            }
+
             std::ifstream fin;
             fin.open( filename );
 
-            ok = ok && parse( fin, verbose );
+            ok = ok && parse( fin, verbose, parallel );
         }
     }
 
@@ -0,0 +1,146 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pcb_save_benchmark.cpp
+ * Saves a board a number of times, as an autosave would, and reports the time taken by the
+ * whole save and by the formatting of the coordinates alone.  The board-reading counterpart
+ * is the io_benchmark tool of qa_common_tools.
+ */
+
+#include <qa_utils/utility_registry.h>
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <cstdio>
+#include <string>
+
+#include <base_units.h>
+#include <common.h>
+#include <profile.h>
+
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <kicad_plugin.h>
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_SWITCH, "h", "help", _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_OPTION, "r", "reps", _( "number of saves (default 5)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_PARAM, nullptr, nullptr, _( "input file" ).mb_str(), wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_MANDATORY },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum PCB_SAVE_BENCHMARK_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    SAVE_FAILED
+};
+
+
+int pcb_save_benchmark_main_func( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText( _( "This program saves a board several times and reports the "
+                               "time taken." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long reps = 5;
+
+    cl_parser.Found( "reps", &reps );
+
+    std::unique_ptr<BOARD> board =
+            KI_TEST::ReadBoardFromFileOrStream( cl_parser.GetParam( 0 ).ToStdString() );
+
+    if( !board )
+        return PCB_SAVE_BENCHMARK_RET_CODES::LOAD_FAILED;
+
+    printf( "%d tracks/vias, %d footprints, %d zones\n", (int) board->Tracks().size(),
+            (int) board->Modules().size(), (int) board->Zones().size() );
+
+    wxString     fileName = wxFileName::CreateTempFileName( "pcb_save_benchmark" );
+    PCB_IO       io;
+    PROF_COUNTER timer;
+
+    try
+    {
+        for( long ii = 0; ii < reps; ++ii )
+            io.Save( fileName, board.get() );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        wxRemoveFile( fileName );
+        fprintf( stderr, "%s\n", TO_UTF8( ioe.What() ) );
+        return PCB_SAVE_BENCHMARK_RET_CODES::SAVE_FAILED;
+    }
+
+    timer.Stop();
+
+    wxULongLong size = wxFileName::GetSize( fileName );
+
+    wxRemoveFile( fileName );
+
+    printf( "Save:                 %10.1f ms (%llu bytes)\n", timer.msecs() / reps,
+            (unsigned long long) size.GetValue() );
+
+    // The track coordinates alone, which make most of the numbers of a routed board
+    size_t chars = 0;
+
+    timer.Start();
+
+    for( long ii = 0; ii < reps; ++ii )
+    {
+        for( TRACK* track : board->Tracks() )
+        {
+            chars += FormatInternalUnits( track->GetStart() ).size();
+            chars += FormatInternalUnits( track->GetEnd() ).size();
+            chars += FormatInternalUnits( track->GetWidth() ).size();
+        }
+    }
+
+    timer.Stop();
+
+    printf( "Track coordinates:    %10.1f ms (%zu chars)\n", timer.msecs() / reps,
+            chars / reps );
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( { "pcb_save_benchmark",
+        "Benchmark saving a board", pcb_save_benchmark_main_func } );
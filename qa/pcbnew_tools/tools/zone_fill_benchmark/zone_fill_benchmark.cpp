@@ -0,0 +1,299 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2020 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file zone_fill_benchmark.cpp
+ * Fills every zone of a board (either a given one or a synthetic, dense, many-layered one)
+ * and reports the time spent gathering the copper item knockouts.  It then nudges a single
+ * track and reports the time taken to refill just the zones affected by the move.
+ */
+
+#include <qa_utils/utility_registry.h>
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <cstdio>
+#include <string>
+
+#include <common.h>
+#include <profile.h>
+
+#include <wx/cmdline.h>
+
+#include <class_board.h>
+#include <class_drawsegment.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <connectivity/connectivity_data.h>
+#include <convert_to_biu.h>
+#include <zone_filler.h>
+
+
+/**
+ * Builds a square board with \a aLayers copper layers.  Each layer carries a \a aGrid by
+ * \a aGrid lattice of tracks (alternately horizontal and vertical) and is covered by
+ * \a aTiles by \a aTiles zones on a mix of nets.  Through-hole footprints and vias
+ * are spread over the whole board.
+ */
+static std::unique_ptr<BOARD> buildSyntheticBoard( int aLayers, int aGrid, int aTiles )
+{
+    std::unique_ptr<BOARD> board = std::make_unique<BOARD>();
+
+    const int size = Millimeter2iu( 100 );
+    const int pitch = size / aGrid;
+    const int nets = 16;
+
+    board->SetCopperLayerCount( aLayers );
+
+    for( int ii = 1; ii <= nets; ++ii )
+        board->Add( new NETINFO_ITEM( board.get(), wxString::Format( "net%d", ii ), ii ) );
+
+    auto netCode = []( int aIndex ) { return aIndex % nets + 1; };
+
+    // Board outline
+    wxPoint corners[] = { { 0, 0 }, { size, 0 }, { size, size }, { 0, size } };
+
+    for( int ii = 0; ii < 4; ++ii )
+    {
+        DRAWSEGMENT* edge = new DRAWSEGMENT( board.get() );
+
+        edge->SetStart( corners[ii] );
+        edge->SetEnd( corners[( ii + 1 ) % 4] );
+        edge->SetLayer( Edge_Cuts );
+        edge->SetWidth( Millimeter2iu( 0.1 ) );
+        board->Add( edge );
+    }
+
+    LSEQ copperLayers = LSET::AllCuMask( aLayers ).Seq();
+    int  index = 0;
+
+    // Tracks, offset by half a pitch from the vias and pads
+    for( PCB_LAYER_ID layer : copperLayers )
+    {
+        bool horizontal = ( layer % 2 ) == 0;
+
+        for( int ii = 0; ii < aGrid; ++ii )
+        {
+            int     offset = ii * pitch + pitch / 2;
+            TRACK*  track = new TRACK( board.get() );
+
+            track->SetStart( horizontal ? wxPoint( 0, offset ) : wxPoint( offset, 0 ) );
+            track->SetEnd( horizontal ? wxPoint( size, offset ) : wxPoint( offset, size ) );
+            track->SetWidth( Millimeter2iu( 0.2 ) );
+            track->SetLayer( layer );
+            track->SetNetCode( netCode( index++ ) );
+            board->Add( track );
+        }
+    }
+
+    // Vias and two-pin through-hole footprints on alternate grid points
+    for( int ii = 1; ii < aGrid; ++ii )
+    {
+        for( int jj = 1; jj < aGrid; ++jj )
+        {
+            wxPoint pos( ii * pitch, jj * pitch );
+
+            if( ( ii + jj ) % 2 )
+            {
+                VIA* via = new VIA( board.get() );
+
+                via->SetPosition( pos );
+                via->SetWidth( Millimeter2iu( 0.6 ) );
+                via->SetDrill( Millimeter2iu( 0.3 ) );
+                via->SetLayerPair( F_Cu, B_Cu );
+                via->SetNetCode( netCode( index++ ) );
+                board->Add( via );
+            }
+            else if( ii % 4 == 0 )
+            {
+                MODULE* module = new MODULE( board.get() );
+
+                module->SetPosition( pos );
+
+                for( int pin = 0; pin < 2; ++pin )
+                {
+                    D_PAD*  pad = new D_PAD( module );
+                    wxPoint offset( 0, ( pin ? 1 : -1 ) * pitch / 4 );
+
+                    pad->SetName( wxString::Format( "%d", pin + 1 ) );
+                    pad->SetShape( PAD_SHAPE_CIRCLE );
+                    pad->SetAttribute( PAD_ATTRIB_STANDARD );
+                    pad->SetLayerSet( D_PAD::StandardMask() );
+                    pad->SetSize( wxSize( Millimeter2iu( 1.0 ), Millimeter2iu( 1.0 ) ) );
+                    pad->SetDrillSize( wxSize( Millimeter2iu( 0.5 ), Millimeter2iu( 0.5 ) ) );
+                    pad->SetPos0( offset );
+                    pad->SetPosition( pos + offset );
+                    pad->SetNetCode( netCode( index++ ) );
+                    module->Add( pad );
+                }
+
+                board->Add( module );
+            }
+        }
+    }
+
+    // Zones
+    const int tile = size / aTiles;
+
+    for( PCB_LAYER_ID layer : copperLayers )
+    {
+        for( int ii = 0; ii < aTiles; ++ii )
+        {
+            for( int jj = 0; jj < aTiles; ++jj )
+            {
+                ZONE_CONTAINER* zone = new ZONE_CONTAINER( board.get() );
+                wxPoint         origin( ii * tile, jj * tile );
+
+                zone->SetLayer( layer );
+                zone->SetNetCode( netCode( index++ ) );
+                zone->AppendCorner( origin, -1 );
+                zone->AppendCorner( origin + wxPoint( tile, 0 ), -1 );
+                zone->AppendCorner( origin + wxPoint( tile, tile ), -1 );
+                zone->AppendCorner( origin + wxPoint( 0, tile ), -1 );
+                board->Add( zone );
+            }
+        }
+    }
+
+    return board;
+}
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_SWITCH, "h", "help", _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_OPTION, "l", "layers",
+            _( "copper layers of the synthetic board (default 30)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "g", "grid",
+            _( "tracks per layer of the synthetic board (default 60)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "t", "tiles",
+            _( "zones per side of each layer (default 4)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_PARAM, nullptr, nullptr,
+            _( "input file (instead of the synthetic board)" ).mb_str(),
+            wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum ZONE_FILL_BENCHMARK_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    FILL_FAILED
+};
+
+
+int zone_fill_benchmark_main_func( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText( _( "This program fills all the zones of a board and reports the "
+                               "time spent building the copper item clearances." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long layers = 30;
+    long grid = 60;
+    long tiles = 4;
+
+    cl_parser.Found( "layers", &layers );
+    cl_parser.Found( "grid", &grid );
+    cl_parser.Found( "tiles", &tiles );
+
+    std::unique_ptr<BOARD> board;
+
+    if( cl_parser.GetParamCount() )
+        board = KI_TEST::ReadBoardFromFileOrStream( cl_parser.GetParam( 0 ).ToStdString() );
+    else
+        board = buildSyntheticBoard( layers, grid, tiles );
+
+    if( !board )
+        return ZONE_FILL_BENCHMARK_RET_CODES::LOAD_FAILED;
+
+    board->BuildConnectivity();
+
+    std::vector<ZONE_CONTAINER*> zones( board->Zones().begin(), board->Zones().end() );
+    ZONE_FILLER                  filler( board.get(), nullptr );
+
+    printf( "%d copper layers, %d zones, %d tracks/vias, %d footprints\n",
+            board->GetCopperLayerCount(), (int) zones.size(), (int) board->Tracks().size(),
+            (int) board->Modules().size() );
+
+    PROF_COUNTER timer;
+
+    if( !filler.Fill( zones ) )
+        return ZONE_FILL_BENCHMARK_RET_CODES::FILL_FAILED;
+
+    timer.Stop();
+
+    printf( "Fill:                %10.1f ms\n", timer.msecs() );
+    printf( "Copper clearances:   %10.1f ms (indexes, then summed over all threads)\n",
+            filler.GetClearanceBuildTime() / 1000.0 );
+
+    // Now move one track from the middle of the board and refill what it touched
+    std::vector<TRACK*> tracks;
+
+    for( TRACK* track : board->Tracks() )
+    {
+        if( track->Type() == PCB_TRACE_T )
+            tracks.push_back( track );
+    }
+
+    if( tracks.empty() )
+        return KI_TEST::RET_CODES::OK;
+
+    TRACK*                                 track = tracks[tracks.size() / 2];
+    std::vector<std::pair<EDA_RECT, LSET>> dirtyAreas;
+    std::vector<ZONE_CONTAINER*>           refilled;
+
+    dirtyAreas.emplace_back( track->GetBoundingBox(), track->GetLayerSet() );
+    track->Move( wxPoint( 0, Millimeter2iu( 0.1 ) ) );
+    dirtyAreas.emplace_back( track->GetBoundingBox(), track->GetLayerSet() );
+    board->GetConnectivity()->Update( track );
+
+    timer.Start();
+
+    if( !filler.FillIncremental( dirtyAreas, refilled ) )
+        return ZONE_FILL_BENCHMARK_RET_CODES::FILL_FAILED;
+
+    timer.Stop();
+
+    printf( "Refill after a move: %10.1f ms (%d zones)\n", timer.msecs(),
+            (int) refilled.size() );
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( { "zone_fill_benchmark",
+        "Benchmark the zone filler on a dense board", zone_fill_benchmark_main_func } );